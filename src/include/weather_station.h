@@ -43,4 +43,10 @@ const string args_log_mode_nologging = "none";
 const string lock_directory = "/run/lock/";
 const string lock_file_suffix = ".lock";
 
+/*
+ * How often the sensors are read in milliseconds. This is independent of
+ * the report interval so the windowed averages have samples to work with.
+ */
+constexpr int ws_sample_interval = 5000;
+
 #endif  // SRC_INCLUDE_WEATHER_STATION_H
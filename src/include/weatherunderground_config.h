@@ -7,15 +7,28 @@ constexpr int wu_default_report_interval = 300000;
 constexpr int wu_report_interval_min = 2500;  // 2.5 seconds in milliseconds
 constexpr int wu_report_interval_max =
     ((60 * 60) * 1000);  // 1 hour in milliseconds
+
+/*
+ * Where reports wait to be uploaded if the config doesn't say
+ */
+const string wu_queue_default_directory = "/usr/local/qw/var/wu_queue";
+
 /*
  * The ReportInterval is in milliseconds. 300000 = 5 miuntes
+ * rapid_fire_interval is how often RapidFire real time updates go, also
+ * in milliseconds, 0 for none. It can't be less than
+ * wu_report_interval_min.
+ * wu_url and rapid_fire_url, if they are there, send the reports and the
+ * RapidFire updates somewhere other than weather underground. That's for
+ * testing against tools/wu_mock_server.
  */
 const string wu_default_config = R"({
     "WeatherUnderground": {
         "pwu_name": "KTXROANO168",
         "pwu_password": "HW0SG8q3"
     },
-   "report_interval": 300000
+   "report_interval": 300000,
+   "rapid_fire_interval": 0
 })";
 
 class WeatherUndergroundConfig {
@@ -0,0 +1,610 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "include/batch_conversion.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "include/lps22.h"
+#include "include/sht4x.h"
+
+using qw_units::inHg_sea_level;
+using qw_units::mb_sea_level;
+using qw_units::pressure_base_conversion_factor;
+using qw_units::rh_base_conversion_factor;
+using qw_units::temperature_base_conversion_factor;
+
+namespace qw_devices {
+
+static BatchConversionKernel bestBatchConversionKernel() {
+
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return BATCH_CONVERSION_AVX2;
+  }
+#elif defined(__aarch64__)
+  return BATCH_CONVERSION_NEON;
+#endif
+
+  return BATCH_CONVERSION_SCALAR;
+}
+
+static const BatchConversionKernel best_kernel = bestBatchConversionKernel();
+static BatchConversionKernel batch_kernel = best_kernel;
+
+BatchConversionKernel batchConversionKernel() {
+
+  return batch_kernel;
+}
+
+expected<bool, int> setBatchConversionKernel(BatchConversionKernel kernel) {
+
+  if ((kernel != BATCH_CONVERSION_SCALAR) && (kernel != best_kernel)) {
+    return unexpected(ENOTSUP);
+  }
+
+  batch_kernel = kernel;
+
+  return true;
+}
+
+const char* batchConversionKernelName(BatchConversionKernel kernel) {
+
+  switch (kernel) {
+    case BATCH_CONVERSION_SCALAR:
+      return "scalar";
+    case BATCH_CONVERSION_AVX2:
+      return "avx2";
+    case BATCH_CONVERSION_NEON:
+      return "neon";
+  }
+
+  return "unknown";
+}
+
+/*
+ * The scalar versions. These are the reference, they go through exactly
+ * the same code as a single reading does. They also finish off whatever
+ * is left over after the vector loops.
+ */
+static void sht4xTemperatureToBaseScalar(const uint16_t* raw, int64_t* base,
+                                         size_t count) {
+
+  for (size_t i = 0; i < count; i++) {
+    base[i] = Celsius(sht4xTemperatureCelsius(raw[i])).baseValue();
+  }
+
+  return;
+}
+
+static void sht4xHumidityToBaseScalar(const uint16_t* raw, int64_t* base,
+                                      size_t count) {
+
+  for (size_t i = 0; i < count; i++) {
+    base[i] = RelativeHumidity(sht4xRelativeHumidity(raw[i])).baseValue();
+  }
+
+  return;
+}
+
+static void lps22TemperatureToBaseScalar(const int16_t* raw, int64_t* base,
+                                         size_t count) {
+
+  for (size_t i = 0; i < count; i++) {
+    base[i] = Celsius(lps22TemperatureCelsius(raw[i])).baseValue();
+  }
+
+  return;
+}
+
+static void lps22PressureToBaseScalar(const int32_t* raw, int64_t* base,
+                                      size_t count) {
+
+  for (size_t i = 0; i < count; i++) {
+    base[i] = Millibar(lps22PressureMillibar(raw[i])).baseValue();
+  }
+
+  return;
+}
+
+static void baseToFahrenheitScalar(const int64_t* base, float* fahrenheit,
+                                   size_t count) {
+
+  for (size_t i = 0; i < count; i++) {
+    fahrenheit[i] = Fahrenheit::fromBase(base[i]).value();
+  }
+
+  return;
+}
+
+static void baseToInchesMercuryScalar(const int64_t* base, float* inhg,
+                                      size_t count) {
+
+  for (size_t i = 0; i < count; i++) {
+    inhg[i] = InchesMercury::fromBase(base[i]).value();
+  }
+
+  return;
+}
+
+#if defined(__x86_64__)
+/*
+ * AVX2 versions, 8 values at a time. Each returns how many values it did,
+ * the scalar version does the rest.
+ */
+
+/*
+ * round() is round half away from zero, which AVX doesn't have. Truncate,
+ * then step away from zero if what got cut off was at least a half. Both
+ * the subtract and the add are exact for anything we'll see.
+ */
+__attribute__((target("avx2"))) static inline __m256 roundAwayAvx2(__m256 f) {
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+
+  __m256 truncated = _mm256_round_ps(f, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  __m256 fraction = _mm256_andnot_ps(sign, _mm256_sub_ps(f, truncated));
+  __m256 away = _mm256_or_ps(_mm256_and_ps(f, sign), _mm256_set1_ps(1.0f));
+  __m256 step = _mm256_cmp_ps(fraction, _mm256_set1_ps(0.5f), _CMP_GE_OQ);
+
+  return _mm256_add_ps(truncated, _mm256_and_ps(step, away));
+}
+
+/*
+ * Round, convert to int the way assigning to an int does, and widen to
+ * 8 base values.
+ */
+__attribute__((target("avx2"))) static inline void storeBaseAvx2(int64_t* base,
+                                                                 __m256 f) {
+  __m256i value = _mm256_cvtps_epi32(roundAwayAvx2(f));
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(base),
+                      _mm256_cvtepi32_epi64(_mm256_castsi256_si128(value)));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(base + 4),
+                      _mm256_cvtepi32_epi64(_mm256_extracti128_si256(value, 1)));
+
+  return;
+}
+
+/*
+ * Base values are int64_t, but AVX2 can only make floats out of 32 bit
+ * ints, so take the low 32 bits of 8 base values. Every base a sensor
+ * gives fits in that. Comes back false if one of them didn't, the scalar
+ * version does those.
+ */
+__attribute__((target("avx2"))) static inline bool loadBaseAvx2(
+    const int64_t* base, __m256* f) {
+  const __m256i low_words = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+  __m256i wide_first =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base));
+  __m256i wide_second =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + 4));
+  __m256i first = _mm256_permutevar8x32_epi32(wide_first, low_words);
+  __m256i second = _mm256_permutevar8x32_epi32(wide_second, low_words);
+
+  /*
+   * It fits if sign extending the low word gives back the whole thing
+   */
+  __m256i fits = _mm256_and_si256(
+      _mm256_cmpeq_epi64(
+          _mm256_cvtepi32_epi64(_mm256_castsi256_si128(first)), wide_first),
+      _mm256_cmpeq_epi64(
+          _mm256_cvtepi32_epi64(_mm256_castsi256_si128(second)), wide_second));
+  if (_mm256_movemask_epi8(fits) != -1) {
+    return false;
+  }
+
+  __m256i value =
+      _mm256_inserti128_si256(first, _mm256_castsi256_si128(second), 1);
+  *f = _mm256_cvtepi32_ps(value);
+
+  return true;
+}
+
+__attribute__((target("avx2"))) static size_t sht4xTemperatureToBaseAvx2(
+    const uint16_t* raw, int64_t* base, size_t count) {
+  const __m256 multiplier =
+      _mm256_set1_ps(kSht4xTemperatureCelsiusMultiplier);
+  const __m256 divisor = _mm256_set1_ps(kSht4xTemperatureCelsisusDivisor);
+  const __m256 offset = _mm256_set1_ps(kSht4xTemperatureCelsiusOffset);
+  const __m256 factor = _mm256_set1_ps(temperature_base_conversion_factor);
+  size_t i = 0;
+
+  for (; (i + 8) <= count; i += 8) {
+    __m256 value = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + i))));
+    value = _mm256_sub_ps(
+        _mm256_div_ps(_mm256_mul_ps(multiplier, value), divisor), offset);
+    storeBaseAvx2(base + i, _mm256_mul_ps(value, factor));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t sht4xHumidityToBaseAvx2(
+    const uint16_t* raw, int64_t* base, size_t count) {
+  const __m256 multiplier = _mm256_set1_ps(kSht4xRelativeHumidityMultiplier);
+  const __m256 divisor = _mm256_set1_ps(kSht4xRelativeHumidityDivisor);
+  const __m256 offset = _mm256_set1_ps(kSht4xRelativeHumidityOffset);
+  const __m256 minimum = _mm256_set1_ps(kSht4xHumidityMin);
+  const __m256 maximum = _mm256_set1_ps(kSht4xHumidityMax);
+  const __m256 factor = _mm256_set1_ps(rh_base_conversion_factor);
+  size_t i = 0;
+
+  for (; (i + 8) <= count; i += 8) {
+    __m256 value = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + i))));
+    value = _mm256_sub_ps(
+        _mm256_div_ps(_mm256_mul_ps(multiplier, value), divisor), offset);
+    /*
+     * Same operand order as min(max, max(min, rh)) so ties come out the same
+     */
+    value = _mm256_min_ps(_mm256_max_ps(value, minimum), maximum);
+    storeBaseAvx2(base + i, _mm256_mul_ps(value, factor));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t lps22TemperatureToBaseAvx2(
+    const int16_t* raw, int64_t* base, size_t count) {
+  const __m256 divisor = _mm256_set1_ps(kLps22hbTemperatureFactor);
+  const __m256 factor = _mm256_set1_ps(temperature_base_conversion_factor);
+  size_t i = 0;
+
+  for (; (i + 8) <= count; i += 8) {
+    __m256 value = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + i))));
+    value = _mm256_div_ps(value, divisor);
+    storeBaseAvx2(base + i, _mm256_mul_ps(value, factor));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t lps22PressureToBaseAvx2(
+    const int32_t* raw, int64_t* base, size_t count) {
+  const __m256 divisor = _mm256_set1_ps(kLps22hbPressureHpaFactor);
+  const __m256 factor = _mm256_set1_ps(pressure_base_conversion_factor);
+  size_t i = 0;
+
+  for (; (i + 8) <= count; i += 8) {
+    __m256 value = _mm256_cvtepi32_ps(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(raw + i)));
+    value = _mm256_div_ps(value, divisor);
+    storeBaseAvx2(base + i, _mm256_mul_ps(value, factor));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t baseToFahrenheitAvx2(
+    const int64_t* base, float* fahrenheit, size_t count) {
+  const __m256 factor = _mm256_set1_ps(temperature_base_conversion_factor);
+  const __m256 nine = _mm256_set1_ps(9);
+  const __m256 five = _mm256_set1_ps(5);
+  const __m256 thirty_two = _mm256_set1_ps(32);
+  size_t i = 0;
+
+  for (; (i + 8) <= count; i += 8) {
+    __m256 value;
+    if (loadBaseAvx2(base + i, &value) == false) {
+      break;
+    }
+    value = _mm256_div_ps(value, factor);
+    value = _mm256_add_ps(
+        _mm256_div_ps(_mm256_mul_ps(value, nine), five), thirty_two);
+    _mm256_storeu_ps(fahrenheit + i, value);
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t baseToInchesMercuryAvx2(
+    const int64_t* base, float* inhg, size_t count) {
+  const __m256 factor = _mm256_set1_ps(pressure_base_conversion_factor);
+  const __m256 inhg_sea_level = _mm256_set1_ps(inHg_sea_level);
+  const __m256 millibar_sea_level = _mm256_set1_ps(mb_sea_level);
+  size_t i = 0;
+
+  for (; (i + 8) <= count; i += 8) {
+    __m256 value;
+    if (loadBaseAvx2(base + i, &value) == false) {
+      break;
+    }
+    value = _mm256_div_ps(value, factor);
+    value = _mm256_div_ps(_mm256_mul_ps(value, inhg_sea_level),
+                          millibar_sea_level);
+    _mm256_storeu_ps(inhg + i, value);
+  }
+
+  return i;
+}
+#endif  // __x86_64__
+
+#if defined(__aarch64__)
+/*
+ * NEON versions, 4 values at a time. vrndaq_f32 is round half away from
+ * zero so it matches round() directly.
+ */
+static inline void storeBaseNeon(int64_t* base, float32x4_t f) {
+  int32x4_t value = vcvtq_s32_f32(vrndaq_f32(f));
+
+  vst1q_s64(base, vmovl_s32(vget_low_s32(value)));
+  vst1q_s64(base + 2, vmovl_high_s32(value));
+
+  return;
+}
+
+/*
+ * The low 32 bits of 4 base values, false if one of them doesn't fit in
+ * that, the same as loadBaseAvx2()
+ */
+static inline bool loadBaseNeon(const int64_t* base, float32x4_t* f) {
+  int64x2_t wide_first = vld1q_s64(base);
+  int64x2_t wide_second = vld1q_s64(base + 2);
+  int32x2_t first = vmovn_s64(wide_first);
+  int32x2_t second = vmovn_s64(wide_second);
+
+  uint64x2_t fits = vandq_u64(vceqq_s64(vmovl_s32(first), wide_first),
+                              vceqq_s64(vmovl_s32(second), wide_second));
+  if ((vgetq_lane_u64(fits, 0) & vgetq_lane_u64(fits, 1)) == 0) {
+    return false;
+  }
+
+  *f = vcvtq_f32_s32(vcombine_s32(first, second));
+
+  return true;
+}
+
+static size_t sht4xTemperatureToBaseNeon(const uint16_t* raw, int64_t* base,
+                                         size_t count) {
+  const float32x4_t multiplier =
+      vdupq_n_f32(kSht4xTemperatureCelsiusMultiplier);
+  const float32x4_t divisor = vdupq_n_f32(kSht4xTemperatureCelsisusDivisor);
+  const float32x4_t offset = vdupq_n_f32(kSht4xTemperatureCelsiusOffset);
+  const float32x4_t factor = vdupq_n_f32(temperature_base_conversion_factor);
+  size_t i = 0;
+
+  for (; (i + 4) <= count; i += 4) {
+    float32x4_t value = vcvtq_f32_u32(vmovl_u16(vld1_u16(raw + i)));
+    value = vsubq_f32(vdivq_f32(vmulq_f32(multiplier, value), divisor), offset);
+    storeBaseNeon(base + i, vmulq_f32(value, factor));
+  }
+
+  return i;
+}
+
+static size_t sht4xHumidityToBaseNeon(const uint16_t* raw, int64_t* base,
+                                      size_t count) {
+  const float32x4_t multiplier = vdupq_n_f32(kSht4xRelativeHumidityMultiplier);
+  const float32x4_t divisor = vdupq_n_f32(kSht4xRelativeHumidityDivisor);
+  const float32x4_t offset = vdupq_n_f32(kSht4xRelativeHumidityOffset);
+  const float32x4_t minimum = vdupq_n_f32(kSht4xHumidityMin);
+  const float32x4_t maximum = vdupq_n_f32(kSht4xHumidityMax);
+  const float32x4_t factor = vdupq_n_f32(rh_base_conversion_factor);
+  size_t i = 0;
+
+  for (; (i + 4) <= count; i += 4) {
+    float32x4_t value = vcvtq_f32_u32(vmovl_u16(vld1_u16(raw + i)));
+    value = vsubq_f32(vdivq_f32(vmulq_f32(multiplier, value), divisor), offset);
+    value = vminq_f32(vmaxq_f32(value, minimum), maximum);
+    storeBaseNeon(base + i, vmulq_f32(value, factor));
+  }
+
+  return i;
+}
+
+static size_t lps22TemperatureToBaseNeon(const int16_t* raw, int64_t* base,
+                                         size_t count) {
+  const float32x4_t divisor = vdupq_n_f32(kLps22hbTemperatureFactor);
+  const float32x4_t factor = vdupq_n_f32(temperature_base_conversion_factor);
+  size_t i = 0;
+
+  for (; (i + 4) <= count; i += 4) {
+    float32x4_t value = vcvtq_f32_s32(vmovl_s16(vld1_s16(raw + i)));
+    value = vdivq_f32(value, divisor);
+    storeBaseNeon(base + i, vmulq_f32(value, factor));
+  }
+
+  return i;
+}
+
+static size_t lps22PressureToBaseNeon(const int32_t* raw, int64_t* base,
+                                      size_t count) {
+  const float32x4_t divisor = vdupq_n_f32(kLps22hbPressureHpaFactor);
+  const float32x4_t factor = vdupq_n_f32(pressure_base_conversion_factor);
+  size_t i = 0;
+
+  for (; (i + 4) <= count; i += 4) {
+    float32x4_t value = vcvtq_f32_s32(vld1q_s32(raw + i));
+    value = vdivq_f32(value, divisor);
+    storeBaseNeon(base + i, vmulq_f32(value, factor));
+  }
+
+  return i;
+}
+
+static size_t baseToFahrenheitNeon(const int64_t* base, float* fahrenheit,
+                                   size_t count) {
+  const float32x4_t factor = vdupq_n_f32(temperature_base_conversion_factor);
+  const float32x4_t nine = vdupq_n_f32(9);
+  const float32x4_t five = vdupq_n_f32(5);
+  const float32x4_t thirty_two = vdupq_n_f32(32);
+  size_t i = 0;
+
+  for (; (i + 4) <= count; i += 4) {
+    float32x4_t value;
+    if (loadBaseNeon(base + i, &value) == false) {
+      break;
+    }
+    value = vdivq_f32(value, factor);
+    value = vaddq_f32(vdivq_f32(vmulq_f32(value, nine), five), thirty_two);
+    vst1q_f32(fahrenheit + i, value);
+  }
+
+  return i;
+}
+
+static size_t baseToInchesMercuryNeon(const int64_t* base, float* inhg,
+                                      size_t count) {
+  const float32x4_t factor = vdupq_n_f32(pressure_base_conversion_factor);
+  const float32x4_t inhg_sea_level = vdupq_n_f32(inHg_sea_level);
+  const float32x4_t millibar_sea_level = vdupq_n_f32(mb_sea_level);
+  size_t i = 0;
+
+  for (; (i + 4) <= count; i += 4) {
+    float32x4_t value;
+    if (loadBaseNeon(base + i, &value) == false) {
+      break;
+    }
+    value = vdivq_f32(value, factor);
+    value = vdivq_f32(vmulq_f32(value, inhg_sea_level), millibar_sea_level);
+    vst1q_f32(inhg + i, value);
+  }
+
+  return i;
+}
+#endif  // __aarch64__
+
+/*
+ * Run the selected vector kernel and let the scalar one do the remainder
+ */
+#if defined(__x86_64__)
+#define BATCH_CONVERT(name, in, out, count)               \
+  size_t done = 0;                                        \
+  if (batch_kernel == BATCH_CONVERSION_AVX2) {            \
+    done = name##Avx2(in, out, count);                    \
+  }                                                       \
+  name##Scalar(in + done, out + done, count - done)
+#elif defined(__aarch64__)
+#define BATCH_CONVERT(name, in, out, count)               \
+  size_t done = 0;                                        \
+  if (batch_kernel == BATCH_CONVERSION_NEON) {            \
+    done = name##Neon(in, out, count);                    \
+  }                                                       \
+  name##Scalar(in + done, out + done, count - done)
+#else
+#define BATCH_CONVERT(name, in, out, count) name##Scalar(in, out, count)
+#endif
+
+void sht4xTemperatureToBase(const uint16_t* raw, int64_t* base, size_t count) {
+
+  BATCH_CONVERT(sht4xTemperatureToBase, raw, base, count);
+
+  return;
+}
+
+void sht4xHumidityToBase(const uint16_t* raw, int64_t* base, size_t count) {
+
+  BATCH_CONVERT(sht4xHumidityToBase, raw, base, count);
+
+  return;
+}
+
+void lps22TemperatureToBase(const int16_t* raw, int64_t* base, size_t count) {
+
+  BATCH_CONVERT(lps22TemperatureToBase, raw, base, count);
+
+  return;
+}
+
+void lps22PressureToBase(const int32_t* raw, int64_t* base, size_t count) {
+
+  BATCH_CONVERT(lps22PressureToBase, raw, base, count);
+
+  return;
+}
+
+void baseToFahrenheit(const int64_t* base, float* fahrenheit, size_t count) {
+
+  BATCH_CONVERT(baseToFahrenheit, base, fahrenheit, count);
+
+  return;
+}
+
+void baseToInchesMercury(const int64_t* base, float* inhg, size_t count) {
+
+  BATCH_CONVERT(baseToInchesMercury, base, inhg, count);
+
+  return;
+}
+
+#undef BATCH_CONVERT
+
+/*
+ * Make room at the end of the series, copy in the times and let the
+ * kernel write the base values in place
+ */
+template <typename Raw, typename Series>
+static void appendToSeries(void (*convert)(const Raw*, int64_t*, size_t),
+                           const Raw* raw,
+                           span<const time_point<system_clock>> times,
+                           Series& series) {
+  size_t first = series.extend(times.size());
+
+  std::copy(times.begin(), times.end(), series.times().begin() + first);
+  convert(raw, series.values().data() + first, times.size());
+
+  return;
+}
+
+void sht4xTemperatureToSeries(const uint16_t* raw,
+                              span<const time_point<system_clock>> times,
+                              TemperatureSeries& series) {
+
+  appendToSeries(sht4xTemperatureToBase, raw, times, series);
+
+  return;
+}
+
+void sht4xHumidityToSeries(const uint16_t* raw,
+                           span<const time_point<system_clock>> times,
+                           RelativeHumiditySeries& series) {
+
+  appendToSeries(sht4xHumidityToBase, raw, times, series);
+
+  return;
+}
+
+void lps22TemperatureToSeries(const int16_t* raw,
+                              span<const time_point<system_clock>> times,
+                              TemperatureSeries& series) {
+
+  appendToSeries(lps22TemperatureToBase, raw, times, series);
+
+  return;
+}
+
+void lps22PressureToSeries(const int32_t* raw,
+                           span<const time_point<system_clock>> times,
+                           PressureSeries& series) {
+
+  appendToSeries(lps22PressureToBase, raw, times, series);
+
+  return;
+}
+
+void baseToFahrenheit(TemperatureSeriesView series, float* fahrenheit) {
+
+  baseToFahrenheit(series.values().data(), fahrenheit, series.size());
+
+  return;
+}
+
+void baseToInchesMercury(PressureSeriesView series, float* inhg) {
+
+  baseToInchesMercury(series.values().data(), inhg, series.size());
+
+  return;
+}
+
+}  // Namespace qw_devices
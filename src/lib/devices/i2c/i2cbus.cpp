@@ -20,6 +20,8 @@
 namespace qw_devices {
 
 mutex I2cBus::i2cbus_lock;
+std::atomic<uint64_t> I2cBus::transfers_[i2c_address_count];
+std::atomic<uint64_t> I2cBus::errors_[i2c_address_count];
 
 I2cBus::I2cBus(string bus_device_name) : bus_device_name_(bus_device_name) {
   int i2c_bus, retval;
@@ -60,6 +62,27 @@ I2cBusStatus I2cBus::status() {
   return status_;
 }
 
+I2cTransferCounts I2cBus::transferCounts(uint8_t slave_address) {
+  I2cTransferCounts counts;
+  int index = slave_address % i2c_address_count;
+
+  counts.transfers_ = transfers_[index].load(std::memory_order_relaxed);
+  counts.errors_ = errors_[index].load(std::memory_order_relaxed);
+
+  return counts;
+}
+
+int I2cBus::counted(uint8_t slave_address, int result) {
+  int index = slave_address % i2c_address_count;
+
+  transfers_[index].fetch_add(1, std::memory_order_relaxed);
+  if (result != 0) {
+    errors_[index].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  return result;
+}
+
 int I2cBus::transferDataToRegisters(uint8_t slave_address, uint8_t reg,
                                     uint8_t* buffer, uint8_t count) {
   int retval;
@@ -80,7 +103,7 @@ int I2cBus::transferDataToRegisters(uint8_t slave_address, uint8_t reg,
     /*
      * If the OS open() call fails return the errno it generated
      */
-    return errno;
+    return counted(slave_address, errno);
   }
 
   /*
@@ -109,15 +132,15 @@ int I2cBus::transferDataToRegisters(uint8_t slave_address, uint8_t reg,
       /*
        * If the ioctl() call fails return the corresponding errno
        */
-      return errno;
+      return counted(slave_address, errno);
     }
     /*
      * If it doesn't return -1 or 1 then resturn EIO
      */
-    return EIO;
+    return counted(slave_address, EIO);
   }
 
-  return 0;
+  return counted(slave_address, 0);
 }
 
 int I2cBus::transferDataFromRegisters(uint8_t slave_address, uint8_t reg,
@@ -137,7 +160,7 @@ int I2cBus::transferDataFromRegisters(uint8_t slave_address, uint8_t reg,
     /*
      * If the OS open() call fails return the errno it generated
      */
-    return errno;
+    return counted(slave_address, errno);
   }
 
   /*
@@ -162,10 +185,10 @@ int I2cBus::transferDataFromRegisters(uint8_t slave_address, uint8_t reg,
   retval = ioctl(i2c_bus, I2C_RDWR, &xfer);
   close(i2c_bus);
   if (retval != 2) {
-    return errno;
+    return counted(slave_address, errno);
   }
 
-  return 0;
+  return counted(slave_address, 0);
 }
 
 int I2cBus::writeCommand(uint8_t slave_address, uint8_t* command,
@@ -179,7 +202,7 @@ int I2cBus::writeCommand(uint8_t slave_address, uint8_t* command,
 
   i2c_bus = open(bus_device_name_.c_str(), O_RDWR);
   if (i2c_bus < 0) {
-    return errno;
+    return counted(slave_address, errno);
   }
 
   /*
@@ -196,10 +219,10 @@ int I2cBus::writeCommand(uint8_t slave_address, uint8_t* command,
   retval = ioctl(i2c_bus, I2C_RDWR, &xfer);
   close(i2c_bus);
   if (retval != 1) {
-    return errno;
+    return counted(slave_address, errno);
   }
 
-  return 0;
+  return counted(slave_address, 0);
 }
 
 int I2cBus::readCommandResult(uint8_t slave_address, uint8_t* buffer,
@@ -213,7 +236,7 @@ int I2cBus::readCommandResult(uint8_t slave_address, uint8_t* buffer,
 
   i2c_bus = open(bus_device_name_.c_str(), O_RDWR);
   if (i2c_bus < 0) {
-    return errno;
+    return counted(slave_address, errno);
   }
 
   /*
@@ -230,10 +253,10 @@ int I2cBus::readCommandResult(uint8_t slave_address, uint8_t* buffer,
   retval = ioctl(i2c_bus, I2C_RDWR, &xfer);
   close(i2c_bus);
   if (retval != 1) {
-    return errno;
+    return counted(slave_address, errno);
   }
 
-  return 0;
+  return counted(slave_address, 0);
 }
 
 }  // Namespace qw_devices
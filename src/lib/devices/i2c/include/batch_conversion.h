@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Convert whole arrays of raw sensor values at once, for draining a FIFO or
+ * reprocessing stored raw history.
+ *
+ * The results are bit for bit what the one at a time path produces, that
+ * is the driver formula followed by the unit class constructor, e.g.
+ *   Celsius(sht4xTemperatureCelsius(raw)).baseValue()
+ * The vector kernels do the same single precision operations in the same
+ * order. round() is done as round half away from zero, and the divides are
+ * real divides rather than multiplies by a reciprocal.
+ *
+ * On x86_64 the AVX2 kernels are used if the CPU has AVX2. On aarch64 NEON
+ * is always there. Anything else gets the scalar loops.
+ */
+
+#ifndef LIB_DEVICES_I2C_BATCH_CONVERSION_H_
+#define LIB_DEVICES_I2C_BATCH_CONVERSION_H_
+
+#include <errno.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+
+#include "pressure_measurement.h"
+#include "relative_humidity_measurement.h"
+#include "temperature_measurement.h"
+
+using qw_units::PressureSeries;
+using qw_units::PressureSeriesView;
+using qw_units::RelativeHumiditySeries;
+using qw_units::TemperatureSeries;
+using qw_units::TemperatureSeriesView;
+using std::expected;
+using std::span;
+using std::unexpected;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_devices {
+
+typedef enum {
+  BATCH_CONVERSION_SCALAR,
+  BATCH_CONVERSION_AVX2,
+  BATCH_CONVERSION_NEON
+} BatchConversionKernel;
+
+/*
+ * The kernels the conversions below will use. It starts out as the best
+ * one the machine supports.
+ */
+BatchConversionKernel batchConversionKernel();
+
+/*
+ * Pick the kernels, mostly so the vector results can be checked against
+ * the scalar ones. ENOTSUP if the machine can't run the ones asked for.
+ */
+expected<bool, int> setBatchConversionKernel(BatchConversionKernel kernel);
+
+const char* batchConversionKernelName(BatchConversionKernel kernel);
+
+/*
+ * Raw counts to base values: millicelsius, hundredths of a percent and
+ * milli-millibars. The raw values are as stored by the drivers, the LPS22
+ * ones already sign extended.
+ */
+void sht4xTemperatureToBase(const uint16_t* raw, int64_t* base, size_t count);
+
+void sht4xHumidityToBase(const uint16_t* raw, int64_t* base, size_t count);
+
+void lps22TemperatureToBase(const int16_t* raw, int64_t* base, size_t count);
+
+void lps22PressureToBase(const int32_t* raw, int64_t* base, size_t count);
+
+/*
+ * Base values to what Fahrenheit::value() and InchesMercury::value() return
+ */
+void baseToFahrenheit(const int64_t* base, float* fahrenheit, size_t count);
+
+void baseToInchesMercury(const int64_t* base, float* inhg, size_t count);
+
+/*
+ * The same conversions appending to a series. One raw reading per time,
+ * the kernel writes straight into the series value column.
+ */
+void sht4xTemperatureToSeries(const uint16_t* raw,
+                              span<const time_point<system_clock>> times,
+                              TemperatureSeries& series);
+
+void sht4xHumidityToSeries(const uint16_t* raw,
+                           span<const time_point<system_clock>> times,
+                           RelativeHumiditySeries& series);
+
+void lps22TemperatureToSeries(const int16_t* raw,
+                              span<const time_point<system_clock>> times,
+                              TemperatureSeries& series);
+
+void lps22PressureToSeries(const int32_t* raw,
+                           span<const time_point<system_clock>> times,
+                           PressureSeries& series);
+
+/*
+ * fahrenheit and inhg need room for series.size() values
+ */
+void baseToFahrenheit(TemperatureSeriesView series, float* fahrenheit);
+
+void baseToInchesMercury(PressureSeriesView series, float* inhg);
+
+}  // Namespace qw_devices
+
+#endif  // LIB_DEVICES_I2C_BATCH_CONVERSION_H_
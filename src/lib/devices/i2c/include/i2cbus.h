@@ -11,6 +11,8 @@
 
 #include <i2c/smbus.h>
 #include <linux/i2c-dev.h>
+#include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <string>
 
@@ -31,6 +33,20 @@ enum I2cBusStatus { I2CBUS_STATUS_OK,
  */
 constexpr string i2c_devicename_prefix = "/dev/i2c-";
 
+/*
+ * I2C addresses are 7 bits
+ */
+constexpr int i2c_address_count = 128;
+
+/*
+ * How many transfers have been done with a device and how many of them
+ * failed
+ */
+struct I2cTransferCounts {
+  uint64_t transfers_ = 0;
+  uint64_t errors_ = 0;
+};
+
 class I2cBus {
 
  public:
@@ -75,8 +91,22 @@ class I2cBus {
 
   I2cBusStatus status();
 
+  /*
+   * The transfers done with the device at slave_address. The devices each
+   * have their own copy of the bus, so like the lock these are kept for
+   * the whole process rather than for one copy.
+   */
+  static I2cTransferCounts transferCounts(uint8_t slave_address);
+
  private:
+  /*
+   * Counts the transfer and hands back result, 0 or an errno
+   */
+  static int counted(uint8_t slave_address, int result);
+
   static mutex i2cbus_lock;
+  static std::atomic<uint64_t> transfers_[i2c_address_count];
+  static std::atomic<uint64_t> errors_[i2c_address_count];
 
   string bus_device_name_;
 
@@ -241,6 +241,20 @@ typedef enum {
 constexpr int kLps22hbTemperature2ComplimentXorMask = 1 << 15;
 constexpr int kLps22hbPressure2ComplimentXorMask = 1 << 23;
 
+/*
+ * From the sign extended register values to Celsius and hPa. Shared by the
+ * driver and the batch conversion kernels.
+ */
+inline float lps22TemperatureCelsius(int16_t raw) {
+
+  return static_cast<float>(raw) / kLps22hbTemperatureFactor;
+}
+
+inline float lps22PressureMillibar(int32_t raw) {
+
+  return static_cast<float>(raw) / kLps22hbPressureHpaFactor;
+}
+
 typedef enum { LPS22HB_TEMPERATURE, LPS22HB_PRESSURE } Lps22hbReading_t;
 
 class Lps22DeviceLocation {
@@ -144,6 +144,32 @@ constexpr int kSht4xTemperatureKelvinDivisor = kSht4xTemperatureCelsisusDivisor;
 constexpr float kSht4xTemperatureKelvinOffset =
     kSht4xTemperatureCelsiusOffset + 273.15;
 
+/*
+ * The conversions from the raw ticks to Celsius and %RH, from section 4.6
+ * of the datasheet. The driver and the batch conversion kernels both use
+ * these so they always agree.
+ */
+inline float sht4xTemperatureCelsius(uint16_t raw) {
+
+  return ((kSht4xTemperatureCelsiusMultiplier * static_cast<float>(raw)) /
+          kSht4xTemperatureCelsisusDivisor) -
+         kSht4xTemperatureCelsiusOffset;
+}
+
+inline float sht4xRelativeHumidity(uint16_t raw) {
+
+  float relative_humidity =
+      ((kSht4xRelativeHumidityMultiplier * static_cast<float>(raw)) /
+       kSht4xRelativeHumidityDivisor) -
+      kSht4xRelativeHumidityOffset;
+
+  /*
+   * SHT4x document says:
+   * cropping of the RH signal to the range of 0 %RH … 100 %RH is advised.
+   */
+  return min(kSht4xHumidityMax, max(kSht4xHumidityMin, relative_humidity));
+}
+
 typedef enum {
   SHT4X_MEASUREMENT_PRECISION_HIGH,
   SHT4X_MEASUREMENT_PRECISION_MEDIUM,
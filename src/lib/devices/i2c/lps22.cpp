@@ -460,8 +460,7 @@ expected<TemperatureMeasurement, int> Lps22::getTemperatureMeasurement() {
   /*
    * Perform the conversion from the data sheet gives you degrees in celsius
    */
-  temperature = static_cast<float>(device_data_->temperature_measurement_) /
-                kLps22hbTemperatureFactor;
+  temperature = lps22TemperatureCelsius(device_data_->temperature_measurement_);
 
   /*
    * create a temprature in celsius
@@ -496,8 +495,7 @@ expected<PressureMeasurement, int> Lps22::getPressureMeasurement() {
   /*
    * pressure is measured in hPa which is same as millibar
    */
-  pressure = static_cast<float>(device_data_->pressure_measurement_) /
-             kLps22hbPressureHpaFactor;
+  pressure = lps22PressureMillibar(device_data_->pressure_measurement_);
 
   Millibar mb(pressure);
 
@@ -182,10 +182,7 @@ expected<TemperatureMeasurement, int> I2cSht4x::getTemperatureMeasurement() {
   /*
    * The temprature in Celsius
    */
-  temperature = ((kSht4xTemperatureCelsiusMultiplier *
-                  static_cast<float>(device_data_->temperature_measurement_)) /
-                 kSht4xTemperatureCelsisusDivisor) -
-                kSht4xTemperatureCelsiusOffset;
+  temperature = sht4xTemperatureCelsius(device_data_->temperature_measurement_);
 
   Celsius tempc(temperature);
 
@@ -250,17 +247,7 @@ I2cSht4x::getRelativeHumidityMeasurement() {
   }
 
   relative_humidity =
-      ((kSht4xRelativeHumidityMultiplier *
-        static_cast<float>(device_data_->humidity_measurement_)) /
-       kSht4xRelativeHumidityDivisor) -
-      kSht4xRelativeHumidityOffset;
-
-  /*
-   * SHT4x document says:
-   * cropping of the RH signal to the range of 0 %RH … 100 %RH is advised.
-   */
-  relative_humidity =
-      min(kSht4xHumidityMax, max(kSht4xHumidityMin, relative_humidity));
+      sht4xRelativeHumidity(device_data_->humidity_measurement_);
 
   RelativeHumidity rhdata(relative_humidity);
 
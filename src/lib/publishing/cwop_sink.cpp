@@ -0,0 +1,220 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The CWOP sink
+ */
+#include "include/cwop_sink.h"
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "fahrenheit.h"
+#include "retry_backoff.h"
+
+using qw_units::Fahrenheit;
+using std::chrono::system_clock;
+
+/*
+ * APRS positions are degrees and hundredths of minutes, DDMM.mm for
+ * latitude and DDDMM.mm for longitude. Working in hundredths of minutes
+ * means 59.999 minutes can't come out as 60.00.
+ */
+static string aprsPosition(double degrees, int width, char positive,
+                           char negative) {
+  long hundredths = std::lround(std::fabs(degrees) * 6000.0);
+
+  return fmt::format("{:0{}}{:02}.{:02}{}", hundredths / 6000, width,
+                     (hundredths % 6000) / 100, hundredths % 100,
+                     degrees < 0.0 ? negative : positive);
+}
+
+CwopSink::CwopSink(CwopSinkConfig config) : config_(config) {
+
+  position_ = aprsPosition(std::clamp(config_.latitude_, -90.0, 90.0), 2,
+                           'N', 'S') +
+              "/" +
+              aprsPosition(std::clamp(config_.longitude_, -180.0, 180.0), 3,
+                           'E', 'W') +
+              "_";
+}
+
+string_view CwopSink::name() const {
+
+  return "cwop";
+}
+
+expected<bool, int> CwopSink::publish(const PublishedSample& sample) {
+  steady_clock::time_point now = steady_clock::now();
+
+  if ((sent_any_ == true) && ((now - last_sent_) < config_.min_interval_)) {
+    return false;
+  }
+
+  if (connection_.alive() == false) {
+    if (now < retry_at_) {
+      return unexpected(EAGAIN);
+    }
+    auto x_logged_in = login();
+    if (x_logged_in.has_value() == false) {
+      connection_.close();
+      failed(now);
+      return x_logged_in;
+    }
+  }
+
+  packet(sample);
+  packet_.append("\r\n");
+  auto x_sent = connection_.send(packet_, config_.timeout_);
+  if (x_sent.has_value() == false) {
+    connection_.close();
+    return x_sent;
+  }
+  failures_ = 0;
+  sent_any_ = true;
+  last_sent_ = now;
+
+  return true;
+}
+
+string_view CwopSink::packet(const PublishedSample& sample) {
+  auto out = std::back_inserter(packet_);
+
+  packet_.clear();
+  fmt::format_to(out, "{}>APRS,TCPIP*:@{:%d%H%M}z{}", config_.callsign_,
+                 fmt::gmtime(system_clock::to_time_t(sample.time_)),
+                 position_);
+
+  /*
+   * Wind direction/speed, gust and temperature always have to be there,
+   * dots if we don't know
+   */
+  if (sample.wind_direction_.has_value() == true) {
+    /*
+     * North is 360, 000 reads as no direction
+     */
+    long direction = std::lround(sample.wind_direction_.value()) % 360;
+    fmt::format_to(out, "{:03}", (direction <= 0) ? direction + 360
+                                                   : direction);
+  } else {
+    packet_.append("...");
+  }
+  if (sample.wind_speed_avg_.has_value() == true) {
+    fmt::format_to(out, "/{:03}",
+                   std::clamp<int64_t>(
+                       sample.wind_speed_avg_.value().fixedValue<1>(), 0, 999));
+  } else {
+    packet_.append("/...");
+  }
+  if (sample.wind_gust_.has_value() == true) {
+    fmt::format_to(
+        out, "g{:03}",
+        std::clamp<int64_t>(sample.wind_gust_.value().fixedValue<1>(), 0, 999));
+  } else {
+    packet_.append("g...");
+  }
+
+  /*
+   * Three characters, below zero is -01 to -99. The whole numbers and the
+   * tenths of a millibar are the exact integer conversions from the base,
+   * rounded half away from zero the same above and below zero.
+   */
+  if (sample.temperature_.has_value() == true) {
+    int64_t temperature = std::clamp<int64_t>(
+        Fahrenheit(sample.temperature_.value()).fixedValue<1>(), -99, 999);
+    if (temperature < 0) {
+      fmt::format_to(out, "t-{:02}", -temperature);
+    } else {
+      fmt::format_to(out, "t{:03}", temperature);
+    }
+  } else {
+    packet_.append("t...");
+  }
+
+  /*
+   * Two digits, 100% is 00
+   */
+  if (sample.humidity_.has_value() == true) {
+    int64_t humidity = std::clamp<int64_t>(
+        sample.humidity_.value().fixedValue<1>(), 1, 100);
+    fmt::format_to(out, "h{:02}", humidity % 100);
+  }
+
+  /*
+   * Five digits of tenths of a millibar, at sea level
+   */
+  if (sample.sea_level_pressure_.has_value() == true) {
+    fmt::format_to(out, "b{:05}",
+                   std::clamp<int64_t>(
+                       sample.sea_level_pressure_.value().fixedValue<10>(), 0,
+                       99999));
+  }
+  packet_.append(config_.software_);
+
+  return packet_;
+}
+
+/*
+ * The server says hello first, a line starting with #, and answers the
+ * login with a # logresp line. Anything else that comes in before that is
+ * more # comments.
+ */
+expected<bool, int> CwopSink::login() {
+  uint8_t buffer[512];
+
+  auto x_opened = connection_.open(config_.host_, config_.port_,
+                                   config_.timeout_);
+  if (x_opened.has_value() == false) {
+    return x_opened;
+  }
+
+  string user = fmt::format("user {} pass {} vers {} {}\r\n",
+                            config_.callsign_, config_.passcode_,
+                            config_.software_, config_.version_);
+  auto x_sent = connection_.send(user, config_.timeout_);
+  if (x_sent.has_value() == false) {
+    return x_sent;
+  }
+
+  in_.clear();
+  steady_clock::time_point deadline = steady_clock::now() + config_.timeout_;
+  while (true) {
+    size_t end = in_.find('\n');
+    if (end != string::npos) {
+      string_view line(in_.data(), end);
+      if (line.starts_with("# logresp") == true) {
+        /*
+         * unverified is fine for CWOP, only a bad login is a problem
+         */
+        bool refused = (line.find(" unverified") == string_view::npos) &&
+                       (line.find(" verified") == string_view::npos);
+        in_.clear();
+        if (refused == true) {
+          return unexpected(EACCES);
+        }
+        return true;
+      }
+      in_.erase(0, end + 1);
+      continue;
+    }
+
+    auto x_received = connection_.receive(buffer, deadline);
+    if (x_received.has_value() == false) {
+      return unexpected(x_received.error());
+    }
+    in_.append(reinterpret_cast<char*>(buffer), x_received.value());
+  }
+}
+
+void CwopSink::failed(steady_clock::time_point now) {
+
+  failures_++;
+  retry_at_ =
+      now + retryDelay(failures_, config_.retry_initial_, config_.retry_max_);
+
+  return;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Sends samples to the Citizen Weather Observer Program as APRS weather
+ * packets over APRS-IS.
+ *
+ * APRS-IS is a plain TCP connection. We log in with the callsign and
+ * passcode, CWOP stations that aren't hams use a CW or DW number and a
+ * passcode of -1, and then each report is one line:
+ *
+ *   CW1234>APRS,TCPIP*:@151830z4903.50N/07201.75W_180/004g009t072h45b10132quietwind
+ *
+ * That's the time the sample was taken, the station's position, then
+ * the wind direction, speed and gust in mph, the temperature in
+ * fahrenheit, the humidity and the sea level pressure in tenths of a
+ * millibar. A reading we don't have is dots, or left out where APRS
+ * allows that.
+ *
+ * The connection and the login are kept from one report to the next. If
+ * the server has gone away we log in again, and if that doesn't work we
+ * wait before the next try, retry_initial and twice as long each time
+ * after up to retry_max. CWOP doesn't want reports more often than every
+ * 5 minutes, a sample that comes sooner than min_interval after the last
+ * one that went is skipped, publish() gives false for it.
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_CWOP_SINK_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_CWOP_SINK_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "publisher_sink.h"
+#include "tcp_connection.h"
+
+using std::string;
+using std::string_view;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+constexpr uint16_t cwop_default_port = 14580;
+constexpr milliseconds cwop_default_min_interval = milliseconds(300000);
+constexpr milliseconds cwop_default_retry_initial = milliseconds(30000);
+constexpr milliseconds cwop_default_retry_max = milliseconds(900000);
+
+struct CwopSinkConfig {
+  string host_ = "cwop.aprs.net";
+  uint16_t port_ = cwop_default_port;
+  string callsign_;
+  string passcode_ = "-1";
+  double latitude_ = 0.0;   // degrees, north is positive
+  double longitude_ = 0.0;  // degrees, east is positive
+  string software_ = "quietwind";
+  string version_;
+  milliseconds min_interval_ = cwop_default_min_interval;
+  milliseconds timeout_ = milliseconds(10000);  // connecting and logging in
+  milliseconds retry_initial_ = cwop_default_retry_initial;
+  milliseconds retry_max_ = cwop_default_retry_max;
+};
+
+class CwopSink : public PublisherSink {
+ public:
+  explicit CwopSink(CwopSinkConfig config);
+
+  string_view name() const override;
+
+  /*
+   * EAGAIN while waiting to try logging in again, EACCES if the server
+   * turned the login down, otherwise whatever went wrong with the
+   * connection
+   */
+  expected<bool, int> publish(const PublishedSample& sample) override;
+
+  /*
+   * The APRS packet for sample, without the line end. For testing.
+   */
+  string_view packet(const PublishedSample& sample);
+
+ private:
+  expected<bool, int> login();
+  void failed(steady_clock::time_point now);
+
+  CwopSinkConfig config_;
+  TcpConnection connection_;
+  string position_;  // DDMM.mmN/DDDMM.mmW_
+  string packet_;
+  string in_;
+
+  bool sent_any_ = false;
+  steady_clock::time_point last_sent_;
+  int failures_ = 0;
+  steady_clock::time_point retry_at_;
+};
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_CWOP_SINK_H_
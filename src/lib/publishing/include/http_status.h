@@ -0,0 +1,41 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * What an HTTP status means to a sink, as an errno
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_HTTP_STATUS_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_HTTP_STATUS_H_
+
+#include <errno.h>
+#include <expected>
+
+using std::expected;
+using std::unexpected;
+
+/*
+ * true for a 2xx. EACCES when the credentials were turned down, EAGAIN
+ * when the server wants us to slow down, EPROTO when it didn't like the
+ * request and ECOMM for anything else.
+ */
+inline expected<bool, int> httpStatusResult(long http_status) {
+
+  if ((http_status >= 200) && (http_status < 300)) {
+    return true;
+  }
+  if ((http_status == 401) || (http_status == 403)) {
+    return unexpected(EACCES);
+  }
+  if (http_status == 429) {
+    return unexpected(EAGAIN);
+  }
+  if ((http_status >= 400) && (http_status < 500)) {
+    return unexpected(EPROTO);
+  }
+
+  return unexpected(ECOMM);
+}
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_HTTP_STATUS_H_
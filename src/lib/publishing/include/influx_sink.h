@@ -0,0 +1,202 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Writes samples to InfluxDB in line protocol.
+ *
+ * Every sample is one line, the measurement, the station tag, every
+ * reading there is as a field and the time the sample was taken in
+ * nanoseconds:
+ *
+ *   weather,station=home temperature=21.37,humidity=55.2 1718000000000000000
+ *
+ * The lines are put together with formatFixed() and to_chars() in a
+ * buffer that is kept from one batch to the next, so once it has grown
+ * big enough a sample doesn't allocate anything.
+ *
+ * Lines are gathered up into a batch and the batch is written when it
+ * has batch_points lines in it, or once it has been open for
+ * batch_interval whether another sample has come in or not, the
+ * publisher thread calls idle() for that. The batch is gzipped and
+ * POSTed to url with a curl handle that is kept, so the connection stays
+ * open from one batch to the next. url is the whole write URL, for
+ * InfluxDB 2
+ * something like
+ *
+ *   http://influx:8086/api/v2/write?org=home&bucket=weather
+ *
+ * with the token in token, or for InfluxDB 1
+ *
+ *   http://influx:8086/write?db=weather
+ *
+ * A batch that can't be written is spilled, gzipped, to a file in
+ * spill_directory and the next tries wait, twice as long each time up to
+ * retry_max. New batches get spilled while we are waiting. Once a write
+ * works again the spilled batches go too, oldest first, a few with each
+ * new batch. The spill directory only holds spill_max_bytes, past that
+ * the oldest batches are dropped. A batch the server says is bad is
+ * dropped, not spilled, it would never go. A batch that can't be spilled
+ * either, the disk is full or there is no spill directory, is kept and
+ * the next samples go on the end of it until it can go somewhere. Only
+ * once it has grown to influx_kept_batch_limit times batch_points is it
+ * dropped.
+ *
+ * The sink runs on the publisher's thread for it so none of this holds
+ * up sampling.
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_INFLUX_SINK_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_INFLUX_SINK_H_
+
+#include <curl/curl.h>
+#include <zlib.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "publisher_sink.h"
+
+using std::deque;
+using std::string;
+using std::string_view;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+constexpr size_t influx_default_batch_points = 500;
+constexpr milliseconds influx_default_batch_interval = milliseconds(10000);
+constexpr uint64_t influx_default_spill_max_bytes = 64 * 1024 * 1024;
+constexpr size_t influx_default_spill_drain = 8;  // batches per write
+constexpr milliseconds influx_default_retry_initial = milliseconds(5000);
+constexpr milliseconds influx_default_retry_max = milliseconds(300000);
+constexpr size_t influx_kept_batch_limit = 10;
+
+constexpr long influx_connect_timeout = 10000;   // milliseconds
+constexpr long influx_transfer_timeout = 30000;  // milliseconds, total
+
+struct InfluxSinkConfig {
+  string url_;
+  string token_;  // no Authorization header if empty
+  string measurement_ = "weather";
+  string station_;  // no station tag if empty
+  size_t batch_points_ = influx_default_batch_points;
+  milliseconds batch_interval_ = influx_default_batch_interval;
+  bool gzip_ = true;
+  std::filesystem::path spill_directory_;  // nowhere to spill if empty
+  uint64_t spill_max_bytes_ = influx_default_spill_max_bytes;
+  size_t spill_drain_ = influx_default_spill_drain;
+  milliseconds retry_initial_ = influx_default_retry_initial;
+  milliseconds retry_max_ = influx_default_retry_max;
+};
+
+/*
+ * How the writes are going. Only good on the thread that publishes.
+ */
+struct InfluxSinkStatistics {
+  uint64_t points_ = 0;
+  uint64_t batches_ = 0;     // finished, whether they went or not
+  uint64_t posts_ = 0;       // writes that worked, spilled ones included
+  uint64_t failed_ = 0;      // writes that didn't work
+  uint64_t spilled_ = 0;     // batches put in the spill directory
+  uint64_t dropped_ = 0;     // batches that went nowhere
+  uint64_t line_bytes_ = 0;  // line protocol that was put in batches
+  uint64_t sent_bytes_ = 0;  // what actually went, gzipped
+  size_t spill_depth_ = 0;   // batches waiting in the spill directory
+  uint64_t spill_bytes_ = 0;
+};
+
+class InfluxSink : public PublisherSink {
+ public:
+  explicit InfluxSink(InfluxSinkConfig config);
+
+  /*
+   * Whatever is in the batch gets spilled, or written if there's no
+   * spill directory
+   */
+  ~InfluxSink() override;
+
+  InfluxSink(const InfluxSink&) = delete;
+  InfluxSink& operator=(const InfluxSink&) = delete;
+
+  string_view name() const override;
+
+  /*
+   * Adds the sample to the batch and writes the batch if it's time.
+   * Comes back true if the batch went, was spilled or was kept for the
+   * next try, it's only an error if it had to be dropped.
+   */
+  expected<bool, int> publish(const PublishedSample& sample) override;
+
+  /*
+   * When the batch has been open for batch_interval, or when the next
+   * try is due for one that was kept
+   */
+  steady_clock::time_point idleAt() const override;
+
+  /*
+   * The batch has waited long enough, write it
+   */
+  void idle() override;
+
+  /*
+   * Write the batch now, whatever is in it. The batch is only cleared
+   * once it has gone, been spilled or been given up on.
+   */
+  expected<bool, int> flush();
+
+  InfluxSinkStatistics statistics() const;
+
+ private:
+  struct SpillFile {
+    std::filesystem::path path_;
+    uint64_t size_;
+    bool gzipped_;
+  };
+
+  void appendLine(const PublishedSample& sample);
+
+  /*
+   * Leaves body_ pointing at what is to be POSTed, batch_ itself or the
+   * gzipped copy of it in compressed_
+   */
+  expected<bool, int> compress();
+
+  expected<bool, int> post(string_view body, bool gzipped);
+
+  expected<bool, int> spill(string_view body, bool gzipped);
+  void openSpillDirectory();
+  void drainSpill();
+  void dropOldestSpill();
+
+  void failed(steady_clock::time_point now);
+
+  InfluxSinkConfig config_;
+  string line_prefix_;  // measurement and tags, escaped
+
+  string batch_;
+  size_t batch_lines_ = 0;
+  steady_clock::time_point batch_started_;
+  string compressed_;
+  string_view body_;
+  z_stream zstream_ = {};
+  bool zstream_ready_ = false;
+
+  CURL* curl_ = nullptr;
+  struct curl_slist* headers_ = nullptr;
+  struct curl_slist* gzip_headers_ = nullptr;
+  string response_;
+  string spilled_body_;
+
+  deque<SpillFile> spill_files_;
+  uint32_t spill_sequence_ = 0;
+
+  int failures_ = 0;
+  steady_clock::time_point retry_at_;
+
+  InfluxSinkStatistics statistics_;
+};
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_INFLUX_SINK_H_
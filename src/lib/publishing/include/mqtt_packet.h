@@ -0,0 +1,142 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Just enough MQTT 3.1.1 to publish.
+ *
+ * The packets get appended onto the end of a buffer so a whole batch of
+ * them can be built in one buffer that is kept around and sent with one
+ * write. Nothing here does any I/O.
+ *
+ * Every packet starts with a fixed header, a byte with the packet type
+ * in the top 4 bits and some flags in the bottom 4, then the length of
+ * the rest of the packet, 7 bits a byte with the top bit set on every
+ * byte but the last.
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_MQTT_PACKET_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_MQTT_PACKET_H_
+
+#include <errno.h>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <string_view>
+
+using std::expected;
+using std::span;
+using std::string;
+using std::string_view;
+using std::unexpected;
+
+enum MqttPacketType : uint8_t {
+  MQTT_CONNECT = 1,
+  MQTT_CONNACK = 2,
+  MQTT_PUBLISH = 3,
+  MQTT_PUBACK = 4,
+  MQTT_SUBSCRIBE = 8,
+  MQTT_SUBACK = 9,
+  MQTT_PINGREQ = 12,
+  MQTT_PINGRESP = 13,
+  MQTT_DISCONNECT = 14,
+};
+
+/*
+ * The flags in the PUBLISH fixed header
+ */
+constexpr uint8_t mqtt_publish_retain = 0x01;
+constexpr uint8_t mqtt_publish_qos1 = 0x02;
+constexpr uint8_t mqtt_publish_dup = 0x08;
+
+/*
+ * The return codes in a CONNACK
+ */
+constexpr uint8_t mqtt_connack_accepted = 0;
+constexpr uint8_t mqtt_connack_bad_protocol = 1;
+constexpr uint8_t mqtt_connack_bad_client_id = 2;
+constexpr uint8_t mqtt_connack_unavailable = 3;
+constexpr uint8_t mqtt_connack_bad_credentials = 4;
+constexpr uint8_t mqtt_connack_not_authorized = 5;
+
+/*
+ * The remaining length can't be more than 4 bytes of 7 bits
+ */
+constexpr size_t mqtt_max_remaining_length = 268435455;
+
+struct MqttConnectOptions {
+  string_view client_id_;
+  string_view username_;  // not sent if empty
+  string_view password_;  // not sent if empty
+  uint16_t keepalive_ = 60;  // seconds
+  bool clean_session_ = false;
+
+  /*
+   * What the broker publishes for us if we go away without saying
+   * goodbye. Not sent if will_topic is empty.
+   */
+  string_view will_topic_;
+  string_view will_message_;
+  bool will_retain_ = false;
+};
+
+/*
+ * A packet found at the front of a buffer. body is everything after the
+ * fixed header, size is the whole packet, fixed header and all.
+ */
+struct MqttPacket {
+  MqttPacketType type_;
+  uint8_t flags_;
+  span<const uint8_t> body_;
+  size_t size_;
+};
+
+void mqttAppendConnect(string& buffer, const MqttConnectOptions& options);
+
+/*
+ * A QoS 1 publish if packet_id isn't 0, QoS 0 if it is
+ */
+void mqttAppendPublish(string& buffer, string_view topic, string_view payload,
+                       uint16_t packet_id, bool retain);
+
+/*
+ * The ones that are only ever a fixed header and maybe a packet id
+ */
+void mqttAppendConnack(string& buffer, bool session_present,
+                       uint8_t return_code);
+void mqttAppendPuback(string& buffer, uint16_t packet_id);
+void mqttAppendPingreq(string& buffer);
+void mqttAppendPingresp(string& buffer);
+void mqttAppendDisconnect(string& buffer);
+
+/*
+ * A SUBSCRIBE for one topic filter at QoS 0, and a SUBACK granting QoS 0
+ * to each of filters. The station never subscribes, these are for the
+ * tools that check what it published.
+ */
+void mqttAppendSubscribe(string& buffer, uint16_t packet_id,
+                         string_view topic_filter);
+void mqttAppendSuback(string& buffer, uint16_t packet_id, size_t filters);
+
+/*
+ * Find the packet at the front of data. EAGAIN if all of it isn't there
+ * yet, EPROTO if the length is bad.
+ */
+expected<MqttPacket, int> mqttParsePacket(span<const uint8_t> data);
+
+/*
+ * The 2 byte length and then the string, the way strings are in MQTT.
+ * Returns how much of data it took, EPROTO if the string runs off the
+ * end of it.
+ */
+expected<size_t, int> mqttParseString(span<const uint8_t> data,
+                                      string_view& value);
+
+/*
+ * The packet id at the front of a PUBACK's body, or the one after the
+ * topic in a QoS 1 PUBLISH
+ */
+expected<uint16_t, int> mqttParsePacketId(span<const uint8_t> data);
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_MQTT_PACKET_H_
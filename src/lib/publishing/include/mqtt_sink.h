@@ -0,0 +1,160 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Publishes samples to an MQTT broker, for Home Assistant and the like.
+ *
+ * There is one TCP connection to the broker and it stays open from one
+ * sample to the next. It is opened with a persistent session, clean
+ * session off, so the broker hangs on to our session if we drop off for
+ * a bit. If the connection has gone away it is opened again on the next
+ * sample. Any PUBLISH the broker hadn't acked when it went away is sent
+ * again first, once, with DUP set and the packet id it had before, so
+ * the broker can tell it is one it may have already seen.
+ *
+ * Each reading goes to a retained topic of its own under topic_prefix,
+ * quietwind/temperature and so on, so anybody who subscribes gets the
+ * latest straight away. They all go at QoS 1 but not one at a time. The
+ * PUBLISH packets for a whole sample are built into one buffer, sent
+ * with one write, and then the PUBACKs are collected as they come back.
+ * The sample is done when every one of them has been acked, it fails if
+ * they haven't all come back in ack_timeout.
+ *
+ * The first time a reading shows up its Home Assistant discovery config
+ * goes in the same batch, retained under discovery_prefix, so Home
+ * Assistant finds the sensors by itself. That happens once per reading
+ * each time we start. Readings the station doesn't have never show up so
+ * they never get a sensor.
+ *
+ * topic_prefix/status is "online" while we are connected. The broker
+ * sets it to "offline" for us if the connection goes away without a
+ * DISCONNECT.
+ *
+ * When nothing has been sent for half the keepalive a PINGREQ goes, so
+ * the broker doesn't hang up on us when the samples are further apart
+ * than the keepalive. If the PINGRESP doesn't come back in ack_timeout
+ * the connection is closed and opened again on the next sample.
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_MQTT_SINK_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_MQTT_SINK_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mqtt_packet.h"
+#include "publisher_sink.h"
+#include "tcp_connection.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+constexpr uint16_t mqtt_default_port = 1883;
+
+struct MqttSinkConfig {
+  string host_ = "localhost";
+  uint16_t port_ = mqtt_default_port;
+  string client_id_ = "quietwind";
+  string username_;  // none if empty
+  string password_;
+  string topic_prefix_ = "quietwind";
+  string discovery_prefix_ = "homeassistant";  // no discovery if empty
+  string device_name_ = "Quietwind Weather Station";
+  seconds keepalive_ = seconds(60);
+  milliseconds connect_timeout_ = milliseconds(5000);
+  milliseconds ack_timeout_ = milliseconds(5000);
+};
+
+class MqttSink : public PublisherSink {
+ public:
+  explicit MqttSink(MqttSinkConfig config);
+
+  /*
+   * If we are connected status gets set to "offline" and we say goodbye.
+   * The broker only publishes the will when we don't.
+   */
+  ~MqttSink() override;
+
+  MqttSink(const MqttSink&) = delete;
+  MqttSink& operator=(const MqttSink&) = delete;
+
+  string_view name() const override;
+
+  /*
+   * ECONNREFUSED and friends if the broker can't be reached, EACCES if it
+   * turned down the credentials, EPROTO if it said something we didn't
+   * expect and ETIMEDOUT if the acks didn't all come back. The connection
+   * is closed after any of them so the next try starts clean.
+   */
+  expected<bool, int> publish(const PublishedSample& sample) override;
+
+  /*
+   * Half the keepalive after the last thing we sent, while connected
+   */
+  steady_clock::time_point idleAt() const override;
+
+  /*
+   * Ping the broker
+   */
+  void idle() override;
+
+ private:
+  expected<bool, int> connect();
+
+  /*
+   * Closes the connection. Whatever in out_ is still waiting on a PUBACK
+   * is kept in resend_ first.
+   */
+  void close();
+  void keepUnacked();
+
+  /*
+   * Write all of out_, then wait for a PUBACK for every one of pending_
+   */
+  expected<bool, int> send();
+  expected<bool, int> waitForAcks();
+  expected<bool, int> waitForPingresp();
+
+  /*
+   * Whatever the broker has sent next goes on the end of in_
+   */
+  expected<bool, int> receive(steady_clock::time_point deadline);
+
+  uint16_t nextPacketId();
+
+  MqttSinkConfig config_;
+  TcpConnection connection_;
+  uint16_t packet_id_ = 0;
+  steady_clock::time_point last_sent_;
+
+  string status_topic_;
+  vector<string> state_topics_;      // one for each reading
+  vector<string> discovery_topics_;
+  vector<string> discovery_configs_;
+  uint32_t discovered_ = 0;  // a bit for each reading
+
+  /*
+   * Kept from one sample to the next so a batch doesn't allocate once
+   * they have grown big enough
+   */
+  string out_;
+  vector<uint8_t> in_;
+  vector<uint16_t> pending_;  // packet ids waiting on a PUBACK
+
+  /*
+   * The PUBLISH packets that weren't acked before the connection went
+   * away, DUP already set, and their packet ids
+   */
+  string resend_;
+  vector<uint16_t> resend_ids_;
+};
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_MQTT_SINK_H_
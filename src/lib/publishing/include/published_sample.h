@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * One sample of the weather, ready to go to wherever it gets published.
+ *
+ * Every destination wants the same readings in its own units, Weather
+ * Underground and PWSweather want fahrenheit and inches of mercury, Windy
+ * wants celsius and pascals, CWOP wants whole degrees and tenths of a
+ * millibar. The readings are kept as unit values and every sink converts
+ * them to what it wants. All the units of a dimension share one base, so
+ * Fahrenheit(sample.temperature_.value()) costs nothing until value() or
+ * fixedValue() is asked for. It is handed around as a shared_ptr to const
+ * so nobody can change it under somebody else and it goes away when the
+ * last sink is done with it.
+ *
+ * A reading that wasn't there, a sensor that failed or one the station
+ * doesn't have, is left empty.
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_PUBLISHED_SAMPLE_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_PUBLISHED_SAMPLE_H_
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include "celsius.h"
+#include "miles_per_hour.h"
+#include "millibar.h"
+#include "relative_humidity.h"
+
+using qw_units::Celsius;
+using qw_units::MilesPerHour;
+using qw_units::Millibar;
+using qw_units::RelativeHumidity;
+using std::optional;
+using std::shared_ptr;
+using std::chrono::system_clock;
+
+struct PublishedSample {
+  system_clock::time_point time_;
+
+  optional<Celsius> temperature_;
+  optional<Celsius> temperature2_;  // the pressure sensor's temperature
+  optional<RelativeHumidity> humidity_;
+  optional<Celsius> dewpoint_;
+
+  /*
+   * Station pressure, what the sensor reads where it is
+   */
+  optional<Millibar> pressure_;
+
+  /*
+   * Reduced to sea level with the station altitude
+   */
+  optional<Millibar> sea_level_pressure_;
+
+  optional<MilesPerHour> wind_speed_;  // latest
+  optional<MilesPerHour> wind_speed_avg_;
+  optional<float> wind_direction_;     // average, degrees
+  optional<MilesPerHour> wind_gust_;   // peak over the gust window
+
+  /*
+   * The Zambretti forecast number, 1 through 32, once there is enough
+   * pressure history for one
+   */
+  optional<int> forecast_;
+};
+
+using SharedSample = shared_ptr<const PublishedSample>;
+
+/*
+ * A reading as a float in Unit, empty if it isn't there.
+ * valueIn<Fahrenheit>(sample.temperature_) is the temperature in
+ * fahrenheit. The wind direction has no unit class, it is degrees with a
+ * Unit of float.
+ */
+template <typename Unit, typename Reading>
+constexpr optional<float> valueIn(const optional<Reading>& reading) {
+
+  if (reading.has_value() == false) {
+    return std::nullopt;
+  }
+  if constexpr (std::is_floating_point_v<Unit> == true) {
+    return static_cast<float>(reading.value());
+  } else {
+    return Unit(reading.value()).value();
+  }
+}
+
+/*
+ * The same for a member of the sample, for the sinks that keep a table of
+ * the readings they send
+ */
+template <typename Unit, auto Member>
+optional<float> sampleValue(const PublishedSample& sample) {
+
+  return valueIn<Unit>(sample.*Member);
+}
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_PUBLISHED_SAMPLE_H_
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Hands every sample to every sink.
+ *
+ * Each sink gets added once and gets a thread and a queue of its own.
+ * publish() puts the sample on every sink's queue and comes straight
+ * back, it never waits on a sink. Each thread takes samples off its queue
+ * oldest first and gives them to its sink.
+ *
+ * When a sink fails the sample is tried again, after retry_initial and
+ * twice as long each time after that up to retry_max. After max_attempts
+ * it is given up on, or right away if the sink says it never will go.
+ * While one sink is failing or slow its queue fills up and the others
+ * carry on. A queue only holds queue_capacity samples, past that the
+ * oldest waiting one is dropped, so a sink that is down for a long time
+ * only ever has the newest samples waiting.
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_PUBLISHER_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_PUBLISHER_H_
+
+#include <errno.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "published_sample.h"
+#include "publisher_sink.h"
+
+using std::deque;
+using std::expected;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::unexpected;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+constexpr size_t publisher_default_queue_capacity = 64;
+constexpr milliseconds publisher_default_retry_initial = milliseconds(5000);
+constexpr milliseconds publisher_default_retry_max = milliseconds(300000);
+constexpr int publisher_default_max_attempts = 10;
+
+struct PublisherSinkConfig {
+  size_t queue_capacity_ = publisher_default_queue_capacity;
+  milliseconds retry_initial_ = publisher_default_retry_initial;
+  milliseconds retry_max_ = publisher_default_retry_max;
+  int max_attempts_ = publisher_default_max_attempts;  // 0 for no limit
+};
+
+/*
+ * How a sink is getting on
+ */
+struct PublisherSinkStatistics {
+  string name_;
+  size_t depth_ = 0;        // samples waiting
+  uint64_t published_ = 0;  // went
+  uint64_t skipped_ = 0;    // the sink passed on it
+  uint64_t retries_ = 0;    // tries that failed and were tried again
+  uint64_t failed_ = 0;     // given up on, turned down or max_attempts
+  uint64_t dropped_ = 0;    // pushed out of a full queue
+  int last_error_ = 0;
+  microseconds last_latency_{0};  // from publish() to the sink being done
+};
+
+class Publisher {
+ public:
+  Publisher();
+
+  /*
+   * Stops the threads. A sample that is being sent is finished, what is
+   * still waiting is dropped.
+   */
+  ~Publisher();
+
+  Publisher(const Publisher&) = delete;
+  Publisher& operator=(const Publisher&) = delete;
+
+  /*
+   * Add a sink and start its thread. EEXIST if there is already one with
+   * the same name.
+   */
+  expected<bool, int> addSink(unique_ptr<PublisherSink> sink,
+                              PublisherSinkConfig config);
+
+  /*
+   * Give sample to every sink
+   */
+  void publish(SharedSample sample);
+
+  size_t sinkCount() const;
+
+  vector<PublisherSinkStatistics> statistics() const;
+
+ private:
+  struct Queued {
+    SharedSample sample_;
+    std::chrono::steady_clock::time_point queued_;
+  };
+
+  struct SinkWorker {
+    unique_ptr<PublisherSink> sink_;
+    PublisherSinkConfig config_;
+    mutable mutex lock_;
+    std::condition_variable_any wake_;
+    deque<Queued> queue_;
+    PublisherSinkStatistics statistics_;
+    std::jthread thread_;
+  };
+
+  vector<unique_ptr<SinkWorker>> workers_;
+
+  static void run(std::stop_token stop, SinkWorker* worker);
+};
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_PUBLISHER_H_
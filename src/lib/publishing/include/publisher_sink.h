@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Somewhere samples get published to.
+ *
+ * A sink turns a sample into whatever its destination wants and sends it.
+ * publish() is called on the sink's own thread, one sample at a time, so
+ * it can take as long as it needs and block on the network without
+ * holding anybody else up. It doesn't retry on its own, an error back
+ * from publish() means the Publisher tries the same sample again later.
+ * Except for EACCES, the credentials were turned down, and EPROTO, the
+ * destination won't take what it was sent. Those would only fail again,
+ * so the Publisher gives up on the sample straight away.
+ *
+ * A sink is only used from its own thread once it has been added to the
+ * Publisher.
+ *
+ * A sink that has work of its own to do between samples, a batch to
+ * write when it has been waiting long enough, says when with idleAt() and
+ * gets idle() called then if no sample has come in first.
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_PUBLISHER_SINK_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_PUBLISHER_SINK_H_
+
+#include <errno.h>
+#include <chrono>
+#include <expected>
+#include <string_view>
+
+#include "published_sample.h"
+
+using std::expected;
+using std::string_view;
+using std::unexpected;
+using std::chrono::steady_clock;
+
+/*
+ * An error back from publish() that trying again won't fix
+ */
+inline bool publishErrorIsPermanent(int error) {
+
+  return (error == EACCES) || (error == EPROTO);
+}
+
+class PublisherSink {
+ public:
+  virtual ~PublisherSink() = default;
+
+  /*
+   * For the log and the statistics, and it has to be different from the
+   * other sinks
+   */
+  virtual string_view name() const = 0;
+
+  /*
+   * Send one sample. true if it went, false if the sink passed on it on
+   * purpose, an errno if it didn't go.
+   */
+  virtual expected<bool, int> publish(const PublishedSample& sample) = 0;
+
+  /*
+   * When idle() wants calling if there is no sample before then. Never,
+   * unless the sink says otherwise.
+   */
+  virtual steady_clock::time_point idleAt() const {
+
+    return steady_clock::time_point::max();
+  }
+
+  virtual void idle() {
+
+    return;
+  }
+};
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_PUBLISHER_SINK_H_
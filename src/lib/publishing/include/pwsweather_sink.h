@@ -0,0 +1,48 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Publishes samples to PWSweather.
+ *
+ * PWSweather takes the same fields as Weather Underground, in the same
+ * units, with the station ID and its API key as PASSWORD. dateutc is the
+ * time the sample was taken so a sample that had to wait still lands at
+ * the right time.
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_PWSWEATHER_SINK_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_PWSWEATHER_SINK_H_
+
+#include <string>
+#include <string_view>
+
+#include "include/wu_connection.h"
+#include "include/wu_url_builder.h"
+#include "publisher_sink.h"
+
+using std::string;
+using std::string_view;
+
+const string pwsweather_url =
+    "https://pwsupdate.pwsweather.com/api/v1/submitwx";
+
+class PwsWeatherSink : public PublisherSink {
+ public:
+  PwsWeatherSink(string station_id, string api_key,
+                 string url = pwsweather_url);
+
+  string_view name() const override;
+
+  expected<bool, int> publish(const PublishedSample& sample) override;
+
+ private:
+  string station_id_;
+  string api_key_;
+  string url_;
+  WuConnection connection_;
+  WuUrlBuilder request_;
+  string response_;
+};
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_PWSWEATHER_SINK_H_
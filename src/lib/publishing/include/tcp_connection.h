@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * A TCP connection that is kept open from one sample to the next, for
+ * the sinks that talk their own protocol over TCP rather than HTTP.
+ *
+ * The socket doesn't block so nothing waits longer than it is told to,
+ * not connecting, sending or waiting for an answer. A server that has
+ * hung up on us between samples only shows up as the socket being
+ * readable and then reading nothing, alive() looks for that before a
+ * sample goes so it doesn't get written into a dead connection.
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_TCP_CONNECTION_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_TCP_CONNECTION_H_
+
+#include <errno.h>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <string_view>
+
+using std::expected;
+using std::span;
+using std::string;
+using std::string_view;
+using std::unexpected;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+class TcpConnection {
+ public:
+  TcpConnection();
+  ~TcpConnection();
+
+  TcpConnection(const TcpConnection&) = delete;
+  TcpConnection& operator=(const TcpConnection&) = delete;
+
+  /*
+   * Try each address host has in turn, giving each one timeout. Nagle is
+   * turned off, everything we send is sent in one go anyway.
+   */
+  expected<bool, int> open(const string& host, uint16_t port,
+                           milliseconds timeout);
+
+  void close();
+
+  bool isOpen() const;
+
+  /*
+   * Throws away anything the server has sent that nobody asked for. false,
+   * and the connection closed, if it has gone away.
+   */
+  bool alive();
+
+  /*
+   * All of data, or an error
+   */
+  expected<bool, int> send(string_view data, milliseconds timeout);
+
+  /*
+   * Whatever has come in, up to the size of buffer, waiting until
+   * deadline for something to. ECONNRESET if the server hung up,
+   * ETIMEDOUT if nothing came.
+   */
+  expected<size_t, int> receive(span<uint8_t> buffer,
+                                steady_clock::time_point deadline);
+
+ private:
+  expected<bool, int> waitFor(short events, milliseconds timeout);
+
+  int fd_ = -1;
+};
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_TCP_CONNECTION_H_
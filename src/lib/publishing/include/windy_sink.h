@@ -0,0 +1,44 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Publishes samples to Windy.
+ *
+ * Windy wants metric, celsius, pascals and meters per second, with the
+ * API key in the path and the time the sample was taken as a unix time.
+ * station is the station's number under that key, 0 for the first one.
+ */
+
+#ifndef SRC_LIB_PUBLISHING_INCLUDE_WINDY_SINK_H_
+#define SRC_LIB_PUBLISHING_INCLUDE_WINDY_SINK_H_
+
+#include <string>
+#include <string_view>
+
+#include "include/wu_connection.h"
+#include "include/wu_url_builder.h"
+#include "publisher_sink.h"
+
+using std::string;
+using std::string_view;
+
+const string windy_url = "https://stations.windy.com/pws/update/";
+
+class WindySink : public PublisherSink {
+ public:
+  WindySink(string api_key, int station = 0, string url = windy_url);
+
+  string_view name() const override;
+
+  expected<bool, int> publish(const PublishedSample& sample) override;
+
+ private:
+  string base_url_;  // url with the key on the end
+  string station_;
+  WuConnection connection_;
+  WuUrlBuilder request_;
+  string response_;
+};
+
+#endif  // SRC_LIB_PUBLISHING_INCLUDE_WINDY_SINK_H_
@@ -0,0 +1,504 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The InfluxDB sink
+ */
+#include "include/influx_sink.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <system_error>
+#include <vector>
+
+#include "atomic_file.h"
+#include "fixed_format.h"
+#include "include/http_status.h"
+#include "retry_backoff.h"
+
+using qw_units::MetersPerSecond;
+using std::optional;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::system_clock;
+
+constexpr string_view influx_spill_extension = ".lp";
+constexpr string_view influx_spill_gzip_extension = ".lp.gz";
+
+/*
+ * The readings that get written and their field names. Everything goes
+ * in metric.
+ */
+struct InfluxField {
+  const char* name_;
+  optional<float> (*value_)(const PublishedSample& sample);
+  int precision_;
+};
+
+static const InfluxField influx_fields[] = {
+    {"temperature", sampleValue<Celsius, &PublishedSample::temperature_>, 2},
+    {"temperature2", sampleValue<Celsius, &PublishedSample::temperature2_>,
+     2},
+    {"humidity", sampleValue<RelativeHumidity, &PublishedSample::humidity_>,
+     1},
+    {"dewpoint", sampleValue<Celsius, &PublishedSample::dewpoint_>, 2},
+    {"pressure", sampleValue<Millibar, &PublishedSample::pressure_>, 2},
+    {"sea_level_pressure",
+     sampleValue<Millibar, &PublishedSample::sea_level_pressure_>, 2},
+    {"wind_speed",
+     sampleValue<MetersPerSecond, &PublishedSample::wind_speed_avg_>, 1},
+    {"wind_direction", sampleValue<float, &PublishedSample::wind_direction_>,
+     0},
+    {"wind_gust", sampleValue<MetersPerSecond, &PublishedSample::wind_gust_>,
+     1},
+};
+
+/*
+ * Commas and spaces have to be escaped in a measurement, and equals
+ * signs as well in tag keys and values
+ */
+static void appendEscaped(string& line, string_view value, bool tag) {
+
+  for (char c : value) {
+    if ((c == ',') || (c == ' ') || ((tag == true) && (c == '='))) {
+      line.push_back('\\');
+    }
+    line.push_back(c);
+  }
+
+  return;
+}
+
+/*
+ * curl hands us the response a piece at a time, it only gets kept for
+ * when something goes wrong
+ */
+static size_t writeCallback(char* data, size_t size, size_t count,
+                            void* response) {
+
+  static_cast<string*>(response)->append(data, size * count);
+
+  return size * count;
+}
+
+InfluxSink::InfluxSink(InfluxSinkConfig config) : config_(config) {
+
+  config_.batch_points_ = std::max<size_t>(1, config_.batch_points_);
+
+  appendEscaped(line_prefix_, config_.measurement_, false);
+  if (config_.station_.empty() == false) {
+    line_prefix_.append(",station=");
+    appendEscaped(line_prefix_, config_.station_, true);
+  }
+  line_prefix_.push_back(' ');
+
+  /*
+   * windowBits of 15 + 16 gets a gzip header and trailer instead of a
+   * zlib one. The stream is kept and reset for each batch.
+   */
+  if (config_.gzip_ == true) {
+    zstream_ready_ = (deflateInit2(&zstream_, Z_DEFAULT_COMPRESSION,
+                                   Z_DEFLATED, 15 + 16, 8,
+                                   Z_DEFAULT_STRATEGY) == Z_OK);
+  }
+
+  headers_ = curl_slist_append(headers_,
+                               "Content-Type: text/plain; charset=utf-8");
+  if (config_.token_.empty() == false) {
+    string authorization = "Authorization: Token " + config_.token_;
+    headers_ = curl_slist_append(headers_, authorization.c_str());
+    gzip_headers_ = curl_slist_append(gzip_headers_, authorization.c_str());
+  }
+  gzip_headers_ = curl_slist_append(gzip_headers_,
+                                    "Content-Type: text/plain; charset=utf-8");
+  gzip_headers_ = curl_slist_append(gzip_headers_, "Content-Encoding: gzip");
+
+  curl_ = curl_easy_init();
+  if (curl_ != nullptr) {
+    curl_easy_setopt(curl_, CURLOPT_URL, config_.url_.c_str());
+    curl_easy_setopt(curl_, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response_);
+    curl_easy_setopt(curl_, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS,
+                     influx_connect_timeout);
+    curl_easy_setopt(curl_, CURLOPT_TIMEOUT_MS, influx_transfer_timeout);
+    curl_easy_setopt(curl_, CURLOPT_NOSIGNAL, 1L);
+  }
+
+  openSpillDirectory();
+}
+
+InfluxSink::~InfluxSink() {
+
+  /*
+   * Don't sit waiting on a server that isn't there on the way out
+   */
+  if (batch_lines_ > 0) {
+    if (config_.spill_directory_.empty() == false) {
+      retry_at_ = steady_clock::now() + config_.retry_max_;
+    }
+    flush();
+  }
+
+  if (curl_ != nullptr) {
+    curl_easy_cleanup(curl_);
+  }
+  curl_slist_free_all(headers_);
+  curl_slist_free_all(gzip_headers_);
+  if (zstream_ready_ == true) {
+    deflateEnd(&zstream_);
+  }
+}
+
+string_view InfluxSink::name() const {
+
+  return "influxdb";
+}
+
+expected<bool, int> InfluxSink::publish(const PublishedSample& sample) {
+  steady_clock::time_point now = steady_clock::now();
+
+  if (batch_lines_ == 0) {
+    batch_started_ = now;
+  }
+  appendLine(sample);
+
+  if ((batch_lines_ >= config_.batch_points_) ||
+      ((now - batch_started_) >= config_.batch_interval_)) {
+    auto x_flushed = flush();
+
+    /*
+     * A batch that was kept still has the sample in it, having it tried
+     * again would only put it in twice
+     */
+    if ((x_flushed.has_value() == false) && (batch_lines_ > 0)) {
+      return true;
+    }
+    return x_flushed;
+  }
+
+  return true;
+}
+
+steady_clock::time_point InfluxSink::idleAt() const {
+
+  if (batch_lines_ == 0) {
+    return steady_clock::time_point::max();
+  }
+
+  return std::max(batch_started_ + config_.batch_interval_, retry_at_);
+}
+
+void InfluxSink::idle() {
+
+  flush();
+
+  return;
+}
+
+expected<bool, int> InfluxSink::flush() {
+  steady_clock::time_point now = steady_clock::now();
+
+  if (batch_lines_ == 0) {
+    return true;
+  }
+
+  auto x_compressed = compress();
+  bool gzipped = x_compressed.has_value();
+
+  expected<bool, int> result = unexpected(EAGAIN);
+  if (now >= retry_at_) {
+    result = post(body_, gzipped);
+    if (result.has_value() == true) {
+      failures_ = 0;
+      drainSpill();
+    } else if (result.error() == EPROTO) {
+      /*
+       * The server will never take it, there's no point keeping it.
+       * That isn't the server being down so the next one goes right
+       * away.
+       */
+      statistics_.dropped_++;
+    } else {
+      failed(now);
+    }
+  }
+  if ((result.has_value() == false) && (result.error() != EPROTO)) {
+    result = spill(body_, gzipped);
+
+    /*
+     * It went nowhere, so it stays and the next samples are added to it.
+     * retry_at_ has been pushed out by the post that failed or wasn't
+     * due yet, so idle() doesn't try again straight away.
+     */
+    if ((result.has_value() == false) &&
+        (batch_lines_ < config_.batch_points_ * influx_kept_batch_limit)) {
+      return result;
+    }
+    if (result.has_value() == false) {
+      statistics_.dropped_++;
+    }
+  }
+
+  statistics_.batches_++;
+  statistics_.line_bytes_ += batch_.size();
+  batch_.clear();
+  batch_lines_ = 0;
+
+  return result;
+}
+
+InfluxSinkStatistics InfluxSink::statistics() const {
+
+  return statistics_;
+}
+
+/*
+ * Nothing in here allocates once batch_ has grown big enough
+ */
+void InfluxSink::appendLine(const PublishedSample& sample) {
+  char value[qw_units::kFixedFormatBufferSize];
+  char timestamp[24];
+  bool first = true;
+
+  for (const InfluxField& field : influx_fields) {
+    optional<float> reading = field.value_(sample);
+    if (reading.has_value() == false) {
+      continue;
+    }
+    if (first == true) {
+      batch_.append(line_prefix_);
+      first = false;
+    } else {
+      batch_.push_back(',');
+    }
+    size_t length = qw_units::formatFixed(value, sizeof(value),
+                                          reading.value(), field.precision_);
+    batch_.append(field.name_);
+    batch_.push_back('=');
+    batch_.append(value, std::min(length, sizeof(value)));
+  }
+
+  /*
+   * A line has to have at least one field
+   */
+  if (first == true) {
+    return;
+  }
+
+  auto nanoseconds_since_epoch =
+      duration_cast<nanoseconds>(sample.time_.time_since_epoch()).count();
+  auto [end, ec] = std::to_chars(timestamp, timestamp + sizeof(timestamp),
+                                 nanoseconds_since_epoch);
+  batch_.push_back(' ');
+  batch_.append(timestamp, end);
+  batch_.push_back('\n');
+  batch_lines_++;
+  statistics_.points_++;
+
+  return;
+}
+
+expected<bool, int> InfluxSink::compress() {
+
+  body_ = batch_;
+  if (zstream_ready_ == false) {
+    return unexpected(ENOTSUP);
+  }
+
+  /*
+   * deflateBound() is as big as it can come out, so it is all done in
+   * one call
+   */
+  deflateReset(&zstream_);
+  compressed_.resize(deflateBound(&zstream_, batch_.size()));
+  zstream_.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(batch_.data()));
+  zstream_.avail_in = batch_.size();
+  zstream_.next_out = reinterpret_cast<Bytef*>(compressed_.data());
+  zstream_.avail_out = compressed_.size();
+  if (deflate(&zstream_, Z_FINISH) != Z_STREAM_END) {
+    return unexpected(EIO);
+  }
+  body_ = string_view(compressed_.data(), zstream_.total_out);
+
+  return true;
+}
+
+expected<bool, int> InfluxSink::post(string_view body, bool gzipped) {
+  long http_status = 0;
+
+  if (curl_ == nullptr) {
+    return unexpected(ENOMEM);
+  }
+
+  response_.clear();
+  curl_easy_setopt(curl_, CURLOPT_HTTPHEADER,
+                   gzipped == true ? gzip_headers_ : headers_);
+  curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, body.data());
+  curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE_LARGE,
+                   static_cast<curl_off_t>(body.size()));
+  CURLcode code = curl_easy_perform(curl_);
+  if (code != CURLE_OK) {
+    statistics_.failed_++;
+    return unexpected(ECOMM);
+  }
+  curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &http_status);
+
+  auto result = httpStatusResult(http_status);
+  if (result.has_value() == true) {
+    statistics_.posts_++;
+    statistics_.sent_bytes_ += body.size();
+  } else {
+    statistics_.failed_++;
+  }
+
+  return result;
+}
+
+/*
+ * Written with writeFileAtomically(), the same as the weather underground
+ * queue, so a crash leaves all of a batch or none of it. The name starts
+ * with the time so the directory sorts oldest first.
+ */
+expected<bool, int> InfluxSink::spill(string_view body, bool gzipped) {
+
+  if (config_.spill_directory_.empty() == true) {
+    return unexpected(ENOENT);
+  }
+
+  string name = fmt::format(
+      "{:016}-{:04}{}",
+      duration_cast<milliseconds>(system_clock::now().time_since_epoch())
+          .count(),
+      spill_sequence_++ % 10000,
+      gzipped == true ? influx_spill_gzip_extension : influx_spill_extension);
+  std::filesystem::path path = config_.spill_directory_ / name;
+  auto x_written = writeFileAtomically(path, body);
+  if (x_written.has_value() == false) {
+    return x_written;
+  }
+
+  spill_files_.push_back(SpillFile{path, body.size(), gzipped});
+  statistics_.spilled_++;
+  statistics_.spill_bytes_ += body.size();
+  while ((statistics_.spill_bytes_ > config_.spill_max_bytes_) &&
+         (spill_files_.size() > 1)) {
+    dropOldestSpill();
+  }
+  statistics_.spill_depth_ = spill_files_.size();
+
+  return true;
+}
+
+/*
+ * Pick up whatever was spilled before we went down
+ */
+void InfluxSink::openSpillDirectory() {
+  std::error_code ec;
+  vector<SpillFile> found;
+
+  if (config_.spill_directory_.empty() == true) {
+    return;
+  }
+  std::filesystem::create_directories(config_.spill_directory_, ec);
+  std::filesystem::directory_iterator entries(config_.spill_directory_, ec);
+  if (ec) {
+    return;
+  }
+
+  for (const auto& entry : entries) {
+    string name = entry.path().filename().string();
+    if (name.ends_with(atomic_file_temporary_extension) == true) {
+      std::filesystem::remove(entry.path(), ec);
+      continue;
+    }
+    bool gzipped = name.ends_with(influx_spill_gzip_extension);
+    if ((gzipped == false) &&
+        (name.ends_with(influx_spill_extension) == false)) {
+      continue;
+    }
+    uint64_t size = entry.file_size(ec);
+    if (ec) {
+      continue;
+    }
+    found.push_back(SpillFile{entry.path(), size, gzipped});
+  }
+  std::sort(found.begin(), found.end(),
+            [](const SpillFile& a, const SpillFile& b) {
+              return a.path_.filename() < b.path_.filename();
+            });
+
+  for (const SpillFile& file : found) {
+    spill_files_.push_back(file);
+    statistics_.spill_bytes_ += file.size_;
+  }
+  while ((statistics_.spill_bytes_ > config_.spill_max_bytes_) &&
+         (spill_files_.empty() == false)) {
+    dropOldestSpill();
+  }
+  statistics_.spill_depth_ = spill_files_.size();
+
+  return;
+}
+
+/*
+ * A few spilled batches go after each batch that works, so catching up
+ * doesn't hold the new ones back for long
+ */
+void InfluxSink::drainSpill() {
+
+  for (size_t n = 0;
+       (n < config_.spill_drain_) && (spill_files_.empty() == false); n++) {
+    const SpillFile& file = spill_files_.front();
+    std::ifstream stream(file.path_, std::ios::binary);
+    spilled_body_.assign(std::istreambuf_iterator<char>(stream),
+                         std::istreambuf_iterator<char>());
+    if (spilled_body_.empty() == false) {
+      auto x_posted = post(spilled_body_, file.gzipped_);
+      if (x_posted.has_value() == false) {
+        if (x_posted.error() != EPROTO) {
+          failed(steady_clock::now());
+          break;
+        }
+        statistics_.dropped_++;
+      }
+    }
+    std::error_code ec;
+    std::filesystem::remove(file.path_, ec);
+    statistics_.spill_bytes_ -= std::min(statistics_.spill_bytes_, file.size_);
+    spill_files_.pop_front();
+  }
+  statistics_.spill_depth_ = spill_files_.size();
+
+  return;
+}
+
+void InfluxSink::dropOldestSpill() {
+  std::error_code ec;
+
+  std::filesystem::remove(spill_files_.front().path_, ec);
+  statistics_.spill_bytes_ -=
+      std::min(statistics_.spill_bytes_, spill_files_.front().size_);
+  spill_files_.pop_front();
+  statistics_.dropped_++;
+
+  return;
+}
+
+void InfluxSink::failed(steady_clock::time_point now) {
+
+  failures_++;
+  retry_at_ =
+      now + retryDelay(failures_, config_.retry_initial_, config_.retry_max_);
+
+  return;
+}
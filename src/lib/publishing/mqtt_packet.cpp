@@ -0,0 +1,238 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Building and taking apart MQTT packets
+ */
+#include "include/mqtt_packet.h"
+
+static void appendLength(string& buffer, size_t length) {
+
+  do {
+    uint8_t byte = length & 0x7f;
+    length >>= 7;
+    if (length > 0) {
+      byte |= 0x80;
+    }
+    buffer.push_back(static_cast<char>(byte));
+  } while (length > 0);
+
+  return;
+}
+
+static void appendUint16(string& buffer, uint16_t value) {
+
+  buffer.push_back(static_cast<char>(value >> 8));
+  buffer.push_back(static_cast<char>(value & 0xff));
+
+  return;
+}
+
+static void appendString(string& buffer, string_view value) {
+
+  appendUint16(buffer, static_cast<uint16_t>(value.size()));
+  buffer.append(value);
+
+  return;
+}
+
+void mqttAppendConnect(string& buffer, const MqttConnectOptions& options) {
+  uint8_t flags = 0;
+  size_t length = 10 + 2 + options.client_id_.size();
+
+  if (options.clean_session_ == true) {
+    flags |= 0x02;
+  }
+  if (options.will_topic_.empty() == false) {
+    /*
+     * The will goes at QoS 1
+     */
+    flags |= 0x04 | 0x08;
+    if (options.will_retain_ == true) {
+      flags |= 0x20;
+    }
+    length += 2 + options.will_topic_.size() + 2 +
+              options.will_message_.size();
+  }
+  if (options.username_.empty() == false) {
+    flags |= 0x80;
+    length += 2 + options.username_.size();
+    if (options.password_.empty() == false) {
+      flags |= 0x40;
+      length += 2 + options.password_.size();
+    }
+  }
+
+  buffer.push_back(static_cast<char>(MQTT_CONNECT << 4));
+  appendLength(buffer, length);
+  appendString(buffer, "MQTT");
+  buffer.push_back(4);  // 3.1.1
+  buffer.push_back(static_cast<char>(flags));
+  appendUint16(buffer, options.keepalive_);
+  appendString(buffer, options.client_id_);
+  if (options.will_topic_.empty() == false) {
+    appendString(buffer, options.will_topic_);
+    appendString(buffer, options.will_message_);
+  }
+  if (options.username_.empty() == false) {
+    appendString(buffer, options.username_);
+    if (options.password_.empty() == false) {
+      appendString(buffer, options.password_);
+    }
+  }
+
+  return;
+}
+
+void mqttAppendPublish(string& buffer, string_view topic, string_view payload,
+                       uint16_t packet_id, bool retain) {
+  uint8_t flags = 0;
+  size_t length = 2 + topic.size() + payload.size();
+
+  if (packet_id != 0) {
+    flags |= mqtt_publish_qos1;
+    length += 2;
+  }
+  if (retain == true) {
+    flags |= mqtt_publish_retain;
+  }
+
+  buffer.push_back(static_cast<char>((MQTT_PUBLISH << 4) | flags));
+  appendLength(buffer, length);
+  appendString(buffer, topic);
+  if (packet_id != 0) {
+    appendUint16(buffer, packet_id);
+  }
+  buffer.append(payload);
+
+  return;
+}
+
+void mqttAppendConnack(string& buffer, bool session_present,
+                       uint8_t return_code) {
+
+  buffer.push_back(static_cast<char>(MQTT_CONNACK << 4));
+  buffer.push_back(2);
+  buffer.push_back(session_present == true ? 1 : 0);
+  buffer.push_back(static_cast<char>(return_code));
+
+  return;
+}
+
+void mqttAppendPuback(string& buffer, uint16_t packet_id) {
+
+  buffer.push_back(static_cast<char>(MQTT_PUBACK << 4));
+  buffer.push_back(2);
+  appendUint16(buffer, packet_id);
+
+  return;
+}
+
+void mqttAppendPingreq(string& buffer) {
+
+  buffer.push_back(static_cast<char>(MQTT_PINGREQ << 4));
+  buffer.push_back(0);
+
+  return;
+}
+
+void mqttAppendPingresp(string& buffer) {
+
+  buffer.push_back(static_cast<char>(MQTT_PINGRESP << 4));
+  buffer.push_back(0);
+
+  return;
+}
+
+void mqttAppendDisconnect(string& buffer) {
+
+  buffer.push_back(static_cast<char>(MQTT_DISCONNECT << 4));
+  buffer.push_back(0);
+
+  return;
+}
+
+/*
+ * SUBSCRIBE has to have 0010 in its flags
+ */
+void mqttAppendSubscribe(string& buffer, uint16_t packet_id,
+                         string_view topic_filter) {
+
+  buffer.push_back(static_cast<char>((MQTT_SUBSCRIBE << 4) | 0x02));
+  appendLength(buffer, 2 + 2 + topic_filter.size() + 1);
+  appendUint16(buffer, packet_id);
+  appendString(buffer, topic_filter);
+  buffer.push_back(0);
+
+  return;
+}
+
+void mqttAppendSuback(string& buffer, uint16_t packet_id, size_t filters) {
+
+  buffer.push_back(static_cast<char>(MQTT_SUBACK << 4));
+  appendLength(buffer, 2 + filters);
+  appendUint16(buffer, packet_id);
+  buffer.append(filters, 0);
+
+  return;
+}
+
+expected<MqttPacket, int> mqttParsePacket(span<const uint8_t> data) {
+  size_t length = 0;
+  size_t header = 1;
+  int shift = 0;
+
+  if (data.size() < 2) {
+    return unexpected(EAGAIN);
+  }
+
+  /*
+   * At most 4 length bytes
+   */
+  while (true) {
+    if (header >= data.size()) {
+      return unexpected(EAGAIN);
+    }
+    uint8_t byte = data[header++];
+    length |= static_cast<size_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+    shift += 7;
+    if (shift > 21) {
+      return unexpected(EPROTO);
+    }
+  }
+  if (data.size() < header + length) {
+    return unexpected(EAGAIN);
+  }
+
+  return MqttPacket{static_cast<MqttPacketType>(data[0] >> 4),
+                    static_cast<uint8_t>(data[0] & 0x0f),
+                    data.subspan(header, length), header + length};
+}
+
+expected<size_t, int> mqttParseString(span<const uint8_t> data,
+                                      string_view& value) {
+
+  if (data.size() < 2) {
+    return unexpected(EPROTO);
+  }
+  size_t length = (static_cast<size_t>(data[0]) << 8) | data[1];
+  if (data.size() < 2 + length) {
+    return unexpected(EPROTO);
+  }
+  value = string_view(reinterpret_cast<const char*>(data.data()) + 2, length);
+
+  return 2 + length;
+}
+
+expected<uint16_t, int> mqttParsePacketId(span<const uint8_t> data) {
+
+  if (data.size() < 2) {
+    return unexpected(EPROTO);
+  }
+
+  return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
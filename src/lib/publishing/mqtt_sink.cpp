@@ -0,0 +1,448 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The MQTT sink
+ */
+#include "include/mqtt_sink.h"
+
+#include <jsoncpp/json/json.h>
+#include <algorithm>
+#include <optional>
+
+#include "fixed_format.h"
+
+using qw_units::MetersPerSecond;
+using std::optional;
+using std::chrono::duration_cast;
+using std::chrono::steady_clock;
+
+/*
+ * The readings that get published, where they are in the sample and what
+ * Home Assistant should make of them. Everything goes in metric, Home
+ * Assistant converts to whatever the user wants to see.
+ */
+struct MqttReading {
+  const char* object_id_;
+  const char* name_;
+  const char* device_class_;  // nullptr for none
+  const char* unit_;
+  optional<float> (*value_)(const PublishedSample& sample);
+  int precision_;
+};
+
+static const MqttReading mqtt_readings[] = {
+    {"temperature", "Temperature", "temperature", "°C",
+     sampleValue<Celsius, &PublishedSample::temperature_>, 2},
+    {"temperature2", "Pressure Sensor Temperature", "temperature", "°C",
+     sampleValue<Celsius, &PublishedSample::temperature2_>, 2},
+    {"humidity", "Humidity", "humidity", "%",
+     sampleValue<RelativeHumidity, &PublishedSample::humidity_>, 1},
+    {"dewpoint", "Dew Point", "temperature", "°C",
+     sampleValue<Celsius, &PublishedSample::dewpoint_>, 2},
+    {"pressure", "Station Pressure", "atmospheric_pressure", "hPa",
+     sampleValue<Millibar, &PublishedSample::pressure_>, 2},
+    {"sea_level_pressure", "Sea Level Pressure", "atmospheric_pressure",
+     "hPa", sampleValue<Millibar, &PublishedSample::sea_level_pressure_>, 2},
+    {"wind_speed", "Wind Speed", "wind_speed", "m/s",
+     sampleValue<MetersPerSecond, &PublishedSample::wind_speed_avg_>, 1},
+    {"wind_direction", "Wind Direction", nullptr, "°",
+     sampleValue<float, &PublishedSample::wind_direction_>, 0},
+    {"wind_gust", "Wind Gust", "wind_speed", "m/s",
+     sampleValue<MetersPerSecond, &PublishedSample::wind_gust_>, 1},
+};
+
+constexpr size_t mqtt_reading_count =
+    sizeof(mqtt_readings) / sizeof(mqtt_readings[0]);
+static_assert(mqtt_reading_count <= 32, "discovered_ is a 32 bit mask");
+
+MqttSink::MqttSink(MqttSinkConfig config) : config_(config) {
+
+  /*
+   * The topics and the discovery configs never change, so they are all
+   * put together once here
+   */
+  status_topic_ = config_.topic_prefix_ + "/status";
+  for (const MqttReading& reading : mqtt_readings) {
+    state_topics_.push_back(config_.topic_prefix_ + "/" + reading.object_id_);
+
+    string unique_id = config_.client_id_ + "_" + reading.object_id_;
+    discovery_topics_.push_back(config_.discovery_prefix_ + "/sensor/" +
+                                unique_id + "/config");
+
+    Json::Value discovery;
+    discovery["name"] = reading.name_;
+    discovery["unique_id"] = unique_id;
+    discovery["state_topic"] = state_topics_.back();
+    discovery["availability_topic"] = status_topic_;
+    discovery["unit_of_measurement"] = reading.unit_;
+    discovery["state_class"] = "measurement";
+    if (reading.device_class_ != nullptr) {
+      discovery["device_class"] = reading.device_class_;
+    }
+    discovery["device"]["identifiers"].append(config_.client_id_);
+    discovery["device"]["name"] = config_.device_name_;
+    discovery["device"]["manufacturer"] = "Quietwind";
+
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    writer["emitUTF8"] = true;
+    discovery_configs_.push_back(Json::writeString(writer, discovery));
+  }
+}
+
+MqttSink::~MqttSink() {
+
+  if (connection_.isOpen() == true) {
+    out_.clear();
+    mqttAppendPublish(out_, status_topic_, "offline", 0, true);
+    mqttAppendDisconnect(out_);
+    connection_.send(out_, config_.ack_timeout_);
+    close();
+  }
+}
+
+string_view MqttSink::name() const {
+
+  return "mqtt";
+}
+
+steady_clock::time_point MqttSink::idleAt() const {
+
+  if ((connection_.isOpen() == false) || (config_.keepalive_.count() == 0)) {
+    return steady_clock::time_point::max();
+  }
+
+  return last_sent_ + duration_cast<milliseconds>(config_.keepalive_) / 2;
+}
+
+void MqttSink::idle() {
+
+  if (connection_.alive() == false) {
+    close();
+    return;
+  }
+
+  out_.clear();
+  mqttAppendPingreq(out_);
+  auto x_sent = send();
+  if (x_sent.has_value() == true) {
+    x_sent = waitForPingresp();
+  }
+  if (x_sent.has_value() == false) {
+    close();
+  }
+
+  return;
+}
+
+expected<bool, int> MqttSink::publish(const PublishedSample& sample) {
+  uint32_t discovering = 0;
+  char value[qw_units::kFixedFormatBufferSize];
+
+  if (connection_.alive() == false) {
+    auto x_connected = connect();
+    if (x_connected.has_value() == false) {
+      return x_connected;
+    }
+  }
+
+  /*
+   * The whole sample goes in one batch, discovery configs first so Home
+   * Assistant has the sensor before its first value shows up
+   */
+  out_.clear();
+  pending_.clear();
+  for (size_t r = 0; r < mqtt_reading_count; r++) {
+    optional<float> reading = mqtt_readings[r].value_(sample);
+    if (reading.has_value() == false) {
+      continue;
+    }
+
+    if ((config_.discovery_prefix_.empty() == false) &&
+        ((discovered_ & (1u << r)) == 0)) {
+      pending_.push_back(nextPacketId());
+      mqttAppendPublish(out_, discovery_topics_[r], discovery_configs_[r],
+                        pending_.back(), true);
+      discovering |= 1u << r;
+    }
+
+    size_t length = qw_units::formatFixed(value, sizeof(value),
+                                          reading.value(),
+                                          mqtt_readings[r].precision_);
+    pending_.push_back(nextPacketId());
+    mqttAppendPublish(out_, state_topics_[r],
+                      string_view(value, std::min(length, sizeof(value))),
+                      pending_.back(), true);
+  }
+  if (pending_.empty() == true) {
+    return true;
+  }
+
+  auto x_sent = send();
+  if (x_sent.has_value() == false) {
+    close();
+    return x_sent;
+  }
+  auto x_acked = waitForAcks();
+  if (x_acked.has_value() == false) {
+    close();
+    return x_acked;
+  }
+
+  /*
+   * Only once the broker has them are the discovery configs done with
+   */
+  discovered_ |= discovering;
+
+  return true;
+}
+
+expected<bool, int> MqttSink::connect() {
+
+  auto x_opened = connection_.open(config_.host_, config_.port_,
+                                   config_.connect_timeout_);
+  if (x_opened.has_value() == false) {
+    return x_opened;
+  }
+
+  MqttConnectOptions options;
+  options.client_id_ = config_.client_id_;
+  options.username_ = config_.username_;
+  options.password_ = config_.password_;
+  options.keepalive_ = static_cast<uint16_t>(
+      std::min<int64_t>(config_.keepalive_.count(), UINT16_MAX));
+  options.clean_session_ = false;
+  options.will_topic_ = status_topic_;
+  options.will_message_ = "offline";
+  options.will_retain_ = true;
+  out_.clear();
+  mqttAppendConnect(out_, options);
+  auto x_sent = send();
+  if (x_sent.has_value() == false) {
+    close();
+    return x_sent;
+  }
+
+  /*
+   * Nothing else can come before the CONNACK
+   */
+  in_.clear();
+  steady_clock::time_point deadline =
+      steady_clock::now() + config_.ack_timeout_;
+  while (true) {
+    auto x_packet = mqttParsePacket(in_);
+    if (x_packet.has_value() == true) {
+      if ((x_packet.value().type_ != MQTT_CONNACK) ||
+          (x_packet.value().body_.size() != 2)) {
+        close();
+        return unexpected(EPROTO);
+      }
+      uint8_t return_code = x_packet.value().body_[1];
+      in_.erase(in_.begin(), in_.begin() + x_packet.value().size_);
+      if (return_code == mqtt_connack_accepted) {
+        break;
+      }
+      close();
+      if ((return_code == mqtt_connack_bad_credentials) ||
+          (return_code == mqtt_connack_not_authorized)) {
+        return unexpected(EACCES);
+      }
+      return unexpected(ECONNREFUSED);
+    }
+    if (x_packet.error() != EAGAIN) {
+      close();
+      return unexpected(x_packet.error());
+    }
+
+    auto x_received = receive(deadline);
+    if (x_received.has_value() == false) {
+      close();
+      return x_received;
+    }
+  }
+
+  /*
+   * Whatever wasn't acked before goes again first, the broker kept our
+   * session so it knows those packet ids. Then we're here, that goes out
+   * ahead of the first sample.
+   */
+  out_.clear();
+  pending_.clear();
+  out_.swap(resend_);
+  pending_.swap(resend_ids_);
+  pending_.push_back(nextPacketId());
+  mqttAppendPublish(out_, status_topic_, "online", pending_.back(), true);
+  x_sent = send();
+  if (x_sent.has_value() == true) {
+    x_sent = waitForAcks();
+  }
+  if (x_sent.has_value() == false) {
+    close();
+    return x_sent;
+  }
+
+  return true;
+}
+
+void MqttSink::close() {
+
+  keepUnacked();
+  connection_.close();
+  in_.clear();
+
+  return;
+}
+
+/*
+ * Only QoS 1 PUBLISH packets ever go in pending_, so those are the only
+ * ones in out_ that can be kept. One that already has DUP set has had its
+ * second go and is let go of, the topics are all retained so a later
+ * sample puts newer readings in them anyway, and a broker that never
+ * acks it can't keep us from ever getting connected again.
+ */
+void MqttSink::keepUnacked() {
+  span<const uint8_t> data(reinterpret_cast<const uint8_t*>(out_.data()),
+                           out_.size());
+
+  while (pending_.empty() == false) {
+    auto x_packet = mqttParsePacket(data);
+    if (x_packet.has_value() == false) {
+      break;
+    }
+    const MqttPacket& packet = x_packet.value();
+    string_view topic;
+    auto x_used = mqttParseString(packet.body_, topic);
+    if ((packet.type_ == MQTT_PUBLISH) &&
+        ((packet.flags_ & mqtt_publish_dup) == 0) &&
+        (x_used.has_value() == true)) {
+      auto x_packet_id =
+          mqttParsePacketId(packet.body_.subspan(x_used.value()));
+      auto found = (x_packet_id.has_value() == true)
+                       ? std::find(pending_.begin(), pending_.end(),
+                                   x_packet_id.value())
+                       : pending_.end();
+      if (found != pending_.end()) {
+        size_t at = resend_.size();
+        resend_.append(reinterpret_cast<const char*>(data.data()),
+                       packet.size_);
+        resend_[at] |= mqtt_publish_dup;
+        resend_ids_.push_back(*found);
+        pending_.erase(found);
+      }
+    }
+    data = data.subspan(packet.size_);
+  }
+  pending_.clear();
+
+  return;
+}
+
+expected<bool, int> MqttSink::send() {
+
+  auto x_sent = connection_.send(out_, config_.ack_timeout_);
+  if (x_sent.has_value() == true) {
+    last_sent_ = steady_clock::now();
+  }
+
+  return x_sent;
+}
+
+/*
+ * The acks can come back in any order and in any size of pieces, so
+ * everything that comes in is gathered in in_ and whole packets are
+ * taken off the front of it
+ */
+expected<bool, int> MqttSink::waitForAcks() {
+  steady_clock::time_point deadline =
+      steady_clock::now() + config_.ack_timeout_;
+
+  while (pending_.empty() == false) {
+    auto x_packet = mqttParsePacket(in_);
+    if (x_packet.has_value() == true) {
+      if (x_packet.value().type_ == MQTT_PUBACK) {
+        auto x_packet_id = mqttParsePacketId(x_packet.value().body_);
+        if (x_packet_id.has_value() == false) {
+          return unexpected(x_packet_id.error());
+        }
+        auto found =
+            std::find(pending_.begin(), pending_.end(), x_packet_id.value());
+        if (found != pending_.end()) {
+          pending_.erase(found);
+        }
+      }
+      in_.erase(in_.begin(), in_.begin() + x_packet.value().size_);
+      continue;
+    }
+    if (x_packet.error() != EAGAIN) {
+      return unexpected(x_packet.error());
+    }
+
+    auto x_received = receive(deadline);
+    if (x_received.has_value() == false) {
+      return x_received;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * A PUBACK for something that was given up on can still turn up first
+ */
+expected<bool, int> MqttSink::waitForPingresp() {
+  steady_clock::time_point deadline =
+      steady_clock::now() + config_.ack_timeout_;
+
+  while (true) {
+    auto x_packet = mqttParsePacket(in_);
+    if (x_packet.has_value() == true) {
+      MqttPacketType type = x_packet.value().type_;
+      in_.erase(in_.begin(), in_.begin() + x_packet.value().size_);
+      if (type == MQTT_PINGRESP) {
+        break;
+      }
+      continue;
+    }
+    if (x_packet.error() != EAGAIN) {
+      return unexpected(x_packet.error());
+    }
+
+    auto x_received = receive(deadline);
+    if (x_received.has_value() == false) {
+      return x_received;
+    }
+  }
+
+  return true;
+}
+
+expected<bool, int> MqttSink::receive(steady_clock::time_point deadline) {
+  uint8_t buffer[1024];
+
+  auto x_received = connection_.receive(buffer, deadline);
+  if (x_received.has_value() == false) {
+    return unexpected(x_received.error());
+  }
+  in_.insert(in_.end(), buffer, buffer + x_received.value());
+
+  return true;
+}
+
+/*
+ * Packet id 0 isn't allowed, and neither is one the broker is still
+ * waiting to see again
+ */
+uint16_t MqttSink::nextPacketId() {
+
+  do {
+    packet_id_++;
+  } while ((packet_id_ == 0) ||
+           (std::find(pending_.begin(), pending_.end(), packet_id_) !=
+            pending_.end()) ||
+           (std::find(resend_ids_.begin(), resend_ids_.end(), packet_id_) !=
+            resend_ids_.end()));
+
+  return packet_id_;
+}
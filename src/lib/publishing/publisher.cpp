@@ -0,0 +1,157 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The Publisher and the threads that feed its sinks
+ */
+#include "include/publisher.h"
+
+#include <algorithm>
+
+#include "retry_backoff.h"
+
+using std::unique_lock;
+using std::chrono::duration_cast;
+using std::chrono::steady_clock;
+
+Publisher::Publisher() {}
+
+Publisher::~Publisher() {
+
+  /*
+   * Tell them all first so they wind down together, then the jthreads
+   * join as they go
+   */
+  for (auto& worker : workers_) {
+    worker->thread_.request_stop();
+  }
+  workers_.clear();
+}
+
+expected<bool, int> Publisher::addSink(unique_ptr<PublisherSink> sink,
+                                       PublisherSinkConfig config) {
+
+  if (sink == nullptr) {
+    return unexpected(EINVAL);
+  }
+  for (const auto& worker : workers_) {
+    if (worker->sink_->name() == sink->name()) {
+      return unexpected(EEXIST);
+    }
+  }
+
+  auto worker = std::make_unique<SinkWorker>();
+  worker->statistics_.name_ = sink->name();
+  worker->sink_ = std::move(sink);
+  worker->config_ = config;
+  worker->config_.queue_capacity_ = std::max<size_t>(1, config.queue_capacity_);
+  worker->thread_ = std::jthread(Publisher::run, worker.get());
+  workers_.push_back(std::move(worker));
+
+  return true;
+}
+
+void Publisher::publish(SharedSample sample) {
+  steady_clock::time_point now = steady_clock::now();
+
+  for (auto& worker : workers_) {
+    {
+      lock_guard<mutex> guard(worker->lock_);
+      if (worker->queue_.size() >= worker->config_.queue_capacity_) {
+        worker->queue_.pop_front();
+        worker->statistics_.dropped_++;
+      }
+      worker->queue_.push_back(Queued{sample, now});
+      worker->statistics_.depth_ = worker->queue_.size();
+    }
+    worker->wake_.notify_one();
+  }
+
+  return;
+}
+
+size_t Publisher::sinkCount() const {
+
+  return workers_.size();
+}
+
+vector<PublisherSinkStatistics> Publisher::statistics() const {
+  vector<PublisherSinkStatistics> statistics;
+
+  for (const auto& worker : workers_) {
+    lock_guard<mutex> guard(worker->lock_);
+    statistics.push_back(worker->statistics_);
+  }
+
+  return statistics;
+}
+
+/*
+ * One of these runs for each sink. The lock is only held to get at the
+ * queue and the statistics, never while the sink is working.
+ */
+void Publisher::run(std::stop_token stop, SinkWorker* worker) {
+  auto waiting = [worker] { return worker->queue_.empty() == false; };
+
+  while (stop.stop_requested() == false) {
+    Queued queued;
+    steady_clock::time_point idle_at = worker->sink_->idleAt();
+    {
+      unique_lock<mutex> guard(worker->lock_);
+      bool woken = (idle_at == steady_clock::time_point::max())
+                       ? worker->wake_.wait(guard, stop, waiting)
+                       : worker->wake_.wait_until(guard, stop, idle_at,
+                                                  waiting);
+
+      /*
+       * Nothing came before the sink wanted to get on with something of
+       * its own, or we've been stopped
+       */
+      if (woken == false) {
+        guard.unlock();
+        if (stop.stop_requested() == false) {
+          worker->sink_->idle();
+        }
+        continue;
+      }
+      queued = worker->queue_.front();
+      worker->queue_.pop_front();
+      worker->statistics_.depth_ = worker->queue_.size();
+    }
+
+    for (int attempt = 1; stop.stop_requested() == false; attempt++) {
+      auto x_published = worker->sink_->publish(*queued.sample_);
+
+      unique_lock<mutex> guard(worker->lock_);
+      if (x_published.has_value() == true) {
+        if (x_published.value() == true) {
+          worker->statistics_.published_++;
+          worker->statistics_.last_latency_ = duration_cast<microseconds>(
+              steady_clock::now() - queued.queued_);
+        } else {
+          worker->statistics_.skipped_++;
+        }
+        break;
+      }
+      worker->statistics_.last_error_ = x_published.error();
+      if ((publishErrorIsPermanent(x_published.error()) == true) ||
+          ((worker->config_.max_attempts_ > 0) &&
+           (attempt >= worker->config_.max_attempts_))) {
+        worker->statistics_.failed_++;
+        break;
+      }
+      worker->statistics_.retries_++;
+
+      /*
+       * Only a stop cuts the wait short, new samples just wait their turn
+       */
+      worker->wake_.wait_for(guard, stop,
+                             retryDelay(attempt, worker->config_.retry_initial_,
+                                        worker->config_.retry_max_),
+                             [] { return false; });
+    }
+  }
+
+  return;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The PWSweather sink
+ */
+#include "include/pwsweather_sink.h"
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <algorithm>
+
+#include "include/http_status.h"
+
+using qw_units::Fahrenheit;
+using qw_units::InchesMercury;
+
+PwsWeatherSink::PwsWeatherSink(string station_id, string api_key, string url)
+    : station_id_(station_id), api_key_(api_key), url_(url) {}
+
+string_view PwsWeatherSink::name() const {
+
+  return "pwsweather";
+}
+
+expected<bool, int> PwsWeatherSink::publish(const PublishedSample& sample) {
+  char dateutc[32];
+
+  /*
+   * Weather Underground's names and precisions
+   */
+  size_t length =
+      fmt::format_to_n(dateutc, sizeof(dateutc), "{:%Y-%m-%d %H:%M:%S}",
+                       fmt::gmtime(system_clock::to_time_t(sample.time_)))
+          .size;
+  request_.start(url_);
+  request_.addField("ID", station_id_);
+  request_.addField("PASSWORD", api_key_);
+  request_.addField("dateutc", string_view(dateutc, std::min(length,
+                                                             sizeof(dateutc))));
+  if (sample.temperature_.has_value() == true) {
+    request_.addNumber("tempf", Fahrenheit(sample.temperature_.value()).value(),
+                       2);
+  }
+  if (sample.humidity_.has_value() == true) {
+    request_.addNumber("humidity", sample.humidity_.value().value(), 2);
+  }
+  if (sample.dewpoint_.has_value() == true) {
+    request_.addNumber("dewptf", Fahrenheit(sample.dewpoint_.value()).value(),
+                       2);
+  }
+  if (sample.pressure_.has_value() == true) {
+    request_.addNumber("baromin",
+                       InchesMercury(sample.pressure_.value()).value(), 2);
+  }
+  if (sample.wind_speed_avg_.has_value() == true) {
+    request_.addNumber("windspeedmph", sample.wind_speed_avg_.value().value(),
+                       1);
+  }
+  if (sample.wind_gust_.has_value() == true) {
+    request_.addNumber("windgustmph", sample.wind_gust_.value().value(), 1);
+  }
+  if (sample.wind_direction_.has_value() == true) {
+    request_.addNumber("winddir", sample.wind_direction_.value(), 0);
+  }
+  request_.addEscapedField("softwaretype", "quietwind");
+
+  response_.clear();
+  auto x_sent = connection_.get(request_.url(), response_);
+  if (x_sent.has_value() == false) {
+    return unexpected(x_sent.error());
+  }
+
+  return httpStatusResult(connection_.lastTiming().http_status_);
+}
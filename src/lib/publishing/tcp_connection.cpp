@@ -0,0 +1,189 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * A kept open TCP connection
+ */
+#include "include/tcp_connection.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using std::chrono::duration_cast;
+
+TcpConnection::TcpConnection() {}
+
+TcpConnection::~TcpConnection() {
+
+  close();
+}
+
+expected<bool, int> TcpConnection::open(const string& host, uint16_t port,
+                                        milliseconds timeout) {
+  struct addrinfo hints = {};
+  struct addrinfo* addresses = nullptr;
+  int error = ECONNREFUSED;
+
+  close();
+
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  string service = std::to_string(port);
+  int result = getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses);
+  if (result != 0) {
+    return unexpected(result == EAI_SYSTEM ? errno : EHOSTUNREACH);
+  }
+
+  for (struct addrinfo* address = addresses; address != nullptr;
+       address = address->ai_next) {
+    fd_ = socket(address->ai_family,
+                 address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                 address->ai_protocol);
+    if (fd_ < 0) {
+      error = errno;
+      continue;
+    }
+    if ((::connect(fd_, address->ai_addr, address->ai_addrlen) < 0) &&
+        (errno != EINPROGRESS)) {
+      error = errno;
+      close();
+      continue;
+    }
+    auto x_ready = waitFor(POLLOUT, timeout);
+    int so_error = 0;
+    socklen_t so_error_length = sizeof(so_error);
+    if (x_ready.has_value() == false) {
+      error = x_ready.error();
+    } else if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &so_error,
+                          &so_error_length) < 0) {
+      error = errno;
+    } else if (so_error != 0) {
+      error = so_error;
+    } else {
+      break;
+    }
+    close();
+  }
+  freeaddrinfo(addresses);
+  if (fd_ < 0) {
+    return unexpected(error);
+  }
+
+  int on = 1;
+  setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+  return true;
+}
+
+void TcpConnection::close() {
+
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+
+  return;
+}
+
+bool TcpConnection::isOpen() const {
+
+  return fd_ >= 0;
+}
+
+bool TcpConnection::alive() {
+  uint8_t buffer[256];
+
+  if (fd_ < 0) {
+    return false;
+  }
+  while (true) {
+    ssize_t count = recv(fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (count > 0) {
+      continue;
+    }
+    if ((count < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+      break;
+    }
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+expected<bool, int> TcpConnection::send(string_view data,
+                                        milliseconds timeout) {
+  size_t sent = 0;
+
+  if (fd_ < 0) {
+    return unexpected(ENOTCONN);
+  }
+  while (sent < data.size()) {
+    ssize_t count = ::send(fd_, data.data() + sent, data.size() - sent,
+                           MSG_NOSIGNAL);
+    if (count >= 0) {
+      sent += count;
+      continue;
+    }
+    if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+      return unexpected(errno);
+    }
+    auto x_ready = waitFor(POLLOUT, timeout);
+    if (x_ready.has_value() == false) {
+      return unexpected(x_ready.error());
+    }
+  }
+
+  return true;
+}
+
+expected<size_t, int> TcpConnection::receive(
+    span<uint8_t> buffer, steady_clock::time_point deadline) {
+
+  if (fd_ < 0) {
+    return unexpected(ENOTCONN);
+  }
+  while (true) {
+    ssize_t count = recv(fd_, buffer.data(), buffer.size(), 0);
+    if (count > 0) {
+      return static_cast<size_t>(count);
+    }
+    if (count == 0) {
+      return unexpected(ECONNRESET);
+    }
+    if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+      return unexpected(errno);
+    }
+    auto x_ready = waitFor(
+        POLLIN, duration_cast<milliseconds>(deadline - steady_clock::now()));
+    if (x_ready.has_value() == false) {
+      return unexpected(x_ready.error());
+    }
+  }
+}
+
+expected<bool, int> TcpConnection::waitFor(short events,
+                                           milliseconds timeout) {
+  struct pollfd pfd = {fd_, events, 0};
+
+  if (timeout.count() <= 0) {
+    return unexpected(ETIMEDOUT);
+  }
+  int result = poll(&pfd, 1, static_cast<int>(timeout.count()));
+  if (result < 0) {
+    return unexpected(errno);
+  }
+  if (result == 0) {
+    return unexpected(ETIMEDOUT);
+  }
+
+  /*
+   * An error or a hangup gets found out by whatever reads or writes next
+   */
+  return true;
+}
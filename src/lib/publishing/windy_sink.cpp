@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The Windy sink
+ */
+#include "include/windy_sink.h"
+
+#include <fmt/format.h>
+
+#include "include/http_status.h"
+
+using qw_units::MetersPerSecond;
+using qw_units::Pascal;
+
+WindySink::WindySink(string api_key, int station, string url)
+    : base_url_(url), station_(fmt::format("{}", station)) {
+
+  /*
+   * The key is part of the path, escape it once
+   */
+  WuUrlBuilder::appendEscaped(base_url_, api_key);
+}
+
+string_view WindySink::name() const {
+
+  return "windy";
+}
+
+expected<bool, int> WindySink::publish(const PublishedSample& sample) {
+
+  request_.start(base_url_);
+  request_.addEscapedField("station", station_);
+  request_.addEscapedField(
+      "ts", fmt::format("{}", system_clock::to_time_t(sample.time_)));
+  if (sample.temperature_.has_value() == true) {
+    request_.addNumber("temp", sample.temperature_.value().value(), 1);
+  }
+  if (sample.humidity_.has_value() == true) {
+    request_.addNumber("humidity", sample.humidity_.value().value(), 0);
+  }
+  if (sample.dewpoint_.has_value() == true) {
+    request_.addNumber("dewpoint", sample.dewpoint_.value().value(), 1);
+  }
+  if (sample.pressure_.has_value() == true) {
+    request_.addNumber("pressure", Pascal(sample.pressure_.value()).value(),
+                       0);
+  }
+  if (sample.wind_speed_avg_.has_value() == true) {
+    request_.addNumber("wind",
+                       MetersPerSecond(sample.wind_speed_avg_.value()).value(),
+                       1);
+  }
+  if (sample.wind_gust_.has_value() == true) {
+    request_.addNumber("gust",
+                       MetersPerSecond(sample.wind_gust_.value()).value(), 1);
+  }
+  if (sample.wind_direction_.has_value() == true) {
+    request_.addNumber("winddir", sample.wind_direction_.value(), 0);
+  }
+
+  response_.clear();
+  auto x_sent = connection_.get(request_.url(), response_);
+  if (x_sent.has_value() == false) {
+    return unexpected(x_sent.error());
+  }
+
+  return httpStatusResult(connection_.lastTiming().http_status_);
+}
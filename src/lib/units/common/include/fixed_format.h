@@ -0,0 +1,363 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Fixed precision formatting into a buffer the caller owns.
+ *
+ * The output is character for character what fmt gives for "{:.2f}" and
+ * friends on the float in question, but there is no format string to
+ * parse, no std::string and no float arithmetic. A float is an integer
+ * mantissa times a power of two, so it gets scaled by 10^Precision and
+ * rounded exactly with integer arithmetic. Exact halfway cases go to the
+ * even digit, like fmt and printf do.
+ *
+ * A quantity whose unit is the reference of its dimension, Celsius,
+ * Millibar and RelativeHumidity, doesn't even make the float. value() is
+ * just float(base) / base_conversion_factor, so the mantissa and exponent
+ * that float would have come straight from the integer base value with a
+ * correctly rounded integer divide. The other units are defined by float
+ * arithmetic in their Scale, so those go through value().
+ *
+ * The few values that don't fit the integer path, NaN, infinity and
+ * anything past 2^63 after scaling, are handed to fmt.
+ */
+
+#ifndef LIB_UNITS_COMMON_FIXED_FORMAT_H_
+#define LIB_UNITS_COMMON_FIXED_FORMAT_H_
+
+#include <fmt/compile.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "quantity.h"
+
+namespace qw_units {
+
+/*
+ * Big enough for any float at any precision we use, fallbacks included
+ */
+constexpr size_t kFixedFormatBufferSize = 64;
+
+constexpr int kFixedFormatMaxPrecision = 6;
+
+namespace fixed_format_internal {
+
+constexpr uint64_t kPowersOfTen[kFixedFormatMaxPrecision + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000};
+
+/*
+ * A float as negative, mantissa and exponent, value = mantissa * 2^exponent
+ */
+struct Dyadic {
+  bool negative;
+  uint64_t mantissa;
+  int exponent;
+};
+
+/*
+ * The divide below, in whatever width the numbers fit
+ */
+template <typename Word>
+constexpr Dyadic divideToFloat(bool negative, Word num, Word den, int shift) {
+  int exponent = -shift;
+
+  if (shift > 0) {
+    num <<= shift;
+  } else {
+    den <<= -shift;
+  }
+  if (num >= (den << 24)) {
+    den <<= 1;
+    exponent++;
+  }
+
+  uint64_t mantissa = static_cast<uint64_t>(num / den);
+  Word remainder = num % den;
+  if (((remainder * 2) > den) ||
+      (((remainder * 2) == den) && ((mantissa & 1) == 1))) {
+    mantissa++;
+    if (mantissa == (1ull << 24)) {
+      mantissa >>= 1;
+      exponent++;
+    }
+  }
+
+  return Dyadic{negative, mantissa, exponent};
+}
+
+/*
+ * Round numerator / denominator to a 24 bit mantissa, nearest with ties to
+ * even, the way an IEEE single precision divide does
+ */
+constexpr Dyadic divideToFloat(bool negative, uint64_t numerator,
+                               uint64_t denominator) {
+  int numerator_width = std::bit_width(numerator);
+  int denominator_width = std::bit_width(denominator);
+
+  /*
+   * Line the quotient up so it is in [2^23, 2^24). Going by the bit widths
+   * gets it to [2^23, 2^25), one more step at most finishes it. After the
+   * shift both sides are about denominator_width + 25 bits, or
+   * numerator_width + 1, so the usual sizes can be done in 64 bits.
+   */
+  int shift = 24 - (numerator_width - denominator_width);
+  if ((denominator_width <= 38) && (numerator_width <= 62)) {
+    return divideToFloat<uint64_t>(negative, numerator, denominator, shift);
+  }
+
+  return divideToFloat<unsigned __int128>(negative, numerator, denominator,
+                                          shift);
+}
+
+/*
+ * Round a magnitude to 24 significant bits, what static_cast<float>() does
+ * to an int64_t
+ */
+constexpr Dyadic integerToFloat(bool negative, uint64_t magnitude) {
+
+  if (magnitude < (1ull << 24)) {
+    return Dyadic{negative, magnitude, 0};  // exact already
+  }
+
+  return divideToFloat(negative, magnitude, 1);
+}
+
+constexpr Dyadic floatToDyadic(float value) {
+  uint32_t bits = std::bit_cast<uint32_t>(value);
+  bool negative = (bits >> 31) != 0;
+  int biased_exponent = (bits >> 23) & 0xff;
+  uint64_t mantissa = bits & 0x7fffff;
+
+  if (biased_exponent == 0) {
+    return Dyadic{negative, mantissa, -149};  // zero or subnormal
+  }
+
+  return Dyadic{negative, mantissa | 0x800000, biased_exponent - 150};
+}
+
+/*
+ * mantissa * 2^exponent * 10^precision rounded to an integer, ties to
+ * even. false if it doesn't fit in 64 bits.
+ */
+constexpr bool scaleAndRound(Dyadic value, int precision, uint64_t& scaled) {
+  unsigned __int128 product =
+      static_cast<unsigned __int128>(value.mantissa) *
+      kPowersOfTen[precision];
+
+  if (value.exponent >= 0) {
+    if ((value.exponent >= 64) || ((product >> (64 - value.exponent)) != 0)) {
+      return false;
+    }
+    scaled = static_cast<uint64_t>(product << value.exponent);
+    return true;
+  }
+
+  int shift = -value.exponent;
+  if (shift >= 127) {
+    scaled = 0;  // product is under 2^64, nowhere near half of 2^shift
+    return true;
+  }
+
+  unsigned __int128 one = 1;
+  unsigned __int128 quotient = product >> shift;
+  unsigned __int128 remainder = product & ((one << shift) - 1);
+  unsigned __int128 half = one << (shift - 1);
+  if ((remainder > half) || ((remainder == half) && ((quotient & 1) == 1))) {
+    quotient++;
+  }
+  if ((quotient >> 64) != 0) {
+    return false;
+  }
+  scaled = static_cast<uint64_t>(quotient);
+
+  return true;
+}
+
+/*
+ * Write the digits, returning how many characters it takes even if that
+ * is more than size. Like fmt, a negative value that rounds to zero still
+ * gets its minus sign.
+ */
+constexpr size_t writeFixed(char* buffer, size_t size, bool negative,
+                            uint64_t scaled, int precision) {
+  char digits[24];
+  size_t count = 0;
+
+  /*
+   * Least significant first. There are always precision fraction digits
+   * and at least one integer digit.
+   */
+  do {
+    digits[count++] = static_cast<char>('0' + (scaled % 10));
+    scaled /= 10;
+  } while ((scaled != 0) || (count <= static_cast<size_t>(precision)));
+
+  size_t length = count + (negative ? 1 : 0) + ((precision > 0) ? 1 : 0);
+  size_t position = 0;
+  auto put = [&](char c) {
+    if (position < size) {
+      buffer[position] = c;
+    }
+    position++;
+  };
+
+  if (negative == true) {
+    put('-');
+  }
+  while (count > 0) {
+    if (count == static_cast<size_t>(precision)) {
+      put('.');
+    }
+    put(digits[--count]);
+  }
+
+  return length;
+}
+
+template <int Precision>
+size_t formatFallback(char* buffer, size_t size, float value) {
+  static constexpr char spec[] = {'{', ':', '.', '0' + Precision,
+                                  'f', '}', '\0'};
+
+  return fmt::format_to_n(buffer, size, FMT_COMPILE(spec), value).size;
+}
+
+/*
+ * fallback gives the float for fmt, only asked for if it's needed
+ */
+template <int Precision, typename Fallback>
+size_t formatDyadic(char* buffer, size_t size, Dyadic value,
+                    Fallback fallback) {
+  uint64_t scaled = 0;
+
+  if (scaleAndRound(value, Precision, scaled) == false) {
+    return formatFallback<Precision>(buffer, size, fallback());
+  }
+
+  return writeFixed(buffer, size, value.negative, scaled, Precision);
+}
+
+}  // Namespace fixed_format_internal
+
+/*
+ * What fmt::format_to_n(buffer, size, "{:.<Precision>f}", value) does.
+ * Returns the length of the whole result, only size characters of it are
+ * written. Nothing is NUL terminated.
+ */
+template <int Precision>
+size_t formatFixed(char* buffer, size_t size, float value) {
+  using namespace fixed_format_internal;
+  static_assert((Precision >= 0) && (Precision <= kFixedFormatMaxPrecision));
+
+  uint32_t bits = std::bit_cast<uint32_t>(value);
+  if (((bits >> 23) & 0xff) == 0xff) {
+    return formatFallback<Precision>(buffer, size, value);  // NaN, inf
+  }
+
+  return formatDyadic<Precision>(buffer, size, floatToDyadic(value),
+                                 [value]() { return value; });
+}
+
+/*
+ * A unit value, the same as formatting value() with "{:.<Precision>f}"
+ */
+template <int Precision, typename Dimension, typename Scale, typename Rep>
+size_t formatFixed(char* buffer, size_t size,
+                   Quantity<Dimension, Scale, Rep> unit) {
+  using namespace fixed_format_internal;
+  static_assert((Precision >= 0) && (Precision <= kFixedFormatMaxPrecision));
+
+  if constexpr (std::is_same_v<Scale, ReferenceScale> == false) {
+    return formatFixed<Precision>(buffer, size, unit.value());
+  } else {
+    int64_t base = unit.baseValue();
+    bool negative = base < 0;
+    uint64_t magnitude = negative ? (0 - static_cast<uint64_t>(base))
+                                  : static_cast<uint64_t>(base);
+
+    if (magnitude == 0) {
+      return writeFixed(buffer, size, false, 0, Precision);
+    }
+
+    /*
+     * The int64_t to float conversion first, then the divide
+     */
+    Dyadic as_float = integerToFloat(negative, magnitude);
+    Dyadic divided = divideToFloat(
+        negative, as_float.mantissa,
+        static_cast<uint64_t>(Dimension::base_conversion_factor));
+    divided.exponent += as_float.exponent;
+
+    return formatDyadic<Precision>(buffer, size, divided,
+                                   [unit]() { return unit.value(); });
+  }
+}
+
+/*
+ * With the unit's default precision, what "{}" gives
+ */
+template <typename Dimension, typename Scale, typename Rep>
+size_t formatFixed(char* buffer, size_t size,
+                   Quantity<Dimension, Scale, Rep> unit) {
+
+  return formatFixed<Dimension::default_precision>(buffer, size, unit);
+}
+
+/*
+ * For when the precision is only known at run time, a field table for
+ * example. Each precision is its own compiled formatter.
+ */
+inline size_t formatFixed(char* buffer, size_t size, float value,
+                          int precision) {
+
+  switch (precision) {
+    case 0:
+      return formatFixed<0>(buffer, size, value);
+    case 1:
+      return formatFixed<1>(buffer, size, value);
+    case 2:
+      return formatFixed<2>(buffer, size, value);
+    case 3:
+      return formatFixed<3>(buffer, size, value);
+    case 4:
+      return formatFixed<4>(buffer, size, value);
+    case 5:
+      return formatFixed<5>(buffer, size, value);
+    case 6:
+      return formatFixed<6>(buffer, size, value);
+  }
+
+  return fmt::format_to_n(buffer, size, "{:.{}f}", value, precision).size;
+}
+
+}  // Namespace qw_units
+
+/*
+ * Formats value(). "{}" uses the dimension's default precision and goes
+ * through formatFixed(), anything else is the float formatter.
+ */
+template <typename Dimension, typename Scale, typename Rep>
+struct fmt::formatter<qw_units::Quantity<Dimension, Scale, Rep>>
+    : qw_units::UnitFormatter {
+  constexpr formatter() : UnitFormatter(Dimension::default_spec) {}
+
+  template <typename FormatContext>
+  auto format(const qw_units::Quantity<Dimension, Scale, Rep>& unit,
+              FormatContext& ctx) const {
+
+    if (isDefault() == true) {
+      char buffer[qw_units::kFixedFormatBufferSize];
+      size_t length = qw_units::formatFixed(buffer, sizeof(buffer), unit);
+      return std::copy_n(buffer, length, ctx.out());
+    }
+
+    return fmt::formatter<float>::format(unit.value(), ctx);
+  }
+};
+
+#endif  // LIB_UNITS_COMMON_FIXED_FORMAT_H_
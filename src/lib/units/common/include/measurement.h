@@ -0,0 +1,69 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Any measurement involves the reading, the accuracy and the time of the
+ * reading.
+ *
+ * The reading and accuracy are kept as the quantity the measurement is
+ * declared with. Any other unit of the same dimension can be handed to the
+ * constructor, or asked for with valueAs<>() and accuracyAs<>(), since
+ * they all share the base value.
+ */
+
+#ifndef LIB_UNITS_COMMON_MEASUREMENT_H_
+#define LIB_UNITS_COMMON_MEASUREMENT_H_
+
+#include <chrono>
+
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_units {
+
+template <typename Quantity>
+class Measurement {
+ public:
+  constexpr Measurement() = default;
+
+  constexpr Measurement(Quantity value, Quantity accuracy,
+                        time_point<system_clock> time)
+      : value_(value), accuracy_(accuracy), time_(time) {}
+
+  constexpr Quantity value() const {
+
+    return value_;
+  }
+
+  constexpr Quantity accuracy() const {
+
+    return accuracy_;
+  }
+
+  constexpr time_point<system_clock> time() const {
+
+    return time_;
+  }
+
+  template <typename Unit>
+  constexpr Unit valueAs() const {
+
+    return Unit(value_);
+  }
+
+  template <typename Unit>
+  constexpr Unit accuracyAs() const {
+
+    return Unit(accuracy_);
+  }
+
+ private:
+  Quantity value_;
+  Quantity accuracy_;
+  time_point<system_clock> time_;
+};
+
+}  // Namespace qw_units
+
+#endif  // LIB_UNITS_COMMON_MEASUREMENT_H_
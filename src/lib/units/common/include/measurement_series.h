@@ -0,0 +1,318 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * A run of measurements of one quantity, kept as columns.
+ *
+ * A vector<TemperatureMeasurement> keeps the time, value and accuracy of
+ * each reading together. Anything that works over a lot of readings, a
+ * batch kernel or a history scan, only wants one of those at a time and
+ * ends up striding over the rest. Here the times, the integer base values
+ * and the quality flags are each their own contiguous array. The accuracy
+ * comes from the sensor and is the same for every reading, so the series
+ * keeps just the one.
+ *
+ * A MeasurementSeriesView is a window onto the columns of a series, or of
+ * anything else that keeps its readings that way. It doesn't own or copy
+ * anything, so it is only good while what it looks at isn't appended to
+ * or cleared.
+ */
+
+#ifndef LIB_UNITS_COMMON_MEASUREMENT_SERIES_H_
+#define LIB_UNITS_COMMON_MEASUREMENT_SERIES_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "measurement.h"
+
+using std::span;
+using std::vector;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_units {
+
+/*
+ * Bits in the quality column. Zero is a reading straight from the sensor.
+ */
+enum MeasurementQuality : uint8_t {
+  MEASUREMENT_QUALITY_GOOD = 0x00,
+  MEASUREMENT_QUALITY_FILTERED = 0x01,  // a filter replaced the reading
+};
+
+template <typename Quantity>
+class MeasurementSeriesView {
+ public:
+  using rep = typename Quantity::rep;
+
+  constexpr MeasurementSeriesView() = default;
+
+  /*
+   * The columns have to be the same length. The quality column can be left
+   * empty, then every reading is MEASUREMENT_QUALITY_GOOD.
+   */
+  constexpr MeasurementSeriesView(span<const time_point<system_clock>> times,
+                                  span<const rep> values,
+                                  span<const uint8_t> quality,
+                                  Quantity accuracy)
+      : times_(times), values_(values), quality_(quality),
+        accuracy_(accuracy) {}
+
+  constexpr size_t size() const {
+
+    return times_.size();
+  }
+
+  constexpr bool empty() const {
+
+    return times_.empty();
+  }
+
+  constexpr span<const time_point<system_clock>> times() const {
+
+    return times_;
+  }
+
+  /*
+   * The base values, ready for the batch kernels
+   */
+  constexpr span<const rep> values() const {
+
+    return values_;
+  }
+
+  constexpr span<const uint8_t> quality() const {
+
+    return quality_;
+  }
+
+  constexpr Quantity accuracy() const {
+
+    return accuracy_;
+  }
+
+  constexpr time_point<system_clock> time(size_t index) const {
+
+    return times_[index];
+  }
+
+  constexpr Quantity value(size_t index) const {
+
+    return Quantity::fromBase(values_[index]);
+  }
+
+  constexpr uint8_t quality(size_t index) const {
+
+    if (quality_.empty() == true) {
+      return MEASUREMENT_QUALITY_GOOD;
+    }
+
+    return quality_[index];
+  }
+
+  /*
+   * One reading put back together
+   */
+  constexpr Measurement<Quantity> operator[](size_t index) const {
+
+    return Measurement<Quantity>(value(index), accuracy_, times_[index]);
+  }
+
+  /*
+   * Readings first <= index < last. Out of range indexes are pulled back
+   * to the ends rather than being an error.
+   */
+  constexpr MeasurementSeriesView slice(size_t first, size_t last) const {
+
+    last = std::min(last, size());
+    first = std::min(first, last);
+
+    span<const uint8_t> quality = quality_;
+    if (quality.empty() == false) {
+      quality = quality.subspan(first, last - first);
+    }
+
+    return MeasurementSeriesView(times_.subspan(first, last - first),
+                                 values_.subspan(first, last - first),
+                                 quality, accuracy_);
+  }
+
+  /*
+   * Readings with from <= time < to. The times have to be in order.
+   */
+  constexpr MeasurementSeriesView slice(time_point<system_clock> from,
+                                        time_point<system_clock> to) const {
+
+    size_t first = std::lower_bound(times_.begin(), times_.end(), from) -
+                   times_.begin();
+    size_t last =
+        std::lower_bound(times_.begin(), times_.end(), to) - times_.begin();
+
+    return slice(first, last);
+  }
+
+ private:
+  span<const time_point<system_clock>> times_;
+  span<const rep> values_;
+  span<const uint8_t> quality_;
+  Quantity accuracy_;
+};
+
+template <typename Quantity>
+class MeasurementSeries {
+ public:
+  using rep = typename Quantity::rep;
+
+  MeasurementSeries() = default;
+
+  MeasurementSeries(Quantity accuracy) : accuracy_(accuracy) {}
+
+  /*
+   * The series keeps one accuracy, the one from the last measurement
+   * appended.
+   */
+  void append(const Measurement<Quantity>& measurement,
+              uint8_t quality = MEASUREMENT_QUALITY_GOOD) {
+
+    accuracy_ = measurement.accuracy();
+    append(measurement.time(), measurement.value(), quality);
+
+    return;
+  }
+
+  void append(time_point<system_clock> time, Quantity value,
+              uint8_t quality = MEASUREMENT_QUALITY_GOOD) {
+
+    times_.push_back(time);
+    values_.push_back(static_cast<rep>(value.baseValue()));
+    quality_.push_back(quality);
+
+    return;
+  }
+
+  /*
+   * Add count readings whose columns get filled in directly, by a batch
+   * kernel for example. The new readings are MEASUREMENT_QUALITY_GOOD and
+   * their times and values are zero until they are written. Returns the
+   * index of the first one.
+   */
+  size_t extend(size_t count) {
+    size_t first = times_.size();
+
+    times_.resize(first + count);
+    values_.resize(first + count);
+    quality_.resize(first + count, MEASUREMENT_QUALITY_GOOD);
+
+    return first;
+  }
+
+  /*
+   * Writable columns, for filling in what extend() added
+   */
+  span<time_point<system_clock>> times() {
+
+    return times_;
+  }
+
+  span<rep> values() {
+
+    return values_;
+  }
+
+  span<uint8_t> quality() {
+
+    return quality_;
+  }
+
+  MeasurementSeriesView<Quantity> view() const {
+
+    return MeasurementSeriesView<Quantity>(times_, values_, quality_,
+                                           accuracy_);
+  }
+
+  MeasurementSeriesView<Quantity> slice(size_t first, size_t last) const {
+
+    return view().slice(first, last);
+  }
+
+  MeasurementSeriesView<Quantity> slice(time_point<system_clock> from,
+                                        time_point<system_clock> to) const {
+
+    return view().slice(from, to);
+  }
+
+  Measurement<Quantity> operator[](size_t index) const {
+
+    return view()[index];
+  }
+
+  Quantity accuracy() const {
+
+    return accuracy_;
+  }
+
+  void setAccuracy(Quantity accuracy) {
+
+    accuracy_ = accuracy;
+
+    return;
+  }
+
+  size_t size() const {
+
+    return times_.size();
+  }
+
+  bool empty() const {
+
+    return times_.empty();
+  }
+
+  void reserve(size_t count) {
+
+    times_.reserve(count);
+    values_.reserve(count);
+    quality_.reserve(count);
+
+    return;
+  }
+
+  /*
+   * Keep the first count readings, for taking readings back out after
+   * the columns have been compacted
+   */
+  void truncate(size_t count) {
+
+    count = std::min(count, size());
+    times_.resize(count);
+    values_.resize(count);
+    quality_.resize(count);
+
+    return;
+  }
+
+  void clear() {
+
+    times_.clear();
+    values_.clear();
+    quality_.clear();
+
+    return;
+  }
+
+ private:
+  vector<time_point<system_clock>> times_;
+  vector<rep> values_;
+  vector<uint8_t> quality_;
+  Quantity accuracy_;
+};
+
+}  // Namespace qw_units
+
+#endif  // LIB_UNITS_COMMON_MEASUREMENT_SERIES_H_
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * One template for all the unit classes.
+ *
+ * A Quantity is a Dimension (temperature, pressure, ...), a Scale that says
+ * how the unit relates to the dimension's reference unit, and an integer
+ * Rep that holds the fixed point base value. Every unit of a dimension
+ * keeps the same base, millicelsius for all the temperatures for example,
+ * so converting Fahrenheit to Celsius is a copy of the base and the
+ * compiler sorts out which copies are allowed. Trying to turn a pressure
+ * into a temperature doesn't compile.
+ *
+ * The Scale only comes into it going to and from float, in the constructor
+ * and value(). Those are constexpr, the constants are template arguments,
+ * so a conversion of a constant is done at compile time.
+ *
+ * fixedValue() and fromFixed() are the same conversions done exactly, in
+ * integers, with the Scale's constants as ratios. They are for code that
+ * wants a unit's value as an integer count of hundredths or whatever, and
+ * for machines without floating point hardware.
+ *
+ * A Dimension is a struct with:
+ *   base_conversion_factor - base units per reference unit
+ *   default_spec           - how "{}" formats a value
+ *   default_precision      - the decimals in default_spec
+ */
+
+#ifndef LIB_UNITS_COMMON_QUANTITY_H_
+#define LIB_UNITS_COMMON_QUANTITY_H_
+
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <ratio>
+#include <type_traits>
+
+#include "unit_base.h"
+
+using std::strong_ordering;
+
+namespace qw_units {
+
+/*
+ * unit = ((reference * Multiplier) / Divisor) + Offset
+ *
+ * The operations are done in that order, in float, which is what the hand
+ * written unit classes did, so the values and the text that gets sent
+ * anywhere come out the same. Steps that would do nothing are skipped at
+ * compile time.
+ *
+ * ExactRatio and ExactOffset are Multiplier / Divisor and Offset as
+ * std::ratio, what the float constants are meant to be before they get
+ * rounded to float. The integer conversions use those.
+ */
+template <float Multiplier, float Divisor, float Offset,
+          typename ExactRatio = std::ratio<1>,
+          typename ExactOffset = std::ratio<0>>
+struct AffineScale {
+  using ratio = ExactRatio;
+  using offset = ExactOffset;
+
+  /*
+   * Catch a ratio that doesn't go with its float constants
+   */
+  static constexpr float ratio_value =
+      static_cast<float>(ExactRatio::num) / ExactRatio::den;
+  static constexpr float offset_value =
+      static_cast<float>(ExactOffset::num) / ExactOffset::den;
+  static_assert((((Multiplier / Divisor) - ratio_value) < 1e-6f) &&
+                ((ratio_value - (Multiplier / Divisor)) < 1e-6f));
+  static_assert(((Offset - offset_value) < 1e-4f) &&
+                ((offset_value - Offset) < 1e-4f));
+
+  static constexpr float fromReference(float reference) {
+    float unit = reference;
+
+    if constexpr (Multiplier != 1.0f) {
+      unit *= Multiplier;
+    }
+    if constexpr (Divisor != 1.0f) {
+      unit /= Divisor;
+    }
+    if constexpr (Offset != 0.0f) {
+      unit += Offset;
+    }
+
+    return unit;
+  }
+
+  static constexpr float toReference(float unit) {
+    float reference = unit;
+
+    if constexpr (Offset != 0.0f) {
+      reference -= Offset;
+    }
+    if constexpr (Divisor != 1.0f) {
+      reference *= Divisor;
+    }
+    if constexpr (Multiplier != 1.0f) {
+      reference /= Multiplier;
+    }
+
+    return reference;
+  }
+};
+
+/*
+ * The reference unit of a dimension
+ */
+using ReferenceScale = AffineScale<1.0f, 1.0f, 0.0f>;
+
+template <typename Dimension, typename Scale, std::integral Rep = int64_t>
+class Quantity {
+ public:
+  using dimension = Dimension;
+  using scale = Scale;
+  using rep = Rep;
+
+  constexpr Quantity() = default;
+
+  constexpr Quantity(float value)
+      : base_value_(static_cast<Rep>(
+            roundToBase(Scale::toReference(value) *
+                        Dimension::base_conversion_factor))) {}
+
+  /*
+   * Any other unit of the same dimension. The base is shared so this is
+   * just a copy, and it's implicit so Celsius tempc = tempf; works.
+   */
+  template <typename OtherScale, std::integral OtherRep>
+  constexpr Quantity(const Quantity<Dimension, OtherScale, OtherRep>& other)
+      : base_value_(static_cast<Rep>(other.baseValue())) {}
+
+  /*
+   * Straight from a base value
+   */
+  static constexpr Quantity fromBase(int64_t base_value) {
+    Quantity unit;
+
+    unit.base_value_ = static_cast<Rep>(base_value);
+
+    return unit;
+  }
+
+  constexpr float value() const {
+
+    return Scale::fromReference(static_cast<float>(base_value_) /
+                                Dimension::base_conversion_factor);
+  }
+
+  /*
+   * The integer base value. History and statistics code works on this
+   * directly so it doesn't round trip through float.
+   */
+  constexpr int64_t baseValue() const {
+
+    return base_value_;
+  }
+
+  /*
+   * The value in this unit times Denominator, exactly rounded half away
+   * from zero. Fahrenheit(tempc).fixedValue<100>() is hundredths of a
+   * degree Fahrenheit with no float anywhere.
+   *
+   * value = (base / factor) * ratio + offset, put over one denominator:
+   *   ((base * ratio_num * offset_den) +
+   *    (offset_num * factor * ratio_den)) / (factor * ratio_den * offset_den)
+   */
+  template <int64_t Denominator>
+  constexpr int64_t fixedValue() const {
+    using Ratio = typename Scale::ratio;
+    using Offset = typename Scale::offset;
+    constexpr __int128 factor = Dimension::base_conversion_factor;
+
+    __int128 numerator =
+        ((static_cast<__int128>(base_value_) * Ratio::num * Offset::den) +
+         (static_cast<__int128>(Offset::num) * factor * Ratio::den)) *
+        Denominator;
+
+    return static_cast<int64_t>(divideRounded<__int128>(
+        numerator, factor * Ratio::den * Offset::den));
+  }
+
+  /*
+   * The other way, from value * Denominator in this unit to the base.
+   * Fahrenheit::fromFixed<10>(725) is 72.5 F.
+   */
+  template <int64_t Denominator>
+  static constexpr Quantity fromFixed(int64_t value) {
+    using Ratio = typename Scale::ratio;
+    using Offset = typename Scale::offset;
+    constexpr __int128 factor = Dimension::base_conversion_factor;
+
+    __int128 numerator =
+        ((static_cast<__int128>(value) * Offset::den) -
+         (static_cast<__int128>(Offset::num) * Denominator)) *
+        Ratio::den * factor;
+
+    return fromBase(static_cast<int64_t>(divideRounded<__int128>(
+        numerator,
+        static_cast<__int128>(Denominator) * Offset::den * Ratio::num)));
+  }
+
+  constexpr bool operator==(const Quantity& other) const = default;
+
+  constexpr strong_ordering operator<=>(const Quantity& other) const = default;
+
+  constexpr Quantity& operator+=(const Quantity& other) {
+
+    base_value_ += other.base_value_;
+
+    return *this;
+  }
+
+  constexpr Quantity& operator-=(const Quantity& other) {
+
+    base_value_ -= other.base_value_;
+
+    return *this;
+  }
+
+  constexpr Quantity operator+(const Quantity& other) const {
+    Quantity result = *this;
+
+    result += other;
+
+    return result;
+  }
+
+  constexpr Quantity operator-(const Quantity& other) const {
+    Quantity result = *this;
+
+    result -= other;
+
+    return result;
+  }
+
+ private:
+  Rep base_value_ = 0;
+};
+
+}  // Namespace qw_units
+
+/*
+ * The fmt::formatter for Quantity is with the fixed precision formatting
+ * it uses
+ */
+#include "fixed_format.h"
+
+#endif  // LIB_UNITS_COMMON_QUANTITY_H_
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Sum and mean of a run of unit values, in the integer base.
+ *
+ * The sum is an exact integer so it doesn't drift no matter how many values
+ * go in or come back out, which a floating point running sum does once it
+ * has seen enough of them. Removing a value is exact too, so the same
+ * accumulator works for a sliding window. The mean rounds half away from
+ * zero like the unit constructors.
+ *
+ * An int64_t sum of milli-millibars, the biggest base we have at around a
+ * million per reading, has room for about 9 trillion readings. Anything
+ * that would still take the sum past that, a base value that is garbage
+ * say, gets EOVERFLOW and leaves the accumulator as it was, rather than
+ * wrapping around to a mean that looks like a reading.
+ */
+
+#ifndef LIB_UNITS_COMMON_QUANTITY_ACCUMULATOR_H_
+#define LIB_UNITS_COMMON_QUANTITY_ACCUMULATOR_H_
+
+#include <errno.h>
+#include <cstdint>
+#include <expected>
+
+#include "measurement_series.h"
+#include "unit_base.h"
+
+using std::expected;
+using std::unexpected;
+
+namespace qw_units {
+
+template <typename Quantity>
+class QuantityAccumulator {
+ public:
+  constexpr QuantityAccumulator() = default;
+
+  constexpr expected<bool, int> add(Quantity value) {
+    int64_t sum;
+
+    if (__builtin_add_overflow(sum_, value.baseValue(), &sum) == true) {
+      return unexpected(EOVERFLOW);
+    }
+    sum_ = sum;
+    count_++;
+
+    return true;
+  }
+
+  /*
+   * Take back a value that was added
+   */
+  constexpr expected<bool, int> remove(Quantity value) {
+    int64_t sum;
+
+    if (count_ <= 0) {
+      return unexpected(ENODATA);
+    }
+    if (__builtin_sub_overflow(sum_, value.baseValue(), &sum) == true) {
+      return unexpected(EOVERFLOW);
+    }
+    sum_ = sum;
+    count_--;
+
+    return true;
+  }
+
+  /*
+   * Fold in another accumulator, for combining per bucket sums
+   */
+  constexpr expected<bool, int> add(const QuantityAccumulator& other) {
+    int64_t sum;
+
+    if (__builtin_add_overflow(sum_, other.sum_, &sum) == true) {
+      return unexpected(EOVERFLOW);
+    }
+    sum_ = sum;
+    count_ += other.count_;
+
+    return true;
+  }
+
+  /*
+   * The exact sum of the base values
+   */
+  constexpr int64_t sum() const {
+
+    return sum_;
+  }
+
+  constexpr int64_t count() const {
+
+    return count_;
+  }
+
+  constexpr expected<Quantity, int> mean() const {
+
+    if (count_ <= 0) {
+      return unexpected(ENODATA);
+    }
+
+    return Quantity::fromBase(divideRounded(sum_, count_));
+  }
+
+  constexpr void clear() {
+
+    sum_ = 0;
+    count_ = 0;
+
+    return;
+  }
+
+ private:
+  int64_t sum_ = 0;
+  int64_t count_ = 0;
+};
+
+/*
+ * Everything in a series, straight off the value column
+ */
+template <typename Quantity>
+constexpr expected<QuantityAccumulator<Quantity>, int> accumulate(
+    MeasurementSeriesView<Quantity> series) {
+  QuantityAccumulator<Quantity> accumulator;
+
+  for (auto value : series.values()) {
+    auto x_added = accumulator.add(Quantity::fromBase(value));
+    if (x_added.has_value() == false) {
+      return unexpected(x_added.error());
+    }
+  }
+
+  return accumulator;
+}
+
+}  // Namespace qw_units
+
+#endif  // LIB_UNITS_COMMON_QUANTITY_ACCUMULATOR_H_
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * What all the unit classes share.
+ *
+ * A unit value is nothing but its integer base value, 8 bytes and
+ * trivially copyable, so it can be copied around and stored by the
+ * million without allocating. How a value gets printed lives in the
+ * fmt::formatter for its class, not in the value.
+ */
+
+#ifndef LIB_UNITS_COMMON_UNIT_BASE_H_
+#define LIB_UNITS_COMMON_UNIT_BASE_H_
+
+#include <fmt/format.h>
+#include <cstdint>
+#include <string_view>
+
+namespace qw_units {
+
+/*
+ * round() to the nearest base unit, halfway cases away from zero, but
+ * usable in a constexpr. Truncate and then look at what was cut off, both
+ * steps are exact in float so this matches round() for every input.
+ */
+constexpr int64_t roundToBase(float value) {
+
+  int64_t truncated = static_cast<int64_t>(value);
+  float fraction = value - static_cast<float>(truncated);
+
+  if (fraction >= 0.5f) {
+    return truncated + 1;
+  }
+  if (fraction <= -0.5f) {
+    return truncated - 1;
+  }
+
+  return truncated;
+}
+
+/*
+ * numerator / denominator rounded half away from zero, the integer version
+ * of roundToBase(). The denominator has to be positive. Works for any
+ * integer type, __int128 included, for when the numerator needs room.
+ *
+ * It rounds on the remainder instead of adding half the denominator first,
+ * so a numerator right up against the limit of its type, a sum of a lot of
+ * readings say, can't overflow. remainder is always smaller than
+ * denominator so comparing it with what is left over can't either.
+ */
+template <typename Integer>
+constexpr Integer divideRounded(Integer numerator, Integer denominator) {
+  Integer quotient = numerator / denominator;
+  Integer remainder = numerator % denominator;
+
+  if (numerator >= 0) {
+    if (remainder >= (denominator - remainder)) {
+      quotient++;
+    }
+  } else if (-remainder >= (denominator + remainder)) {
+    quotient--;
+  }
+
+  return quotient;
+}
+
+/*
+ * The base for the unit fmt::formatter specializations. The value gets
+ * formatted as a float, so "{:.1f}" and friends work. An empty spec, "{}",
+ * gets the unit's default precision instead of the shortest float.
+ */
+class UnitFormatter : public fmt::formatter<float> {
+ public:
+  constexpr UnitFormatter(std::string_view default_spec)
+      : default_spec_(default_spec) {}
+
+  constexpr auto parse(fmt::format_parse_context& ctx) {
+
+    if ((ctx.begin() == ctx.end()) || (*ctx.begin() == '}')) {
+      fmt::format_parse_context default_ctx(default_spec_);
+      fmt::formatter<float>::parse(default_ctx);
+      default_ = true;
+      return ctx.begin();
+    }
+
+    default_ = false;
+
+    return fmt::formatter<float>::parse(ctx);
+  }
+
+ protected:
+  /*
+   * True when the format didn't give a spec, so the default is in use
+   */
+  constexpr bool isDefault() const {
+
+    return default_;
+  }
+
+ private:
+  std::string_view default_spec_;
+  bool default_ = false;
+};
+
+}  // Namespace qw_units
+
+#endif  // LIB_UNITS_COMMON_UNIT_BASE_H_
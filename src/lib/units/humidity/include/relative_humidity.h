@@ -8,7 +8,12 @@
 #include <fmt/format.h>
 #include <math.h>
 #include <compare>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "quantity.h"
 
 using fmt::format;
 using std::string;
@@ -17,56 +22,28 @@ using std::strong_ordering;
 namespace qw_units {
 
 constexpr int rh_base_conversion_factor = 100;
-constexpr string relative_humidity_default_format = "{0:.1f}";
-
-class RelativeHumidity {
- public:
-  RelativeHumidity();
-
-  RelativeHumidity(float rh);
-
-  RelativeHumidity(float rh, string fmt_value);
-
-  bool operator==(const RelativeHumidity& other) const;
-
-  bool operator!=(const RelativeHumidity& other) const;
-
-  bool operator<(const RelativeHumidity& other) const;
-
-  bool operator>(const RelativeHumidity& other) const;
-
-  bool operator<=(const RelativeHumidity& other) const;
-
-  bool operator>=(const RelativeHumidity& other) const;
-
-  strong_ordering operator<=> (const RelativeHumidity& other) const;
-
-  RelativeHumidity& operator=(const RelativeHumidity& other);
-
-  RelativeHumidity& operator+=(const RelativeHumidity& other);
 
-  RelativeHumidity& operator-=(const RelativeHumidity& other);
-
-  const RelativeHumidity operator+(const RelativeHumidity& other) const;
-
-  const RelativeHumidity operator-(const RelativeHumidity& other) const;
-
-  float value();
-
-  string toString();
-
-  string toString(string format);
-
-  void setFormat(string fmt_value);
+/*
+ * How a relative humidity prints when the format doesn't say, as in "{}"
+ */
+constexpr std::string_view relative_humidity_default_spec = ".1f";
 
- private:
-  int base_value_;
+struct RelativeHumidityDimension {
+  static constexpr int base_conversion_factor = rh_base_conversion_factor;
+  static constexpr std::string_view default_spec =
+      relative_humidity_default_spec;
+  static constexpr int default_precision = 1;
+};
 
-  string fmt_value_ = relative_humidity_default_format;
+/*
+ * Percent, base value in hundredths of a percent. There is only the one
+ * unit of relative humidity.
+ */
+using RelativeHumidity = Quantity<RelativeHumidityDimension, ReferenceScale>;
 
-  void setBaseValue(int base_value);
-};
+static_assert(sizeof(RelativeHumidity) == sizeof(int64_t));
+static_assert(std::is_trivially_copyable_v<RelativeHumidity>);
 
 }  // Namespace qw_units
 
-#endif  // LIB_UNITS_HUMIDITY_RELATIVE_HUMIDITY_H_
\ No newline at end of file
+#endif  // LIB_UNITS_HUMIDITY_RELATIVE_HUMIDITY_H_
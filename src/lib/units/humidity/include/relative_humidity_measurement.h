@@ -5,6 +5,10 @@
 #define LIB_UNITS_RELATIVE_HUMIDITY_MEASUREMENT_H_
 
 #include <chrono>
+#include <type_traits>
+
+#include "measurement.h"
+#include "measurement_series.h"
 #include "relative_humidity.h"
 
 using std::chrono::system_clock;
@@ -12,29 +16,34 @@ using std::chrono::time_point;
 
 namespace qw_units {
 
-class RelativeHumidityMeasurement {
+class RelativeHumidityMeasurement : public Measurement<RelativeHumidity> {
  public:
-  RelativeHumidityMeasurement();
-
-  RelativeHumidityMeasurement(RelativeHumidity value, RelativeHumidity accuracy,
-                              time_point<system_clock> time);
+  using Measurement::Measurement;
 
-  RelativeHumidity value();
+  /*
+   * These would make more sense if there was more than one
+   * unit of relative humidity. They are value() and accuracy()
+   * for symmetry with the other units.
+   */
+  constexpr RelativeHumidity relativeHumidityValue() const {
 
-  RelativeHumidity accuracy();
+    return value();
+  }
 
-  time_point<system_clock> time();
+  constexpr RelativeHumidity relativeHumidityAccuracy() const {
 
-  RelativeHumidity relativeHumidityValue();
+    return accuracy();
+  }
+};
 
-  RelativeHumidity relativeHumidityAccuracy();
+static_assert(std::is_trivially_copyable_v<RelativeHumidityMeasurement>);
 
- private:
-  RelativeHumidity value_;
-  RelativeHumidity accuracy_;
-  time_point<system_clock> time_;
-};
+/*
+ * Columns of readings, see measurement_series.h
+ */
+using RelativeHumiditySeries = MeasurementSeries<RelativeHumidity>;
+using RelativeHumiditySeriesView = MeasurementSeriesView<RelativeHumidity>;
 
 }  // Namespace qw_units
 
-#endif  // LIB_UNITS_RELATIVE_HUMIDITY_MEASUREMENT_H_
\ No newline at end of file
+#endif  // LIB_UNITS_RELATIVE_HUMIDITY_MEASUREMENT_H_
@@ -5,85 +5,25 @@
 #ifndef LIB_UNITS_PRESSURE_MILLIBAR_H_
 #define LIB_UNITS_PRESSURE_MILLIBAR_H_
 
-#include <fmt/format.h>
-#include <math.h>
-#include <compare>
-#include <string>
+#include <cstdint>
+#include <type_traits>
 
-#include "inches_mercury.h"
+#include "quantity.h"
 #include "pressure.h"
 
-using fmt::format;
-using std::string;
-using std::strong_ordering;
-
 namespace qw_units {
+
 /*
- * Need to predeclare these classes
- * I found that out the hard way
+ * Base value in milli-millibars
  */
-class InchesMercury;
-
-class Millibar {
-
-  friend InchesMercury;
-
- public:
-  Millibar();
-
-  Millibar(float temp);
-
-  Millibar(float temp, string fmt_value);
-
-  float value();
-
-  string toString();
-
-  string toString(string format);
-
-  void setFormat(string fmt_value);
-
-  bool operator==(const Millibar& other) const;
-
-  bool operator!=(const Millibar& other) const;
-
-  bool operator<(const Millibar& other) const;
-
-  bool operator>(const Millibar& other) const;
+using Millibar = Quantity<PressureDimension, MillibarScale>;
 
-  bool operator<=(const Millibar& other) const;
-
-  bool operator>=(const Millibar& other) const;
-
-  strong_ordering operator<=> (const Millibar& other) const;
-
-  Millibar& operator=(const Millibar& other);
-
-  Millibar& operator+=(const Millibar& other);
-
-  Millibar& operator-=(const Millibar& other);
-
-  const Millibar operator+(const Millibar& other) const;
-
-  const Millibar operator-(const Millibar& other) const;
-
-  /*
-   * Supports implicit casting
-   */
-  operator InchesMercury() const;
-
- private:
-  int64_t base_value_;
-
-  string fmt_value_ = pressure_default_format;
-
-  int MillibarToBase(float temp);
-
-  float BaseToMillibar(int base);
-
-  void setBaseValue(int base_value);
-};
+static_assert(sizeof(Millibar) == sizeof(int64_t));
+static_assert(std::is_trivially_copyable_v<Millibar>);
 
 }  // Namespace qw_units
 
-#endif  // LIB_UNITS_PRESSURE_MILLIBAR_H_
\ No newline at end of file
+#include "inches_mercury.h"
+#include "pascal.h"
+
+#endif  // LIB_UNITS_PRESSURE_MILLIBAR_H_
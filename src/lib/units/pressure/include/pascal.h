@@ -0,0 +1,28 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#ifndef LIB_UNITS_PRESSURE_PASCAL_H_
+#define LIB_UNITS_PRESSURE_PASCAL_H_
+
+#include <cstdint>
+#include <type_traits>
+
+#include "quantity.h"
+#include "pressure.h"
+
+namespace qw_units {
+
+/*
+ * Milli-millibars too, the base is not pascals
+ */
+using Pascal = Quantity<PressureDimension, PascalScale>;
+
+static_assert(sizeof(Pascal) == sizeof(int64_t));
+static_assert(std::is_trivially_copyable_v<Pascal>);
+
+}  // Namespace qw_units
+
+#include "millibar.h"
+
+#endif  // LIB_UNITS_PRESSURE_PASCAL_H_
@@ -8,7 +8,11 @@
 #include <fmt/format.h>
 #include <math.h>
 #include <compare>
+#include <ratio>
 #include <string>
+#include <string_view>
+
+#include "quantity.h"
 
 using fmt::format;
 using std::string;
@@ -23,7 +27,30 @@ namespace qw_units {
 constexpr int pressure_base_conversion_factor = 1000;
 constexpr float inHg_sea_level = 29.92;  // inches mersury at eea level
 constexpr float mb_sea_level = 1013.25;  // millibars at sea level
-constexpr string pressure_default_format = "{0:.2f}";
+
+/*
+ * inHg_sea_level / mb_sea_level as an exact ratio
+ */
+using inches_mercury_per_millibar = std::ratio<2992, 101325>;
+
+/*
+ * How a pressure prints when the format doesn't say, as in "{}"
+ */
+constexpr std::string_view pressure_default_spec = ".2f";
+
+struct PressureDimension {
+  static constexpr int base_conversion_factor = pressure_base_conversion_factor;
+  static constexpr std::string_view default_spec = pressure_default_spec;
+  static constexpr int default_precision = 2;
+};
+
+/*
+ * Millibars are the reference
+ */
+using MillibarScale = ReferenceScale;
+using InchesMercuryScale = AffineScale<inHg_sea_level, mb_sea_level, 0.0f,
+                                       inches_mercury_per_millibar>;
+using PascalScale = AffineScale<100.0f, 1.0f, 0.0f, std::ratio<100>>;
 
 }  // Namespace qw_units
 
@@ -5,45 +5,55 @@
 #define LIB_UNITS_PRESSURE_MEASUREMENT_H_
 
 #include <chrono>
-#include <variant>
+#include <type_traits>
+
 #include "inches_mercury.h"
+#include "measurement.h"
+#include "measurement_series.h"
 #include "millibar.h"
 #include "pressure.h"
 
-using std::variant;
 using std::chrono::system_clock;
 using std::chrono::time_point;
 
 namespace qw_units {
 
-class PressureMeasurement {
+/*
+ * Kept in millibars, inches of mercury convert on the way in
+ */
+class PressureMeasurement : public Measurement<Millibar> {
  public:
-  PressureMeasurement();
-
-  PressureMeasurement(variant<Millibar, InchesMercury> value,
-                      variant<Millibar, InchesMercury> accuracy,
-                      time_point<system_clock> time);
+  using Measurement::Measurement;
 
-  variant<Millibar, InchesMercury> value();
+  constexpr Millibar millibarValue() const {
 
-  variant<Millibar, InchesMercury> accuracy();
+    return value();
+  }
 
-  time_point<system_clock> time();
+  constexpr InchesMercury inchesMercuryValue() const {
 
-  Millibar millibarValue();
+    return valueAs<InchesMercury>();
+  }
 
-  InchesMercury inchesMercuryValue();
+  constexpr Millibar millibarAccuracy() const {
 
-  Millibar millibarAccuracy();
+    return accuracy();
+  }
 
-  InchesMercury inchesMercuryAccuracy();
+  constexpr InchesMercury inchesMercuryAccuracy() const {
 
- private:
-  variant<Millibar, InchesMercury> value_;
-  variant<Millibar, InchesMercury> accuracy_;
-  time_point<system_clock> time_;
+    return accuracyAs<InchesMercury>();
+  }
 };
 
+static_assert(std::is_trivially_copyable_v<PressureMeasurement>);
+
+/*
+ * Columns of readings, see measurement_series.h
+ */
+using PressureSeries = MeasurementSeries<Millibar>;
+using PressureSeriesView = MeasurementSeriesView<Millibar>;
+
 }  // Namespace qw_units
 
-#endif  // LIB_UNITS_PRESSURE_MEASUREMENT_H_
\ No newline at end of file
+#endif  // LIB_UNITS_PRESSURE_MEASUREMENT_H_
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#ifndef LIB_UNITS_SPEED_METERS_PER_SECOND_H_
+#define LIB_UNITS_SPEED_METERS_PER_SECOND_H_
+
+#include <cstdint>
+#include <type_traits>
+
+#include "quantity.h"
+#include "speed.h"
+
+namespace qw_units {
+
+/*
+ * Thousandths of a mile per hour too, the base is not meters
+ */
+using MetersPerSecond = Quantity<SpeedDimension, MetersPerSecondScale>;
+
+static_assert(sizeof(MetersPerSecond) == sizeof(int64_t));
+static_assert(std::is_trivially_copyable_v<MetersPerSecond>);
+
+}  // Namespace qw_units
+
+#include "miles_per_hour.h"
+
+#endif  // LIB_UNITS_SPEED_METERS_PER_SECOND_H_
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#ifndef LIB_UNITS_SPEED_MILES_PER_HOUR_H_
+#define LIB_UNITS_SPEED_MILES_PER_HOUR_H_
+
+#include <cstdint>
+#include <type_traits>
+
+#include "quantity.h"
+#include "speed.h"
+
+namespace qw_units {
+
+/*
+ * Base value in thousandths of a mile per hour
+ */
+using MilesPerHour = Quantity<SpeedDimension, MilesPerHourScale>;
+
+static_assert(sizeof(MilesPerHour) == sizeof(int64_t));
+static_assert(std::is_trivially_copyable_v<MilesPerHour>);
+
+}  // Namespace qw_units
+
+#include "meters_per_second.h"
+
+#endif  // LIB_UNITS_SPEED_MILES_PER_HOUR_H_
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#ifndef LIB_UNITS_SPEED_H_
+#define LIB_UNITS_SPEED_H_
+
+#include <ratio>
+#include <string_view>
+
+#include "quantity.h"
+
+namespace qw_units {
+
+/*
+ * The anemometer counts in miles per hour so that is the reference, the
+ * base is thousandths of a mile per hour
+ */
+constexpr int speed_base_conversion_factor = 1000;
+constexpr float meters_per_second_per_mph = 0.44704;
+
+/*
+ * meters_per_second_per_mph as an exact ratio, a mile is 1609.344 meters
+ */
+using meters_per_second_per_mile_per_hour = std::ratio<1397, 3125>;
+
+/*
+ * How a speed prints when the format doesn't say, as in "{}"
+ */
+constexpr std::string_view speed_default_spec = ".1f";
+
+struct SpeedDimension {
+  static constexpr int base_conversion_factor = speed_base_conversion_factor;
+  static constexpr std::string_view default_spec = speed_default_spec;
+  static constexpr int default_precision = 1;
+};
+
+using MilesPerHourScale = ReferenceScale;
+using MetersPerSecondScale =
+    AffineScale<meters_per_second_per_mph, 1.0f, 0.0f,
+                meters_per_second_per_mile_per_hour>;
+
+}  // Namespace qw_units
+
+#endif  // LIB_UNITS_SPEED_H_
@@ -5,92 +5,25 @@
 #ifndef LIB_UNITS_TEMPERATURE_FAHRENHEIT_H_
 #define LIB_UNITS_TEMPERATURE_FAHRENHEIT_H_
 
-#include <fmt/format.h>
-#include <math.h>
-#include <compare>
-#include <string>
-#include <variant>
+#include <cstdint>
+#include <type_traits>
 
-#include "celsius.h"
-#include "kelvin.h"
+#include "quantity.h"
 #include "temperature.h"
 
-using fmt::format;
-using std::string;
-using std::strong_ordering;
-
 namespace qw_units {
+
 /*
- * Need to predeclare the friend classes
- * I found that out the hard way
+ * The base is still millicelsius, not millifahrenheit
  */
+using Fahrenheit = Quantity<TemperatureDimension, FahrenheitScale>;
 
-class Celsius;
-class Kelvin;
-
-class Fahrenheit {
-  friend Celsius;
-  friend Kelvin;
-
- public:
-  Fahrenheit();
-
-  Fahrenheit(float temp);
-
-  Fahrenheit(float temp, string fmt_value);
-
-  float value();
-
-  string toString();
-
-  string toString(string format);
-
-  void setFormat(string fmt_value);
-
-  /********************
-   * Operator functions
-   ********************/
-
-  bool operator==(const Fahrenheit& other) const;
-
-  bool operator!=(const Fahrenheit& other) const;
-
-  bool operator<(const Fahrenheit& other) const;
-
-  bool operator>(const Fahrenheit& other) const;
-
-  bool operator<=(const Fahrenheit& other) const;
-
-  bool operator>=(const Fahrenheit& other) const;
-
-  strong_ordering operator<=> (const Fahrenheit& other) const;
-
-  Fahrenheit& operator=(const Fahrenheit& other);
-
-  Fahrenheit& operator+=(const Fahrenheit& other);
-
-  Fahrenheit& operator-=(const Fahrenheit& other);
-
-  const Fahrenheit operator+(const Fahrenheit& other) const;
-
-  const Fahrenheit operator-(const Fahrenheit& other) const;
-
-  operator Celsius() const;
-
-  operator Kelvin() const;
-
- private:
-  int64_t base_value_;
-
-  string fmt_value_ = temperature_default_format;
-
-  int FahrenheitToBase(float temp);
-
-  float BaseToFahrenheit(int base);
-
-  void setBaseValue(int base_value);
-};
+static_assert(sizeof(Fahrenheit) == sizeof(int64_t));
+static_assert(std::is_trivially_copyable_v<Fahrenheit>);
 
 }  // Namespace qw_units
 
-#endif  // LIB_UNITS_TEMPERATURE_FAHRENHEIT_H_
\ No newline at end of file
+#include "celsius.h"
+#include "kelvin.h"
+
+#endif  // LIB_UNITS_TEMPERATURE_FAHRENHEIT_H_
@@ -5,9 +5,10 @@
 #ifndef LIB_UNITS_TEMPERATURE_H_
 #define LIB_UNITS_TEMPERATURE_H_
 
-#include <string>
+#include <ratio>
+#include <string_view>
 
-using std::string;
+#include "quantity.h"
 
 namespace qw_units {
 
@@ -18,8 +19,36 @@ namespace qw_units {
  */
 constexpr int temperature_base_conversion_factor = 1000;
 constexpr float temperature_celsius_kelvin_offset = 273.15;
-constexpr string temperature_default_format = "{0:.2f}";
+
+/*
+ * The same conversions as exact ratios
+ */
+using fahrenheit_per_celsius = std::ratio<9, 5>;
+using fahrenheit_celsius_offset = std::ratio<32>;
+using kelvin_celsius_offset = std::ratio<27315, 100>;
+
+/*
+ * How a temperature prints when the format doesn't say, as in "{}"
+ */
+constexpr std::string_view temperature_default_spec = ".2f";
+
+struct TemperatureDimension {
+  static constexpr int base_conversion_factor =
+      temperature_base_conversion_factor;
+  static constexpr std::string_view default_spec = temperature_default_spec;
+  static constexpr int default_precision = 2;
+};
+
+/*
+ * Celsius is the reference, the others are relative to it
+ */
+using CelsiusScale = ReferenceScale;
+using FahrenheitScale = AffineScale<9.0f, 5.0f, 32.0f, fahrenheit_per_celsius,
+                                    fahrenheit_celsius_offset>;
+using KelvinScale =
+    AffineScale<1.0f, 1.0f, temperature_celsius_kelvin_offset, std::ratio<1>,
+                kelvin_celsius_offset>;
 
 }  // Namespace qw_units
 
-#endif  // LIB_UNITS_TEMPERATURE_H_
\ No newline at end of file
+#endif  // LIB_UNITS_TEMPERATURE_H_
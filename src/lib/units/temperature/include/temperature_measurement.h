@@ -1,4 +1,3 @@
-
 /*
  * Any measurement invlolves the reading the accuracy and the time of the reading
  */
@@ -6,51 +5,67 @@
 #define LIB_UNITS_TEMPERATURE_MEASUREMENT_H_
 
 #include <chrono>
-#include <variant>
+#include <type_traits>
 
 #include "celsius.h"
 #include "fahrenheit.h"
 #include "kelvin.h"
+#include "measurement.h"
+#include "measurement_series.h"
 #include "temperature.h"
 
-using std::variant;
 using std::chrono::system_clock;
 using std::chrono::time_point;
 
 namespace qw_units {
 
-class TemperatureMeasurement {
+/*
+ * Kept in Celsius. A Fahrenheit or Kelvin reading converts on the way in
+ * without losing anything since they all share the millicelsius base.
+ */
+class TemperatureMeasurement : public Measurement<Celsius> {
  public:
-  TemperatureMeasurement();
+  using Measurement::Measurement;
+
+  constexpr Celsius celsiusValue() const {
 
-  TemperatureMeasurement(variant<Celsius, Fahrenheit, Kelvin> value,
-                         variant<Celsius, Fahrenheit, Kelvin> accuracy,
-                         time_point<system_clock> time);
+    return value();
+  }
 
-  variant<Celsius, Fahrenheit, Kelvin> value();
+  constexpr Fahrenheit fahrenheitValue() const {
 
-  variant<Celsius, Fahrenheit, Kelvin> accuracy();
+    return valueAs<Fahrenheit>();
+  }
 
-  time_point<system_clock> time();
+  constexpr Kelvin kelvinValue() const {
 
-  Celsius celsiusValue();
+    return valueAs<Kelvin>();
+  }
 
-  Fahrenheit fahrenheitValue();
+  constexpr Celsius celsiusAccuracy() const {
 
-  Kelvin kelvinValue();
+    return accuracy();
+  }
 
-  Celsius celsiusAccuracy();
+  constexpr Fahrenheit fahrenheitAccuracy() const {
 
-  Fahrenheit fahrenheitAccuracy();
+    return accuracyAs<Fahrenheit>();
+  }
 
-  Kelvin kelvinAccuracy();
+  constexpr Kelvin kelvinAccuracy() const {
 
- private:
-  variant<Celsius, Fahrenheit, Kelvin> value_;
-  variant<Celsius, Fahrenheit, Kelvin> accuracy_;
-  time_point<system_clock> time_;
+    return accuracyAs<Kelvin>();
+  }
 };
 
+static_assert(std::is_trivially_copyable_v<TemperatureMeasurement>);
+
+/*
+ * Columns of readings, see measurement_series.h
+ */
+using TemperatureSeries = MeasurementSeries<Celsius>;
+using TemperatureSeriesView = MeasurementSeriesView<Celsius>;
+
 }  // Namespace qw_units
 
-#endif  // LIB_UNITS_TEMPERATURE_MEASUREMENT_H_
\ No newline at end of file
+#endif  // LIB_UNITS_TEMPERATURE_MEASUREMENT_H_
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * A rollup index over a time ordered series of integer base values.
+ *
+ * The raw samples are kept in time order. On top of them is a pyramid of
+ * aggregate nodes. Level 0 summarizes blocks of kRollupLeafSize raw samples
+ * and every level above that summarizes pairs of nodes from the level below.
+ * An append only touches the last node on each level, so it is O(log n).
+ * A range query binary searches the time range into an index range, scans
+ * at most two partial leaf blocks and then walks up the pyramid like a
+ * bottom up segment tree. That is O(log n) plus the constant leaf scan.
+ */
+
+#ifndef LIB_UTILITIES_HISTORY_ROLLUP_INDEX_H_
+#define LIB_UTILITIES_HISTORY_ROLLUP_INDEX_H_
+
+#include <errno.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <span>
+#include <vector>
+
+using std::expected;
+using std::span;
+using std::unexpected;
+using std::vector;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_utilities {
+
+/*
+ * Number of raw samples summarized by one level 0 node.
+ * Bigger blocks use less memory but make the leaf scan longer.
+ */
+constexpr size_t kRollupLeafSize = 32;
+
+enum HistoryAggregate {
+  HISTORY_AGGREGATE_MIN,
+  HISTORY_AGGREGATE_MAX,
+  HISTORY_AGGREGATE_MEAN,
+  HISTORY_AGGREGATE_SUM,
+  HISTORY_AGGREGATE_COUNT
+};
+
+/*
+ * The aggregate of a set of samples. An empty node has count_ of 0 and
+ * min_/max_ set so that merging anything into it gives the right answer.
+ */
+struct RollupNode {
+  int64_t min_ = std::numeric_limits<int64_t>::max();
+  int64_t max_ = std::numeric_limits<int64_t>::min();
+  int64_t sum_ = 0;
+  uint64_t count_ = 0;
+
+  void add(int64_t value) {
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += value;
+    count_++;
+  }
+
+  void merge(const RollupNode& other) {
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+    count_ += other.count_;
+  }
+};
+
+class RollupIndex {
+ public:
+  RollupIndex();
+
+  /*
+   * Samples have to be appended in time order. A sample older than the
+   * last one appended is rejected with EINVAL.
+   */
+  expected<bool, int> append(time_point<system_clock> time, int64_t value);
+
+  /*
+   * A run of samples at once, the columns of a MeasurementSeries for
+   * example. They all go in or, if any are out of order or the columns
+   * differ in length, none do and it's EINVAL.
+   */
+  expected<bool, int> append(span<const time_point<system_clock>> times,
+                             span<const int64_t> values);
+
+  /*
+   * Aggregate the samples with from <= time < to.
+   * Returns ENODATA if there are no samples in the range.
+   */
+  expected<int64_t, int> query(time_point<system_clock> from,
+                               time_point<system_clock> to,
+                               HistoryAggregate aggregate);
+
+  /*
+   * Aggregate the samples with index first <= index < last.
+   */
+  RollupNode rollup(size_t first, size_t last);
+
+  size_t size();
+
+  /*
+   * The raw samples, in time order. Good until the next append() or
+   * clear().
+   */
+  span<const time_point<system_clock>> times();
+
+  span<const int64_t> values();
+
+  void reserve(size_t count);
+
+  /*
+   * Throw away the samples from before time and returns how many went.
+   * The pyramid has to be built again after that, so nothing goes until
+   * at least a quarter of the samples, or one leaf block, are old enough.
+   * That keeps the cost of an append O(log n) on average when this is
+   * called every sample.
+   */
+  size_t expire(time_point<system_clock> time);
+
+  void clear();
+
+ private:
+  vector<time_point<system_clock>> times_;
+  vector<int64_t> values_;
+
+  /*
+   * levels_[0] summarizes kRollupLeafSize raw values per node.
+   * levels_[n] summarizes two nodes of levels_[n - 1].
+   */
+  vector<vector<RollupNode>> levels_;
+
+  size_t lowerBound(time_point<system_clock> time);
+
+  void rebuild();
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_HISTORY_ROLLUP_INDEX_H_
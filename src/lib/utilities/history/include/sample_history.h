@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The history of the readings the station has taken. Each quantity gets its
+ * own RollupIndex so questions like "max temperature over the last 30 days"
+ * or "mean pressure per hour this week" don't have to scan the raw samples.
+ *
+ * Everything is kept and returned as integer base values:
+ *   Celsius          - millicelsius
+ *   RelativeHumidity - hundredths of a percent
+ *   Millibar         - milli-millibars
+ */
+
+#ifndef LIB_UTILITIES_HISTORY_SAMPLE_HISTORY_H_
+#define LIB_UTILITIES_HISTORY_SAMPLE_HISTORY_H_
+
+#include <array>
+#include <chrono>
+#include <expected>
+#include <vector>
+
+#include "pressure_measurement.h"
+#include "relative_humidity_measurement.h"
+#include "rollup_index.h"
+#include "temperature_measurement.h"
+
+using qw_units::PressureMeasurement;
+using qw_units::PressureSeriesView;
+using qw_units::RelativeHumidityMeasurement;
+using qw_units::RelativeHumiditySeriesView;
+using qw_units::TemperatureMeasurement;
+using qw_units::TemperatureSeriesView;
+using std::expected;
+using std::vector;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_utilities {
+
+enum HistoryQuantity {
+  HISTORY_QUANTITY_CELSIUS,
+  HISTORY_QUANTITY_RELATIVE_HUMIDITY,
+  HISTORY_QUANTITY_MILLIBAR,
+  HISTORY_QUANTITY_MAX  // This should always be last
+};
+
+class SampleHistory {
+ public:
+  SampleHistory();
+
+  expected<bool, int> append(TemperatureMeasurement measurement);
+
+  expected<bool, int> append(RelativeHumidityMeasurement measurement);
+
+  expected<bool, int> append(PressureMeasurement measurement);
+
+  /*
+   * A whole series at once, all or nothing like RollupIndex::append()
+   */
+  expected<bool, int> append(TemperatureSeriesView series);
+
+  expected<bool, int> append(RelativeHumiditySeriesView series);
+
+  expected<bool, int> append(PressureSeriesView series);
+
+  /*
+   * Aggregate of one quantity over from <= time < to
+   */
+  expected<int64_t, int> query(HistoryQuantity quantity,
+                               HistoryAggregate aggregate,
+                               time_point<system_clock> from,
+                               time_point<system_clock> to);
+
+  /*
+   * Splits from..to into buckets of the given length and aggregates each
+   * one. Buckets without samples come back with ENODATA.
+   */
+  vector<expected<int64_t, int>> queryBuckets(HistoryQuantity quantity,
+                                              HistoryAggregate aggregate,
+                                              time_point<system_clock> from,
+                                              time_point<system_clock> to,
+                                              system_clock::duration bucket);
+
+  /*
+   * The raw samples with from <= time < to, straight out of the history
+   * without copying. The history doesn't keep accuracy or quality, so the
+   * views come back with a zero accuracy and every sample good. They are
+   * only good until the next append.
+   */
+  TemperatureSeriesView temperatureSeries(time_point<system_clock> from,
+                                          time_point<system_clock> to);
+
+  RelativeHumiditySeriesView relativeHumiditySeries(
+      time_point<system_clock> from, time_point<system_clock> to);
+
+  PressureSeriesView pressureSeries(time_point<system_clock> from,
+                                    time_point<system_clock> to);
+
+  size_t size(HistoryQuantity quantity);
+
+  /*
+   * Throw away samples from before time, see RollupIndex::expire(). The
+   * history only holds as much as it is asked about if this gets called
+   * as samples come in.
+   */
+  void expire(time_point<system_clock> time);
+
+ private:
+  std::array<RollupIndex, HISTORY_QUANTITY_MAX> indexes_;
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_HISTORY_SAMPLE_HISTORY_H_
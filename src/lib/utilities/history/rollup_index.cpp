@@ -0,0 +1,260 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "rollup_index.h"
+
+#include "unit_base.h"
+
+namespace qw_utilities {
+
+RollupIndex::RollupIndex() {}
+
+expected<bool, int> RollupIndex::append(time_point<system_clock> time,
+                                        int64_t value) {
+
+  /*
+   * The binary search in query() depends on the times being in order
+   */
+  if ((times_.empty() == false) && (time < times_.back())) {
+    return unexpected(EINVAL);
+  }
+
+  times_.push_back(time);
+  values_.push_back(value);
+
+  if (levels_.empty() == true) {
+    levels_.emplace_back();
+  }
+
+  /*
+   * Walk up the pyramid adding the value to the last node of each level.
+   * Only the top level has a single node so that is where we stop.
+   */
+  size_t index = (values_.size() - 1) / kRollupLeafSize;
+  size_t level = 0;
+  while (true) {
+    vector<RollupNode>& nodes = levels_[level];
+    if (index == nodes.size()) {
+      nodes.emplace_back();
+    }
+    nodes[index].add(value);
+
+    if (nodes.size() == 1) {
+      break;
+    }
+
+    if (level + 1 == levels_.size()) {
+      /*
+       * This level just got its second node so it needs a new level above
+       * it. The new top node starts out covering the first node. The new
+       * value gets added to it on the next pass through the loop.
+       * Copy the node before emplace_back() since it can move nodes.
+       */
+      RollupNode first = nodes[0];
+      levels_.emplace_back(1, first);
+    }
+
+    index /= 2;
+    level++;
+  }
+
+  return true;
+}
+
+expected<bool, int> RollupIndex::append(
+    span<const time_point<system_clock>> times, span<const int64_t> values) {
+
+  if (times.size() != values.size()) {
+    return unexpected(EINVAL);
+  }
+  if (times.empty() == true) {
+    return true;
+  }
+
+  /*
+   * Check the order up front so a bad run doesn't leave half of itself
+   * behind
+   */
+  if ((times_.empty() == false) && (times.front() < times_.back())) {
+    return unexpected(EINVAL);
+  }
+  if (std::is_sorted(times.begin(), times.end()) == false) {
+    return unexpected(EINVAL);
+  }
+
+  for (size_t i = 0; i < times.size(); i++) {
+    append(times[i], values[i]);
+  }
+
+  return true;
+}
+
+expected<int64_t, int> RollupIndex::query(time_point<system_clock> from,
+                                          time_point<system_clock> to,
+                                          HistoryAggregate aggregate) {
+
+  if (to <= from) {
+    return unexpected(EINVAL);
+  }
+
+  RollupNode node = rollup(lowerBound(from), lowerBound(to));
+  if (node.count_ == 0) {
+    return unexpected(ENODATA);
+  }
+
+  int64_t count = node.count_;
+  int64_t value = 0;
+  switch (aggregate) {
+    case HISTORY_AGGREGATE_MIN:
+      value = node.min_;
+      break;
+    case HISTORY_AGGREGATE_MAX:
+      value = node.max_;
+      break;
+    case HISTORY_AGGREGATE_MEAN:
+      /*
+       * Round half away from zero the same way the units round
+       */
+      value = qw_units::divideRounded(node.sum_, count);
+      break;
+    case HISTORY_AGGREGATE_SUM:
+      value = node.sum_;
+      break;
+    case HISTORY_AGGREGATE_COUNT:
+      value = count;
+      break;
+    default:
+      return unexpected(EINVAL);
+  }
+
+  return value;
+}
+
+RollupNode RollupIndex::rollup(size_t first, size_t last) {
+  RollupNode result;
+
+  last = std::min(last, values_.size());
+  if (first >= last) {
+    return result;
+  }
+
+  /*
+   * Scan the raw values in the partial leaf blocks at either end
+   */
+  size_t left = first;
+  size_t right = last;
+  while ((left < right) && ((left % kRollupLeafSize) != 0)) {
+    result.add(values_[left++]);
+  }
+  while ((left < right) && ((right % kRollupLeafSize) != 0)) {
+    result.add(values_[--right]);
+  }
+
+  /*
+   * What is left lines up with whole leaf blocks. From here it is a
+   * bottom up segment tree walk. A node is only used if everything it
+   * covers is inside the range.
+   */
+  left /= kRollupLeafSize;
+  right /= kRollupLeafSize;
+  for (size_t level = 0; left < right; level++) {
+    vector<RollupNode>& nodes = levels_[level];
+    if ((left & 1) != 0) {
+      result.merge(nodes[left++]);
+    }
+    if ((right & 1) != 0) {
+      result.merge(nodes[--right]);
+    }
+    left /= 2;
+    right /= 2;
+  }
+
+  return result;
+}
+
+size_t RollupIndex::size() {
+
+  return values_.size();
+}
+
+span<const time_point<system_clock>> RollupIndex::times() {
+
+  return times_;
+}
+
+span<const int64_t> RollupIndex::values() {
+
+  return values_;
+}
+
+void RollupIndex::reserve(size_t count) {
+
+  times_.reserve(count);
+  values_.reserve(count);
+
+  return;
+}
+
+size_t RollupIndex::expire(time_point<system_clock> time) {
+
+  size_t old = lowerBound(time);
+  if ((old == 0) || (old < std::max(kRollupLeafSize, values_.size() / 4))) {
+    return 0;
+  }
+  times_.erase(times_.begin(), times_.begin() + old);
+  values_.erase(values_.begin(), values_.begin() + old);
+  rebuild();
+
+  return old;
+}
+
+void RollupIndex::clear() {
+
+  times_.clear();
+  values_.clear();
+  levels_.clear();
+
+  return;
+}
+
+/*
+ * The pyramid from the raw values, bottom up. It comes out the same as
+ * appending them one at a time would have made it, every level has half
+ * the nodes of the one below, rounded up, until a level has only one.
+ */
+void RollupIndex::rebuild() {
+
+  levels_.clear();
+  if (values_.empty() == true) {
+    return;
+  }
+
+  levels_.emplace_back((values_.size() + kRollupLeafSize - 1) /
+                       kRollupLeafSize);
+  for (size_t i = 0; i < values_.size(); i++) {
+    levels_[0][i / kRollupLeafSize].add(values_[i]);
+  }
+  while (levels_.back().size() > 1) {
+    vector<RollupNode> above((levels_.back().size() + 1) / 2);
+    const vector<RollupNode>& below = levels_.back();
+    for (size_t i = 0; i < below.size(); i++) {
+      above[i / 2].merge(below[i]);
+    }
+    levels_.push_back(std::move(above));
+  }
+
+  return;
+}
+
+/*
+ * Index of the first sample at or after time
+ */
+size_t RollupIndex::lowerBound(time_point<system_clock> time) {
+
+  auto item = std::lower_bound(times_.begin(), times_.end(), time);
+
+  return item - times_.begin();
+}
+
+}  // namespace qw_utilities
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "sample_history.h"
+
+namespace qw_utilities {
+
+SampleHistory::SampleHistory() {}
+
+expected<bool, int> SampleHistory::append(TemperatureMeasurement measurement) {
+
+  return indexes_[HISTORY_QUANTITY_CELSIUS].append(
+      measurement.time(), measurement.celsiusValue().baseValue());
+}
+
+expected<bool, int> SampleHistory::append(
+    RelativeHumidityMeasurement measurement) {
+
+  return indexes_[HISTORY_QUANTITY_RELATIVE_HUMIDITY].append(
+      measurement.time(), measurement.relativeHumidityValue().baseValue());
+}
+
+expected<bool, int> SampleHistory::append(PressureMeasurement measurement) {
+
+  return indexes_[HISTORY_QUANTITY_MILLIBAR].append(
+      measurement.time(), measurement.millibarValue().baseValue());
+}
+
+expected<bool, int> SampleHistory::append(TemperatureSeriesView series) {
+
+  return indexes_[HISTORY_QUANTITY_CELSIUS].append(series.times(),
+                                                   series.values());
+}
+
+expected<bool, int> SampleHistory::append(RelativeHumiditySeriesView series) {
+
+  return indexes_[HISTORY_QUANTITY_RELATIVE_HUMIDITY].append(series.times(),
+                                                             series.values());
+}
+
+expected<bool, int> SampleHistory::append(PressureSeriesView series) {
+
+  return indexes_[HISTORY_QUANTITY_MILLIBAR].append(series.times(),
+                                                    series.values());
+}
+
+expected<int64_t, int> SampleHistory::query(HistoryQuantity quantity,
+                                            HistoryAggregate aggregate,
+                                            time_point<system_clock> from,
+                                            time_point<system_clock> to) {
+
+  if ((quantity < 0) || (quantity >= HISTORY_QUANTITY_MAX)) {
+    return unexpected(EINVAL);
+  }
+
+  return indexes_[quantity].query(from, to, aggregate);
+}
+
+vector<expected<int64_t, int>> SampleHistory::queryBuckets(
+    HistoryQuantity quantity, HistoryAggregate aggregate,
+    time_point<system_clock> from, time_point<system_clock> to,
+    system_clock::duration bucket) {
+  vector<expected<int64_t, int>> results;
+
+  if (bucket <= system_clock::duration::zero()) {
+    return results;
+  }
+
+  for (time_point<system_clock> start = from; start < to; start += bucket) {
+    results.push_back(
+        query(quantity, aggregate, start, std::min(start + bucket, to)));
+  }
+
+  return results;
+}
+
+TemperatureSeriesView SampleHistory::temperatureSeries(
+    time_point<system_clock> from, time_point<system_clock> to) {
+  RollupIndex& index = indexes_[HISTORY_QUANTITY_CELSIUS];
+
+  TemperatureSeriesView series(index.times(), index.values(), {}, {});
+
+  return series.slice(from, to);
+}
+
+RelativeHumiditySeriesView SampleHistory::relativeHumiditySeries(
+    time_point<system_clock> from, time_point<system_clock> to) {
+  RollupIndex& index = indexes_[HISTORY_QUANTITY_RELATIVE_HUMIDITY];
+
+  RelativeHumiditySeriesView series(index.times(), index.values(), {}, {});
+
+  return series.slice(from, to);
+}
+
+PressureSeriesView SampleHistory::pressureSeries(
+    time_point<system_clock> from, time_point<system_clock> to) {
+  RollupIndex& index = indexes_[HISTORY_QUANTITY_MILLIBAR];
+
+  PressureSeriesView series(index.times(), index.values(), {}, {});
+
+  return series.slice(from, to);
+}
+
+size_t SampleHistory::size(HistoryQuantity quantity) {
+
+  if ((quantity < 0) || (quantity >= HISTORY_QUANTITY_MAX)) {
+    return 0;
+  }
+
+  return indexes_[quantity].size();
+}
+
+void SampleHistory::expire(time_point<system_clock> time) {
+
+  for (RollupIndex& index : indexes_) {
+    index.expire(time);
+  }
+
+  return;
+}
+
+}  // namespace qw_utilities
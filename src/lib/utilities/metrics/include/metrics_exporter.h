@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Serves the station's metrics over HTTP for Prometheus to scrape, on a
+ * TCP port or a unix socket.
+ *
+ * The scrapes are answered by a thread of its own and never look at the
+ * readings or the counters themselves. The main loop renders the text once
+ * a cycle and hands it over with update(), which makes it into a whole
+ * HTTP response, headers and all. A scrape takes a reference to the
+ * latest response under a lock held only for that and writes it out, so
+ * scraping as often as anybody likes costs the sampler nothing and the
+ * scrape never sees half of one cycle and half of the next.
+ *
+ * GET /metrics, or /, gets the metrics. Connections are kept open for the
+ * next scrape unless the client says otherwise.
+ */
+
+#ifndef LIB_UTILITIES_METRICS_METRICS_EXPORTER_H_
+#define LIB_UTILITIES_METRICS_METRICS_EXPORTER_H_
+
+#include <errno.h>
+#include <atomic>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using std::expected;
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::unexpected;
+
+namespace qw_utilities {
+
+constexpr char metrics_default_listen[] = "127.0.0.1:9420";
+
+class MetricsExporter {
+ public:
+  MetricsExporter();
+
+  /*
+   * Stops the thread, and takes the unix socket away if there was one
+   */
+  ~MetricsExporter();
+
+  MetricsExporter(const MetricsExporter&) = delete;
+  MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+  /*
+   * listen is host:port, with * for every address, or unix:path. Starts
+   * the thread. Scrapes get a 503 until the first update().
+   */
+  expected<bool, int> open(const string& listen);
+
+  bool isOpen() const;
+
+  /*
+   * The metrics every scrape from now on gets
+   */
+  void update(const string& text);
+
+  uint64_t scrapes() const;
+
+ private:
+  expected<int, int> listenTcp(const string& host, const string& port);
+  expected<int, int> listenUnix(const string& path);
+
+  shared_ptr<const string> response() const;
+
+  static void run(std::stop_token stop, MetricsExporter* exporter);
+
+  int listen_fd_ = -1;
+  string unix_path_;
+
+  mutable mutex lock_;
+  shared_ptr<const string> response_;
+
+  std::atomic<uint64_t> scrapes_{0};
+
+  std::jthread thread_;
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_METRICS_METRICS_EXPORTER_H_
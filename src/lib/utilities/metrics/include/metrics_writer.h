@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Builds the text a Prometheus scrape gets, in the OpenMetrics format.
+ *
+ * Each metric is a family line, # TYPE and # HELP, followed by its
+ * samples. A sample's labels are passed already formatted, like
+ * sensor="sht4x", the callers only ever use a few fixed ones. Counters
+ * are declared without _total and their samples have it, the way
+ * OpenMetrics wants.
+ *
+ * The writer keeps its buffer from one render to the next, once it has
+ * grown to the size of a whole scrape a render doesn't allocate.
+ *
+ * MetricsHistogram keeps the counts for one histogram. The bucket bounds
+ * are fixed when it is made and their le labels are formatted then, so
+ * writing it out is only the counts.
+ */
+
+#ifndef LIB_UTILITIES_METRICS_METRICS_WRITER_H_
+#define LIB_UTILITIES_METRICS_METRICS_WRITER_H_
+
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace qw_utilities {
+
+class MetricsHistogram {
+ public:
+  /*
+   * bounds in seconds, smallest first. The +Inf bucket is added.
+   */
+  explicit MetricsHistogram(vector<double> bounds);
+
+  void observe(double value);
+
+  /*
+   * Durations are observed in seconds
+   */
+  template <typename Rep, typename Period>
+  void observe(std::chrono::duration<Rep, Period> duration) {
+
+    observe(std::chrono::duration<double>(duration).count());
+
+    return;
+  }
+
+  const vector<string>& boundLabels() const;
+  const vector<uint64_t>& bucketCounts() const;  // not cumulative
+  uint64_t count() const;
+  double sum() const;
+
+ private:
+  vector<double> bounds_;
+  vector<string> bound_labels_;
+  vector<uint64_t> bucket_counts_;  // one more than bounds_, for +Inf
+  uint64_t count_ = 0;
+  double sum_ = 0.0;
+};
+
+class MetricsWriter {
+ public:
+  MetricsWriter();
+
+  /*
+   * Start over, keeping the buffer
+   */
+  void clear();
+
+  /*
+   * type is counter, gauge or histogram
+   */
+  void family(string_view name, string_view type, string_view help);
+
+  /*
+   * A value that isn't finite goes as NaN, +Inf or -Inf
+   */
+  void sample(string_view name, string_view labels, double value);
+
+  /*
+   * Counts, and sizes, whatever type they are kept in
+   */
+  template <std::integral Count>
+  void sample(string_view name, string_view labels, Count value) {
+
+    count(name, labels, static_cast<uint64_t>(value));
+
+    return;
+  }
+
+  /*
+   * The _bucket, _count and _sum samples of histogram
+   */
+  void histogram(string_view name, string_view labels,
+                 const MetricsHistogram& histogram);
+
+  /*
+   * The # EOF line OpenMetrics ends with
+   */
+  void finish();
+
+  const string& text() const;
+
+ private:
+  void count(string_view name, string_view labels, uint64_t value);
+  void sampleName(string_view name, string_view labels,
+                  string_view extra_label);
+
+  string text_;
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_METRICS_METRICS_WRITER_H_
@@ -0,0 +1,351 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The metrics HTTP server
+ */
+#include "include/metrics_exporter.h"
+
+#include <fmt/format.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <string_view>
+#include <vector>
+
+using std::make_shared;
+using std::map;
+using std::string_view;
+using std::vector;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+namespace qw_utilities {
+
+/*
+ * Nobody gets more connections than this, or longer than idle_timeout
+ * between requests, or a request bigger than max_request
+ */
+constexpr size_t max_clients = 16;
+constexpr seconds idle_timeout = seconds(60);
+constexpr size_t max_request = 8192;
+
+/*
+ * How often the thread looks to see if it has been told to stop
+ */
+constexpr int stop_poll_ms = 250;
+
+static const shared_ptr<const string> not_ready = make_shared<const string>(
+    "HTTP/1.1 503 Service Unavailable\r\nContent-Type: text/plain\r\n"
+    "Content-Length: 10\r\n\r\nNot ready\n");
+static const shared_ptr<const string> not_found = make_shared<const string>(
+    "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n"
+    "Content-Length: 10\r\n\r\nNot found\n");
+static const shared_ptr<const string> bad_method = make_shared<const string>(
+    "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\n"
+    "Content-Type: text/plain\r\nContent-Length: 19\r\n\r\n"
+    "Method not allowed\n");
+
+struct MetricsClient {
+  string in;
+  shared_ptr<const string> out;
+  size_t sent = 0;
+  bool close_after = false;
+  steady_clock::time_point last_active;
+};
+
+MetricsExporter::MetricsExporter() {}
+
+MetricsExporter::~MetricsExporter() {
+
+  if (thread_.joinable() == true) {
+    thread_.request_stop();
+    thread_.join();
+  }
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+  }
+  if (unix_path_.empty() == false) {
+    unlink(unix_path_.c_str());
+  }
+}
+
+expected<bool, int> MetricsExporter::open(const string& listen) {
+  expected<int, int> x_fd = unexpected(EINVAL);
+
+  if (listen_fd_ >= 0) {
+    return unexpected(EALREADY);
+  }
+  if (listen.starts_with("unix:") == true) {
+    x_fd = listenUnix(listen.substr(5));
+  } else {
+    size_t colon = listen.rfind(':');
+    if (colon == string::npos) {
+      return unexpected(EINVAL);
+    }
+    x_fd = listenTcp(listen.substr(0, colon), listen.substr(colon + 1));
+  }
+  if (x_fd.has_value() == false) {
+    return unexpected(x_fd.error());
+  }
+  listen_fd_ = x_fd.value();
+  thread_ = std::jthread(MetricsExporter::run, this);
+
+  return true;
+}
+
+bool MetricsExporter::isOpen() const {
+
+  return listen_fd_ >= 0;
+}
+
+void MetricsExporter::update(const string& text) {
+
+  auto response = make_shared<string>();
+  response->reserve(text.size() + 128);
+  fmt::format_to(std::back_inserter(*response),
+                 "HTTP/1.1 200 OK\r\n"
+                 "Content-Type: application/openmetrics-text; "
+                 "version=1.0.0; charset=utf-8\r\n"
+                 "Content-Length: {}\r\n\r\n",
+                 text.size());
+  response->append(text);
+
+  lock_guard<mutex> guard(lock_);
+  response_ = std::move(response);
+
+  return;
+}
+
+uint64_t MetricsExporter::scrapes() const {
+
+  return scrapes_.load(std::memory_order_relaxed);
+}
+
+expected<int, int> MetricsExporter::listenTcp(const string& host,
+                                              const string& port) {
+  struct addrinfo hints = {};
+  struct addrinfo* addresses = nullptr;
+
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  int result = getaddrinfo(((host == "*") || (host.empty() == true))
+                               ? nullptr
+                               : host.c_str(),
+                           port.c_str(), &hints, &addresses);
+  if (result != 0) {
+    return unexpected(result == EAI_SYSTEM ? errno : EADDRNOTAVAIL);
+  }
+
+  int error = EADDRNOTAVAIL;
+  int fd = -1;
+  for (struct addrinfo* address = addresses; address != nullptr;
+       address = address->ai_next) {
+    fd = socket(address->ai_family,
+                address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                address->ai_protocol);
+    if (fd < 0) {
+      error = errno;
+      continue;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if ((bind(fd, address->ai_addr, address->ai_addrlen) == 0) &&
+        (::listen(fd, SOMAXCONN) == 0)) {
+      break;
+    }
+    error = errno;
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(addresses);
+  if (fd < 0) {
+    return unexpected(error);
+  }
+
+  return fd;
+}
+
+expected<int, int> MetricsExporter::listenUnix(const string& path) {
+  struct sockaddr_un address = {};
+
+  if ((path.empty() == true) || (path.size() >= sizeof(address.sun_path))) {
+    return unexpected(ENAMETOOLONG);
+  }
+  address.sun_family = AF_UNIX;
+  path.copy(address.sun_path, path.size());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return unexpected(errno);
+  }
+
+  /*
+   * A socket left behind by the last run would stop the bind. Anything
+   * else at path isn't ours to remove.
+   */
+  struct stat info;
+  if (lstat(path.c_str(), &info) == 0) {
+    if (S_ISSOCK(info.st_mode) == false) {
+      close(fd);
+      return unexpected(EEXIST);
+    }
+    unlink(path.c_str());
+  }
+  if ((bind(fd, reinterpret_cast<struct sockaddr*>(&address),
+            sizeof(address)) != 0) ||
+      (::listen(fd, SOMAXCONN) != 0)) {
+    int error = errno;
+    close(fd);
+    return unexpected(error);
+  }
+  unix_path_ = path;
+
+  return fd;
+}
+
+shared_ptr<const string> MetricsExporter::response() const {
+  lock_guard<mutex> guard(lock_);
+
+  return response_;
+}
+
+/*
+ * Takes a whole request off the front of client.in and picks the answer.
+ * Only the request line and Connection matter, nothing we serve has a
+ * body to read.
+ */
+static shared_ptr<const string> answer(MetricsClient& client,
+                                       const shared_ptr<const string>& metrics,
+                                       bool& scraped) {
+  size_t end = client.in.find("\r\n\r\n");
+  string_view request(client.in.data(), end);
+  string_view request_line = request.substr(0, request.find("\r\n"));
+
+  string lower(request);
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  client.close_after =
+      (request_line.ends_with("HTTP/1.0") == true) ||
+      (lower.find("\r\nconnection: close") != string::npos);
+
+  shared_ptr<const string> result;
+  scraped = false;
+  if (request_line.starts_with("GET ") == false) {
+    result = bad_method;
+  } else if ((request_line.starts_with("GET /metrics ") == false) &&
+             (request_line.starts_with("GET / ") == false)) {
+    result = not_found;
+  } else if (metrics == nullptr) {
+    result = not_ready;
+  } else {
+    result = metrics;
+    scraped = true;
+  }
+  client.in.erase(0, end + 4);
+
+  return result;
+}
+
+void MetricsExporter::run(std::stop_token stop, MetricsExporter* exporter) {
+  map<int, MetricsClient> clients;
+  vector<pollfd> fds;
+
+  while (stop.stop_requested() == false) {
+
+    fds.clear();
+    fds.push_back(pollfd{exporter->listen_fd_, POLLIN, 0});
+    for (auto& [fd, client] : clients) {
+      fds.push_back(
+          pollfd{fd, static_cast<short>(client.out ? POLLOUT : POLLIN), 0});
+    }
+    if (poll(fds.data(), fds.size(), stop_poll_ms) < 0) {
+      continue;
+    }
+    steady_clock::time_point now = steady_clock::now();
+
+    if ((fds[0].revents & POLLIN) != 0) {
+      int fd;
+      while ((fd = accept4(exporter->listen_fd_, nullptr, nullptr,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        if (clients.size() >= max_clients) {
+          close(fd);
+          continue;
+        }
+        clients[fd].last_active = now;
+      }
+    }
+
+    for (size_t i = 1; i < fds.size(); i++) {
+      int fd = fds[i].fd;
+      MetricsClient& client = clients[fd];
+      bool closed = false;
+
+      if (fds[i].revents != 0) {
+        client.last_active = now;
+        if (client.out == nullptr) {
+          char buffer[2048];
+          ssize_t n = read(fd, buffer, sizeof(buffer));
+          if ((n <= 0) && ((n == 0) || (errno != EAGAIN))) {
+            closed = true;
+          } else if (n > 0) {
+            client.in.append(buffer, n);
+            closed = (client.in.size() > max_request);
+          }
+        } else {
+          ssize_t n = send(fd, client.out->data() + client.sent,
+                           client.out->size() - client.sent, MSG_NOSIGNAL);
+          if ((n < 0) && (errno != EAGAIN)) {
+            closed = true;
+          } else if (n > 0) {
+            client.sent += n;
+          }
+          if ((closed == false) && (client.sent == client.out->size())) {
+            client.out = nullptr;
+            client.sent = 0;
+            closed = client.close_after;
+          }
+        }
+      }
+
+      /*
+       * The next request, if a whole one is in. A pipelined one waits
+       * until the answer to the last one is gone.
+       */
+      if ((closed == false) && (client.out == nullptr) &&
+          (client.in.find("\r\n\r\n") != string::npos)) {
+        bool scraped = false;
+        client.out = answer(client, exporter->response(), scraped);
+        if (scraped == true) {
+          exporter->scrapes_.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+
+      if ((closed == false) && (now - client.last_active > idle_timeout)) {
+        closed = true;
+      }
+      if (closed == true) {
+        close(fd);
+        clients.erase(fd);
+      }
+    }
+  }
+
+  for (auto& [fd, client] : clients) {
+    close(fd);
+  }
+
+  return;
+}
+
+}  // namespace qw_utilities
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * OpenMetrics text
+ */
+#include "include/metrics_writer.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace qw_utilities {
+
+MetricsHistogram::MetricsHistogram(vector<double> bounds)
+    : bounds_(bounds), bucket_counts_(bounds.size() + 1, 0) {
+
+  std::sort(bounds_.begin(), bounds_.end());
+  for (double bound : bounds_) {
+    bound_labels_.push_back(fmt::format("le=\"{}\"", bound));
+  }
+  bound_labels_.push_back("le=\"+Inf\"");
+}
+
+void MetricsHistogram::observe(double value) {
+
+  /*
+   * The first bucket value fits under, le means less than or equal
+   */
+  size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), value) -
+                  bounds_.begin();
+  bucket_counts_[bucket]++;
+  count_++;
+  sum_ += value;
+
+  return;
+}
+
+const vector<string>& MetricsHistogram::boundLabels() const {
+
+  return bound_labels_;
+}
+
+const vector<uint64_t>& MetricsHistogram::bucketCounts() const {
+
+  return bucket_counts_;
+}
+
+uint64_t MetricsHistogram::count() const {
+
+  return count_;
+}
+
+double MetricsHistogram::sum() const {
+
+  return sum_;
+}
+
+MetricsWriter::MetricsWriter() {}
+
+void MetricsWriter::clear() {
+
+  text_.clear();
+
+  return;
+}
+
+void MetricsWriter::family(string_view name, string_view type,
+                           string_view help) {
+
+  fmt::format_to(std::back_inserter(text_), "# TYPE {} {}\n# HELP {} {}\n",
+                 name, type, name, help);
+
+  return;
+}
+
+void MetricsWriter::sample(string_view name, string_view labels,
+                           double value) {
+
+  sampleName(name, labels, "");
+
+  /*
+   * fmt would write nan and inf, OpenMetrics only takes its own spelling
+   */
+  if (std::isnan(value) == true) {
+    text_.append(" NaN\n");
+  } else if (std::isinf(value) == true) {
+    text_.append((value > 0) ? " +Inf\n" : " -Inf\n");
+  } else {
+    fmt::format_to(std::back_inserter(text_), " {}\n", value);
+  }
+
+  return;
+}
+
+void MetricsWriter::histogram(string_view name, string_view labels,
+                              const MetricsHistogram& histogram) {
+  const vector<uint64_t>& counts = histogram.bucketCounts();
+  const vector<string>& bound_labels = histogram.boundLabels();
+  uint64_t cumulative = 0;
+
+  for (size_t i = 0; i < counts.size(); i++) {
+    cumulative += counts[i];
+    text_.append(name);
+    text_.append("_bucket");
+    sampleName("", labels, bound_labels[i]);
+    fmt::format_to(std::back_inserter(text_), " {}\n", cumulative);
+  }
+  text_.append(name);
+  sample("_count", labels, histogram.count());
+  text_.append(name);
+  sample("_sum", labels, histogram.sum());
+
+  return;
+}
+
+void MetricsWriter::finish() {
+
+  text_.append("# EOF\n");
+
+  return;
+}
+
+const string& MetricsWriter::text() const {
+
+  return text_;
+}
+
+void MetricsWriter::count(string_view name, string_view labels,
+                          uint64_t value) {
+
+  sampleName(name, labels, "");
+  fmt::format_to(std::back_inserter(text_), " {}\n", value);
+
+  return;
+}
+
+/*
+ * name{labels,extra_label}, or just name if there are no labels
+ */
+void MetricsWriter::sampleName(string_view name, string_view labels,
+                               string_view extra_label) {
+
+  text_.append(name);
+  if ((labels.empty() == true) && (extra_label.empty() == true)) {
+    return;
+  }
+  text_.push_back('{');
+  text_.append(labels);
+  if ((labels.empty() == false) && (extra_label.empty() == false)) {
+    text_.push_back(',');
+  }
+  text_.append(extra_label);
+  text_.push_back('}');
+
+  return;
+}
+
+}  // namespace qw_utilities
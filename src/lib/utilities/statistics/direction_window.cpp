@@ -0,0 +1,63 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "direction_window.h"
+
+namespace qw_utilities {
+
+DirectionWindow::DirectionWindow(system_clock::duration window)
+    : x_(window), y_(window) {}
+
+void DirectionWindow::add(time_point<system_clock> time, double degrees) {
+
+  double radians = degrees * M_PI / 180;
+
+  x_.add(time, cos(radians));
+  y_.add(time, sin(radians));
+
+  return;
+}
+
+void DirectionWindow::expire(time_point<system_clock> time) {
+
+  x_.expire(time);
+  y_.expire(time);
+
+  return;
+}
+
+expected<double, int> DirectionWindow::mean() {
+
+  expected<double, int> x_mean = x_.mean();
+  expected<double, int> y_mean = y_.mean();
+  if ((x_mean.has_value() == false) || (y_mean.has_value() == false)) {
+    return unexpected(ENODATA);
+  }
+
+  if (hypot(x_mean.value(), y_mean.value()) < kDirectionMinimumResultant) {
+    return unexpected(ERANGE);
+  }
+
+  double degrees = atan2(y_mean.value(), x_mean.value()) * 180 / M_PI;
+  if (degrees < 0) {
+    degrees += 360;
+  }
+
+  return degrees;
+}
+
+size_t DirectionWindow::count() {
+
+  return x_.count();
+}
+
+void DirectionWindow::clear() {
+
+  x_.clear();
+  y_.clear();
+
+  return;
+}
+
+}  // namespace qw_utilities
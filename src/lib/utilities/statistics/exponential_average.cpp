@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "exponential_average.h"
+
+using std::chrono::duration;
+
+namespace qw_utilities {
+
+ExponentialAverage::ExponentialAverage(system_clock::duration time_constant)
+    : time_constant_(duration<double>(time_constant).count()) {}
+
+void ExponentialAverage::add(time_point<system_clock> time, double value) {
+
+  /*
+   * The first sample is the average
+   */
+  if (initialized_ == false) {
+    value_ = value;
+    last_time_ = time;
+    initialized_ = true;
+    return;
+  }
+
+  /*
+   * alpha = 1 - e^(-dt/tau). A sample at the same time as the last one,
+   * or out of order, doesn't move the average.
+   */
+  double dt = duration<double>(time - last_time_).count();
+  if (dt <= 0) {
+    return;
+  }
+  double alpha = 1 - exp(-dt / time_constant_);
+
+  value_ += alpha * (value - value_);
+  last_time_ = time;
+
+  return;
+}
+
+expected<double, int> ExponentialAverage::value() {
+
+  if (initialized_ == false) {
+    return unexpected(ENODATA);
+  }
+
+  return value_;
+}
+
+void ExponentialAverage::clear() {
+
+  value_ = 0;
+  initialized_ = false;
+
+  return;
+}
+
+}  // namespace qw_utilities
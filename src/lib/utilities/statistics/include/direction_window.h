@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Average of a direction in degrees over a trailing time window.
+ * Directions can't be averaged directly (350 and 10 should give 0, not 180)
+ * so each one is turned into a unit vector and the vectors are averaged.
+ */
+
+#ifndef LIB_UTILITIES_STATISTICS_DIRECTION_WINDOW_H_
+#define LIB_UTILITIES_STATISTICS_DIRECTION_WINDOW_H_
+
+#include <chrono>
+#include <cmath>
+#include <expected>
+
+#include "rolling_window.h"
+
+using std::expected;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_utilities {
+
+/*
+ * If the vectors cancel out to less than this there is no meaningful
+ * average direction.
+ */
+constexpr double kDirectionMinimumResultant = 1e-6;
+
+class DirectionWindow {
+ public:
+  DirectionWindow(system_clock::duration window);
+
+  void add(time_point<system_clock> time, double degrees);
+
+  /*
+   * Drop the directions that have aged out as of time without adding one
+   */
+  void expire(time_point<system_clock> time);
+
+  /*
+   * Mean direction in degrees, 0 <= direction < 360
+   */
+  expected<double, int> mean();
+
+  size_t count();
+
+  void clear();
+
+ private:
+  RollingWindow x_;
+  RollingWindow y_;
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_STATISTICS_DIRECTION_WINDOW_H_
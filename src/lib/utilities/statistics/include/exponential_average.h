@@ -0,0 +1,46 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * An exponentially weighted moving average with a time constant rather than
+ * a fixed alpha. The weight of each new sample depends on how long it has
+ * been since the previous one, so irregular sampling still gives the same
+ * amount of smoothing.
+ */
+
+#ifndef LIB_UTILITIES_STATISTICS_EXPONENTIAL_AVERAGE_H_
+#define LIB_UTILITIES_STATISTICS_EXPONENTIAL_AVERAGE_H_
+
+#include <errno.h>
+#include <chrono>
+#include <cmath>
+#include <expected>
+
+using std::expected;
+using std::unexpected;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_utilities {
+
+class ExponentialAverage {
+ public:
+  ExponentialAverage(system_clock::duration time_constant);
+
+  void add(time_point<system_clock> time, double value);
+
+  expected<double, int> value();
+
+  void clear();
+
+ private:
+  double time_constant_;  // seconds
+  time_point<system_clock> last_time_;
+  double value_ = 0;
+  bool initialized_ = false;
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_STATISTICS_EXPONENTIAL_AVERAGE_H_
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The windowed statistics behind the averaged Weather Underground fields.
+ * The sampler adds every reading as it comes in and the uploader reads the
+ * averages when it builds a report, instead of using a single instantaneous
+ * reading.
+ *
+ * Values are kept in the units they are reported from:
+ *   temperature - Celsius
+ *   humidity    - percent relative humidity
+ *   pressure    - millibars
+ *   wind speed  - miles per hour
+ *   wind dir    - degrees
+ */
+
+#ifndef LIB_UTILITIES_STATISTICS_OBSERVATION_STATISTICS_H_
+#define LIB_UTILITIES_STATISTICS_OBSERVATION_STATISTICS_H_
+
+#include <chrono>
+
+#include "direction_window.h"
+#include "exponential_average.h"
+#include "pressure_measurement.h"
+#include "relative_humidity_measurement.h"
+#include "rolling_window.h"
+#include "temperature_measurement.h"
+
+using qw_units::PressureMeasurement;
+using qw_units::RelativeHumidityMeasurement;
+using qw_units::TemperatureMeasurement;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_utilities {
+
+/*
+ * Weather Underground's _avg2m fields are 2 minute averages and the _10m
+ * gust fields are the peak over 10 minutes.
+ */
+constexpr std::chrono::minutes kAverageWindow(2);
+constexpr std::chrono::minutes kGustWindow(10);
+constexpr std::chrono::minutes kSmoothingTimeConstant(2);
+
+class ObservationStatistics {
+ public:
+  ObservationStatistics();
+
+  void add(TemperatureMeasurement measurement);
+
+  void add(RelativeHumidityMeasurement measurement);
+
+  void add(PressureMeasurement measurement);
+
+  void addWind(time_point<system_clock> time, double speed_mph,
+               double direction_degrees);
+
+  /*
+   * Drop everything that has aged out of the windows as of time
+   */
+  void expire(time_point<system_clock> time);
+
+  RollingWindow& temperature();
+
+  RollingWindow& humidity();
+
+  RollingWindow& pressure();
+
+  ExponentialAverage& smoothedTemperature();
+
+  ExponentialAverage& smoothedPressure();
+
+  RollingWindow& windSpeed();
+
+  RollingWindow& windGust();
+
+  DirectionWindow& windDirection();
+
+ private:
+  RollingWindow temperature_{kAverageWindow};
+  RollingWindow humidity_{kAverageWindow};
+  RollingWindow pressure_{kAverageWindow};
+
+  ExponentialAverage smoothed_temperature_{kSmoothingTimeConstant};
+  ExponentialAverage smoothed_pressure_{kSmoothingTimeConstant};
+
+  RollingWindow wind_speed_{kAverageWindow};
+  RollingWindow wind_gust_{kGustWindow};
+  DirectionWindow wind_direction_{kAverageWindow};
+
+  /*
+   * The drivers hand back the same cached reading until their measurement
+   * interval expires. These keep us from counting it twice.
+   */
+  time_point<system_clock> last_temperature_time_;
+  time_point<system_clock> last_humidity_time_;
+  time_point<system_clock> last_pressure_time_;
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_STATISTICS_OBSERVATION_STATISTICS_H_
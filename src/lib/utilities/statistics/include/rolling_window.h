@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Statistics over the samples that fall within a trailing time window.
+ *
+ * Every add() is O(1) amortized:
+ *  - mean and variance use Welford's update, with the matching downdate when
+ *    a sample ages out of the window.
+ *  - min and max use monotonic deques. A sample that can never be the min
+ *    (or max) again is dropped as soon as a better one arrives.
+ */
+
+#ifndef LIB_UTILITIES_STATISTICS_ROLLING_WINDOW_H_
+#define LIB_UTILITIES_STATISTICS_ROLLING_WINDOW_H_
+
+#include <errno.h>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <expected>
+
+using std::deque;
+using std::expected;
+using std::unexpected;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_utilities {
+
+class RollingWindow {
+ public:
+  RollingWindow(system_clock::duration window);
+
+  /*
+   * Samples are expected in time order. Anything older than
+   * time - window is dropped.
+   */
+  void add(time_point<system_clock> time, double value);
+
+  /*
+   * Drop the samples that have aged out as of time without adding one
+   */
+  void expire(time_point<system_clock> time);
+
+  expected<double, int> mean();
+
+  expected<double, int> variance();
+
+  expected<double, int> standardDeviation();
+
+  expected<double, int> min();
+
+  expected<double, int> max();
+
+  /*
+   * The most recent sample
+   */
+  expected<double, int> last();
+
+  size_t count();
+
+  system_clock::duration window();
+
+  void clear();
+
+ private:
+  struct Sample {
+    time_point<system_clock> time;
+    double value;
+    uint64_t sequence;
+  };
+
+  system_clock::duration window_;
+
+  deque<Sample> samples_;
+  deque<Sample> min_samples_;  // values increase from front to back
+  deque<Sample> max_samples_;  // values decrease from front to back
+  uint64_t next_sequence_ = 0;
+
+  /*
+   * Welford running mean and sum of squared differences
+   */
+  double mean_ = 0;
+  double m2_ = 0;
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_STATISTICS_ROLLING_WINDOW_H_
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Median and median absolute deviation (MAD) of the last N integer samples.
+ *
+ * The window is kept in an order statistics tree (GNU pb_ds red black tree
+ * with rank information in every node) plus a FIFO of what to evict. Adding
+ * a sample is an insert and maybe an erase, O(log w). The median is a rank
+ * lookup, O(log w). The MAD is found by binary searching the deviation d
+ * until half the window lies within median +- d. Each probe is two rank
+ * queries so the MAD costs O(log w * log range).
+ */
+
+#ifndef LIB_UTILITIES_STATISTICS_SLIDING_MEDIAN_H_
+#define LIB_UTILITIES_STATISTICS_SLIDING_MEDIAN_H_
+
+#include <errno.h>
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <functional>
+#include <limits>
+#include <utility>
+
+using std::deque;
+using std::expected;
+using std::pair;
+using std::unexpected;
+
+namespace qw_utilities {
+
+class SlidingMedian {
+ public:
+  SlidingMedian(size_t window);
+
+  /*
+   * Add a sample, dropping the oldest one if the window is full
+   */
+  void add(int64_t value);
+
+  expected<int64_t, int> median();
+
+  /*
+   * Median of |x - median| over the window
+   */
+  expected<int64_t, int> medianAbsoluteDeviation();
+
+  size_t count();
+
+  size_t window();
+
+  void clear();
+
+ private:
+  /*
+   * Samples are keyed by value and then by arrival so equal values are
+   * still distinct keys.
+   */
+  typedef pair<int64_t, uint64_t> Key;
+  typedef __gnu_pbds::tree<Key, __gnu_pbds::null_type, std::less<Key>,
+                           __gnu_pbds::rb_tree_tag,
+                           __gnu_pbds::tree_order_statistics_node_update>
+      OrderedTree;
+
+  size_t window_;
+  uint64_t next_sequence_ = 0;
+  OrderedTree tree_;
+  deque<Key> fifo_;
+
+  /*
+   * Number of samples with low <= value <= high
+   */
+  size_t countBetween(int64_t low, int64_t high);
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_STATISTICS_SLIDING_MEDIAN_H_
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * A filter stage that sits between a sensor driver and everything that
+ * consumes its readings. It rejects single sample glitches, like the
+ * humidity spikes we see from the SHT4x, before they reach the history,
+ * the statistics or Weather Underground.
+ *
+ * Each reading goes through up to three checks, all on integer base values:
+ *  - Rate of change. A reading that moved further from the last accepted
+ *    reading than max_rate per second allows is rejected.
+ *  - Hampel. A reading more than hampel_threshold scaled MADs away from the
+ *    median of the last window readings is rejected. The scaled MAD is never
+ *    allowed below minimum_deviation, otherwise a quiet sensor with a MAD
+ *    of 0 would reject every change.
+ *  - Median output. If median_output is set the accepted reading is replaced
+ *    by the window median.
+ *
+ * If more than max_consecutive_rejections readings in a row are rejected we
+ * assume the quantity really did jump, throw the window away and start over.
+ *
+ * A whole series can be filtered too. Rejected readings are taken out of it
+ * and the ones the filter replaced are marked MEASUREMENT_QUALITY_FILTERED.
+ */
+
+#ifndef LIB_UTILITIES_STATISTICS_SPIKE_FILTER_H_
+#define LIB_UTILITIES_STATISTICS_SPIKE_FILTER_H_
+
+#include <errno.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <expected>
+#include <span>
+#include <string>
+
+#include "measurement_series.h"
+#include "pressure_measurement.h"
+#include "relative_humidity_measurement.h"
+#include "sliding_median.h"
+#include "temperature_measurement.h"
+
+using qw_units::MEASUREMENT_QUALITY_FILTERED;
+using qw_units::MeasurementSeries;
+using qw_units::PressureMeasurement;
+using qw_units::RelativeHumidityMeasurement;
+using qw_units::TemperatureMeasurement;
+using std::expected;
+using std::span;
+using std::string;
+using std::unexpected;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_utilities {
+
+/*
+ * 1.4826 * MAD estimates the standard deviation for normally
+ * distributed data
+ */
+constexpr double kMadToStandardDeviation = 1.4826;
+
+/*
+ * The Hampel check needs a few readings before the median means anything
+ */
+constexpr size_t kSpikeFilterMinimumSamples = 3;
+
+/*
+ * The defaults pass everything through. The checks are turned on from
+ * the Filters section of the config file.
+ */
+struct SpikeFilterConfig {
+  size_t window = 0;  // readings in the median window, 0 turns it off
+  double hampel_threshold = 3.0;
+  int64_t minimum_deviation = 0;  // in base units
+  int64_t max_rate = 0;           // base units per second, 0 turns it off
+  size_t max_consecutive_rejections = 5;
+  bool median_output = false;
+};
+
+class SpikeFilter {
+ public:
+  SpikeFilter(string name, SpikeFilterConfig config);
+
+  /*
+   * Returns the reading to pass on, or ERANGE if it was rejected
+   */
+  expected<int64_t, int> filter(time_point<system_clock> time, int64_t value);
+
+  expected<TemperatureMeasurement, int> filter(
+      TemperatureMeasurement measurement);
+
+  expected<RelativeHumidityMeasurement, int> filter(
+      RelativeHumidityMeasurement measurement);
+
+  expected<PressureMeasurement, int> filter(PressureMeasurement measurement);
+
+  /*
+   * Runs the readings from first on through the filter, in place
+   */
+  template <typename Quantity>
+  void filter(MeasurementSeries<Quantity>& series, size_t first = 0);
+
+  string name();
+
+  uint64_t acceptedCount();
+
+  uint64_t rejectedCount();
+
+  uint64_t rateRejectedCount();
+
+  uint64_t hampelRejectedCount();
+
+  uint64_t resyncCount();
+
+  void reset();
+
+ private:
+  string name_;
+  SpikeFilterConfig config_;
+  SlidingMedian median_;
+
+  bool have_accepted_ = false;
+  int64_t last_accepted_value_ = 0;
+  time_point<system_clock> last_accepted_time_;
+
+  /*
+   * The drivers return the same cached reading until it expires. A repeat
+   * gets the same answer as the first time without being counted again.
+   */
+  bool have_last_ = false;
+  time_point<system_clock> last_time_;
+  expected<int64_t, int> last_result_ = unexpected(ENODATA);
+
+  size_t consecutive_rejections_ = 0;
+
+  uint64_t accepted_ = 0;
+  uint64_t rate_rejected_ = 0;
+  uint64_t hampel_rejected_ = 0;
+  uint64_t resyncs_ = 0;
+};
+
+/*
+ * The readings that are kept are moved down over the rejected ones, so
+ * the series only has to be cut short at the end
+ */
+template <typename Quantity>
+void SpikeFilter::filter(MeasurementSeries<Quantity>& series, size_t first) {
+  span<time_point<system_clock>> times = series.times();
+  span<typename Quantity::rep> values = series.values();
+  span<uint8_t> quality = series.quality();
+  size_t kept = first;
+
+  for (size_t i = first; i < series.size(); i++) {
+    expected<int64_t, int> x_value = filter(times[i], values[i]);
+    if (x_value.has_value() == false) {
+      continue;
+    }
+    times[kept] = times[i];
+    quality[kept] = quality[i];
+    if (x_value.value() != values[i]) {
+      quality[kept] |= MEASUREMENT_QUALITY_FILTERED;
+    }
+    values[kept] = static_cast<typename Quantity::rep>(x_value.value());
+    kept++;
+  }
+  series.truncate(kept);
+
+  return;
+}
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_STATISTICS_SPIKE_FILTER_H_
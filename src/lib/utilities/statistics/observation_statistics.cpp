@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "observation_statistics.h"
+
+namespace qw_utilities {
+
+ObservationStatistics::ObservationStatistics() {}
+
+void ObservationStatistics::add(TemperatureMeasurement measurement) {
+
+  time_point<system_clock> time = measurement.time();
+  if (time <= last_temperature_time_) {
+    return;
+  }
+  last_temperature_time_ = time;
+
+  double tempc = measurement.celsiusValue().value();
+  temperature_.add(time, tempc);
+  smoothed_temperature_.add(time, tempc);
+
+  return;
+}
+
+void ObservationStatistics::add(RelativeHumidityMeasurement measurement) {
+
+  time_point<system_clock> time = measurement.time();
+  if (time <= last_humidity_time_) {
+    return;
+  }
+  last_humidity_time_ = time;
+
+  humidity_.add(time, measurement.relativeHumidityValue().value());
+
+  return;
+}
+
+void ObservationStatistics::add(PressureMeasurement measurement) {
+
+  time_point<system_clock> time = measurement.time();
+  if (time <= last_pressure_time_) {
+    return;
+  }
+  last_pressure_time_ = time;
+
+  double mb = measurement.millibarValue().value();
+  pressure_.add(time, mb);
+  smoothed_pressure_.add(time, mb);
+
+  return;
+}
+
+/*
+ * The gust window just tracks the peak speed so it gets the speed as well
+ */
+void ObservationStatistics::addWind(time_point<system_clock> time,
+                                    double speed_mph,
+                                    double direction_degrees) {
+
+  wind_speed_.add(time, speed_mph);
+  wind_gust_.add(time, speed_mph);
+  wind_direction_.add(time, direction_degrees);
+
+  return;
+}
+
+/*
+ * If a sensor stops returning readings its old values shouldn't keep
+ * getting reported as the average.
+ */
+void ObservationStatistics::expire(time_point<system_clock> time) {
+
+  temperature_.expire(time);
+  humidity_.expire(time);
+  pressure_.expire(time);
+  wind_speed_.expire(time);
+  wind_gust_.expire(time);
+  wind_direction_.expire(time);
+
+  return;
+}
+
+RollingWindow& ObservationStatistics::temperature() {
+
+  return temperature_;
+}
+
+RollingWindow& ObservationStatistics::humidity() {
+
+  return humidity_;
+}
+
+RollingWindow& ObservationStatistics::pressure() {
+
+  return pressure_;
+}
+
+ExponentialAverage& ObservationStatistics::smoothedTemperature() {
+
+  return smoothed_temperature_;
+}
+
+ExponentialAverage& ObservationStatistics::smoothedPressure() {
+
+  return smoothed_pressure_;
+}
+
+RollingWindow& ObservationStatistics::windSpeed() {
+
+  return wind_speed_;
+}
+
+RollingWindow& ObservationStatistics::windGust() {
+
+  return wind_gust_;
+}
+
+DirectionWindow& ObservationStatistics::windDirection() {
+
+  return wind_direction_;
+}
+
+}  // namespace qw_utilities
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "rolling_window.h"
+
+namespace qw_utilities {
+
+RollingWindow::RollingWindow(system_clock::duration window)
+    : window_(window) {}
+
+void RollingWindow::add(time_point<system_clock> time, double value) {
+
+  expire(time);
+
+  Sample sample = {time, value, next_sequence_++};
+  samples_.push_back(sample);
+
+  /*
+   * Welford update with the new sample
+   */
+  double delta = value - mean_;
+  mean_ += delta / samples_.size();
+  m2_ += delta * (value - mean_);
+
+  /*
+   * Anything at the back that is not smaller than the new value can't be
+   * the minimum while the new value is in the window. Same for max.
+   */
+  while ((min_samples_.empty() == false) &&
+         (min_samples_.back().value >= value)) {
+    min_samples_.pop_back();
+  }
+  min_samples_.push_back(sample);
+
+  while ((max_samples_.empty() == false) &&
+         (max_samples_.back().value <= value)) {
+    max_samples_.pop_back();
+  }
+  max_samples_.push_back(sample);
+
+  return;
+}
+
+void RollingWindow::expire(time_point<system_clock> time) {
+
+  while ((samples_.empty() == false) &&
+         (samples_.front().time <= (time - window_))) {
+    Sample oldest = samples_.front();
+    samples_.pop_front();
+
+    if (samples_.empty() == true) {
+      mean_ = 0;
+      m2_ = 0;
+    } else {
+      /*
+       * Welford downdate. This is the add in reverse.
+       */
+      double delta = oldest.value - mean_;
+      mean_ -= delta / samples_.size();
+      m2_ -= delta * (oldest.value - mean_);
+      if (m2_ < 0) {
+        m2_ = 0;  // rounding can leave it a hair below zero
+      }
+    }
+
+    if ((min_samples_.empty() == false) &&
+        (min_samples_.front().sequence == oldest.sequence)) {
+      min_samples_.pop_front();
+    }
+    if ((max_samples_.empty() == false) &&
+        (max_samples_.front().sequence == oldest.sequence)) {
+      max_samples_.pop_front();
+    }
+  }
+
+  return;
+}
+
+expected<double, int> RollingWindow::mean() {
+
+  if (samples_.empty() == true) {
+    return unexpected(ENODATA);
+  }
+
+  return mean_;
+}
+
+/*
+ * This is the sample variance so it needs at least two samples
+ */
+expected<double, int> RollingWindow::variance() {
+
+  if (samples_.size() < 2) {
+    return unexpected(ENODATA);
+  }
+
+  return m2_ / (samples_.size() - 1);
+}
+
+expected<double, int> RollingWindow::standardDeviation() {
+
+  expected<double, int> x_variance = variance();
+  if (x_variance.has_value() == false) {
+    return x_variance;
+  }
+
+  return sqrt(x_variance.value());
+}
+
+expected<double, int> RollingWindow::min() {
+
+  if (min_samples_.empty() == true) {
+    return unexpected(ENODATA);
+  }
+
+  return min_samples_.front().value;
+}
+
+expected<double, int> RollingWindow::max() {
+
+  if (max_samples_.empty() == true) {
+    return unexpected(ENODATA);
+  }
+
+  return max_samples_.front().value;
+}
+
+expected<double, int> RollingWindow::last() {
+
+  if (samples_.empty() == true) {
+    return unexpected(ENODATA);
+  }
+
+  return samples_.back().value;
+}
+
+size_t RollingWindow::count() {
+
+  return samples_.size();
+}
+
+system_clock::duration RollingWindow::window() {
+
+  return window_;
+}
+
+void RollingWindow::clear() {
+
+  samples_.clear();
+  min_samples_.clear();
+  max_samples_.clear();
+  mean_ = 0;
+  m2_ = 0;
+
+  return;
+}
+
+}  // namespace qw_utilities
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "sliding_median.h"
+
+namespace qw_utilities {
+
+SlidingMedian::SlidingMedian(size_t window) : window_(window) {}
+
+void SlidingMedian::add(int64_t value) {
+
+  if (window_ == 0) {
+    return;
+  }
+
+  if (fifo_.size() == window_) {
+    tree_.erase(fifo_.front());
+    fifo_.pop_front();
+  }
+
+  Key key = {value, next_sequence_++};
+  tree_.insert(key);
+  fifo_.push_back(key);
+
+  return;
+}
+
+/*
+ * For an even count this is the mean of the two middle values rounded
+ * toward negative infinity. That is close enough for a filter.
+ */
+expected<int64_t, int> SlidingMedian::median() {
+
+  size_t n = tree_.size();
+  if (n == 0) {
+    return unexpected(ENODATA);
+  }
+
+  int64_t upper = tree_.find_by_order(n / 2)->first;
+  if ((n % 2) == 1) {
+    return upper;
+  }
+  int64_t lower = tree_.find_by_order((n / 2) - 1)->first;
+
+  return lower + ((upper - lower) / 2);
+}
+
+expected<int64_t, int> SlidingMedian::medianAbsoluteDeviation() {
+
+  expected<int64_t, int> x_median = median();
+  if (x_median.has_value() == false) {
+    return x_median;
+  }
+  int64_t center = x_median.value();
+
+  /*
+   * We want the smallest d where at least half the samples are within
+   * center +- d. The answer is somewhere between 0 and the distance to
+   * the farthest sample.
+   */
+  size_t needed = (tree_.size() + 1) / 2;
+  int64_t low = 0;
+  int64_t high = std::max(center - tree_.find_by_order(0)->first,
+                          tree_.find_by_order(tree_.size() - 1)->first -
+                              center);
+  while (low < high) {
+    int64_t d = low + ((high - low) / 2);
+    if (countBetween(center - d, center + d) >= needed) {
+      high = d;
+    } else {
+      low = d + 1;
+    }
+  }
+
+  return low;
+}
+
+size_t SlidingMedian::count() {
+
+  return tree_.size();
+}
+
+size_t SlidingMedian::window() {
+
+  return window_;
+}
+
+void SlidingMedian::clear() {
+
+  tree_.clear();
+  fifo_.clear();
+
+  return;
+}
+
+size_t SlidingMedian::countBetween(int64_t low, int64_t high) {
+
+  size_t below = tree_.order_of_key({low, 0});
+  size_t through =
+      tree_.order_of_key({high, std::numeric_limits<uint64_t>::max()});
+
+  return through - below;
+}
+
+}  // namespace qw_utilities
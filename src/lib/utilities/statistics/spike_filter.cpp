@@ -0,0 +1,176 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "spike_filter.h"
+
+using qw_units::Celsius;
+using qw_units::Millibar;
+using qw_units::RelativeHumidity;
+using std::chrono::duration;
+
+namespace qw_utilities {
+
+SpikeFilter::SpikeFilter(string name, SpikeFilterConfig config)
+    : name_(name), config_(config), median_(config.window) {}
+
+expected<int64_t, int> SpikeFilter::filter(time_point<system_clock> time,
+                                           int64_t value) {
+
+  if ((have_last_ == true) && (time == last_time_)) {
+    return last_result_;
+  }
+  have_last_ = true;
+  last_time_ = time;
+
+  bool rate_rejected = false;
+  bool hampel_rejected = false;
+
+  if ((config_.max_rate > 0) && (have_accepted_ == true)) {
+    double seconds = duration<double>(time - last_accepted_time_).count();
+    if ((seconds > 0) &&
+        (std::abs(value - last_accepted_value_) > config_.max_rate * seconds)) {
+      rate_rejected = true;
+    }
+  }
+
+  if ((config_.window > 0) &&
+      (median_.count() >= kSpikeFilterMinimumSamples)) {
+    int64_t center = median_.median().value();
+    double limit = config_.hampel_threshold * kMadToStandardDeviation *
+                   median_.medianAbsoluteDeviation().value();
+    limit = std::max(limit, static_cast<double>(config_.minimum_deviation));
+    if (std::abs(value - center) > limit) {
+      hampel_rejected = true;
+    }
+  }
+
+  if ((rate_rejected == true) || (hampel_rejected == true)) {
+    if (rate_rejected == true) {
+      rate_rejected_++;
+    } else {
+      hampel_rejected_++;
+    }
+    consecutive_rejections_++;
+    if (consecutive_rejections_ <= config_.max_consecutive_rejections) {
+      last_result_ = unexpected(ERANGE);
+      return last_result_;
+    }
+    /*
+     * Too many in a row. This isn't a spike, the reading moved.
+     */
+    median_.clear();
+    resyncs_++;
+  }
+
+  consecutive_rejections_ = 0;
+  accepted_++;
+  median_.add(value);
+  have_accepted_ = true;
+  last_accepted_value_ = value;
+  last_accepted_time_ = time;
+
+  if ((config_.median_output == true) && (median_.count() != 0)) {
+    last_result_ = median_.median().value();
+  } else {
+    last_result_ = value;
+  }
+
+  return last_result_;
+}
+
+/*
+ * The measurement versions run the base value through the filter and
+ * rebuild the measurement from the base value if the filter changed it,
+ * so nothing goes through a float on the way.
+ */
+expected<TemperatureMeasurement, int> SpikeFilter::filter(
+    TemperatureMeasurement measurement) {
+
+  int64_t base = measurement.celsiusValue().baseValue();
+  expected<int64_t, int> x_value = filter(measurement.time(), base);
+  if (x_value.has_value() == false) {
+    return unexpected(x_value.error());
+  }
+  if (x_value.value() == base) {
+    return measurement;
+  }
+
+  return TemperatureMeasurement(Celsius::fromBase(x_value.value()),
+                                measurement.accuracy(), measurement.time());
+}
+
+expected<RelativeHumidityMeasurement, int> SpikeFilter::filter(
+    RelativeHumidityMeasurement measurement) {
+
+  int64_t base = measurement.relativeHumidityValue().baseValue();
+  expected<int64_t, int> x_value = filter(measurement.time(), base);
+  if (x_value.has_value() == false) {
+    return unexpected(x_value.error());
+  }
+  if (x_value.value() == base) {
+    return measurement;
+  }
+
+  return RelativeHumidityMeasurement(
+      RelativeHumidity::fromBase(x_value.value()), measurement.accuracy(),
+      measurement.time());
+}
+
+expected<PressureMeasurement, int> SpikeFilter::filter(
+    PressureMeasurement measurement) {
+
+  int64_t base = measurement.millibarValue().baseValue();
+  expected<int64_t, int> x_value = filter(measurement.time(), base);
+  if (x_value.has_value() == false) {
+    return unexpected(x_value.error());
+  }
+  if (x_value.value() == base) {
+    return measurement;
+  }
+
+  return PressureMeasurement(Millibar::fromBase(x_value.value()),
+                             measurement.accuracy(), measurement.time());
+}
+
+string SpikeFilter::name() {
+
+  return name_;
+}
+
+uint64_t SpikeFilter::acceptedCount() {
+
+  return accepted_;
+}
+
+uint64_t SpikeFilter::rejectedCount() {
+
+  return rate_rejected_ + hampel_rejected_;
+}
+
+uint64_t SpikeFilter::rateRejectedCount() {
+
+  return rate_rejected_;
+}
+
+uint64_t SpikeFilter::hampelRejectedCount() {
+
+  return hampel_rejected_;
+}
+
+uint64_t SpikeFilter::resyncCount() {
+
+  return resyncs_;
+}
+
+void SpikeFilter::reset() {
+
+  median_.clear();
+  have_accepted_ = false;
+  have_last_ = false;
+  consecutive_rejections_ = 0;
+
+  return;
+}
+
+}  // namespace qw_utilities
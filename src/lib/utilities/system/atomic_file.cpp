@@ -0,0 +1,67 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "atomic_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+expected<bool, int> writeFileAtomically(const std::filesystem::path& path,
+                                        string_view data) {
+  std::filesystem::path temporary = path;
+
+  temporary += atomic_file_temporary_extension;
+
+  int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0644);
+  if (fd < 0) {
+    return unexpected(errno);
+  }
+
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t count = write(fd, data.data() + written, data.size() - written);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      int error = errno;
+      close(fd);
+      unlink(temporary.c_str());
+      return unexpected(error);
+    }
+    written += count;
+  }
+
+  if (fsync(fd) != 0) {
+    int error = errno;
+    close(fd);
+    unlink(temporary.c_str());
+    return unexpected(error);
+  }
+  close(fd);
+
+  if (rename(temporary.c_str(), path.c_str()) != 0) {
+    int error = errno;
+    unlink(temporary.c_str());
+    return unexpected(error);
+  }
+
+  /*
+   * And the directory, so the new name is on disk too. The file is there
+   * by now whatever happens here, so this can't fail the write.
+   */
+  std::filesystem::path directory = path.parent_path();
+  if (directory.empty() == true) {
+    directory = ".";
+  }
+  int directory_fd =
+      open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (directory_fd >= 0) {
+    fsync(directory_fd);
+    close(directory_fd);
+  }
+
+  return true;
+}
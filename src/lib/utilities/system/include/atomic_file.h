@@ -0,0 +1,37 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Writing a file so that after a crash or a power failure it is either
+ * all there or not there at all.
+ *
+ * The data is written to the path with atomic_file_temporary_extension on
+ * the end and fsync()ed, then renamed to the path and the directory is
+ * fsync()ed so the new name is on disk too. A file left with the
+ * temporary extension was being written when we went down, whoever owns
+ * the directory should remove it when they start.
+ */
+
+#ifndef LIB_UTILITIES_SYSTEM_ATOMIC_FILE_H_
+#define LIB_UTILITIES_SYSTEM_ATOMIC_FILE_H_
+
+#include <errno.h>
+#include <expected>
+#include <filesystem>
+#include <string_view>
+
+using std::expected;
+using std::string_view;
+using std::unexpected;
+
+constexpr string_view atomic_file_temporary_extension = ".tmp";
+
+/*
+ * true once data is at path, or the errno of whatever went wrong. Nothing
+ * is left behind on an error, path is as it was.
+ */
+expected<bool, int> writeFileAtomically(const std::filesystem::path& path,
+                                        string_view data);
+
+#endif  // LIB_UTILITIES_SYSTEM_ATOMIC_FILE_H_
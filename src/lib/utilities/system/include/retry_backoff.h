@@ -0,0 +1,33 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * How long to wait before trying something that keeps failing again
+ */
+
+#ifndef LIB_UTILITIES_SYSTEM_RETRY_BACKOFF_H_
+#define LIB_UTILITIES_SYSTEM_RETRY_BACKOFF_H_
+
+#include <algorithm>
+#include <chrono>
+
+using std::chrono::milliseconds;
+
+/*
+ * retry_initial, doubled for every failure after the first, up to
+ * retry_max. failures is how many in a row there have been, this one
+ * included.
+ */
+inline milliseconds retryDelay(int failures, milliseconds retry_initial,
+                               milliseconds retry_max) {
+  milliseconds delay = retry_initial;
+
+  for (int i = 1; (i < failures) && (delay < retry_max); i++) {
+    delay *= 2;
+  }
+
+  return std::min(delay, retry_max);
+}
+
+#endif  // LIB_UTILITIES_SYSTEM_RETRY_BACKOFF_H_
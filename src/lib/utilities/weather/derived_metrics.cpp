@@ -0,0 +1,405 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "derived_metrics.h"
+
+#include <cmath>
+
+#include "dewpoint.h"
+#include "fahrenheit.h"
+#include "psychrometrics.h"
+#include "sea_level_pressure.h"
+
+using qw_units::Fahrenheit;
+
+namespace qw_utilities {
+
+/*
+ * Grams per cubic meter per (millibar / Kelvin), from the water vapor
+ * gas constant.
+ */
+constexpr double absolute_humidity_factor = 216.7;
+
+/*
+ * NWS says wind chill isn't defined above 50 F or below 3 mph
+ */
+constexpr double wind_chill_max_fahrenheit = 50;
+constexpr double wind_chill_min_mph = 3;
+
+#define INPUT(x) (1u << DERIVED_INPUT_##x)
+#define METRIC(x) (1u << DERIVED_METRIC_##x)
+
+struct DerivedMetricDefinition {
+  const char* name;
+  uint32_t inputs;   // bit per DerivedInput read directly
+  uint32_t metrics;  // bit per DerivedMetric it is computed from
+  expected<double, int> (*compute)(DerivedMetrics& derived);
+};
+
+static expected<double, int> computeSaturationVaporPressure(
+    DerivedMetrics& derived) {
+
+  double t = derived.input(DERIVED_INPUT_TEMPERATURE).value();
+
+  return qw_utilities::saturationVaporPressure(Celsius(static_cast<float>(t)))
+      .value();
+}
+
+static expected<double, int> computeVaporPressure(DerivedMetrics& derived) {
+
+  double rh = derived.input(DERIVED_INPUT_HUMIDITY).value();
+  double es = derived.value(DERIVED_METRIC_SATURATION_VAPOR_PRESSURE).value();
+
+  return (rh / 100) * es;
+}
+
+static expected<double, int> computeDewPoint(DerivedMetrics& derived) {
+
+  double t = derived.input(DERIVED_INPUT_TEMPERATURE).value();
+  double rh = derived.input(DERIVED_INPUT_HUMIDITY).value();
+
+  /*
+   * log(0) doesn't go well
+   */
+  if (rh <= 0) {
+    return unexpected(ERANGE);
+  }
+
+  /*
+   * Go through the same function the station always used so the uploaded
+   * dewpoint doesn't change.
+   */
+  return dewPoint(Celsius(static_cast<float>(t)),
+                  RelativeHumidity(static_cast<float>(rh)))
+      .value();
+}
+
+static expected<double, int> computeAbsoluteHumidity(DerivedMetrics& derived) {
+
+  double t = derived.input(DERIVED_INPUT_TEMPERATURE).value();
+  double e = derived.value(DERIVED_METRIC_VAPOR_PRESSURE).value();
+
+  return (absolute_humidity_factor * e) / (t + 273.15);
+}
+
+static expected<double, int> computeHeatIndex(DerivedMetrics& derived) {
+
+  double t = derived.input(DERIVED_INPUT_TEMPERATURE).value();
+  double rh = derived.input(DERIVED_INPUT_HUMIDITY).value();
+
+  return qw_utilities::heatIndex(Celsius(static_cast<float>(t)),
+                                 RelativeHumidity(static_cast<float>(rh)))
+      .value();
+}
+
+/*
+ * Environment Canada's humidex, with the vapor pressure taken from the
+ * dew point the way they define it.
+ */
+static expected<double, int> computeHumidex(DerivedMetrics& derived) {
+
+  double t = derived.input(DERIVED_INPUT_TEMPERATURE).value();
+  expected<double, int> x_dewpoint = derived.value(DERIVED_METRIC_DEW_POINT);
+  if (x_dewpoint.has_value() == false) {
+    return x_dewpoint;
+  }
+
+  double e = 6.11 * exp(5417.7530 * ((1 / 273.16) -
+                                     (1 / (273.15 + x_dewpoint.value()))));
+
+  return t + (0.5555 * (e - 10));
+}
+
+/*
+ * The 2001 NWS wind chill, also done in Fahrenheit and mph:
+ * https://www.weather.gov/media/epz/wxcalc/windChill.pdf
+ */
+static expected<double, int> computeWindChill(DerivedMetrics& derived) {
+
+  double t = Fahrenheit(Celsius(static_cast<float>(
+                            derived.input(DERIVED_INPUT_TEMPERATURE).value())))
+                 .value();
+  double v = derived.input(DERIVED_INPUT_WIND_SPEED).value();
+
+  if ((t > wind_chill_max_fahrenheit) || (v < wind_chill_min_mph)) {
+    return unexpected(ERANGE);
+  }
+
+  double v16 = pow(v, 0.16);
+  double wc = 35.74 + (0.6215 * t) - (35.75 * v16) + (0.4275 * t * v16);
+
+  return Celsius(Fahrenheit(static_cast<float>(wc))).value();
+}
+
+static expected<double, int> computeSeaLevelPressure(DerivedMetrics& derived) {
+
+  double t = derived.input(DERIVED_INPUT_TEMPERATURE).value();
+  double p = derived.input(DERIVED_INPUT_PRESSURE).value();
+
+  return qw_utilities::seaLevelPressure(Millibar(static_cast<float>(p)),
+                                        Celsius(static_cast<float>(t)),
+                                        derived.altitude())
+      .value();
+}
+
+/*
+ * In the same order as DerivedMetric
+ */
+static const std::array<DerivedMetricDefinition, DERIVED_METRIC_MAX>
+    derived_metric_definitions = {{
+        {"saturation_vapor_pressure", INPUT(TEMPERATURE), 0,
+         computeSaturationVaporPressure},
+        {"vapor_pressure", INPUT(HUMIDITY), METRIC(SATURATION_VAPOR_PRESSURE),
+         computeVaporPressure},
+        {"dew_point", INPUT(TEMPERATURE) | INPUT(HUMIDITY), 0,
+         computeDewPoint},
+        {"absolute_humidity", INPUT(TEMPERATURE), METRIC(VAPOR_PRESSURE),
+         computeAbsoluteHumidity},
+        {"heat_index", INPUT(TEMPERATURE) | INPUT(HUMIDITY), 0,
+         computeHeatIndex},
+        {"humidex", INPUT(TEMPERATURE), METRIC(DEW_POINT), computeHumidex},
+        {"wind_chill", INPUT(TEMPERATURE) | INPUT(WIND_SPEED), 0,
+         computeWindChill},
+        {"sea_level_pressure", INPUT(TEMPERATURE) | INPUT(PRESSURE), 0,
+         computeSeaLevelPressure},
+    }};
+
+#undef INPUT
+#undef METRIC
+
+/*
+ * Fold the dependencies on other metrics into one mask of all the inputs
+ * each metric ends up needing. A metric only depends on earlier ones, so
+ * one pass in order does it.
+ */
+static std::array<uint32_t, DERIVED_METRIC_MAX> allInputs() {
+  std::array<uint32_t, DERIVED_METRIC_MAX> all_inputs;
+
+  for (int m = 0; m < DERIVED_METRIC_MAX; m++) {
+    all_inputs[m] = derived_metric_definitions[m].inputs;
+    for (int d = 0; d < m; d++) {
+      if ((derived_metric_definitions[m].metrics & (1u << d)) != 0) {
+        all_inputs[m] |= all_inputs[d];
+      }
+    }
+  }
+
+  return all_inputs;
+}
+
+static const std::array<uint32_t, DERIVED_METRIC_MAX> derived_metric_inputs =
+    allInputs();
+
+/*
+ * For each input, the metrics that have to be recalculated when it changes
+ */
+static std::array<uint32_t, DERIVED_INPUT_MAX> dependents() {
+  std::array<uint32_t, DERIVED_INPUT_MAX> dependent_metrics = {};
+
+  for (int m = 0; m < DERIVED_METRIC_MAX; m++) {
+    for (int i = 0; i < DERIVED_INPUT_MAX; i++) {
+      if ((derived_metric_inputs[m] & (1u << i)) != 0) {
+        dependent_metrics[i] |= (1u << m);
+      }
+    }
+  }
+
+  return dependent_metrics;
+}
+
+static const std::array<uint32_t, DERIVED_INPUT_MAX> derived_input_dependents =
+    dependents();
+
+DerivedMetrics::DerivedMetrics(float altitude_meters)
+    : altitude_meters_(altitude_meters) {
+
+  inputs_.fill(0);
+  cache_.fill(unexpected(ENODATA));
+}
+
+void DerivedMetrics::setTemperature(Celsius tempc) {
+
+  setInput(DERIVED_INPUT_TEMPERATURE, tempc.value());
+
+  return;
+}
+
+void DerivedMetrics::setHumidity(RelativeHumidity rh) {
+
+  setInput(DERIVED_INPUT_HUMIDITY, rh.value());
+
+  return;
+}
+
+void DerivedMetrics::setPressure(Millibar pressure) {
+
+  setInput(DERIVED_INPUT_PRESSURE, pressure.value());
+
+  return;
+}
+
+void DerivedMetrics::setWindSpeed(double speed_mph) {
+
+  setInput(DERIVED_INPUT_WIND_SPEED, speed_mph);
+
+  return;
+}
+
+void DerivedMetrics::clearInput(DerivedInput input) {
+
+  if ((input < 0) || (input >= DERIVED_INPUT_MAX)) {
+    return;
+  }
+
+  inputs_set_ &= ~(1u << input);
+  cached_ &= ~derived_input_dependents[input];
+
+  return;
+}
+
+expected<double, int> DerivedMetrics::input(DerivedInput input) {
+
+  if ((input < 0) || (input >= DERIVED_INPUT_MAX)) {
+    return unexpected(EINVAL);
+  }
+
+  if ((inputs_set_ & (1u << input)) == 0) {
+    return unexpected(ENODATA);
+  }
+
+  return inputs_[input];
+}
+
+expected<double, int> DerivedMetrics::value(DerivedMetric metric) {
+
+  if ((metric < 0) || (metric >= DERIVED_METRIC_MAX)) {
+    return unexpected(EINVAL);
+  }
+
+  if ((cached_ & (1u << metric)) != 0) {
+    return cache_[metric];
+  }
+
+  /*
+   * The compute functions can assume their inputs are there
+   */
+  uint32_t needed = derived_metric_inputs[metric];
+  if ((inputs_set_ & needed) != needed) {
+    return unexpected(ENODATA);
+  }
+
+  cache_[metric] = derived_metric_definitions[metric].compute(*this);
+  cached_ |= (1u << metric);
+  compute_count_++;
+
+  return cache_[metric];
+}
+
+expected<Millibar, int> DerivedMetrics::saturationVaporPressure() {
+
+  expected<double, int> x_mb = value(DERIVED_METRIC_SATURATION_VAPOR_PRESSURE);
+  if (x_mb.has_value() == false) {
+    return unexpected(x_mb.error());
+  }
+
+  return Millibar(static_cast<float>(x_mb.value()));
+}
+
+expected<Millibar, int> DerivedMetrics::vaporPressure() {
+
+  expected<double, int> x_mb = value(DERIVED_METRIC_VAPOR_PRESSURE);
+  if (x_mb.has_value() == false) {
+    return unexpected(x_mb.error());
+  }
+
+  return Millibar(static_cast<float>(x_mb.value()));
+}
+
+expected<Celsius, int> DerivedMetrics::dewPoint() {
+
+  expected<double, int> x_c = value(DERIVED_METRIC_DEW_POINT);
+  if (x_c.has_value() == false) {
+    return unexpected(x_c.error());
+  }
+
+  return Celsius(static_cast<float>(x_c.value()));
+}
+
+expected<double, int> DerivedMetrics::absoluteHumidity() {
+
+  return value(DERIVED_METRIC_ABSOLUTE_HUMIDITY);
+}
+
+expected<Celsius, int> DerivedMetrics::heatIndex() {
+
+  expected<double, int> x_c = value(DERIVED_METRIC_HEAT_INDEX);
+  if (x_c.has_value() == false) {
+    return unexpected(x_c.error());
+  }
+
+  return Celsius(static_cast<float>(x_c.value()));
+}
+
+expected<double, int> DerivedMetrics::humidex() {
+
+  return value(DERIVED_METRIC_HUMIDEX);
+}
+
+expected<Celsius, int> DerivedMetrics::windChill() {
+
+  expected<double, int> x_c = value(DERIVED_METRIC_WIND_CHILL);
+  if (x_c.has_value() == false) {
+    return unexpected(x_c.error());
+  }
+
+  return Celsius(static_cast<float>(x_c.value()));
+}
+
+expected<Millibar, int> DerivedMetrics::seaLevelPressure() {
+
+  expected<double, int> x_mb = value(DERIVED_METRIC_SEA_LEVEL_PRESSURE);
+  if (x_mb.has_value() == false) {
+    return unexpected(x_mb.error());
+  }
+
+  return Millibar(static_cast<float>(x_mb.value()));
+}
+
+const char* DerivedMetrics::name(DerivedMetric metric) {
+
+  if ((metric < 0) || (metric >= DERIVED_METRIC_MAX)) {
+    return "unknown";
+  }
+
+  return derived_metric_definitions[metric].name;
+}
+
+float DerivedMetrics::altitude() {
+
+  return altitude_meters_;
+}
+
+uint64_t DerivedMetrics::computeCount() {
+
+  return compute_count_;
+}
+
+/*
+ * Setting an input to the value it already has leaves the cache alone, so
+ * a sensor that returns its cached reading doesn't cost a recalculation.
+ */
+void DerivedMetrics::setInput(DerivedInput input, double value) {
+
+  if (((inputs_set_ & (1u << input)) != 0) && (inputs_[input] == value)) {
+    return;
+  }
+
+  inputs_[input] = value;
+  inputs_set_ |= (1u << input);
+  cached_ &= ~derived_input_dependents[input];
+
+  return;
+}
+
+}  // namespace qw_utilities
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Quantities that are calculated from the measured ones rather than read
+ * from a sensor: dew point, heat index and so on.
+ *
+ * Each metric declares which inputs and which other metrics it is computed
+ * from. Nothing is calculated until someone asks for it, and the answer is
+ * kept until one of the inputs it depends on changes. So the uploader, the
+ * logger and anything else can all ask for the dew point of the same sample
+ * and the logs and exps only get done once.
+ *
+ * Values come back in fixed units:
+ *   temperatures      - Celsius
+ *   pressures         - millibars
+ *   absolute humidity - grams per cubic meter
+ *   humidex           - a unitless index on the Celsius scale
+ */
+
+#ifndef LIB_UTILITIES_WEATHER_DERIVED_METRICS_H_
+#define LIB_UTILITIES_WEATHER_DERIVED_METRICS_H_
+
+#include <errno.h>
+#include <array>
+#include <cstdint>
+#include <expected>
+
+#include "celsius.h"
+#include "millibar.h"
+#include "relative_humidity.h"
+
+using qw_units::Celsius;
+using qw_units::Millibar;
+using qw_units::RelativeHumidity;
+using std::expected;
+using std::unexpected;
+
+namespace qw_utilities {
+
+enum DerivedInput {
+  DERIVED_INPUT_TEMPERATURE,  // Celsius
+  DERIVED_INPUT_HUMIDITY,     // percent
+  DERIVED_INPUT_PRESSURE,     // station pressure, millibars
+  DERIVED_INPUT_WIND_SPEED,   // miles per hour
+  DERIVED_INPUT_MAX           // This should always be last
+};
+
+/*
+ * A metric can only depend on the ones listed before it
+ */
+enum DerivedMetric {
+  DERIVED_METRIC_SATURATION_VAPOR_PRESSURE,
+  DERIVED_METRIC_VAPOR_PRESSURE,
+  DERIVED_METRIC_DEW_POINT,
+  DERIVED_METRIC_ABSOLUTE_HUMIDITY,
+  DERIVED_METRIC_HEAT_INDEX,
+  DERIVED_METRIC_HUMIDEX,
+  DERIVED_METRIC_WIND_CHILL,
+  DERIVED_METRIC_SEA_LEVEL_PRESSURE,
+  DERIVED_METRIC_MAX  // This should always be last
+};
+
+class DerivedMetrics {
+ public:
+  /*
+   * The altitude is only used for the sea level pressure
+   */
+  DerivedMetrics(float altitude_meters);
+
+  void setTemperature(Celsius tempc);
+
+  void setHumidity(RelativeHumidity rh);
+
+  void setPressure(Millibar pressure);
+
+  void setWindSpeed(double speed_mph);
+
+  /*
+   * Forget an input, say when its sensor stops answering. The metrics
+   * that need it go back to ENODATA.
+   */
+  void clearInput(DerivedInput input);
+
+  expected<double, int> input(DerivedInput input);
+
+  /*
+   * The metric in the units listed above. ENODATA if an input it needs
+   * hasn't been set, ERANGE if it isn't defined for the current inputs,
+   * like wind chill on a warm day.
+   */
+  expected<double, int> value(DerivedMetric metric);
+
+  expected<Millibar, int> saturationVaporPressure();
+
+  expected<Millibar, int> vaporPressure();
+
+  expected<Celsius, int> dewPoint();
+
+  expected<double, int> absoluteHumidity();
+
+  expected<Celsius, int> heatIndex();
+
+  expected<double, int> humidex();
+
+  expected<Celsius, int> windChill();
+
+  expected<Millibar, int> seaLevelPressure();
+
+  static const char* name(DerivedMetric metric);
+
+  float altitude();
+
+  /*
+   * How many times a metric has actually been calculated, as opposed to
+   * handed back from the cache.
+   */
+  uint64_t computeCount();
+
+ private:
+  float altitude_meters_;
+
+  std::array<double, DERIVED_INPUT_MAX> inputs_;
+  uint32_t inputs_set_ = 0;  // bit per DerivedInput
+
+  std::array<expected<double, int>, DERIVED_METRIC_MAX> cache_;
+  uint32_t cached_ = 0;  // bit per DerivedMetric
+
+  uint64_t compute_count_ = 0;
+
+  void setInput(DerivedInput input, double value);
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_WEATHER_DERIVED_METRICS_H_
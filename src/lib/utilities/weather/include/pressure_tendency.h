@@ -0,0 +1,125 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The barometric tendency: a least squares line fitted to the last three
+ * hours of pressure readings.
+ *
+ * The samples live in a fixed size ring. The fit only needs the running
+ * sums of t, p, t*t and t*p, which get updated as a sample goes in and as
+ * the oldest one ages out, so each add() is O(1). Times are whole seconds
+ * from the first sample and pressures are integer base values, so the sums
+ * are exact 128 bit integers and never drift however long the daemon runs.
+ */
+
+#ifndef LIB_UTILITIES_WEATHER_PRESSURE_TENDENCY_H_
+#define LIB_UTILITIES_WEATHER_PRESSURE_TENDENCY_H_
+
+#include <errno.h>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <vector>
+
+#include "pressure_measurement.h"
+
+using qw_units::PressureMeasurement;
+using std::expected;
+using std::string;
+using std::unexpected;
+using std::vector;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+namespace qw_utilities {
+
+constexpr std::chrono::hours kPressureTendencyWindow(3);
+
+/*
+ * Enough for 3 hours of readings every 5 seconds with room to spare.
+ * If it fills up the oldest samples are dropped early.
+ */
+constexpr size_t kPressureTendencyCapacity = 4096;
+
+/*
+ * Don't report a tendency until the samples cover at least this long.
+ * A fit over a few minutes is mostly noise.
+ */
+constexpr std::chrono::minutes kPressureTendencyMinimumSpan(30);
+
+/*
+ * Met Office terms for the change over 3 hours, in millibars
+ */
+constexpr double kPressureTrendSteady = 0.1;
+constexpr double kPressureTrendSlowly = 1.6;
+constexpr double kPressureTrendNormal = 3.6;
+constexpr double kPressureTrendQuickly = 6.0;
+
+enum PressureTrend {
+  PRESSURE_TREND_FALLING_VERY_RAPIDLY,
+  PRESSURE_TREND_FALLING_QUICKLY,
+  PRESSURE_TREND_FALLING,
+  PRESSURE_TREND_FALLING_SLOWLY,
+  PRESSURE_TREND_STEADY,
+  PRESSURE_TREND_RISING_SLOWLY,
+  PRESSURE_TREND_RISING,
+  PRESSURE_TREND_RISING_QUICKLY,
+  PRESSURE_TREND_RISING_VERY_RAPIDLY
+};
+
+string pressureTrendName(PressureTrend trend);
+
+class PressureTendency {
+ public:
+  PressureTendency();
+
+  void add(PressureMeasurement measurement);
+
+  /*
+   * value is in milli-millibars like the Millibar base value
+   */
+  void add(time_point<system_clock> time, int64_t value);
+
+  /*
+   * Fitted slope in millibars per hour
+   */
+  expected<double, int> slope();
+
+  /*
+   * Fitted change over 3 hours in millibars
+   */
+  expected<double, int> change();
+
+  expected<PressureTrend, int> trend();
+
+  size_t count();
+
+  void clear();
+
+ private:
+  struct Sample {
+    int64_t seconds;  // since origin_
+    int64_t value;
+  };
+
+  vector<Sample> ring_;
+  size_t head_ = 0;  // oldest sample
+  size_t count_ = 0;
+
+  time_point<system_clock> origin_;
+  int64_t last_seconds_ = 0;
+
+  __int128 sum_t_ = 0;
+  __int128 sum_v_ = 0;
+  __int128 sum_tt_ = 0;
+  __int128 sum_tv_ = 0;
+
+  void removeOldest();
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_WEATHER_PRESSURE_TENDENCY_H_
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Saturation vapor pressure, dew point and heat index.
+ *
+ * The single value functions are the reference. The batch versions do
+ * whole arrays at once for reprocessing history, using polynomial
+ * approximations of log and exp instead of libm, with AVX2, SSE2 or NEON
+ * depending on the machine. Over the whole sensor range, -40 to 125 C and
+ * 0.01 to 100 %RH, they stay within the errors below of the reference
+ * functions. tools/psychrometric_error_sweep measures them.
+ *
+ * The batch dew point treats anything under 0.01 %RH, the humidity
+ * resolution, as 0.01 %RH instead of taking log(0).
+ */
+
+#ifndef LIB_UTILITIES_WEATHER_PSYCHROMETRICS_H_
+#define LIB_UTILITIES_WEATHER_PSYCHROMETRICS_H_
+
+#include <cmath>
+#include <cstddef>
+
+#include "celsius.h"
+#include "millibar.h"
+#include "relative_humidity.h"
+
+namespace qw_utilities {
+
+using qw_units::Celsius;
+using qw_units::Millibar;
+using qw_units::RelativeHumidity;
+
+/*
+ * Magnus formula coefficient for the saturation vapor pressure, in
+ * millibars. The other two are dew_point_b and dew_point_c.
+ */
+constexpr float svp_a = 6.1094;
+
+constexpr float kPsychrometricMinimumHumidity = 0.01;
+
+/*
+ * Bounds on the difference from the reference functions over the sweep.
+ * The reference values are rounded to the 0.001 resolution of the unit
+ * classes, which accounts for most of it. The sweep measured 0.00085 mb,
+ * 0.00053 C and 0.00061 C.
+ */
+constexpr float kSaturationVaporPressureBatchMaxError = 0.001;  // millibars
+constexpr float kDewPointBatchMaxError = 0.001;                 // Celsius
+constexpr float kHeatIndexBatchMaxError = 0.001;                // Celsius
+
+Millibar saturationVaporPressure(Celsius tempc);
+
+/*
+ * The NWS heat index:
+ * https://www.wpc.ncep.noaa.gov/html/heatindex_equation.shtml
+ */
+Celsius heatIndex(Celsius tempc, RelativeHumidity rh);
+
+void saturationVaporPressureBatch(const float* tempc, float* es, size_t count);
+
+void dewPointBatch(const float* tempc, const float* rh, float* dewpoint,
+                   size_t count);
+
+void heatIndexBatch(const float* tempc, const float* rh, float* heat_index,
+                    size_t count);
+
+/*
+ * Which vector kernels the batch functions use on this machine
+ */
+const char* psychrometricKernelName();
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_WEATHER_PSYCHROMETRICS_H_
@@ -0,0 +1,30 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#ifndef LIB_UTILITIES_WEATHER_SEA_LEVEL_PRESSURE_H_
+#define LIB_UTILITIES_WEATHER_SEA_LEVEL_PRESSURE_H_
+
+#include <cmath>
+
+#include "celsius.h"
+#include "millibar.h"
+
+namespace qw_utilities {
+
+using qw_units::Celsius;
+using qw_units::Millibar;
+
+constexpr float lapse_rate = 0.0065;  // Kelvin per meter
+constexpr float barometric_exponent = 5.257;
+
+/*
+ * Reduce the pressure measured at the station to what it would be at sea
+ * level, using the hypsometric formula with a standard lapse rate.
+ */
+Millibar seaLevelPressure(Millibar station, Celsius tempc,
+                          float altitude_meters);
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_WEATHER_SEA_LEVEL_PRESSURE_H_
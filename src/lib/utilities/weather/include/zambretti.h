@@ -0,0 +1,68 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * A Zambretti style short term forecast.
+ *
+ * The original Negretti & Zambra forecaster was a slide rule that took the
+ * sea level pressure and whether it was rising, falling or steady and
+ * pointed at one of 26 lettered forecasts. The version here is the common
+ * arithmetic approximation of it: a straight line in pressure per trend
+ * picks one of 32 numbered forecasts.
+ *
+ * Everything it needs comes from PressureTendency so update() is O(1) and
+ * can be called on every pressure sample.
+ */
+
+#ifndef LIB_UTILITIES_WEATHER_ZAMBRETTI_H_
+#define LIB_UTILITIES_WEATHER_ZAMBRETTI_H_
+
+#include <errno.h>
+#include <expected>
+#include <string>
+
+using std::expected;
+using std::string;
+using std::unexpected;
+
+namespace qw_utilities {
+
+/*
+ * A change over 3 hours smaller than this, in millibars, counts as steady
+ */
+constexpr double kZambrettiTrendThreshold = 1.6;
+
+constexpr int kZambrettiFallingFirst = 1;
+constexpr int kZambrettiFallingLast = 9;
+constexpr int kZambrettiSteadyFirst = 10;
+constexpr int kZambrettiSteadyLast = 19;
+constexpr int kZambrettiRisingFirst = 20;
+constexpr int kZambrettiRisingLast = 32;
+
+class ZambrettiForecast {
+ public:
+  ZambrettiForecast();
+
+  /*
+   * sea_level is the reduced pressure in millibars and change is the
+   * fitted change over the last 3 hours, also in millibars.
+   */
+  void update(double sea_level, double change);
+
+  /*
+   * The forecast number, 1 through 32
+   */
+  expected<int, int> number();
+
+  expected<string, int> forecast();
+
+  void clear();
+
+ private:
+  int number_ = 0;  // 0 until the first update
+};
+
+}  // namespace qw_utilities
+
+#endif  // LIB_UTILITIES_WEATHER_ZAMBRETTI_H_
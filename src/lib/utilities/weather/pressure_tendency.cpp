@@ -0,0 +1,196 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "pressure_tendency.h"
+
+using qw_units::pressure_base_conversion_factor;
+using std::chrono::duration_cast;
+using std::chrono::seconds;
+
+namespace qw_utilities {
+
+string pressureTrendName(PressureTrend trend) {
+
+  switch (trend) {
+    case PRESSURE_TREND_FALLING_VERY_RAPIDLY:
+      return "falling very rapidly";
+    case PRESSURE_TREND_FALLING_QUICKLY:
+      return "falling quickly";
+    case PRESSURE_TREND_FALLING:
+      return "falling";
+    case PRESSURE_TREND_FALLING_SLOWLY:
+      return "falling slowly";
+    case PRESSURE_TREND_STEADY:
+      return "steady";
+    case PRESSURE_TREND_RISING_SLOWLY:
+      return "rising slowly";
+    case PRESSURE_TREND_RISING:
+      return "rising";
+    case PRESSURE_TREND_RISING_QUICKLY:
+      return "rising quickly";
+    case PRESSURE_TREND_RISING_VERY_RAPIDLY:
+      return "rising very rapidly";
+  }
+
+  return "unknown";
+}
+
+PressureTendency::PressureTendency() : ring_(kPressureTendencyCapacity) {}
+
+void PressureTendency::add(PressureMeasurement measurement) {
+
+  add(measurement.time(), measurement.millibarValue().baseValue());
+
+  return;
+}
+
+void PressureTendency::add(time_point<system_clock> time, int64_t value) {
+
+  if (count_ == 0) {
+    origin_ = time;
+  }
+
+  int64_t t = duration_cast<seconds>(time - origin_).count();
+
+  /*
+   * The drivers repeat a cached reading until it expires. Also ignore
+   * anything that goes backwards in time.
+   */
+  if ((count_ != 0) && (t <= last_seconds_)) {
+    return;
+  }
+  last_seconds_ = t;
+
+  /*
+   * Age out anything older than the window, and make room if the ring
+   * is full.
+   */
+  int64_t oldest_allowed =
+      t - duration_cast<seconds>(kPressureTendencyWindow).count();
+  while ((count_ != 0) && (ring_[head_].seconds < oldest_allowed)) {
+    removeOldest();
+  }
+  if (count_ == ring_.size()) {
+    removeOldest();
+  }
+
+  ring_[(head_ + count_) % ring_.size()] = {t, value};
+  count_++;
+
+  sum_t_ += t;
+  sum_v_ += value;
+  sum_tt_ += static_cast<__int128>(t) * t;
+  sum_tv_ += static_cast<__int128>(t) * value;
+
+  return;
+}
+
+/*
+ * The usual least squares slope
+ *   (n * sum(tv) - sum(t) * sum(v)) / (n * sum(tt) - sum(t)^2)
+ * computed exactly and only turned into floating point at the end.
+ */
+expected<double, int> PressureTendency::slope() {
+
+  if (count_ < 2) {
+    return unexpected(ENODATA);
+  }
+
+  int64_t span = ring_[(head_ + count_ - 1) % ring_.size()].seconds -
+                 ring_[head_].seconds;
+  if (span < duration_cast<seconds>(kPressureTendencyMinimumSpan).count()) {
+    return unexpected(ENODATA);
+  }
+
+  __int128 n = count_;
+  __int128 numerator = (n * sum_tv_) - (sum_t_ * sum_v_);
+  __int128 denominator = (n * sum_tt_) - (sum_t_ * sum_t_);
+  if (denominator == 0) {
+    return unexpected(ENODATA);
+  }
+
+  /*
+   * base units per second to millibars per hour
+   */
+  long double per_second = static_cast<long double>(numerator) /
+                           static_cast<long double>(denominator);
+
+  return static_cast<double>(per_second * 3600 /
+                             pressure_base_conversion_factor);
+}
+
+expected<double, int> PressureTendency::change() {
+
+  expected<double, int> x_slope = slope();
+  if (x_slope.has_value() == false) {
+    return x_slope;
+  }
+
+  return x_slope.value() *
+         std::chrono::duration<double, std::ratio<3600>>(
+             kPressureTendencyWindow)
+             .count();
+}
+
+expected<PressureTrend, int> PressureTendency::trend() {
+
+  expected<double, int> x_change = change();
+  if (x_change.has_value() == false) {
+    return unexpected(x_change.error());
+  }
+
+  double delta = x_change.value();
+  double size = std::abs(delta);
+  if (size < kPressureTrendSteady) {
+    return PRESSURE_TREND_STEADY;
+  }
+  if (size < kPressureTrendSlowly) {
+    return (delta > 0) ? PRESSURE_TREND_RISING_SLOWLY
+                       : PRESSURE_TREND_FALLING_SLOWLY;
+  }
+  if (size < kPressureTrendNormal) {
+    return (delta > 0) ? PRESSURE_TREND_RISING : PRESSURE_TREND_FALLING;
+  }
+  if (size < kPressureTrendQuickly) {
+    return (delta > 0) ? PRESSURE_TREND_RISING_QUICKLY
+                       : PRESSURE_TREND_FALLING_QUICKLY;
+  }
+
+  return (delta > 0) ? PRESSURE_TREND_RISING_VERY_RAPIDLY
+                     : PRESSURE_TREND_FALLING_VERY_RAPIDLY;
+}
+
+size_t PressureTendency::count() {
+
+  return count_;
+}
+
+void PressureTendency::clear() {
+
+  head_ = 0;
+  count_ = 0;
+  sum_t_ = 0;
+  sum_v_ = 0;
+  sum_tt_ = 0;
+  sum_tv_ = 0;
+
+  return;
+}
+
+void PressureTendency::removeOldest() {
+
+  Sample& oldest = ring_[head_];
+
+  sum_t_ -= oldest.seconds;
+  sum_v_ -= oldest.value;
+  sum_tt_ -= static_cast<__int128>(oldest.seconds) * oldest.seconds;
+  sum_tv_ -= static_cast<__int128>(oldest.seconds) * oldest.value;
+
+  head_ = (head_ + 1) % ring_.size();
+  count_--;
+
+  return;
+}
+
+}  // namespace qw_utilities
@@ -0,0 +1,277 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The vector bodies of the psychrometric batch kernels.
+ *
+ * There is deliberately no include guard. psychrometrics.cpp includes this
+ * once per vector width, each time inside its own namespace and with VF
+ * (lanes of float) and VI (lanes of int32_t) typedef'd to GCC vector
+ * types of that width. The AVX2 copy is included under
+ * #pragma GCC target("avx2") so it gets compiled with the wide registers.
+ *
+ * The approximations are the Cephes single precision logf and expf: a
+ * range reduction on the exponent bits and a short polynomial on what's
+ * left. There are no libm calls.
+ */
+
+constexpr int kLanes = sizeof(VF) / sizeof(float);
+
+/*
+ * Cephes logf coefficients
+ */
+constexpr float log_sqrt_half = 0.707106781186547524f;
+constexpr float log_p0 = 7.0376836292e-2f;
+constexpr float log_p1 = -1.1514610310e-1f;
+constexpr float log_p2 = 1.1676998740e-1f;
+constexpr float log_p3 = -1.2420140846e-1f;
+constexpr float log_p4 = 1.4249322787e-1f;
+constexpr float log_p5 = -1.6668057665e-1f;
+constexpr float log_p6 = 2.0000714765e-1f;
+constexpr float log_p7 = -2.4999993993e-1f;
+constexpr float log_p8 = 3.3333331174e-1f;
+constexpr float log_q1 = -2.12194440e-4f;
+constexpr float log_q2 = 0.693359375f;
+
+/*
+ * Cephes expf coefficients
+ */
+constexpr float exp_max = 88.3762626647949f;
+constexpr float exp_log2e = 1.44269504088896341f;
+constexpr float exp_c1 = 0.693359375f;
+constexpr float exp_c2 = -2.12194440e-4f;
+constexpr float exp_p0 = 1.9875691500e-4f;
+constexpr float exp_p1 = 1.3981999507e-3f;
+constexpr float exp_p2 = 8.3334519073e-3f;
+constexpr float exp_p3 = 4.1665795894e-2f;
+constexpr float exp_p4 = 1.6666665459e-1f;
+constexpr float exp_p5 = 5.0000001201e-1f;
+
+static inline VF splat(float value) {
+
+  return VF{} + value;
+}
+
+static inline VF absolute(VF x) {
+
+  return (VF)((VI)x & 0x7fffffff);
+}
+
+static inline VF minimum(VF x, VF y) {
+
+  return (x < y) ? x : y;
+}
+
+static inline VF maximum(VF x, VF y) {
+
+  return (x > y) ? x : y;
+}
+
+static inline VF squareRoot(VF x) {
+  VF result;
+
+  for (int i = 0; i < kLanes; i++) {
+    result[i] = __builtin_sqrtf(x[i]);
+  }
+
+  return result;
+}
+
+/*
+ * Natural log for x > 0
+ */
+static inline VF fastLog(VF x) {
+  VI bits = (VI)x;
+
+  /*
+   * Split x into 2^e * m with m in [0.5, 1), then shift m into
+   * [sqrt(0.5), sqrt(2)) so the polynomial works on a small range
+   */
+  VI exponent = ((bits >> 23) & 0xff) - 126;
+  VF m = (VF)((bits & 0x007fffff) | 0x3f000000);
+  VI small = (m < log_sqrt_half);
+  VF e = __builtin_convertvector(exponent + small, VF);
+  m = (small ? (m + m) : m) - 1.0f;
+
+  VF z = m * m;
+  VF y = splat(log_p0);
+  y = (y * m) + log_p1;
+  y = (y * m) + log_p2;
+  y = (y * m) + log_p3;
+  y = (y * m) + log_p4;
+  y = (y * m) + log_p5;
+  y = (y * m) + log_p6;
+  y = (y * m) + log_p7;
+  y = (y * m) + log_p8;
+  y = y * m * z;
+
+  y = y + (log_q1 * e);
+  y = y - (0.5f * z);
+
+  return m + y + (log_q2 * e);
+}
+
+static inline VF fastExp(VF x) {
+
+  x = minimum(maximum(x, splat(-exp_max)), splat(exp_max));
+
+  /*
+   * x = n * ln(2) + r, n = floor(x / ln(2) + 0.5)
+   */
+  VF fx = (x * exp_log2e) + 0.5f;
+  VI n = __builtin_convertvector(fx, VI);
+  n = n + (__builtin_convertvector(n, VF) > fx);  // truncation to floor
+  fx = __builtin_convertvector(n, VF);
+
+  x = x - (fx * exp_c1);
+  x = x - (fx * exp_c2);
+
+  VF z = x * x;
+  VF y = splat(exp_p0);
+  y = (y * x) + exp_p1;
+  y = (y * x) + exp_p2;
+  y = (y * x) + exp_p3;
+  y = (y * x) + exp_p4;
+  y = (y * x) + exp_p5;
+  y = (y * z) + x + 1.0f;
+
+  /*
+   * Times 2^n by building the float directly
+   */
+  return y * (VF)((n + 127) << 23);
+}
+
+static inline VF saturationVaporPressureVector(VF tempc) {
+
+  return svp_a * fastExp((dew_point_b * tempc) / (dew_point_c + tempc));
+}
+
+static inline VF dewPointVector(VF tempc, VF rh) {
+
+  rh = maximum(rh, splat(kPsychrometricMinimumHumidity));
+
+  VF gamma =
+      fastLog(rh / 100.0f) + ((dew_point_b * tempc) / (dew_point_c + tempc));
+
+  return (dew_point_c * gamma) / (dew_point_b - gamma);
+}
+
+/*
+ * The NWS heat index, the same steps as heatIndex() but with every lane
+ * computing both the simple and the regression form and a select at the
+ * end.
+ */
+static inline VF heatIndexVector(VF tempc, VF rh) {
+  VF t = (((tempc * 9.0f) / 5.0f) + 32.0f);
+
+  VF simple = 0.5f * (t + 61.0f + ((t - 68.0f) * 1.2f) + (rh * 0.094f));
+
+  VF full = -42.379f + (2.04901523f * t) + (10.14333127f * rh) -
+            (0.22475541f * t * rh) - (0.00683783f * t * t) -
+            (0.05481717f * rh * rh) + (0.00122874f * t * t * rh) +
+            (0.00085282f * t * rh * rh) - (0.00000199f * t * t * rh * rh);
+
+  VF dry = ((13.0f - rh) / 4.0f) *
+           squareRoot(maximum((17.0f - absolute(t - 95.0f)) / 17.0f, VF{}));
+  VF humid = ((rh - 85.0f) / 10.0f) * ((87.0f - t) / 5.0f);
+
+  VI is_dry = (rh < 13.0f) & (t >= 80.0f) & (t <= 112.0f);
+  VI is_humid = (rh > 85.0f) & (t >= 80.0f) & (t <= 87.0f);
+  full = is_dry ? (full - dry) : (is_humid ? (full + humid) : full);
+
+  VF hi = (((simple + t) / 2.0f) >= 80.0f) ? full : simple;
+
+  return ((hi - 32.0f) * 5.0f) / 9.0f;
+}
+
+/*
+ * The loops. A partial vector at the end gets padded out so every value
+ * goes through exactly the same code.
+ */
+static inline VF load(const float* data) {
+  VF value;
+
+  __builtin_memcpy(&value, data, sizeof(value));
+
+  return value;
+}
+
+static inline void store(float* data, VF value) {
+
+  __builtin_memcpy(data, &value, sizeof(value));
+
+  return;
+}
+
+static inline VF loadPartial(const float* data, size_t count) {
+  VF value = {};
+
+  for (size_t i = 0; i < count; i++) {
+    value[i] = data[i];
+  }
+
+  return value;
+}
+
+static inline void storePartial(float* data, VF value, size_t count) {
+
+  for (size_t i = 0; i < count; i++) {
+    data[i] = value[i];
+  }
+
+  return;
+}
+
+static void saturationVaporPressureLoop(const float* tempc, float* es,
+                                        size_t count) {
+  size_t i = 0;
+
+  for (; (i + kLanes) <= count; i += kLanes) {
+    store(es + i, saturationVaporPressureVector(load(tempc + i)));
+  }
+  if (i < count) {
+    size_t left = count - i;
+    storePartial(es + i,
+                 saturationVaporPressureVector(loadPartial(tempc + i, left)),
+                 left);
+  }
+
+  return;
+}
+
+static void dewPointLoop(const float* tempc, const float* rh, float* dewpoint,
+                         size_t count) {
+  size_t i = 0;
+
+  for (; (i + kLanes) <= count; i += kLanes) {
+    store(dewpoint + i, dewPointVector(load(tempc + i), load(rh + i)));
+  }
+  if (i < count) {
+    size_t left = count - i;
+    storePartial(dewpoint + i,
+                 dewPointVector(loadPartial(tempc + i, left),
+                                loadPartial(rh + i, left)),
+                 left);
+  }
+
+  return;
+}
+
+static void heatIndexLoop(const float* tempc, const float* rh,
+                          float* heat_index, size_t count) {
+  size_t i = 0;
+
+  for (; (i + kLanes) <= count; i += kLanes) {
+    store(heat_index + i, heatIndexVector(load(tempc + i), load(rh + i)));
+  }
+  if (i < count) {
+    size_t left = count - i;
+    storePartial(heat_index + i,
+                 heatIndexVector(loadPartial(tempc + i, left),
+                                 loadPartial(rh + i, left)),
+                 left);
+  }
+
+  return;
+}
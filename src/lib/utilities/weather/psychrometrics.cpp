@@ -0,0 +1,139 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "psychrometrics.h"
+
+#include <cstdint>
+
+#include "dewpoint.h"
+#include "fahrenheit.h"
+
+using qw_units::Fahrenheit;
+
+namespace qw_utilities {
+
+Millibar saturationVaporPressure(Celsius tempc) {
+
+  float es =
+      svp_a * exp((dew_point_b * tempc.value()) / (dew_point_c + tempc.value()));
+
+  Millibar svp(es);
+
+  return svp;
+}
+
+Celsius heatIndex(Celsius tempc, RelativeHumidity rh) {
+
+  /*
+   * Single precision, and the same order of operations as the batch
+   * kernel. The formula jumps where it switches to the regression, so the
+   * two have to make exactly the same choice there.
+   */
+  float t = Fahrenheit(tempc).value();
+  float h = rh.value();
+
+  float hi = 0.5f * (t + 61.0f + ((t - 68.0f) * 1.2f) + (h * 0.094f));
+
+  if (((hi + t) / 2.0f) >= 80.0f) {
+    hi = -42.379f + (2.04901523f * t) + (10.14333127f * h) -
+         (0.22475541f * t * h) - (0.00683783f * t * t) -
+         (0.05481717f * h * h) + (0.00122874f * t * t * h) +
+         (0.00085282f * t * h * h) - (0.00000199f * t * t * h * h);
+
+    if ((h < 13.0f) && (t >= 80.0f) && (t <= 112.0f)) {
+      hi -= ((13.0f - h) / 4.0f) * sqrtf((17.0f - fabsf(t - 95.0f)) / 17.0f);
+    } else if ((h > 85.0f) && (t >= 80.0f) && (t <= 87.0f)) {
+      hi += ((h - 85.0f) / 10.0f) * ((87.0f - t) / 5.0f);
+    }
+  }
+
+  Celsius heat_index = Fahrenheit(hi);
+
+  return heat_index;
+}
+
+/*
+ * GCC vector extensions rather than intrinsics, so the same kernel source
+ * compiles to whichever vector unit the width maps onto.
+ */
+#if defined(__x86_64__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace avx2_kernels {
+typedef float VF __attribute__((vector_size(32)));
+typedef int32_t VI __attribute__((vector_size(32)));
+#include "psychrometric_kernels.h"
+}  // namespace avx2_kernels
+#pragma GCC pop_options
+#endif
+
+/*
+ * SSE2 on x86_64 and NEON on aarch64, both of which are always there
+ */
+namespace base_kernels {
+typedef float VF __attribute__((vector_size(16)));
+typedef int32_t VI __attribute__((vector_size(16)));
+#include "psychrometric_kernels.h"
+}  // namespace base_kernels
+
+#if defined(__x86_64__)
+static const bool psychrometric_avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+void saturationVaporPressureBatch(const float* tempc, float* es, size_t count) {
+
+#if defined(__x86_64__)
+  if (psychrometric_avx2 == true) {
+    avx2_kernels::saturationVaporPressureLoop(tempc, es, count);
+    return;
+  }
+#endif
+  base_kernels::saturationVaporPressureLoop(tempc, es, count);
+
+  return;
+}
+
+void dewPointBatch(const float* tempc, const float* rh, float* dewpoint,
+                   size_t count) {
+
+#if defined(__x86_64__)
+  if (psychrometric_avx2 == true) {
+    avx2_kernels::dewPointLoop(tempc, rh, dewpoint, count);
+    return;
+  }
+#endif
+  base_kernels::dewPointLoop(tempc, rh, dewpoint, count);
+
+  return;
+}
+
+void heatIndexBatch(const float* tempc, const float* rh, float* heat_index,
+                    size_t count) {
+
+#if defined(__x86_64__)
+  if (psychrometric_avx2 == true) {
+    avx2_kernels::heatIndexLoop(tempc, rh, heat_index, count);
+    return;
+  }
+#endif
+  base_kernels::heatIndexLoop(tempc, rh, heat_index, count);
+
+  return;
+}
+
+const char* psychrometricKernelName() {
+
+#if defined(__x86_64__)
+  if (psychrometric_avx2 == true) {
+    return "avx2";
+  }
+  return "sse2";
+#elif defined(__aarch64__)
+  return "neon";
+#else
+  return "generic";
+#endif
+}
+
+}  // namespace qw_utilities
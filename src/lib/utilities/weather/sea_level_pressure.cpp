@@ -0,0 +1,28 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "sea_level_pressure.h"
+
+using qw_units::Celsius;
+using qw_units::Millibar;
+
+namespace qw_utilities {
+
+Millibar seaLevelPressure(Millibar station, Celsius tempc,
+                          float altitude_meters) {
+
+  /*
+   * This is the formula used by most of the Zambretti implementations out
+   * there, see:
+   * https://en.wikipedia.org/wiki/Barometric_formula
+   */
+  float rise = lapse_rate * altitude_meters;
+  float ratio = 1 - (rise / (tempc.value() + rise + 273.15));
+
+  Millibar sea_level(station.value() * pow(ratio, -barometric_exponent));
+
+  return sea_level;
+}
+
+}  // namespace qw_utilities
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+#include "zambretti.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace qw_utilities {
+
+/*
+ * Indexed by the forecast number. 1-9 are for falling pressure, 10-19 for
+ * steady and 20-32 for rising.
+ */
+static const std::array<const char*, kZambrettiRisingLast + 1>
+    zambretti_forecasts = {
+        "",
+        "Settled fine",
+        "Fine weather",
+        "Fine, becoming less settled",
+        "Fairly fine, showery later",
+        "Showery, becoming more unsettled",
+        "Unsettled, rain later",
+        "Rain at times, worse later",
+        "Rain at times, becoming very unsettled",
+        "Very unsettled, rain",
+        "Settled fine",
+        "Fine weather",
+        "Fine, possibly showers",
+        "Fairly fine, showers likely",
+        "Showery, bright intervals",
+        "Changeable, some rain",
+        "Unsettled, rain at times",
+        "Rain at frequent intervals",
+        "Very unsettled, rain",
+        "Stormy, much rain",
+        "Settled fine",
+        "Fine weather",
+        "Becoming fine",
+        "Fairly fine, improving",
+        "Fairly fine, possibly showers early",
+        "Showery early, improving",
+        "Changeable, mending",
+        "Rather unsettled, clearing later",
+        "Unsettled, probably improving",
+        "Unsettled, short fine intervals",
+        "Very unsettled, finer at times",
+        "Stormy, possibly improving",
+        "Stormy, much rain",
+};
+
+ZambrettiForecast::ZambrettiForecast() {}
+
+void ZambrettiForecast::update(double sea_level, double change) {
+
+  double z;
+  int first;
+  int last;
+
+  if (change <= -kZambrettiTrendThreshold) {
+    z = 127 - (0.12 * sea_level);
+    first = kZambrettiFallingFirst;
+    last = kZambrettiFallingLast;
+  } else if (change >= kZambrettiTrendThreshold) {
+    z = 185 - (0.16 * sea_level);
+    first = kZambrettiRisingFirst;
+    last = kZambrettiRisingLast;
+  } else {
+    z = 144 - (0.13 * sea_level);
+    first = kZambrettiSteadyFirst;
+    last = kZambrettiSteadyLast;
+  }
+
+  /*
+   * Pressures outside the usual 950 - 1050 mb range would run off the end
+   * of the trend's part of the table, so pin them to the last entry.
+   */
+  number_ = std::clamp(static_cast<int>(round(z)), first, last);
+
+  return;
+}
+
+expected<int, int> ZambrettiForecast::number() {
+
+  if (number_ == 0) {
+    return unexpected(ENODATA);
+  }
+
+  return number_;
+}
+
+expected<string, int> ZambrettiForecast::forecast() {
+
+  if (number_ == 0) {
+    return unexpected(ENODATA);
+  }
+
+  return string(zambretti_forecasts[number_]);
+}
+
+void ZambrettiForecast::clear() {
+
+  number_ = 0;
+
+  return;
+}
+
+}  // namespace qw_utilities
@@ -19,18 +19,21 @@
 #include <expected>
 #include <list>
 #include <map>
-#include <regex>
+#include <memory>
 #include <string>
 #include <variant>
 #include <vector>
 
+#include "fixed_format.h"
+#include "wu_connection.h"
+#include "wu_field_schema.h"
+#include "wu_url_builder.h"
+
 using fmt::format;
 using std::expected;
 using std::find;
 using std::get;
 using std::map;
-using std::regex;
-using std::regex_match;
 using std::string;
 using std::unexpected;
 using std::variant;
@@ -52,29 +55,6 @@ enum FieldType {  // When we switch to WuFieldType below this will not be needed
   DATE
 };
 
-enum WuFieldType {
-  WU_FIELD_TYPE_NUMBER,
-  WU_FIELD_TYPE_STRING,
-  WU_FIELD_TYPE_SYSTEM_CLOCK_TIME_POINT,
-  WU_FIELD_TYPE_INVALID  // This should always be last and indicates an invalid type.
-                         // Be sure to add any new values above this
-                         // It is used in setVarData to indicate that an regex
-                         // was not matched
-};
-
-class WuFieldProperties {
- public:
-  WuFieldType type_;
-  string default_format_;
-
-  /*
-   * Define the different Consructors
-   */
-  WuFieldProperties() {}
-  WuFieldProperties(WuFieldType type, string default_format)
-      : type_(type), default_format_(default_format) {}
-};
-
 struct WuFieldData {
   /*
    * The order of the types in this variant must match the order of the values
@@ -84,28 +64,30 @@ struct WuFieldData {
    * to do that.
    */
   variant<float, string, system_clock::time_point>
-      data;         // The original value passed
-  string url_data;  // The URL escaped string
-};
-
-/*
- * A field that matches the regex expression has the indicated WuFieldType
- */
-class WuRegexTypeAssignment {
- public:
-  string expression;
-  WuFieldType type;
+      data;             // The original value passed
+  string url_data;      // The URL escaped string
+  bool present = false; // Set for this report
 };
 
 class WeatherUnderground {
  public:
   WeatherUnderground(string id, string password);
 
-  static size_t WriteCallback(void* contents, size_t size, size_t nmemb,
-                              void* userp);
+  /*
+   * Send over a connection that somebody else keeps, so it outlives this
+   * object. connection has to stay around as long as this does.
+   */
+  WeatherUnderground(string id, string password, WuConnection* connection);
+
+  /*
+   * Send to url instead of weather underground, a mock server for
+   * testing
+   */
+  void setUrl(string_view url);
 
   expected<bool, int> setVarData(
-      string field, variant<float, string, system_clock::time_point> value);
+      string_view field,
+      const variant<float, string, system_clock::time_point>& value);
 
   expected<bool, int> setData(string field, string value);
 
@@ -115,10 +97,40 @@ class WeatherUnderground {
 
   void reset();
 
-  string buildHttpRequest();
+  /*
+   * The request goes together in a buffer that is kept from one report to
+   * the next, what comes back is that buffer
+   */
+  const string& buildHttpRequest();
 
+  /*
+   * Send the report and wait for the answer
+   */
   expected<bool, int> sendData();
 
+  /*
+   * Start sending the report and come straight back. done gets called from
+   * the connection's process() when it has gone, or failed to. EBUSY if
+   * the last report is still going.
+   *
+   * done shouldn't use this object, it could be gone by then. It gets the
+   * response.
+   */
+  expected<bool, int> sendDataAsync(WuUploadCallback done);
+
+  /*
+   * The report's fields, URL escaped, without ID and PASSWORD. This is
+   * what gets kept in the upload queue.
+   */
+  expected<string, int> reportFields();
+
+  /*
+   * Send fields from reportFields(), maybe from an earlier report, with
+   * this station's ID and PASSWORD. Like sendDataAsync() otherwise.
+   */
+  expected<bool, int> sendFieldsAsync(string_view fields,
+                                      WuUploadCallback done);
+
   string getHttpResponse();
 
   void clearHttpResponse();
@@ -127,20 +139,42 @@ class WeatherUnderground {
 
   void clearHttpRequest();
 
+  /*
+   * Where the time went in the last sendData()
+   */
+  WuUploadTiming lastUploadTiming();
+
  private:
   string id_;
   string password_;
+  string url_id_;        // id_ URL escaped
+  string url_password_;  // password_ URL escaped
+  string url_ = wu_url;
   string* response_ = new string();
-  string http_get_request_;
+  WuUrlBuilder http_get_request_;
+  std::unique_ptr<WuConnection> own_connection_;
+  WuConnection* connection_;
 
-  map<string, WuFieldData> wu_data_;
+  /*
+   * One for each field weather underground knows, by wuFieldIndex(). The
+   * strings in here hang on to their memory when a report is done so the
+   * next one doesn't allocate.
+   */
+  std::array<WuFieldData, wu_field_count> wu_data_;
   map<string, string> wu_text_data_ = {};
   map<string, float> wu_number_data_ = {};
 
-  expected<bool, int> addData(
-      string field, variant<float, string, system_clock::time_point> value);
+  expected<bool, int> checkReport();
+
+  expected<bool, int> prepareRequest();
+
+  void startHttpRequest();
 
-  expected<WuFieldProperties, int> getFieldProperties(string field);
+  void addReportFields(WuUrlBuilder& builder);
+
+  expected<bool, int> addData(
+      size_t index,
+      const variant<float, string, system_clock::time_point>& value);
 };
 
 #endif  // SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WEATHER_UNDERGROUND_H
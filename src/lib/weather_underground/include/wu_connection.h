@@ -0,0 +1,177 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * A long lived curl handle for talking to weather underground.
+ *
+ * Setting up a new handle for every report means a DNS lookup, a TCP
+ * handshake and a full TLS handshake every time. curl keeps its DNS cache,
+ * its open connections and its TLS sessions in its handles, so keeping
+ * the handles around keeps all of those. If the server has closed the
+ * connection since the last report curl opens a new one, and the TLS
+ * session it saved makes that an abbreviated handshake.
+ *
+ * The connection doesn't know anything about the station so main can keep
+ * one across WeatherUnderground objects when the config gets reloaded.
+ *
+ * Uploads don't block. The easy handle runs in a curl multi handle, and
+ * the sockets curl wants watched and the time it next wants to be called
+ * are handed to whoever runs the poll() loop:
+ *
+ *   addPollFds(fds);
+ *   poll(fds, ..., min(my_timeout, connection.timeout()));
+ *   connection.process(fds);
+ *
+ * When an upload finishes, one way or the other, its callback gets called
+ * from process(). Every upload has a connect timeout and a total timeout
+ * so one that hangs gets given up on.
+ *
+ * The name lookup is the one thing that could still block. curl does it on
+ * a thread of its own when it was built with the threaded resolver, which
+ * is the default.
+ */
+
+#ifndef SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_CONNECTION_H_
+#define SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_CONNECTION_H_
+
+#include <curl/curl.h>
+#include <errno.h>
+#include <poll.h>
+#include <chrono>
+#include <expected>
+#include <functional>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+using std::expected;
+using std::map;
+using std::span;
+using std::string;
+using std::unexpected;
+using std::vector;
+using std::chrono::microseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+/*
+ * Reports are 5 minutes apart by default, so hang on to things a bit
+ * longer than that. curl checks a cached connection is still alive before
+ * it uses it.
+ */
+constexpr long wu_dns_cache_timeout = 900;   // seconds
+constexpr long wu_connection_max_age = 900;  // seconds
+constexpr long wu_tcp_keepalive_idle = 60;   // seconds
+
+/*
+ * How long an upload gets before it is given up on
+ */
+constexpr long wu_connect_timeout = 10000;   // milliseconds
+constexpr long wu_transfer_timeout = 30000;  // milliseconds, total
+
+/*
+ * Where the time of an upload went. Each one is from the start of the
+ * request, the way curl reports them, so connect includes namelookup and
+ * so on. appconnect is when the TLS handshake finished.
+ *
+ * The HTTP status and the Retry-After the server sent, if any, come along
+ * too. http_status is 0 if nothing came back.
+ */
+struct WuUploadTiming {
+  microseconds namelookup_{0};
+  microseconds connect_{0};
+  microseconds appconnect_{0};
+  microseconds total_{0};
+  long new_connections_ = 0;  // 0 when an open connection was reused
+  long http_status_ = 0;
+  seconds retry_after_{0};
+};
+
+/*
+ * Called when an upload is done. result is ETIMEDOUT if it ran out of
+ * time and ECOMM for anything else that went wrong. response is only good
+ * until the next upload starts.
+ */
+using WuUploadCallback =
+    std::function<void(expected<bool, int> result, const string& response,
+                       const WuUploadTiming& timing)>;
+
+class WuConnection {
+ public:
+  WuConnection();
+
+  ~WuConnection();
+
+  WuConnection(const WuConnection&) = delete;
+  WuConnection& operator=(const WuConnection&) = delete;
+
+  /*
+   * Start an HTTP GET. EBUSY if the last one hasn't finished.
+   */
+  expected<bool, int> startGet(const string& url, WuUploadCallback done);
+
+  /*
+   * Send an HTTP GET and append what comes back to response. This one
+   * waits for it.
+   */
+  expected<bool, int> get(const string& url, string& response);
+
+  /*
+   * true while an upload is going
+   */
+  bool busy();
+
+  /*
+   * Add the sockets curl wants watched to fds
+   */
+  void addPollFds(vector<pollfd>& fds);
+
+  /*
+   * Milliseconds until process() needs to be called even if none of the
+   * sockets do anything, -1 if there is nothing going on
+   */
+  int timeout();
+
+  /*
+   * Let curl handle whatever poll() found on its sockets, and whatever
+   * timer has run out. fds can have other fds in it, those are left alone.
+   */
+  void process(span<const pollfd> fds);
+
+  /*
+   * The timing of the last upload
+   */
+  WuUploadTiming lastTiming();
+
+ private:
+  CURL* curl_ = nullptr;
+  CURLM* multi_ = nullptr;
+  bool busy_ = false;
+  string response_;
+  WuUploadCallback done_;
+  WuUploadTiming last_timing_;
+
+  /*
+   * What curl has asked for, POLLIN and POLLOUT for each socket, and when
+   * it wants to hear about its timer
+   */
+  map<curl_socket_t, short> sockets_;
+  bool timer_set_ = false;
+  steady_clock::time_point timer_;
+
+  void socketAction(curl_socket_t socket, int events);
+
+  void finish();
+
+  static size_t WriteCallback(void* contents, size_t size, size_t nmemb,
+                              void* userp);
+
+  static int SocketCallback(CURL* easy, curl_socket_t socket, int what,
+                            void* userp, void* socketp);
+
+  static int TimerCallback(CURLM* multi, long timeout_ms, void* userp);
+};
+
+#endif  // SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_CONNECTION_H_
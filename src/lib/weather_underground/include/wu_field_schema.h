@@ -0,0 +1,102 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The fields weather underground recognizes, and the type and format of
+ * each.
+ *
+ * This used to be a list of regular expressions that got compiled and
+ * tried one after the other for every field of every report. Now the
+ * fixed names are in a table that is hashed at compile time, with a hash
+ * that has no collisions on the names, so a lookup is one hash and one
+ * string compare. The numbered families, tempNf and such, get a small
+ * matcher of their own.
+ *
+ * Every field also has an index, 0 to wu_field_count - 1, so whoever keeps
+ * data for the fields can keep it in an array instead of a map.
+ *
+ * See https://support.weather.com/s/article/PWS-Upload-Protocol?language=en_US
+ */
+
+#ifndef SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_FIELD_SCHEMA_H_
+#define SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_FIELD_SCHEMA_H_
+
+#include <errno.h>
+#include <fmt/format.h>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <string_view>
+
+using std::expected;
+using std::span;
+using std::string;
+using std::string_view;
+using std::unexpected;
+
+enum WuFieldType {
+  WU_FIELD_TYPE_NUMBER,
+  WU_FIELD_TYPE_STRING,
+  WU_FIELD_TYPE_SYSTEM_CLOCK_TIME_POINT,
+  WU_FIELD_TYPE_INVALID  // This should always be last and indicates an invalid type.
+                         // Be sure to add any new values above this
+                         // It is used in setVarData to indicate that a field
+                         // was not found
+};
+
+class WuFieldProperties {
+ public:
+  WuFieldType type_;
+  string default_format_;
+  int precision_ = -1;  // decimals for a number, -1 for anything else
+
+  /*
+   * Define the different Consructors
+   */
+  WuFieldProperties() {}
+  WuFieldProperties(WuFieldType type, string default_format)
+      : type_(type), default_format_(default_format) {}
+
+  /*
+   * Numbers are sent with a fixed number of decimals. They get formatted
+   * with qw_units::formatFixed(), default_format_ is just for show.
+   */
+  WuFieldProperties(WuFieldType type, int precision)
+      : type_(type), default_format_(fmt::format("{{0:.{}f}}", precision)),
+        precision_(precision) {}
+};
+
+/*
+ * The fixed names plus tempf, temp2f-temp9f and temp10f-temp99f
+ */
+constexpr size_t wu_fixed_field_count = 15;
+constexpr size_t wu_temperature_field_count = 99;
+constexpr size_t wu_field_count =
+    wu_fixed_field_count + wu_temperature_field_count;
+
+/*
+ * The properties of a field, or EINVAL if weather underground doesn't
+ * know it. What comes back is in a table that is always there.
+ */
+expected<const WuFieldProperties*, int> wuFieldProperties(string_view field);
+
+/*
+ * The index of a field, or EINVAL if weather underground doesn't know it
+ */
+expected<size_t, int> wuFieldIndex(string_view field);
+
+string_view wuFieldName(size_t index);
+
+const WuFieldProperties& wuFieldProperties(size_t index);
+
+/*
+ * All the field indexes, in the order of their names. URLs list the fields
+ * in this order, which is the order they came out of the std::map that
+ * used to hold them.
+ */
+span<const uint8_t> wuFieldUrlOrder();
+
+#endif  // SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_FIELD_SCHEMA_H_
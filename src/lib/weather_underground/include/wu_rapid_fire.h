@@ -0,0 +1,156 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Weather underground RapidFire updates.
+ *
+ * RapidFire is the real time feed, a report every few seconds to the
+ * rtupdate server with realtime=1&rtfreq=<seconds> on the end. At that
+ * rate there isn't time to check every field against the schema, escape
+ * everything and put the whole request together again each time.
+ *
+ * So the fields get checked once, when they are added. Everything that
+ * doesn't change from one update to the next, the server, ID, PASSWORD,
+ * action, dateutc=now, realtime and rtfreq, goes in a prefix that gets
+ * built once. Each field keeps the text of its last value and only gets
+ * formatted again when the value changes. An update is the prefix with
+ * the fields copied on the end, in a buffer that is never freed, so
+ * putting an update together doesn't allocate once it's running.
+ *
+ * Numbers come out of formatFixed() as digits, '-' and '.', none of which
+ * need escaping.
+ *
+ * The time from the start of a cycle, when the sensors get read, to the
+ * answer from the server is kept for every update. An update that takes
+ * longer than the interval is counted as late, and one that can't start
+ * because the last one is still going is counted as skipped. Stale real
+ * time data isn't worth sending late so those aren't retried.
+ */
+
+#ifndef SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_RAPID_FIRE_H_
+#define SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_RAPID_FIRE_H_
+
+#include <errno.h>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fixed_format.h"
+#include "wu_connection.h"
+#include "wu_url_builder.h"
+
+using std::expected;
+using std::string;
+using std::string_view;
+using std::unexpected;
+using std::vector;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+const string wu_rapid_fire_url =
+    "https://rtupdate.wunderground.com/weatherstation/"
+    "updateweatherstation.php";
+
+/*
+ * How the updates have been keeping up
+ */
+struct WuRapidFireStatistics {
+  uint64_t sent_ = 0;
+  uint64_t failed_ = 0;
+  uint64_t late_ = 0;     // took longer than the interval
+  uint64_t skipped_ = 0;  // the last one was still going
+  microseconds last_{0};
+  microseconds max_{0};
+  microseconds mean_{0};
+};
+
+class WuRapidFire {
+ public:
+  /*
+   * connection has to stay around as long as this does
+   */
+  WuRapidFire(WuConnection* connection);
+
+  /*
+   * Set up the station, how often updates go and where they go. The
+   * fields that were added are kept.
+   */
+  void setStation(string_view id, string_view password, milliseconds interval,
+                  string_view url = wu_rapid_fire_url);
+
+  /*
+   * Add a number field to the updates. What comes back is the slot to
+   * set it with. EINVAL if it isn't a number field weather underground
+   * knows.
+   */
+  expected<size_t, int> addField(string_view field);
+
+  /*
+   * The value of a field for the next update. The text only gets made
+   * again if the value is different from last time.
+   */
+  void setValue(size_t slot, float value);
+
+  /*
+   * Leave the field out of the next update, the sensor didn't have a
+   * reading
+   */
+  void clearValue(size_t slot);
+
+  /*
+   * Put the update together and start sending it. cycle_start is when
+   * the readings in it were taken, the latency is measured from there.
+   * EBUSY if the last update hasn't finished, that counts as skipped.
+   *
+   * done is called like it is for WuConnection::startGet(), after the
+   * statistics have been updated.
+   */
+  expected<bool, int> sendAsync(steady_clock::time_point cycle_start,
+                                WuUploadCallback done);
+
+  /*
+   * The last update that was put together
+   */
+  const string& url() const;
+
+  milliseconds interval() const;
+
+  WuRapidFireStatistics statistics() const;
+
+ private:
+  struct Slot {
+    string prefix_;  // &name=
+    char text_[qw_units::kFixedFormatBufferSize];
+    size_t length_ = 0;
+    int precision_ = 0;
+    float value_ = 0;
+    bool formatted_ = false;
+    bool present_ = false;
+  };
+
+  WuConnection* connection_;
+  milliseconds interval_{0};
+  vector<Slot> slots_;
+  WuUrlBuilder url_;
+  size_t prefix_length_ = 0;
+
+  /*
+   * The update that is going
+   */
+  steady_clock::time_point cycle_start_;
+  WuUploadCallback done_;
+
+  WuRapidFireStatistics statistics_;
+  microseconds total_latency_{0};
+
+  void buildUrl();
+
+  void recordLatency(bool success);
+};
+
+#endif  // SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_RAPID_FIRE_H_
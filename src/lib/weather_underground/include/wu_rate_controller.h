@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * How often to report, going by what weather underground has been saying.
+ *
+ * It works like TCP's congestion control, backwards since it keeps an
+ * interval instead of a rate. When the server says slow down, a 429 or a
+ * 5xx, the interval gets multiplied by backoff_factor, or made as long as
+ * the Retry-After if that's longer. Every success takes recovery_step off
+ * it until it's back to the configured report interval. So a server in
+ * trouble quickly gets fewer reports and they come back up slowly.
+ *
+ * A bad ID or PASSWORD isn't going to fix itself, so uploads stop until
+ * the config file changes and resume() gets called. Not being able to
+ * reach the server at all doesn't change the interval, the upload queue
+ * already waits before trying again and the reports still need taking. A
+ * request the server rejects doesn't either, it's the request that's bad.
+ */
+
+#ifndef SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_RATE_CONTROLLER_H_
+#define SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_RATE_CONTROLLER_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "wu_response.h"
+
+using std::array;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+constexpr milliseconds wu_rate_default_base_interval = milliseconds(300000);
+constexpr milliseconds wu_rate_default_max_interval = milliseconds(3600000);
+constexpr double wu_rate_default_backoff_factor = 2.0;
+constexpr milliseconds wu_rate_default_recovery_step = milliseconds(300000);
+
+struct WuRateControlConfig {
+  milliseconds base_interval_ = wu_rate_default_base_interval;
+  milliseconds max_interval_ = wu_rate_default_max_interval;
+  double backoff_factor_ = wu_rate_default_backoff_factor;
+  milliseconds recovery_step_ = wu_rate_default_recovery_step;
+};
+
+/*
+ * Everything there is to know about the controller, for the log and
+ * metrics
+ */
+struct WuRateControlState {
+  milliseconds interval_{0};
+  milliseconds base_interval_{0};
+  bool suspended_ = false;
+  WuResponseClass last_class_ = WU_RESPONSE_SUCCESS;
+  array<uint64_t, WU_RESPONSE_MAX> responses_{};  // by WuResponseClass
+  uint64_t backoffs_ = 0;
+  uint64_t suspensions_ = 0;
+};
+
+class WuRateController {
+ public:
+  WuRateController(WuRateControlConfig config);
+
+  /*
+   * The report interval from the config. The interval is kept where it
+   * is unless it would be shorter than this.
+   */
+  void setBaseInterval(milliseconds base_interval);
+
+  /*
+   * What the last upload got back. retry_after is what the server sent
+   * with it, 0 if nothing.
+   */
+  void record(WuResponseClass response_class, seconds retry_after);
+
+  /*
+   * How often to report right now
+   */
+  milliseconds interval() const;
+
+  /*
+   * true if the interval is longer than the configured one
+   */
+  bool backingOff() const;
+
+  /*
+   * true after the ID or PASSWORD was turned down, nothing should be sent
+   */
+  bool suspended() const;
+
+  /*
+   * The config file changed, try again
+   */
+  void resume();
+
+  WuRateControlState state() const;
+
+ private:
+  WuRateControlConfig config_;
+  WuRateControlState state_;
+};
+
+#endif  // SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_RATE_CONTROLLER_H_
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * What weather underground's answer to an upload means.
+ *
+ * A report that went is "success". A bad ID or password is
+ * "INVALIDPASSWORDID|Password or key and/or id are incorrect", with a 401
+ * these days. When it wants us to slow down it sends a 429, maybe with a
+ * Retry-After, and when it's having trouble a 5xx. Any other 4xx means
+ * there is something wrong with the request itself, sending it again
+ * won't help.
+ */
+
+#ifndef SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_RESPONSE_H_
+#define SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_RESPONSE_H_
+
+#include <expected>
+#include <string_view>
+
+using std::expected;
+using std::string_view;
+
+enum WuResponseClass {
+  WU_RESPONSE_SUCCESS,
+  WU_RESPONSE_AUTH_FAILED,   // ID or PASSWORD is wrong
+  WU_RESPONSE_THROTTLED,     // 429, slow down
+  WU_RESPONSE_SERVER_ERROR,  // 5xx, or a 200 that isn't success
+  WU_RESPONSE_REJECTED,      // any other 4xx, the request is bad
+  WU_RESPONSE_COMM_ERROR,    // nothing came back
+  WU_RESPONSE_MAX  // This should always be last, it is the number of classes
+};
+
+/*
+ * result and http_status are what the connection reported, body is what
+ * came back
+ */
+WuResponseClass wuClassifyResponse(const expected<bool, int>& result,
+                                   long http_status, string_view body);
+
+string_view wuResponseClassName(WuResponseClass response_class);
+
+#endif  // SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_RESPONSE_H_
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Reports waiting to go to weather underground.
+ *
+ * Every report goes in here with the time it was taken, and they go out
+ * oldest first. If an upload fails the report stays at the front and the
+ * next try waits, twice as long each time up to a limit. When the network
+ * comes back the backlog goes out one report every drain interval so we
+ * don't hammer the server.
+ *
+ * Each report is also a file in the queue directory, so whatever hasn't
+ * gone yet is still there after a restart. A file is written to a
+ * temporary name, synced and then renamed, so a crash leaves either the
+ * whole report or none of it. The file name is the report time so a
+ * directory listing sorts them oldest first.
+ *
+ * The queue is bounded. Past max_reports, or once a report is older than
+ * max_age, the oldest ones get dropped.
+ */
+
+#ifndef SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_UPLOAD_QUEUE_H_
+#define SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_UPLOAD_QUEUE_H_
+
+#include <errno.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+using std::deque;
+using std::expected;
+using std::string;
+using std::string_view;
+using std::unexpected;
+using std::chrono::hours;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+using std::chrono::system_clock;
+
+/*
+ * A week of reports at the default 5 minute interval
+ */
+constexpr size_t wu_queue_default_max_reports = 2016;
+constexpr hours wu_queue_default_max_age = hours(24 * 7);
+constexpr milliseconds wu_queue_default_drain_interval = milliseconds(5000);
+constexpr milliseconds wu_queue_default_retry_initial = milliseconds(30000);
+constexpr milliseconds wu_queue_default_retry_max = milliseconds(600000);
+
+struct WuUploadQueueConfig {
+  std::filesystem::path directory_;
+  size_t max_reports_ = wu_queue_default_max_reports;
+  system_clock::duration max_age_ = wu_queue_default_max_age;
+  milliseconds drain_interval_ = wu_queue_default_drain_interval;
+  milliseconds retry_initial_ = wu_queue_default_retry_initial;
+  milliseconds retry_max_ = wu_queue_default_retry_max;
+};
+
+/*
+ * One report. fields is the URL escaped &name=value list, everything but
+ * ID and PASSWORD.
+ */
+struct WuQueuedReport {
+  system_clock::time_point time_;
+  string file_name_;
+  string fields_;
+};
+
+class WuUploadQueue {
+ public:
+  WuUploadQueue(WuUploadQueueConfig config);
+
+  /*
+   * Make the directory if it isn't there and pick up whatever reports
+   * were left in it
+   */
+  expected<bool, int> open();
+
+  /*
+   * Add a report. If it can't be written to disk it is still queued, it
+   * just won't survive a restart, and the error comes back.
+   */
+  expected<bool, int> push(system_clock::time_point time, string_view fields);
+
+  /*
+   * The oldest report, if it's time to send it. ENODATA if there aren't
+   * any, EAGAIN if it's too soon.
+   */
+  expected<WuQueuedReport, int> next(steady_clock::time_point now);
+
+  /*
+   * Milliseconds until next() has something, -1 if the queue is empty
+   */
+  int timeout(steady_clock::time_point now);
+
+  /*
+   * report went, take it out
+   */
+  void sent(const WuQueuedReport& report, steady_clock::time_point now);
+
+  /*
+   * The last one didn't go, wait a while before trying again
+   */
+  void failed(steady_clock::time_point now);
+
+  /*
+   * The server won't ever take report, it's counted as dropped
+   */
+  void discard(const WuQueuedReport& report, steady_clock::time_point now);
+
+  size_t depth();
+
+  /*
+   * How old the oldest report is, ENODATA if there aren't any
+   */
+  expected<system_clock::duration, int> oldestAge(system_clock::time_point now);
+
+  uint64_t sentCount();
+
+  uint64_t failedCount();
+
+  uint64_t droppedCount();
+
+ private:
+  WuUploadQueueConfig config_;
+  deque<WuQueuedReport> reports_;
+  uint32_t sequence_ = 0;
+
+  steady_clock::time_point next_send_;
+  int failures_ = 0;
+
+  uint64_t sent_count_ = 0;
+  uint64_t failed_count_ = 0;
+  uint64_t dropped_count_ = 0;
+
+  void enforceBounds(system_clock::time_point now);
+
+  void dropOldest();
+
+  expected<bool, int> writeReport(const WuQueuedReport& report);
+
+  void removeReport(const WuQueuedReport& report);
+};
+
+#endif  // SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_UPLOAD_QUEUE_H_
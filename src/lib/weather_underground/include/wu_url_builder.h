@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Puts a weather underground request URL together in one buffer.
+ *
+ * The buffer is a string that only ever gets cleared, never freed, so once
+ * it has grown to the size of a report nothing allocates. Values are
+ * percent encoded with a table, the same characters curl_easy_escape()
+ * leaves alone are left alone and everything else becomes %XX.
+ */
+
+#ifndef SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_URL_BUILDER_H_
+#define SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_URL_BUILDER_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+/*
+ * Room for a report with every field the station sends
+ */
+constexpr size_t wu_url_default_capacity = 1024;
+
+class WuUrlBuilder {
+ public:
+  WuUrlBuilder(size_t capacity = wu_url_default_capacity);
+
+  /*
+   * Throw away what was there and start over with base_url?
+   */
+  void start(string_view base_url);
+
+  /*
+   * &name=escaped_value, the value has to be escaped already
+   */
+  void addEscapedField(string_view name, string_view escaped_value);
+
+  /*
+   * Fields that have been put together already, &name=value&...
+   */
+  void addEscapedFields(string_view escaped_fields);
+
+  /*
+   * &name=value, escaping value on the way in
+   */
+  void addField(string_view name, string_view value);
+
+  /*
+   * &name=value with precision decimals, formatted with formatFixed()
+   */
+  void addNumber(string_view name, float value, int precision);
+
+  const string& url() const;
+
+  size_t size() const;
+
+  /*
+   * Cut the URL back to its first length characters, to put different
+   * fields on the end of the same start
+   */
+  void truncate(size_t length);
+
+  void clear();
+
+  /*
+   * Percent encode value onto the end of out
+   */
+  static void appendEscaped(string& out, string_view value);
+
+ private:
+  string url_;
+};
+
+#endif  // SRC_LIB_WEATHER_UNDERGROUND_INCLUDE_WU_URL_BUILDER_H_
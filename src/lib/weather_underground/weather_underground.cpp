@@ -7,22 +7,6 @@
  */
 #include "include/weather_underground.h"
 
-/*
- * Any filed that matches the pattern of the key has the associated properties
- */
-const map<string, WuFieldProperties> wu_field_regex_list = {
-    {"^ID$", WuFieldProperties(WU_FIELD_TYPE_STRING, "{}")},
-    {"^PASSWORD$", WuFieldProperties(WU_FIELD_TYPE_STRING, "{}")},
-    {"^dateutc$", WuFieldProperties(WU_FIELD_TYPE_SYSTEM_CLOCK_TIME_POINT,
-                                    "{:%Y-%m-%d %H:%M:%S}")},
-    {"^action$", WuFieldProperties(WU_FIELD_TYPE_STRING, "{}")},
-    {"^baromin$", WuFieldProperties(WU_FIELD_TYPE_NUMBER, "{0:.2f}")},
-    {"^humidity$", WuFieldProperties(WU_FIELD_TYPE_NUMBER, "{0:.2f}")},
-    {"^temp[2-9]?f$|^temp[1-9][0-9]f$",
-     WuFieldProperties(WU_FIELD_TYPE_NUMBER,
-                       "{0:.2f}")},  // This supports tempf, temp2-99f
-    {"^dewptf$", WuFieldProperties(WU_FIELD_TYPE_NUMBER, "{0:.2f}")}};
-
 map<string, FieldType> wu_fields = {
     {"ID", TEXT},
     {"PASSWORD", TEXT},
@@ -85,16 +69,42 @@ map<string, FieldType> wu_fields = {
     {"softwaretype", TEXT}  // [text] ie: WeatherLink, VWS, WeatherDisplay
 };
 
+/*
+ * The fields sendData() looks for
+ */
+const size_t wu_action_index = wuFieldIndex("action").value();
+const size_t wu_dateutc_index = wuFieldIndex("dateutc").value();
+
 WeatherUnderground::WeatherUnderground(string id, string password)
-    : id_(id), password_(password) {}
+    : WeatherUnderground(id, password, nullptr) {}
 
-size_t WeatherUnderground::WriteCallback(void* contents, size_t size,
-                                         size_t nmemb, void* userp) {
-  ((std::string*)userp)->append((char*)contents, size * nmemb);
-  return size * nmemb;
+WeatherUnderground::WeatherUnderground(string id, string password,
+                                       WuConnection* connection)
+    : id_(id), password_(password), connection_(connection) {
+
+  if (connection_ == nullptr) {
+    own_connection_ = std::make_unique<WuConnection>();
+    connection_ = own_connection_.get();
+  }
+
+  /*
+   * These go in every request, escape them once
+   */
+  WuUrlBuilder::appendEscaped(url_id_, id_);
+  WuUrlBuilder::appendEscaped(url_password_, password_);
 }
 
-expected<bool, int> WeatherUnderground::sendData() {
+void WeatherUnderground::setUrl(string_view url) {
+
+  url_ = url;
+
+  return;
+}
+
+/*
+ * Check there is a report to send
+ */
+expected<bool, int> WeatherUnderground::checkReport() {
 
   /*
    * We need to check that ID and PASSWORD are NOT in the map
@@ -104,58 +114,93 @@ expected<bool, int> WeatherUnderground::sendData() {
   }
 
   /*
-   * We have to make sure that these values exist in the map
+   * We have to make sure that these values were set
    */
-  if ((wu_data_.contains("action") == false) ||
-      (wu_data_["action"].data.index() != WU_FIELD_TYPE_STRING) ||
-      (get<string>(wu_data_["action"].data) != "updateraw") ||
-      (wu_data_.contains("dateutc") == false)) {
+  const WuFieldData& action = wu_data_[wu_action_index];
+  if ((action.present == false) ||
+      (action.data.index() != WU_FIELD_TYPE_STRING) ||
+      (get<string>(action.data) != "updateraw") ||
+      (wu_data_[wu_dateutc_index].present == false)) {
     return unexpected(EINVAL);
   }
 
-  http_get_request_ = buildHttpRequest();
+  return true;
+}
 
-  /*
-   * Now use curl to send the HTTP GET request
-   */
-  CURL* curl = curl_easy_init();
-  CURLcode res;
+/*
+ * Check there is a report to send and put the request together
+ */
+expected<bool, int> WeatherUnderground::prepareRequest() {
 
-  /*
-   * Set the URL options
-   */
-  curl_easy_setopt(curl, CURLOPT_URL, http_get_request_.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
-                   WeatherUnderground::WriteCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, response_);
+  auto x_checked = checkReport();
+  if (x_checked.has_value() == false) {
+    return unexpected(x_checked.error());
+  }
+
+  buildHttpRequest();
+
+  return true;
+}
+
+expected<bool, int> WeatherUnderground::sendData() {
+
+  auto x_prepared = prepareRequest();
+  if (x_prepared.has_value() == false) {
+    return unexpected(x_prepared.error());
+  }
 
   /*
-   * Send the GET request
+   * Now send the HTTP GET request, over the connection from last time if
+   * it's still open
    */
-  res = curl_easy_perform(curl);
+  return connection_->get(http_get_request_.url(), *response_);
+}
 
-  curl_easy_cleanup(curl);
+expected<bool, int> WeatherUnderground::sendDataAsync(WuUploadCallback done) {
 
-  if (res != CURLE_OK) {
-    /*
-     * May want to return different values for different return errors
-     */
-    return unexpected(ECOMM);
+  auto x_prepared = prepareRequest();
+  if (x_prepared.has_value() == false) {
+    return unexpected(x_prepared.error());
   }
 
-  return true;
+  return connection_->startGet(http_get_request_.url(), std::move(done));
+}
+
+expected<string, int> WeatherUnderground::reportFields() {
+
+  auto x_checked = checkReport();
+  if (x_checked.has_value() == false) {
+    return unexpected(x_checked.error());
+  }
+
+  WuUrlBuilder fields;
+  addReportFields(fields);
+
+  return fields.url();
+}
+
+expected<bool, int> WeatherUnderground::sendFieldsAsync(string_view fields,
+                                                        WuUploadCallback done) {
+
+  startHttpRequest();
+  http_get_request_.addEscapedFields(fields);
+
+  return connection_->startGet(http_get_request_.url(), std::move(done));
 }
 
 expected<bool, int> WeatherUnderground::setVarData(
-    string field, variant<float, string, system_clock::time_point> value) {
+    string_view field,
+    const variant<float, string, system_clock::time_point>& value) {
 
   /*
-   * Sanity check by walking through the regex list to make sure it is a valid field
+   * Sanity check against the field schema to make sure it is a valid field
    */
-  expected<WuFieldProperties, int> field_properties = getFieldProperties(field);
-  if (field_properties.has_value() == false) {
-    return unexpected(field_properties.error());
+  expected<size_t, int> field_index = wuFieldIndex(field);
+  if (field_index.has_value() == false) {
+    return unexpected(field_index.error());
   }
+  const WuFieldProperties& field_properties =
+      wuFieldProperties(field_index.value());
 
   /*
    * We only get ID and PASSWORD from id_ and password_ when class is created.
@@ -190,7 +235,7 @@ expected<bool, int> WeatherUnderground::setVarData(
     /*
      * Make sure all the other fields are passing the correct type
      */
-    if (field_properties.value().type_ != value.index()) {
+    if (field_properties.type_ != value.index()) {
       return unexpected(EINVAL);
     }
   }
@@ -198,46 +243,48 @@ expected<bool, int> WeatherUnderground::setVarData(
   /*
    * It's OK to add the field and it's value
    */
-  addData(field, value);
+  addData(field_index.value(), value);
 
   return true;
 }
 
 expected<bool, int> WeatherUnderground::addData(
-    string field, variant<float, string, system_clock::time_point> value) {
+    size_t index,
+    const variant<float, string, system_clock::time_point>& value) {
   /*
    * This is a private routine. The public routine setData does all the sanity checking
-   * And then calls this routine to actually add the field data to the map.
+   * And then calls this routine to actually add the field data to the array.
    * We assume that field and value a valid when we get here.
-   * This allows us to add ID and PASSWORD when we send the data.
    */
 
   /*
-   * Create the field's data and set the value to what was passed in
+   * The field's data is filled in where it is, so its strings reuse the
+   * memory they had from the last report
    */
-  WuFieldData field_data;
+  WuFieldData& field_data = wu_data_[index];
   field_data.data = value;
+  field_data.url_data.clear();
+  field_data.present = true;
 
   /*
    * Get the field's properties in order to get the default format
    */
-  expected<WuFieldProperties, int> field_properties = getFieldProperties(field);
-  if (field_properties.has_value() == false) {
-    return unexpected(field_properties.error());
-  }
+  const WuFieldProperties& field_properties = wuFieldProperties(index);
 
   /*
-   * Get the data string to be converted to escaped URL
-   * Define data_string before switch so it won't go out of scope.
-   * You need to use fmt::runtime() to use a variable for the
-   * format string.
+   * Format the value and escape it straight into url_data. The numbers and
+   * times are formatted into a buffer on the stack. You need to use
+   * fmt::runtime() to use a variable for the format string.
    */
-  string data_string;
+  char buffer[qw_units::kFixedFormatBufferSize];
+  size_t length = 0;
   switch (value.index()) {
     case WU_FIELD_TYPE_NUMBER:
-      data_string =
-          format(fmt::runtime(field_properties.value().default_format_),
-                 get<float>(value));
+      /*
+       * No format string to parse for a number
+       */
+      length = qw_units::formatFixed(buffer, sizeof(buffer), get<float>(value),
+                                     field_properties.precision_);
       break;
     case WU_FIELD_TYPE_STRING:
       /*
@@ -245,52 +292,38 @@ expected<bool, int> WeatherUnderground::addData(
        * Probably not the best place to sort that out but it
        * seems to be the simplist place to put it.
        * If dateutc is a string then don't use the default
-       * format for it.
+       * format for it. "{}" is the string as it is.
        */
-      if (field == "dateutc") {
-        data_string = format("{}", get<string>(value));
+      if ((index == wu_dateutc_index) ||
+          (field_properties.default_format_ == "{}")) {
+        WuUrlBuilder::appendEscaped(field_data.url_data, get<string>(value));
       } else {
-        data_string =
-            format(fmt::runtime(field_properties.value().default_format_),
-                   get<string>(value));
+        WuUrlBuilder::appendEscaped(
+            field_data.url_data,
+            format(fmt::runtime(field_properties.default_format_),
+                   get<string>(value)));
       }
-      break;
+      return true;
     case WU_FIELD_TYPE_SYSTEM_CLOCK_TIME_POINT:
-      data_string =
-          format(fmt::runtime(field_properties.value().default_format_),
-                 get<system_clock::time_point>(value));
+      /*
+       * fmt formats a time_point in local time, dateutc has to be UTC
+       */
+      length = fmt::format_to_n(
+                   buffer, sizeof(buffer),
+                   fmt::runtime(field_properties.default_format_),
+                   fmt::gmtime(system_clock::to_time_t(
+                       get<system_clock::time_point>(value))))
+                   .size;
       break;
   }
 
-  /*
-   * Now escape the string and store it in the url_data field
-   */
-  CURL* curl = curl_easy_init();
-  field_data.url_data =
-      string(curl_easy_escape(curl, data_string.c_str(), data_string.length()));
-  curl_easy_cleanup(curl);
-
-  /*
-   * Now store the field data into the wu_data_ array
-   */
-  wu_data_[field] = field_data;
+  WuUrlBuilder::appendEscaped(field_data.url_data,
+                              string_view(buffer, std::min(length,
+                                                           sizeof(buffer))));
 
   return true;
 }
 
-expected<WuFieldProperties, int> WeatherUnderground::getFieldProperties(
-    string field) {
-
-  for (auto [rgx, properties] : wu_field_regex_list) {
-    if (std::regex_match(field, regex(rgx)) == true) {
-      return properties;
-      break;
-    }
-  }
-
-  return unexpected(EINVAL);
-}
-
 expected<bool, int> WeatherUnderground::setData(string field, string value) {
   int n;
   /*
@@ -370,7 +403,9 @@ expected<bool, int> WeatherUnderground::setData(string field,
 
 void WeatherUnderground::reset() {
 
-  wu_data_.clear();
+  for (WuFieldData& field_data : wu_data_) {
+    field_data.present = false;
+  }
   wu_number_data_.clear();
   wu_text_data_.clear();
   clearHttpResponse();
@@ -379,33 +414,43 @@ void WeatherUnderground::reset() {
   return;
 }
 
-string WeatherUnderground::buildHttpRequest() {
-  string url_get_string;
+const string& WeatherUnderground::buildHttpRequest() {
 
-  /*
-   * Add the ID and PASSWORD
-   */
-  addData("ID", id_);
-  addData("PASSWORD", password_);
+  startHttpRequest();
+  addReportFields(http_get_request_);
 
-  /*
-   * Now walk through the url data map and create the urk escaped get string.
-   */
-  for (auto [field, value] : wu_data_) {
-    url_get_string += format("&{}={}", field, value.url_data);
-  }
+  return http_get_request_.url();
+}
 
-  /*
-   * Put the URL pieces together
-   */
-  string url_http_string = wu_url + "?" + url_get_string;
+/*
+ * ID and PASSWORD first, then the fields in the order of their names.
+ * That's the order they have always come out in. The fields were kept
+ * in a std::map and ID and PASSWORD sort ahead of the lower case names.
+ */
+void WeatherUnderground::startHttpRequest() {
+
+  http_get_request_.start(url_);
+  http_get_request_.addEscapedField("ID", url_id_);
+  http_get_request_.addEscapedField("PASSWORD", url_password_);
 
-  return url_http_string;
+  return;
+}
+
+void WeatherUnderground::addReportFields(WuUrlBuilder& builder) {
+
+  for (uint8_t index : wuFieldUrlOrder()) {
+    const WuFieldData& field_data = wu_data_[index];
+    if (field_data.present == true) {
+      builder.addEscapedField(wuFieldName(index), field_data.url_data);
+    }
+  }
+
+  return;
 }
 
 string WeatherUnderground::getHttpRequest() {
 
-  return http_get_request_;
+  return http_get_request_.url();
 }
 
 void WeatherUnderground::clearHttpRequest() {
@@ -425,3 +470,8 @@ void WeatherUnderground::clearHttpResponse() {
 
   return;
 }
+
+WuUploadTiming WeatherUnderground::lastUploadTiming() {
+
+  return connection_->lastTiming();
+}
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The curl handle that stays open between weather underground reports
+ */
+#include "include/wu_connection.h"
+
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+
+WuConnection::WuConnection() {
+
+  curl_ = curl_easy_init();
+  multi_ = curl_multi_init();
+  if ((curl_ == nullptr) || (multi_ == nullptr)) {
+    return;
+  }
+
+  /*
+   * These stay the same for every request, only the URL changes.
+   * NOSIGNAL so the timeouts don't use SIGALRM.
+   */
+  curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, WuConnection::WriteCallback);
+  curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response_);
+  curl_easy_setopt(curl_, CURLOPT_DNS_CACHE_TIMEOUT, wu_dns_cache_timeout);
+  curl_easy_setopt(curl_, CURLOPT_MAXAGE_CONN, wu_connection_max_age);
+  curl_easy_setopt(curl_, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(curl_, CURLOPT_TCP_KEEPIDLE, wu_tcp_keepalive_idle);
+  curl_easy_setopt(curl_, CURLOPT_TCP_KEEPINTVL, wu_tcp_keepalive_idle);
+  curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, wu_connect_timeout);
+  curl_easy_setopt(curl_, CURLOPT_TIMEOUT_MS, wu_transfer_timeout);
+  curl_easy_setopt(curl_, CURLOPT_NOSIGNAL, 1L);
+
+  curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION,
+                    WuConnection::SocketCallback);
+  curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, this);
+  curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION,
+                    WuConnection::TimerCallback);
+  curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, this);
+
+  return;
+}
+
+WuConnection::~WuConnection() {
+
+  /*
+   * An upload that is still going is dropped, its callback never gets
+   * called
+   */
+  if (busy_ == true) {
+    curl_multi_remove_handle(multi_, curl_);
+  }
+  if (curl_ != nullptr) {
+    curl_easy_cleanup(curl_);
+  }
+  if (multi_ != nullptr) {
+    curl_multi_cleanup(multi_);
+  }
+
+  return;
+}
+
+size_t WuConnection::WriteCallback(void* contents, size_t size, size_t nmemb,
+                                   void* userp) {
+
+  static_cast<string*>(userp)->append(static_cast<char*>(contents),
+                                      size * nmemb);
+
+  return size * nmemb;
+}
+
+int WuConnection::SocketCallback(CURL* /*easy*/, curl_socket_t socket,
+                                 int what, void* userp, void* /*socketp*/) {
+  WuConnection* connection = static_cast<WuConnection*>(userp);
+
+  switch (what) {
+    case CURL_POLL_IN:
+      connection->sockets_[socket] = POLLIN;
+      break;
+    case CURL_POLL_OUT:
+      connection->sockets_[socket] = POLLOUT;
+      break;
+    case CURL_POLL_INOUT:
+      connection->sockets_[socket] = POLLIN | POLLOUT;
+      break;
+    case CURL_POLL_REMOVE:
+      connection->sockets_.erase(socket);
+      break;
+  }
+
+  return 0;
+}
+
+int WuConnection::TimerCallback(CURLM* /*multi*/, long timeout_ms,
+                                void* userp) {
+  WuConnection* connection = static_cast<WuConnection*>(userp);
+
+  if (timeout_ms < 0) {
+    connection->timer_set_ = false;
+  } else {
+    connection->timer_set_ = true;
+    connection->timer_ = steady_clock::now() + milliseconds(timeout_ms);
+  }
+
+  return 0;
+}
+
+expected<bool, int> WuConnection::startGet(const string& url,
+                                           WuUploadCallback done) {
+
+  if ((curl_ == nullptr) || (multi_ == nullptr)) {
+    return unexpected(ENOMEM);
+  }
+  if (busy_ == true) {
+    return unexpected(EBUSY);
+  }
+
+  /*
+   * curl keeps its own copy of the URL
+   */
+  response_.clear();
+  curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
+  if (curl_multi_add_handle(multi_, curl_) != CURLM_OK) {
+    return unexpected(ECOMM);
+  }
+  busy_ = true;
+  done_ = std::move(done);
+
+  return true;
+}
+
+expected<bool, int> WuConnection::get(const string& url, string& response) {
+  expected<bool, int> result = unexpected(ECOMM);
+  bool finished = false;
+
+  auto x_started = startGet(
+      url, [&](expected<bool, int> upload_result, const string& upload_response,
+               const WuUploadTiming& /*timing*/) {
+        result = upload_result;
+        response.append(upload_response);
+        finished = true;
+      });
+  if (x_started.has_value() == false) {
+    return unexpected(x_started.error());
+  }
+
+  /*
+   * The transfer timeout makes sure this ends
+   */
+  vector<pollfd> fds;
+  while (finished == false) {
+    fds.clear();
+    addPollFds(fds);
+    poll(fds.data(), fds.size(), timeout());
+    process(fds);
+  }
+
+  return result;
+}
+
+bool WuConnection::busy() {
+
+  return busy_;
+}
+
+void WuConnection::addPollFds(vector<pollfd>& fds) {
+
+  for (auto [socket, events] : sockets_) {
+    fds.push_back(pollfd{socket, events, 0});
+  }
+
+  return;
+}
+
+int WuConnection::timeout() {
+
+  if (timer_set_ == false) {
+    return -1;
+  }
+
+  auto remaining = duration_cast<milliseconds>(timer_ - steady_clock::now());
+  if (remaining.count() <= 0) {
+    return 0;
+  }
+
+  /*
+   * Round up, waking up a hair early just means waking up again
+   */
+  return static_cast<int>(remaining.count()) + 1;
+}
+
+void WuConnection::process(span<const pollfd> fds) {
+
+  if (multi_ == nullptr) {
+    return;
+  }
+
+  for (const pollfd& fd : fds) {
+    if ((fd.revents == 0) || (sockets_.contains(fd.fd) == false)) {
+      continue;
+    }
+    int events = 0;
+    if ((fd.revents & POLLIN) != 0) {
+      events |= CURL_CSELECT_IN;
+    }
+    if ((fd.revents & POLLOUT) != 0) {
+      events |= CURL_CSELECT_OUT;
+    }
+    if ((fd.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0) {
+      events |= CURL_CSELECT_ERR;
+    }
+    socketAction(fd.fd, events);
+  }
+
+  if ((timer_set_ == true) && (steady_clock::now() >= timer_)) {
+    timer_set_ = false;
+    socketAction(CURL_SOCKET_TIMEOUT, 0);
+  }
+
+  finish();
+
+  return;
+}
+
+void WuConnection::socketAction(curl_socket_t socket, int events) {
+  int running = 0;
+
+  curl_multi_socket_action(multi_, socket, events, &running);
+
+  return;
+}
+
+/*
+ * If the upload is done take it out of the multi handle and let whoever
+ * started it know
+ */
+void WuConnection::finish() {
+  CURLMsg* message;
+  int queued = 0;
+
+  while ((message = curl_multi_info_read(multi_, &queued)) != nullptr) {
+    if ((message->msg != CURLMSG_DONE) || (message->easy_handle != curl_)) {
+      continue;
+    }
+    CURLcode res = message->data.result;
+    curl_multi_remove_handle(multi_, curl_);
+    busy_ = false;
+
+    /*
+     * Get the timing even if it failed, it shows how far it got
+     */
+    curl_off_t namelookup = 0;
+    curl_off_t connect = 0;
+    curl_off_t appconnect = 0;
+    curl_off_t total = 0;
+    long new_connections = 0;
+    long http_status = 0;
+    curl_off_t retry_after = 0;
+    curl_easy_getinfo(curl_, CURLINFO_NAMELOOKUP_TIME_T, &namelookup);
+    curl_easy_getinfo(curl_, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl_, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+    curl_easy_getinfo(curl_, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(curl_, CURLINFO_NUM_CONNECTS, &new_connections);
+    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &http_status);
+    curl_easy_getinfo(curl_, CURLINFO_RETRY_AFTER, &retry_after);
+    last_timing_.namelookup_ = microseconds(namelookup);
+    last_timing_.connect_ = microseconds(connect);
+    last_timing_.appconnect_ = microseconds(appconnect);
+    last_timing_.total_ = microseconds(total);
+    last_timing_.new_connections_ = new_connections;
+    last_timing_.http_status_ = http_status;
+    last_timing_.retry_after_ = seconds(retry_after);
+
+    expected<bool, int> result = true;
+    if (res == CURLE_OPERATION_TIMEDOUT) {
+      result = unexpected(ETIMEDOUT);
+    } else if (res != CURLE_OK) {
+      /*
+       * May want to return different values for different return errors
+       */
+      result = unexpected(ECOMM);
+    }
+
+    /*
+     * The callback is moved out first so it can start the next upload
+     */
+    WuUploadCallback done = std::move(done_);
+    done_ = nullptr;
+    if (done) {
+      done(result, response_, last_timing_);
+    }
+  }
+
+  return;
+}
+
+WuUploadTiming WuConnection::lastTiming() {
+
+  return last_timing_;
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The weather underground field table and the lookup into it
+ */
+#include "include/wu_field_schema.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+/*
+ * The different sets of properties a field can have. Every field points
+ * at one of these.
+ */
+enum WuFieldKind {
+  WU_FIELD_KIND_TEXT,
+  WU_FIELD_KIND_TIME,
+  WU_FIELD_KIND_NUMBER_0,
+  WU_FIELD_KIND_NUMBER_1,
+  WU_FIELD_KIND_NUMBER_2,
+  WU_FIELD_KIND_MAX
+};
+
+const WuFieldProperties wu_field_kinds[WU_FIELD_KIND_MAX] = {
+    WuFieldProperties(WU_FIELD_TYPE_STRING, "{}"),
+    WuFieldProperties(WU_FIELD_TYPE_SYSTEM_CLOCK_TIME_POINT,
+                      "{:%Y-%m-%d %H:%M:%S}"),
+    WuFieldProperties(WU_FIELD_TYPE_NUMBER, 0),
+    WuFieldProperties(WU_FIELD_TYPE_NUMBER, 1),
+    WuFieldProperties(WU_FIELD_TYPE_NUMBER, 2)};
+
+struct WuFixedField {
+  string_view name;
+  WuFieldKind kind;
+};
+
+constexpr WuFixedField wu_fixed_fields[] = {
+    {"ID", WU_FIELD_KIND_TEXT},
+    {"PASSWORD", WU_FIELD_KIND_TEXT},
+    {"dateutc", WU_FIELD_KIND_TIME},
+    {"action", WU_FIELD_KIND_TEXT},
+    {"baromin", WU_FIELD_KIND_NUMBER_2},
+    {"humidity", WU_FIELD_KIND_NUMBER_2},
+    {"dewptf", WU_FIELD_KIND_NUMBER_2},
+    {"winddir", WU_FIELD_KIND_NUMBER_0},
+    {"windgustdir", WU_FIELD_KIND_NUMBER_0},
+    {"winddir_avg2m", WU_FIELD_KIND_NUMBER_0},
+    {"windgustdir_10m", WU_FIELD_KIND_NUMBER_0},
+    {"windspeedmph", WU_FIELD_KIND_NUMBER_1},
+    {"windgustmph", WU_FIELD_KIND_NUMBER_1},
+    {"windspdmph_avg2m", WU_FIELD_KIND_NUMBER_1},
+    {"windgustmph_10m", WU_FIELD_KIND_NUMBER_1}};
+
+static_assert(std::size(wu_fixed_fields) == wu_fixed_field_count);
+
+/*
+ * A power of two at least twice the number of names so a seed that
+ * spreads them all out turns up quickly
+ */
+constexpr uint32_t wu_field_slot_count = 32;
+static_assert(std::has_single_bit(wu_field_slot_count) &&
+              (wu_field_slot_count >= (2 * wu_fixed_field_count)));
+
+/*
+ * FNV-1a, with the seed mixed into the starting value
+ */
+static constexpr uint32_t wuFieldHash(string_view name, uint32_t seed) {
+  uint32_t hash = 2166136261u ^ seed;
+
+  for (char c : name) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+/*
+ * The top bits, the low bits of an FNV hash only depend on the low bits of
+ * what went into it
+ */
+static constexpr uint32_t wuFieldSlot(string_view name, uint32_t seed) {
+
+  return wuFieldHash(name, seed) >>
+         (32 - std::countr_zero(wu_field_slot_count));
+}
+
+/*
+ * Try seeds until every fixed name lands in a slot of its own. This all
+ * happens while compiling.
+ */
+constexpr uint32_t wu_field_seed_limit = 10000;
+
+static constexpr uint32_t findWuFieldSeed() {
+
+  for (uint32_t seed = 0; seed < wu_field_seed_limit; seed++) {
+    bool used[wu_field_slot_count] = {};
+    bool collision = false;
+    for (const WuFixedField& field : wu_fixed_fields) {
+      uint32_t slot = wuFieldSlot(field.name, seed);
+      if (used[slot] == true) {
+        collision = true;
+        break;
+      }
+      used[slot] = true;
+    }
+    if (collision == false) {
+      return seed;
+    }
+  }
+
+  return wu_field_seed_limit;
+}
+
+constexpr uint32_t wu_field_seed = findWuFieldSeed();
+static_assert(wu_field_seed < wu_field_seed_limit,
+              "No perfect hash seed for the weather underground fields");
+
+/*
+ * Slot to index in wu_fixed_fields, -1 for an empty slot
+ */
+static constexpr std::array<int8_t, wu_field_slot_count> makeWuFieldSlots() {
+  std::array<int8_t, wu_field_slot_count> slots;
+
+  slots.fill(-1);
+  for (size_t i = 0; i < wu_fixed_field_count; i++) {
+    slots[wuFieldSlot(wu_fixed_fields[i].name, wu_field_seed)] =
+        static_cast<int8_t>(i);
+  }
+
+  return slots;
+}
+
+constexpr std::array<int8_t, wu_field_slot_count> wu_field_slots =
+    makeWuFieldSlots();
+
+/*
+ * tempf, temp2f through temp9f and temp10f through temp99f. There is no
+ * temp1f, tempf is the first one, so the number less one is where it goes
+ * among the temperatures. -1 for anything else.
+ */
+static constexpr int wuTemperatureField(string_view field) {
+
+  if ((field.starts_with("temp") == false) || (field.ends_with("f") == false)) {
+    return -1;
+  }
+
+  string_view number = field.substr(4, field.size() - 5);
+  switch (number.size()) {
+    case 0:
+      return 0;
+    case 1:
+      if ((number[0] >= '2') && (number[0] <= '9')) {
+        return number[0] - '1';
+      }
+      break;
+    case 2:
+      if ((number[0] >= '1') && (number[0] <= '9') && (number[1] >= '0') &&
+          (number[1] <= '9')) {
+        return ((number[0] - '0') * 10) + (number[1] - '0') - 1;
+      }
+      break;
+  }
+
+  return -1;
+}
+
+static_assert(wuTemperatureField("tempf") == 0);
+static_assert(wuTemperatureField("temp2f") == 1);
+static_assert(wuTemperatureField("temp99f") == 98);
+static_assert(wuTemperatureField("temp1f") == -1);
+static_assert(wuTemperatureField("temp05f") == -1);
+static_assert(wuTemperatureField("temp100f") == -1);
+static_assert(wuTemperatureField("tempff") == -1);
+
+/*
+ * The temperature names, built while compiling. The longest is temp99f.
+ */
+constexpr size_t wu_temperature_name_size = 8;
+
+static constexpr std::array<std::array<char, wu_temperature_name_size>,
+                            wu_temperature_field_count>
+makeWuTemperatureNames() {
+  std::array<std::array<char, wu_temperature_name_size>,
+             wu_temperature_field_count>
+      names{};
+
+  for (size_t i = 0; i < wu_temperature_field_count; i++) {
+    std::array<char, wu_temperature_name_size>& name = names[i];
+    size_t length = 0;
+    for (char c : string_view("temp")) {
+      name[length++] = c;
+    }
+    size_t number = i + 1;
+    if (number >= 10) {
+      name[length++] = static_cast<char>('0' + (number / 10));
+    }
+    if (number >= 2) {
+      name[length++] = static_cast<char>('0' + (number % 10));
+    }
+    name[length++] = 'f';
+  }
+
+  return names;
+}
+
+constexpr std::array<std::array<char, wu_temperature_name_size>,
+                     wu_temperature_field_count>
+    wu_temperature_names = makeWuTemperatureNames();
+
+static constexpr string_view wuFieldNameAt(size_t index) {
+
+  if (index < wu_fixed_field_count) {
+    return wu_fixed_fields[index].name;
+  }
+
+  return string_view(wu_temperature_names[index - wu_fixed_field_count].data());
+}
+
+static_assert(wuFieldNameAt(wu_fixed_field_count) == "tempf");
+static_assert(wuFieldNameAt(wu_field_count - 1) == "temp99f");
+
+/*
+ * Sorted by name, the way std::map<string, ...> would have them
+ */
+static constexpr std::array<uint8_t, wu_field_count> makeWuFieldUrlOrder() {
+  std::array<uint8_t, wu_field_count> order;
+
+  for (size_t i = 0; i < wu_field_count; i++) {
+    order[i] = static_cast<uint8_t>(i);
+  }
+  std::sort(order.begin(), order.end(), [](uint8_t a, uint8_t b) {
+    return wuFieldNameAt(a) < wuFieldNameAt(b);
+  });
+
+  return order;
+}
+
+constexpr std::array<uint8_t, wu_field_count> wu_field_url_order =
+    makeWuFieldUrlOrder();
+
+expected<size_t, int> wuFieldIndex(string_view field) {
+
+  int index = wu_field_slots[wuFieldSlot(field, wu_field_seed)];
+  if ((index >= 0) && (wu_fixed_fields[index].name == field)) {
+    return index;
+  }
+
+  int temperature = wuTemperatureField(field);
+  if (temperature >= 0) {
+    return wu_fixed_field_count + temperature;
+  }
+
+  return unexpected(EINVAL);
+}
+
+string_view wuFieldName(size_t index) {
+
+  return wuFieldNameAt(index);
+}
+
+const WuFieldProperties& wuFieldProperties(size_t index) {
+
+  if (index < wu_fixed_field_count) {
+    return wu_field_kinds[wu_fixed_fields[index].kind];
+  }
+
+  return wu_field_kinds[WU_FIELD_KIND_NUMBER_2];
+}
+
+span<const uint8_t> wuFieldUrlOrder() {
+
+  return wu_field_url_order;
+}
+
+expected<const WuFieldProperties*, int> wuFieldProperties(string_view field) {
+
+  auto x_index = wuFieldIndex(field);
+  if (x_index.has_value() == false) {
+    return unexpected(x_index.error());
+  }
+
+  return &wuFieldProperties(x_index.value());
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Weather underground RapidFire updates
+ */
+#include "include/wu_rapid_fire.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+
+#include "include/wu_field_schema.h"
+#include "include/wu_response.h"
+
+using std::chrono::duration_cast;
+
+WuRapidFire::WuRapidFire(WuConnection* connection) : connection_(connection) {}
+
+void WuRapidFire::setStation(string_view id, string_view password,
+                             milliseconds interval, string_view url) {
+  char rtfreq[qw_units::kFixedFormatBufferSize];
+
+  interval_ = interval;
+
+  /*
+   * Everything that is the same in every update. rtfreq is in seconds.
+   */
+  url_.start(url);
+  url_.addField("ID", id);
+  url_.addField("PASSWORD", password);
+  url_.addEscapedField("action", "updateraw");
+  url_.addEscapedField("dateutc", "now");
+  url_.addEscapedField("realtime", "1");
+  size_t length = qw_units::formatFixed(
+      rtfreq, sizeof(rtfreq), static_cast<float>(interval_.count()) / 1000,
+      1);
+  url_.addEscapedField("rtfreq", string_view(rtfreq, length));
+  prefix_length_ = url_.size();
+
+  return;
+}
+
+expected<size_t, int> WuRapidFire::addField(string_view field) {
+  Slot slot;
+
+  /*
+   * This is the only time the field gets checked
+   */
+  expected<size_t, int> field_index = wuFieldIndex(field);
+  if (field_index.has_value() == false) {
+    return unexpected(field_index.error());
+  }
+  const WuFieldProperties& field_properties =
+      wuFieldProperties(field_index.value());
+  if (field_properties.type_ != WU_FIELD_TYPE_NUMBER) {
+    return unexpected(EINVAL);
+  }
+
+  slot.prefix_ = fmt::format("&{}=", field);
+  slot.precision_ = field_properties.precision_;
+  slots_.push_back(slot);
+
+  return slots_.size() - 1;
+}
+
+void WuRapidFire::setValue(size_t slot, float value) {
+  Slot& field = slots_[slot];
+
+  /*
+   * Compare the bits, a NaN is never equal to itself
+   */
+  field.present_ = true;
+  if ((field.formatted_ == true) &&
+      (std::memcmp(&field.value_, &value, sizeof(value)) == 0)) {
+    return;
+  }
+
+  field.value_ = value;
+  field.length_ = std::min(
+      qw_units::formatFixed(field.text_, sizeof(field.text_), value,
+                            field.precision_),
+      sizeof(field.text_));
+  field.formatted_ = true;
+
+  return;
+}
+
+void WuRapidFire::clearValue(size_t slot) {
+
+  slots_[slot].present_ = false;
+
+  return;
+}
+
+/*
+ * The prefix is already in the buffer, cut back to it and copy the fields
+ * on the end
+ */
+void WuRapidFire::buildUrl() {
+
+  url_.truncate(prefix_length_);
+  for (const Slot& slot : slots_) {
+    if (slot.present_ == true) {
+      url_.addEscapedFields(slot.prefix_);
+      url_.addEscapedFields(string_view(slot.text_, slot.length_));
+    }
+  }
+
+  return;
+}
+
+expected<bool, int> WuRapidFire::sendAsync(steady_clock::time_point cycle_start,
+                                           WuUploadCallback done) {
+
+  if (prefix_length_ == 0) {
+    return unexpected(EINVAL);
+  }
+  if (connection_->busy() == true) {
+    statistics_.skipped_++;
+    return unexpected(EBUSY);
+  }
+
+  buildUrl();
+
+  /*
+   * The callback only holds this so it fits in the std::function without
+   * allocating, what it needs is kept here
+   */
+  cycle_start_ = cycle_start;
+  done_ = std::move(done);
+  auto x_started = connection_->startGet(
+      url_.url(), [this](expected<bool, int> result, const string& response,
+                         const WuUploadTiming& timing) {
+        recordLatency(wuClassifyResponse(result, timing.http_status_,
+                                         response) == WU_RESPONSE_SUCCESS);
+        WuUploadCallback done = std::move(done_);
+        done_ = nullptr;
+        if (done) {
+          done(result, response, timing);
+        }
+      });
+  if (x_started.has_value() == false) {
+    done_ = nullptr;
+    return unexpected(x_started.error());
+  }
+
+  return true;
+}
+
+void WuRapidFire::recordLatency(bool success) {
+  microseconds latency =
+      duration_cast<microseconds>(steady_clock::now() - cycle_start_);
+
+  if (success == true) {
+    statistics_.sent_++;
+  } else {
+    statistics_.failed_++;
+  }
+  if (latency > interval_) {
+    statistics_.late_++;
+  }
+
+  statistics_.last_ = latency;
+  statistics_.max_ = std::max(statistics_.max_, latency);
+  total_latency_ += latency;
+  statistics_.mean_ =
+      total_latency_ / (statistics_.sent_ + statistics_.failed_);
+
+  return;
+}
+
+const string& WuRapidFire::url() const {
+
+  return url_.url();
+}
+
+milliseconds WuRapidFire::interval() const {
+
+  return interval_;
+}
+
+WuRapidFireStatistics WuRapidFire::statistics() const {
+
+  return statistics_;
+}
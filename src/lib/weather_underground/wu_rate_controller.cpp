@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The weather underground report rate controller
+ */
+#include "include/wu_rate_controller.h"
+
+#include <algorithm>
+
+using std::chrono::duration_cast;
+
+WuRateController::WuRateController(WuRateControlConfig config)
+    : config_(config) {
+
+  state_.base_interval_ = config_.base_interval_;
+  state_.interval_ = config_.base_interval_;
+}
+
+void WuRateController::setBaseInterval(milliseconds base_interval) {
+
+  /*
+   * If we weren't backing off the new interval goes in straight away
+   */
+  if (backingOff() == false) {
+    state_.interval_ = base_interval;
+  }
+  config_.base_interval_ = base_interval;
+  state_.base_interval_ = base_interval;
+  state_.interval_ = std::max(state_.interval_, base_interval);
+
+  return;
+}
+
+void WuRateController::record(WuResponseClass response_class,
+                              seconds retry_after) {
+
+  if ((response_class >= 0) && (response_class < WU_RESPONSE_MAX)) {
+    state_.responses_[response_class]++;
+  }
+  state_.last_class_ = response_class;
+
+  switch (response_class) {
+    case WU_RESPONSE_SUCCESS:
+      /*
+       * Additive, back down a step at a time
+       */
+      state_.interval_ = std::max(config_.base_interval_,
+                                  state_.interval_ - config_.recovery_step_);
+      break;
+    case WU_RESPONSE_THROTTLED:
+    case WU_RESPONSE_SERVER_ERROR: {
+      /*
+       * Multiplicative, and at least as long as we were told to wait
+       */
+      milliseconds backed_off = milliseconds(static_cast<int64_t>(
+          state_.interval_.count() * config_.backoff_factor_));
+      backed_off = std::max(backed_off,
+                            duration_cast<milliseconds>(retry_after));
+      state_.interval_ = std::max(
+          config_.base_interval_, std::min(backed_off, config_.max_interval_));
+      state_.backoffs_++;
+      break;
+    }
+    case WU_RESPONSE_AUTH_FAILED:
+      if (state_.suspended_ == false) {
+        state_.suspensions_++;
+      }
+      state_.suspended_ = true;
+      break;
+    default:
+      break;
+  }
+
+  return;
+}
+
+milliseconds WuRateController::interval() const {
+
+  return state_.interval_;
+}
+
+bool WuRateController::backingOff() const {
+
+  return state_.interval_ > config_.base_interval_;
+}
+
+bool WuRateController::suspended() const {
+
+  return state_.suspended_;
+}
+
+void WuRateController::resume() {
+
+  state_.suspended_ = false;
+
+  return;
+}
+
+WuRateControlState WuRateController::state() const {
+
+  return state_;
+}
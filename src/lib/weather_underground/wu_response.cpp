@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * Sorting out weather underground's answers
+ */
+#include "include/wu_response.h"
+
+constexpr string_view wu_success_response = "success";
+constexpr string_view wu_invalid_password_response = "INVALIDPASSWORDID";
+
+constexpr string_view wu_response_class_names[WU_RESPONSE_MAX] = {
+    "success", "auth_failed", "throttled", "server_error", "rejected",
+    "comm_error"};
+
+WuResponseClass wuClassifyResponse(const expected<bool, int>& result,
+                                   long http_status, string_view body) {
+
+  if ((result.has_value() == false) || (http_status == 0)) {
+    return WU_RESPONSE_COMM_ERROR;
+  }
+
+  /*
+   * The body is checked first, it has been known to come with a 200
+   */
+  if ((body.starts_with(wu_invalid_password_response) == true) ||
+      (http_status == 401) || (http_status == 403)) {
+    return WU_RESPONSE_AUTH_FAILED;
+  }
+  if (http_status == 429) {
+    return WU_RESPONSE_THROTTLED;
+  }
+  if (http_status >= 500) {
+    return WU_RESPONSE_SERVER_ERROR;
+  }
+  if (http_status >= 400) {
+    return WU_RESPONSE_REJECTED;
+  }
+  if (body.starts_with(wu_success_response) == true) {
+    return WU_RESPONSE_SUCCESS;
+  }
+
+  /*
+   * Something came back but it wasn't what weather underground says, a
+   * captive portal or a proxy maybe. Treat it like the server is having
+   * trouble.
+   */
+  return WU_RESPONSE_SERVER_ERROR;
+}
+
+string_view wuResponseClassName(WuResponseClass response_class) {
+
+  if ((response_class < 0) || (response_class >= WU_RESPONSE_MAX)) {
+    return "unknown";
+  }
+
+  return wu_response_class_names[response_class];
+}
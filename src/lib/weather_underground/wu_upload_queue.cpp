@@ -0,0 +1,254 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The store and forward queue for weather underground reports
+ */
+#include "include/wu_upload_queue.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#include "atomic_file.h"
+#include "retry_backoff.h"
+
+using std::chrono::duration_cast;
+
+constexpr string_view wu_queue_extension = ".wu";
+
+WuUploadQueue::WuUploadQueue(WuUploadQueueConfig config) : config_(config) {}
+
+expected<bool, int> WuUploadQueue::open() {
+  std::error_code ec;
+
+  std::filesystem::create_directories(config_.directory_, ec);
+  if (ec) {
+    return unexpected(ec.value());
+  }
+
+  std::filesystem::directory_iterator entries(config_.directory_, ec);
+  if (ec) {
+    return unexpected(ec.value());
+  }
+
+  reports_.clear();
+  for (const auto& entry : entries) {
+    string name = entry.path().filename().string();
+
+    /*
+     * Something that was being written when we went down
+     */
+    if (name.ends_with(atomic_file_temporary_extension) == true) {
+      std::filesystem::remove(entry.path(), ec);
+      continue;
+    }
+    if (name.ends_with(wu_queue_extension) == false) {
+      continue;
+    }
+
+    /*
+     * The name starts with the report time in milliseconds
+     */
+    long long milliseconds_since_epoch = 0;
+    if (sscanf(name.c_str(), "%lld-", &milliseconds_since_epoch) != 1) {
+      continue;
+    }
+
+    std::ifstream file(entry.path());
+    WuQueuedReport report;
+    report.time_ = system_clock::time_point(
+        milliseconds(milliseconds_since_epoch));
+    report.file_name_ = name;
+    report.fields_.assign(std::istreambuf_iterator<char>(file),
+                          std::istreambuf_iterator<char>());
+    if (report.fields_.empty() == true) {
+      continue;
+    }
+    reports_.push_back(report);
+  }
+
+  std::sort(reports_.begin(), reports_.end(),
+            [](const WuQueuedReport& a, const WuQueuedReport& b) {
+              return a.file_name_ < b.file_name_;
+            });
+  enforceBounds(system_clock::now());
+
+  return true;
+}
+
+expected<bool, int> WuUploadQueue::push(system_clock::time_point time,
+                                        string_view fields) {
+  WuQueuedReport report;
+
+  /*
+   * Too old to keep already
+   */
+  if ((system_clock::now() - time) > config_.max_age_) {
+    dropped_count_++;
+    return true;
+  }
+
+  report.time_ = time;
+  report.fields_ = fields;
+  report.file_name_ = fmt::format(
+      "{:016}-{:04}{}",
+      duration_cast<milliseconds>(time.time_since_epoch()).count(),
+      sequence_++ % 10000, wu_queue_extension);
+
+  reports_.push_back(report);
+  expected<bool, int> x_written = writeReport(report);
+
+  /*
+   * Only once the file is there, so a report that is dropped straight
+   * away, max_reports of 0 say, takes its file with it instead of
+   * leaving it for the next start to pick up
+   */
+  enforceBounds(system_clock::now());
+
+  return x_written;
+}
+
+expected<WuQueuedReport, int> WuUploadQueue::next(
+    steady_clock::time_point now) {
+
+  enforceBounds(system_clock::now());
+  if (reports_.empty() == true) {
+    return unexpected(ENODATA);
+  }
+  if (now < next_send_) {
+    return unexpected(EAGAIN);
+  }
+
+  return reports_.front();
+}
+
+int WuUploadQueue::timeout(steady_clock::time_point now) {
+
+  if (reports_.empty() == true) {
+    return -1;
+  }
+  if (now >= next_send_) {
+    return 0;
+  }
+
+  return static_cast<int>(
+             duration_cast<milliseconds>(next_send_ - now).count()) +
+         1;
+}
+
+void WuUploadQueue::sent(const WuQueuedReport& report,
+                         steady_clock::time_point now) {
+
+  /*
+   * It could have been dropped while it was going out
+   */
+  if ((reports_.empty() == false) &&
+      (reports_.front().file_name_ == report.file_name_)) {
+    removeReport(reports_.front());
+    reports_.pop_front();
+  }
+
+  sent_count_++;
+  failures_ = 0;
+  next_send_ = now + config_.drain_interval_;
+
+  return;
+}
+
+void WuUploadQueue::discard(const WuQueuedReport& report,
+                            steady_clock::time_point now) {
+
+  if ((reports_.empty() == false) &&
+      (reports_.front().file_name_ == report.file_name_)) {
+    dropOldest();
+  }
+
+  /*
+   * The next one can go straight away
+   */
+  failures_ = 0;
+  next_send_ = now;
+
+  return;
+}
+
+void WuUploadQueue::failed(steady_clock::time_point now) {
+
+  failed_count_++;
+  failures_++;
+  next_send_ =
+      now + retryDelay(failures_, config_.retry_initial_, config_.retry_max_);
+
+  return;
+}
+
+size_t WuUploadQueue::depth() {
+
+  return reports_.size();
+}
+
+expected<system_clock::duration, int> WuUploadQueue::oldestAge(
+    system_clock::time_point now) {
+
+  if (reports_.empty() == true) {
+    return unexpected(ENODATA);
+  }
+
+  return now - reports_.front().time_;
+}
+
+uint64_t WuUploadQueue::sentCount() {
+
+  return sent_count_;
+}
+
+uint64_t WuUploadQueue::failedCount() {
+
+  return failed_count_;
+}
+
+uint64_t WuUploadQueue::droppedCount() {
+
+  return dropped_count_;
+}
+
+void WuUploadQueue::enforceBounds(system_clock::time_point now) {
+
+  while (reports_.size() > config_.max_reports_) {
+    dropOldest();
+  }
+  while ((reports_.empty() == false) &&
+         ((now - reports_.front().time_) > config_.max_age_)) {
+    dropOldest();
+  }
+
+  return;
+}
+
+void WuUploadQueue::dropOldest() {
+
+  removeReport(reports_.front());
+  reports_.pop_front();
+  dropped_count_++;
+
+  return;
+}
+
+expected<bool, int> WuUploadQueue::writeReport(const WuQueuedReport& report) {
+
+  return writeFileAtomically(config_.directory_ / report.file_name_,
+                             report.fields_);
+}
+
+void WuUploadQueue::removeReport(const WuQueuedReport& report) {
+  std::error_code ec;
+
+  std::filesystem::remove(config_.directory_ / report.file_name_, ec);
+
+  return;
+}
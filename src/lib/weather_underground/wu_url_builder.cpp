@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 Chris Kottaridis
+ */
+
+/*
+ * The weather underground URL builder and its percent encoder
+ */
+#include "include/wu_url_builder.h"
+
+#include <algorithm>
+
+#include "fixed_format.h"
+
+/*
+ * The unreserved characters from RFC 3986, letters, digits and -._~ go as
+ * they are. Everything else is %XX with upper case hex, like curl does it.
+ */
+static constexpr std::array<bool, 256> makeUnreserved() {
+  std::array<bool, 256> unreserved{};
+
+  for (int c = 0; c < 256; c++) {
+    unreserved[c] = ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z')) ||
+                    ((c >= '0') && (c <= '9')) || (c == '-') || (c == '.') ||
+                    (c == '_') || (c == '~');
+  }
+
+  return unreserved;
+}
+
+constexpr std::array<bool, 256> url_unreserved = makeUnreserved();
+
+constexpr char url_hex_digits[] = "0123456789ABCDEF";
+
+WuUrlBuilder::WuUrlBuilder(size_t capacity) {
+
+  url_.reserve(capacity);
+}
+
+void WuUrlBuilder::start(string_view base_url) {
+
+  url_.clear();
+  url_.append(base_url);
+  url_.push_back('?');
+
+  return;
+}
+
+void WuUrlBuilder::addEscapedField(string_view name,
+                                   string_view escaped_value) {
+
+  url_.push_back('&');
+  url_.append(name);
+  url_.push_back('=');
+  url_.append(escaped_value);
+
+  return;
+}
+
+void WuUrlBuilder::addEscapedFields(string_view escaped_fields) {
+
+  url_.append(escaped_fields);
+
+  return;
+}
+
+void WuUrlBuilder::addField(string_view name, string_view value) {
+
+  url_.push_back('&');
+  url_.append(name);
+  url_.push_back('=');
+  appendEscaped(url_, value);
+
+  return;
+}
+
+void WuUrlBuilder::addNumber(string_view name, float value, int precision) {
+  char buffer[qw_units::kFixedFormatBufferSize];
+
+  /*
+   * Digits, '-' and '.' don't need escaping
+   */
+  size_t length =
+      qw_units::formatFixed(buffer, sizeof(buffer), value, precision);
+  url_.push_back('&');
+  url_.append(name);
+  url_.push_back('=');
+  url_.append(buffer, std::min(length, sizeof(buffer)));
+
+  return;
+}
+
+const string& WuUrlBuilder::url() const {
+
+  return url_;
+}
+
+size_t WuUrlBuilder::size() const {
+
+  return url_.size();
+}
+
+void WuUrlBuilder::truncate(size_t length) {
+
+  url_.resize(std::min(length, url_.size()));
+
+  return;
+}
+
+void WuUrlBuilder::clear() {
+
+  url_.clear();
+
+  return;
+}
+
+void WuUrlBuilder::appendEscaped(string& out, string_view value) {
+
+  for (char c : value) {
+    uint8_t byte = static_cast<uint8_t>(c);
+    if (url_unreserved[byte] == true) {
+      out.push_back(c);
+    } else {
+      char escaped[3] = {'%', url_hex_digits[byte >> 4],
+                         url_hex_digits[byte & 0x0f]};
+      out.append(escaped, sizeof(escaped));
+    }
+  }
+
+  return;
+}
@@ -23,15 +23,34 @@
 #include "fmt/chrono.h"
 #include "fmt/format.h"
 #include "include/weather_underground.h"
+#include "include/wu_rapid_fire.h"
+#include "include/wu_rate_controller.h"
+#include "include/wu_response.h"
+#include "include/wu_upload_queue.h"
+
+#include "include/cwop_sink.h"
+#include "include/influx_sink.h"
+#include "include/mqtt_sink.h"
+#include "include/publisher.h"
+#include "include/pwsweather_sink.h"
+#include "include/windy_sink.h"
 
 #include "celsius.h"
 #include "fahrenheit.h"
 #include "inches_mercury.h"
 #include "kelvin.h"
+#include "miles_per_hour.h"
 #include "millibar.h"
 #include "relative_humidity.h"
 
-#include "dewpoint.h"
+#include "derived_metrics.h"
+#include "metrics_exporter.h"
+#include "metrics_writer.h"
+#include "observation_statistics.h"
+#include "pressure_tendency.h"
+#include "sample_history.h"
+#include "spike_filter.h"
+#include "zambretti.h"
 
 using fmt::format;
 using qw_devices::I2cBus;
@@ -43,7 +62,10 @@ using qw_units::Celsius;
 using qw_units::Fahrenheit;
 using qw_units::InchesMercury;
 using qw_units::Kelvin;
+using qw_units::MetersPerSecond;
+using qw_units::MilesPerHour;
 using qw_units::Millibar;
+using qw_units::RelativeHumidity;
 using std::cout;
 using std::endl;
 using std::get;
@@ -51,12 +73,229 @@ using std::holds_alternative;
 using std::ifstream;
 using std::ofstream;
 using std::string;
+using std::chrono::duration_cast;
+using std::chrono::hours;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
 using std::chrono::system_clock;
 using std::chrono::time_point;
 using std::chrono::utc_clock;
 
 extern Logger logger;
 
+/*
+ * How far back the sample history goes unless the config says, and how
+ * many hours of hourly pressure means go in the log with each report
+ */
+constexpr int history_default_retention_days = 31;
+constexpr int history_pressure_hours = 6;
+
+/*
+ * Build a spike filter configuration from one entry in the Filters section
+ * of the config file. The deviation and rate in the file are in the
+ * sensor's display units (C, %RH, mb) so they get scaled to base units.
+ */
+qw_utilities::SpikeFilterConfig spikeFilterConfig(const Json::Value& config,
+                                                  int base_factor) {
+  qw_utilities::SpikeFilterConfig filter_config;
+
+  if (config.isObject() == false) {
+    return filter_config;
+  }
+
+  filter_config.window = config.get("window", 0).asUInt();
+  filter_config.hampel_threshold =
+      config.get("hampel_threshold", filter_config.hampel_threshold)
+          .asDouble();
+  filter_config.minimum_deviation =
+      round(config.get("minimum_deviation", 0).asDouble() * base_factor);
+  filter_config.max_rate =
+      round(config.get("max_rate_per_second", 0).asDouble() * base_factor);
+  filter_config.median_output =
+      config.get("median_output", false).asBool();
+
+  return filter_config;
+}
+
+/*
+ * Build a publisher sink configuration from one entry in the Publishers
+ * section of the config file. Times are in milliseconds.
+ */
+PublisherSinkConfig publisherSinkConfig(const Json::Value& config) {
+  PublisherSinkConfig sink_config;
+
+  if (config.isMember("queue_capacity") == true) {
+    sink_config.queue_capacity_ =
+        std::max(1u, config["queue_capacity"].asUInt());
+  }
+  if (config.isMember("retry_initial") == true) {
+    sink_config.retry_initial_ =
+        milliseconds(config["retry_initial"].asInt());
+  }
+  if (config.isMember("retry_max") == true) {
+    sink_config.retry_max_ = milliseconds(config["retry_max"].asInt());
+  }
+  if (config.isMember("max_attempts") == true) {
+    sink_config.max_attempts_ = config["max_attempts"].asInt();
+  }
+
+  return sink_config;
+}
+
+/*
+ * Put the windowed readings and the forecast into a sample for the
+ * publishers. The sinks convert them to whatever units they want.
+ */
+SharedSample publishedSample(
+    qw_utilities::ObservationStatistics& statistics,
+    qw_utilities::DerivedMetrics& derived,
+    qw_utilities::ZambrettiForecast& zambretti,
+    const std::expected<qw_units::TemperatureMeasurement, int>& x_lps22_temp) {
+  auto published_sample = std::make_shared<PublishedSample>();
+  published_sample->time_ = system_clock::now();
+
+  auto x_tempc = statistics.temperature().mean();
+  auto x_humidity = statistics.humidity().mean();
+  auto x_pressure = statistics.pressure().mean();
+
+  /*
+   * The SHT4x is supposed to be more accurate so it is the temperature,
+   * the LPS22 is the second one
+   */
+  if (x_tempc.has_value() == true) {
+    published_sample->temperature_ = Celsius(x_tempc.value());
+  }
+  if (x_lps22_temp.has_value() == true) {
+    published_sample->temperature2_ = x_lps22_temp.value().celsiusValue();
+  }
+  if (x_humidity.has_value() == true) {
+    published_sample->humidity_ = RelativeHumidity(x_humidity.value());
+  }
+
+  /*
+   * If there are valid temperature and relative humidity then there
+   * is a dewpoint
+   */
+  auto x_dewptc = derived.dewPoint();
+  if (x_dewptc.has_value() == true) {
+    published_sample->dewpoint_ = x_dewptc.value();
+  }
+
+  if (x_pressure.has_value() == true) {
+    published_sample->pressure_ = Millibar(x_pressure.value());
+  }
+  auto x_sea_level_pressure = derived.seaLevelPressure();
+  if (x_sea_level_pressure.has_value() == true) {
+    published_sample->sea_level_pressure_ = x_sea_level_pressure.value();
+  }
+
+  /*
+   * The wind fields only get filled in if there is a wind sensor
+   * feeding the statistics.
+   */
+  auto x_wind_speed = statistics.windSpeed().mean();
+  if (x_wind_speed.has_value() == true) {
+    published_sample->wind_speed_avg_ = MilesPerHour(x_wind_speed.value());
+    published_sample->wind_speed_ =
+        MilesPerHour(statistics.windSpeed().last().value());
+  }
+  auto x_wind_direction = statistics.windDirection().mean();
+  if (x_wind_direction.has_value() == true) {
+    published_sample->wind_direction_ =
+        static_cast<float>(x_wind_direction.value());
+  }
+  auto x_wind_gust = statistics.windGust().max();
+  if (x_wind_gust.has_value() == true) {
+    published_sample->wind_gust_ = MilesPerHour(x_wind_gust.value());
+  }
+
+  auto x_forecast = zambretti.number();
+  if (x_forecast.has_value() == true) {
+    published_sample->forecast_ = x_forecast.value();
+  }
+
+  return published_sample;
+}
+
+/*
+ * The readings in a sample, for the metrics exporter. Pressures are in
+ * hectopascals, the same number as millibars, because that is the unit
+ * Prometheus knows.
+ */
+void sampleMetrics(qw_utilities::MetricsWriter& metrics,
+                   const PublishedSample& sample) {
+
+  metrics.family("quietwind_temperature_celsius", "gauge",
+                 "Air temperature, averaged over the report window");
+  if (sample.temperature_.has_value() == true) {
+    metrics.sample("quietwind_temperature_celsius", "sensor=\"sht4x\"",
+                   static_cast<double>(sample.temperature_.value().value()));
+  }
+  if (sample.temperature2_.has_value() == true) {
+    metrics.sample("quietwind_temperature_celsius", "sensor=\"lps22\"",
+                   static_cast<double>(sample.temperature2_.value().value()));
+  }
+  metrics.family("quietwind_humidity_percent", "gauge", "Relative humidity");
+  if (sample.humidity_.has_value() == true) {
+    metrics.sample("quietwind_humidity_percent", "",
+                   static_cast<double>(sample.humidity_.value().value()));
+  }
+  metrics.family("quietwind_dewpoint_celsius", "gauge", "Dew point");
+  if (sample.dewpoint_.has_value() == true) {
+    metrics.sample("quietwind_dewpoint_celsius", "",
+                   static_cast<double>(sample.dewpoint_.value().value()));
+  }
+  metrics.family("quietwind_pressure_hectopascals", "gauge",
+                 "Barometric pressure at the station");
+  if (sample.pressure_.has_value() == true) {
+    metrics.sample("quietwind_pressure_hectopascals", "",
+                   static_cast<double>(sample.pressure_.value().value()));
+  }
+  metrics.family("quietwind_sea_level_pressure_hectopascals", "gauge",
+                 "Barometric pressure reduced to sea level");
+  if (sample.sea_level_pressure_.has_value() == true) {
+    metrics.sample(
+        "quietwind_sea_level_pressure_hectopascals", "",
+        static_cast<double>(sample.sea_level_pressure_.value().value()));
+  }
+  metrics.family("quietwind_wind_speed_meters_per_second", "gauge",
+                 "Wind speed, averaged");
+  if (sample.wind_speed_avg_.has_value() == true) {
+    metrics.sample(
+        "quietwind_wind_speed_meters_per_second", "",
+        static_cast<double>(
+            MetersPerSecond(sample.wind_speed_avg_.value()).value()));
+  }
+  metrics.family("quietwind_wind_gust_meters_per_second", "gauge",
+                 "Peak wind speed over the gust window");
+  if (sample.wind_gust_.has_value() == true) {
+    metrics.sample("quietwind_wind_gust_meters_per_second", "",
+                   static_cast<double>(
+                       MetersPerSecond(sample.wind_gust_.value()).value()));
+  }
+  metrics.family("quietwind_wind_direction_degrees", "gauge",
+                 "Wind direction, averaged");
+  if (sample.wind_direction_.has_value() == true) {
+    metrics.sample("quietwind_wind_direction_degrees", "",
+                   static_cast<double>(sample.wind_direction_.value()));
+  }
+  metrics.family("quietwind_zambretti_forecast", "gauge",
+                 "Zambretti forecast number, 1 to 9 falling, 10 to 19 "
+                 "steady, 20 to 32 rising");
+  if (sample.forecast_.has_value() == true) {
+    metrics.sample("quietwind_zambretti_forecast", "",
+                   static_cast<double>(sample.forecast_.value()));
+  }
+  metrics.family("quietwind_sample_timestamp_seconds", "gauge",
+                 "When the readings were taken");
+  metrics.sample(
+      "quietwind_sample_timestamp_seconds", "",
+      std::chrono::duration<double>(sample.time_.time_since_epoch()).count());
+
+  return;
+}
+
 int main(int argc, char* argv[]) {
   string temperature;
   string humidity;
@@ -272,121 +511,1167 @@ int main(int argc, char* argv[]) {
   string pwu_name = wu_json_config["pwu_name"].asString();
   string pwu_password = wu_json_config["pwu_password"].asString();
 
-  WeatherUnderground* wu = new WeatherUnderground(pwu_name, pwu_password);
+  /*
+   * The connection to weather underground stays open across reports and
+   * across config reloads, only the WeatherUnderground object gets redone.
+   */
+  WuConnection wu_connection;
+  WeatherUnderground* wu =
+      new WeatherUnderground(pwu_name, pwu_password, &wu_connection);
+
+  /*
+   * The reports can be pointed somewhere else, a mock server for testing
+   */
+  string pwu_url = wu_url;
+  if (wu_json_config.isMember("wu_url") == true) {
+    pwu_url = wu_json_config["wu_url"].asString();
+  }
+  string pwu_rapid_fire_url = wu_rapid_fire_url;
+  if (wu_json_config.isMember("rapid_fire_url") == true) {
+    pwu_rapid_fire_url = wu_json_config["rapid_fire_url"].asString();
+  }
+  wu->setUrl(pwu_url);
   int reporting_loop_interval = wu_default_report_interval;
   if (wu_json_config.isMember("report_interval") == true) {
     reporting_loop_interval =
       min(max(wu_report_interval_min, wu_json_config["report_interval"].asInt()),
           wu_report_interval_max);
   }
+
+  /*
+   * The report interval that is actually used comes from the rate
+   * controller. It starts at report_interval and gets longer when weather
+   * underground says to slow down.
+   */
+  WuRateControlConfig rate_config;
+  Json::Value rate_json = json_config["RateControl"];
+  rate_config.base_interval_ = milliseconds(reporting_loop_interval);
+  rate_config.max_interval_ = milliseconds(wu_report_interval_max);
+  if (rate_json.isMember("max_interval") == true) {
+    rate_config.max_interval_ =
+        milliseconds(max(wu_report_interval_min,
+                         rate_json["max_interval"].asInt()));
+  }
+  if (rate_json.isMember("backoff_factor") == true) {
+    rate_config.backoff_factor_ =
+        std::max(1.0, rate_json["backoff_factor"].asDouble());
+  }
+  if (rate_json.isMember("recovery_step") == true) {
+    rate_config.recovery_step_ =
+        milliseconds(rate_json["recovery_step"].asInt());
+  }
+  WuRateController rate_controller(rate_config);
+
+  /*
+   * RapidFire updates go on their own connection, to a different server,
+   * so a slow one doesn't hold up the regular reports or the other way
+   * round. They only go if the config asks for them.
+   */
+  WuConnection rapid_fire_connection;
+  WuRapidFire rapid_fire(&rapid_fire_connection);
+  int rapid_fire_interval = 0;
+  if (wu_json_config.isMember("rapid_fire_interval") == true) {
+    rapid_fire_interval = wu_json_config["rapid_fire_interval"].asInt();
+    if (rapid_fire_interval > 0) {
+      rapid_fire_interval = max(wu_report_interval_min, rapid_fire_interval);
+    }
+  }
+  rapid_fire.setStation(pwu_name, pwu_password,
+                        milliseconds(rapid_fire_interval),
+                        pwu_rapid_fire_url);
+  size_t rapid_fire_tempf = rapid_fire.addField("tempf").value();
+  size_t rapid_fire_humidity = rapid_fire.addField("humidity").value();
+  size_t rapid_fire_dewptf = rapid_fire.addField("dewptf").value();
+  size_t rapid_fire_baromin = rapid_fire.addField("baromin").value();
+  size_t rapid_fire_windspeedmph = rapid_fire.addField("windspeedmph").value();
+
+  /*
+   * Everywhere else the reports go. Weather Underground has its own queue
+   * and rate control above, the rest are sinks on the publisher, each
+   * with a thread and a queue of its own so a slow or broken one doesn't
+   * hold up anybody else.
+   */
+  Publisher publisher;
+  Json::Value publishers_json = json_config["Publishers"];
+  Json::Value pwsweather_json = publishers_json["pwsweather"];
+  if (pwsweather_json.get("enabled", false).asBool() == true) {
+    auto x_added = publisher.addSink(
+        std::make_unique<PwsWeatherSink>(
+            pwsweather_json["station_id"].asString(),
+            pwsweather_json["api_key"].asString(),
+            pwsweather_json.get("url", pwsweather_url).asString()),
+        publisherSinkConfig(pwsweather_json));
+    if (x_added.has_value() == false) {
+      logger.log(LOG_ERR, format("Unable to add PWSweather publisher: {}",
+                                 strerror(x_added.error())));
+    }
+  }
+  Json::Value windy_json = publishers_json["windy"];
+  if (windy_json.get("enabled", false).asBool() == true) {
+    auto x_added = publisher.addSink(
+        std::make_unique<WindySink>(windy_json["api_key"].asString(),
+                                    windy_json.get("station", 0).asInt(),
+                                    windy_json.get("url", windy_url).asString()),
+        publisherSinkConfig(windy_json));
+    if (x_added.has_value() == false) {
+      logger.log(LOG_ERR, format("Unable to add Windy publisher: {}",
+                                 strerror(x_added.error())));
+    }
+  }
+  Json::Value cwop_json = publishers_json["cwop"];
+  if (cwop_json.get("enabled", false).asBool() == true) {
+    CwopSinkConfig cwop_config;
+    cwop_config.host_ = cwop_json.get("host", cwop_config.host_).asString();
+    cwop_config.port_ = static_cast<uint16_t>(
+        cwop_json.get("port", cwop_config.port_).asUInt());
+    cwop_config.callsign_ = cwop_json["callsign"].asString();
+    cwop_config.passcode_ =
+        cwop_json.get("passcode", cwop_config.passcode_).asString();
+    cwop_config.latitude_ = cwop_json["latitude"].asDouble();
+    cwop_config.longitude_ = cwop_json["longitude"].asDouble();
+    cwop_config.version_ = software_version;
+    cwop_config.min_interval_ = milliseconds(
+        cwop_json
+            .get("min_interval",
+                 static_cast<int>(cwop_default_min_interval.count()))
+            .asInt());
+    cwop_config.retry_initial_ = milliseconds(
+        cwop_json
+            .get("reconnect_initial",
+                 static_cast<int>(cwop_default_retry_initial.count()))
+            .asInt());
+    cwop_config.retry_max_ = milliseconds(
+        cwop_json
+            .get("reconnect_max",
+                 static_cast<int>(cwop_default_retry_max.count()))
+            .asInt());
+    auto x_added = publisher.addSink(std::make_unique<CwopSink>(cwop_config),
+                                     publisherSinkConfig(cwop_json));
+    if (x_added.has_value() == false) {
+      logger.log(LOG_ERR, format("Unable to add CWOP publisher: {}",
+                                 strerror(x_added.error())));
+    }
+  }
+  logger.log(LOG_INFO, format("Publishing to {} other destinations",
+                              publisher.sinkCount()));
+
+  /*
+   * Local destinations, like an MQTT broker for Home Assistant or a time
+   * series database, get a sample far more often than the report
+   * interval, every live_interval, so they have a publisher of their own.
+   * There is nothing new to send more often than the sensors are read.
+   */
+  Publisher live_publisher;
+  int live_interval =
+      max(ws_sample_interval,
+          publishers_json.get("live_interval", ws_sample_interval).asInt());
+  Json::Value mqtt_json = publishers_json["mqtt"];
+  if (mqtt_json.get("enabled", false).asBool() == true) {
+    MqttSinkConfig mqtt_config;
+    mqtt_config.host_ = mqtt_json.get("host", mqtt_config.host_).asString();
+    mqtt_config.port_ = static_cast<uint16_t>(
+        mqtt_json.get("port", mqtt_config.port_).asUInt());
+    mqtt_config.client_id_ =
+        mqtt_json.get("client_id", mqtt_config.client_id_).asString();
+    mqtt_config.username_ = mqtt_json["username"].asString();
+    mqtt_config.password_ = mqtt_json["password"].asString();
+    mqtt_config.topic_prefix_ =
+        mqtt_json.get("topic_prefix", mqtt_config.topic_prefix_).asString();
+    mqtt_config.discovery_prefix_ =
+        mqtt_json.get("discovery_prefix", mqtt_config.discovery_prefix_)
+            .asString();
+    mqtt_config.device_name_ =
+        mqtt_json.get("device_name", mqtt_config.device_name_).asString();
+
+    /*
+     * Nothing goes to the broker between samples so the keepalive has to
+     * cover at least a couple of them
+     */
+    mqtt_config.keepalive_ = std::max(
+        seconds(mqtt_json.get("keepalive", 60).asInt()),
+        duration_cast<seconds>(milliseconds(live_interval * 2)) + seconds(1));
+
+    auto x_added = live_publisher.addSink(
+        std::make_unique<MqttSink>(mqtt_config),
+        publisherSinkConfig(mqtt_json));
+    if (x_added.has_value() == false) {
+      logger.log(LOG_ERR, format("Unable to add MQTT publisher: {}",
+                                 strerror(x_added.error())));
+    } else {
+      logger.log(LOG_INFO, format("Publishing to MQTT at {}:{} every {}ms",
+                                  mqtt_config.host_, mqtt_config.port_,
+                                  live_interval));
+    }
+  }
+  Json::Value influx_json = publishers_json["influxdb"];
+  if (influx_json.get("enabled", false).asBool() == true) {
+    InfluxSinkConfig influx_config;
+    influx_config.url_ = influx_json["url"].asString();
+    influx_config.token_ = influx_json["token"].asString();
+    influx_config.measurement_ =
+        influx_json.get("measurement", influx_config.measurement_).asString();
+    influx_config.station_ = influx_json["station"].asString();
+    influx_config.batch_points_ =
+        influx_json.get("batch_points", influx_default_batch_points)
+            .asUInt();
+    influx_config.batch_interval_ = milliseconds(
+        influx_json
+            .get("batch_interval",
+                 static_cast<int>(influx_default_batch_interval.count()))
+            .asInt());
+    influx_config.gzip_ = influx_json.get("gzip", true).asBool();
+    influx_config.spill_directory_ =
+        influx_json["spill_directory"].asString();
+    influx_config.spill_max_bytes_ =
+        influx_json.get("spill_max_bytes", influx_default_spill_max_bytes)
+            .asUInt64();
+
+    /*
+     * The sink spills batches it can't write itself, the publisher only
+     * has to try again when even that didn't work
+     */
+    auto x_added = live_publisher.addSink(
+        std::make_unique<InfluxSink>(influx_config),
+        publisherSinkConfig(influx_json));
+    if (x_added.has_value() == false) {
+      logger.log(LOG_ERR, format("Unable to add InfluxDB publisher: {}",
+                                 strerror(x_added.error())));
+    } else {
+      logger.log(LOG_INFO, format("Publishing to InfluxDB at {} every {}ms",
+                                  influx_config.url_, live_interval));
+    }
+  }
+
+  /*
+   * Reports wait in the upload queue until they go, so they survive the
+   * network or weather underground being down, and a restart
+   */
+  WuUploadQueueConfig queue_config;
+  Json::Value queue_json = json_config["UploadQueue"];
+  queue_config.directory_ = wu_queue_default_directory;
+  if (queue_json.isMember("directory") == true) {
+    queue_config.directory_ = queue_json["directory"].asString();
+  }
+  if (queue_json.isMember("max_reports") == true) {
+    queue_config.max_reports_ = queue_json["max_reports"].asUInt();
+  }
+  if (queue_json.isMember("max_age_hours") == true) {
+    queue_config.max_age_ = hours(queue_json["max_age_hours"].asInt());
+  }
+  if (queue_json.isMember("drain_interval") == true) {
+    queue_config.drain_interval_ =
+        milliseconds(max(wu_report_interval_min,
+                         queue_json["drain_interval"].asInt()));
+  }
+  if (queue_json.isMember("retry_initial") == true) {
+    queue_config.retry_initial_ =
+        milliseconds(queue_json["retry_initial"].asInt());
+  }
+  if (queue_json.isMember("retry_max") == true) {
+    queue_config.retry_max_ = milliseconds(queue_json["retry_max"].asInt());
+  }
+  WuUploadQueue upload_queue(queue_config);
+  auto x_queue_open = upload_queue.open();
+  if (x_queue_open.has_value() == false) {
+    logger.log(LOG_ERR, format("Upload queue {} can't be used, reports will "
+                               "only be kept in memory: {}",
+                               queue_config.directory_.string(),
+                               strerror(x_queue_open.error())));
+  } else {
+    logger.log(LOG_INFO, format("Upload queue {}: {} reports waiting",
+                                queue_config.directory_.string(),
+                                upload_queue.depth()));
+  }
+
+  /*
+   * Served to Prometheus, if it's turned on. The main loop renders the
+   * metrics once a cycle and the exporter's thread answers the scrapes
+   * from that, they never get in the way of the sampling.
+   */
+  qw_utilities::MetricsExporter metrics_exporter;
+  Json::Value metrics_json = json_config["Metrics"];
+  if (metrics_json.get("enabled", false).asBool() == true) {
+    string metrics_listen =
+        metrics_json.get("listen", qw_utilities::metrics_default_listen)
+            .asString();
+    auto x_metrics_open = metrics_exporter.open(metrics_listen);
+    if (x_metrics_open.has_value() == false) {
+      logger.log(LOG_ERR, format("Unable to serve metrics on {}: {}",
+                                 metrics_listen,
+                                 strerror(x_metrics_open.error())));
+    } else {
+      logger.log(LOG_INFO, format("Serving metrics on {}", metrics_listen));
+    }
+  }
+  qw_utilities::MetricsWriter metrics_writer;
+
+  /*
+   * How long things take, in seconds. They are kept whether or not the
+   * exporter is on, it's only a few counts.
+   */
+  const vector<double> sensor_read_buckets = {0.001, 0.002, 0.005, 0.01,
+                                              0.02,  0.05,  0.1,   0.2,
+                                              0.5,   1.0};
+  const vector<double> upload_buckets = {0.05, 0.1, 0.25, 0.5,  1.0,
+                                         2.5,  5.0, 10.0, 30.0, 60.0};
+  const vector<double> loop_late_buckets = {0.001, 0.002, 0.005, 0.01,
+                                            0.025, 0.05,  0.1,   0.25,
+                                            0.5,   1.0};
+  qw_utilities::MetricsHistogram sht4x_temperature_read(sensor_read_buckets);
+  qw_utilities::MetricsHistogram sht4x_humidity_read(sensor_read_buckets);
+  qw_utilities::MetricsHistogram lps22_temperature_read(sensor_read_buckets);
+  qw_utilities::MetricsHistogram lps22_pressure_read(sensor_read_buckets);
+  qw_utilities::MetricsHistogram report_upload_latency(upload_buckets);
+  qw_utilities::MetricsHistogram rapid_fire_upload_latency(upload_buckets);
+  qw_utilities::MetricsHistogram loop_late(loop_late_buckets);
+  string sht4x_labels =
+      format("device=\"sht4x\",address=\"{:#04x}\"", kSht4xI2cPrimaryAddress);
+  string lps22_labels = format("device=\"lps22\",address=\"{:#04x}\"",
+                               kLps22hbI2cPrimaryAddress);
+
+  /*
+   * Start on the oldest report in the queue if it's time. When it's done
+   * it comes out of the queue if weather underground took it, otherwise it
+   * gets tried again later. The callback could run after the config is
+   * reloaded so it doesn't touch wu.
+   */
+  auto send_queued_report = [&]() {
+    if ((wu_connection.busy() == true) || (pwu_name == "") ||
+        (pwu_password == "") || (rate_controller.suspended() == true)) {
+      return;
+    }
+    auto x_report = upload_queue.next(steady_clock::now());
+    if (x_report.has_value() == false) {
+      return;
+    }
+
+    WuQueuedReport report = x_report.value();
+    auto errval = wu->sendFieldsAsync(
+        report.fields_,
+        [&upload_queue, &rate_controller, &report_upload_latency, report](
+            expected<bool, int> result, const string& response,
+            const WuUploadTiming& timing) {
+          report_upload_latency.observe(timing.total_);
+          if (result.has_value() == false) {
+            logger.log(LOG_ERR, format("COMM Error: {}",
+                                       strerror(result.error())));
+          }
+          logger.log(LOG_INFO,
+                     format("Upload: namelookup {} connect {} appconnect {} "
+                            "total {} new connections {}",
+                            timing.namelookup_, timing.connect_,
+                            timing.appconnect_, timing.total_,
+                            timing.new_connections_));
+          logger.log(LOG_INFO, response);
+
+          /*
+           * A report the server turned down for what's in it would just
+           * get turned down again, everything else stays in the queue
+           */
+          WuResponseClass response_class =
+              wuClassifyResponse(result, timing.http_status_, response);
+          rate_controller.record(response_class, timing.retry_after_);
+          switch (response_class) {
+            case WU_RESPONSE_SUCCESS:
+              upload_queue.sent(report, steady_clock::now());
+              break;
+            case WU_RESPONSE_REJECTED:
+              logger.log(LOG_ERR, format("Report rejected, HTTP {}, dropped",
+                                         timing.http_status_));
+              upload_queue.discard(report, steady_clock::now());
+              break;
+            case WU_RESPONSE_AUTH_FAILED:
+              logger.log(LOG_ERR, "Weather Underground turned down the ID or "
+                                  "PASSWORD, no uploads until the config "
+                                  "file changes");
+              upload_queue.failed(steady_clock::now());
+              break;
+            default:
+              logger.log(LOG_ERR,
+                         format("Upload {}, HTTP {}, report interval now {}",
+                                wuResponseClassName(response_class),
+                                timing.http_status_,
+                                rate_controller.interval()));
+              upload_queue.failed(steady_clock::now());
+              break;
+          }
+        });
+    if (errval.has_value() == false) {
+      logger.log(LOG_ERR, "COMM Error");
+      upload_queue.failed(steady_clock::now());
+    }
+  };
+
   /*
    * Setup inotify to get notified when config file changes during poll
    */
   int inotify_fd = inotify_init();
   int watch_fd =
       inotify_add_watch(inotify_fd, json_config["WeatherUndegroundFile"].asString().c_str(), IN_MODIFY);
-  pollfd fds[1];
-  fds[0].fd = inotify_fd;
-  fds[0].events = POLLIN;
+  /*
+   * The inotify fd is always first, the sockets of an upload that's going
+   * follow it
+   */
+  vector<pollfd> fds;
+
+  /*
+   * Each sensor reading goes through its own spike filter before anything
+   * else sees it.
+   */
+  Json::Value filters_config = json_config["Filters"];
+  qw_utilities::SpikeFilter sht4x_temperature_filter(
+      "sht4x_temperature",
+      spikeFilterConfig(filters_config["sht4x_temperature"],
+                        qw_units::temperature_base_conversion_factor));
+  qw_utilities::SpikeFilter sht4x_humidity_filter(
+      "sht4x_humidity",
+      spikeFilterConfig(filters_config["sht4x_humidity"],
+                        qw_units::rh_base_conversion_factor));
+  qw_utilities::SpikeFilter lps22_temperature_filter(
+      "lps22_temperature",
+      spikeFilterConfig(filters_config["lps22_temperature"],
+                        qw_units::temperature_base_conversion_factor));
+  qw_utilities::SpikeFilter lps22_pressure_filter(
+      "lps22_pressure",
+      spikeFilterConfig(filters_config["lps22_pressure"],
+                        qw_units::pressure_base_conversion_factor));
+  qw_utilities::SpikeFilter* spike_filters[] = {
+      &sht4x_temperature_filter, &sht4x_humidity_filter,
+      &lps22_temperature_filter, &lps22_pressure_filter};
+
+  /*
+   * Every reading we take is kept here so range queries like the max
+   * temperature over the last day don't have to scan raw samples. It only
+   * goes back retention_days, older readings are thrown away as new ones
+   * come in.
+   */
+  qw_utilities::SampleHistory history;
+  hours history_retention =
+      hours(24) *
+      max(1, json_config["History"].get("retention_days",
+                                        history_default_retention_days)
+                 .asInt());
+
+  /*
+   * Windowed statistics that the averaged Weather Underground fields
+   * are filled from.
+   */
+  qw_utilities::ObservationStatistics statistics;
+
+  /*
+   * The 3 hour pressure tendency and the forecast that comes from it.
+   * Zambretti wants sea level pressure so it needs the station altitude.
+   */
+  qw_utilities::PressureTendency pressure_tendency;
+  qw_utilities::ZambrettiForecast zambretti;
+
+  /*
+   * Dew point and the rest of the calculated quantities. They are worked
+   * out from the windowed averages, and only when something asks for them.
+   */
+  qw_utilities::DerivedMetrics derived(
+      json_config["Station"]["altitude_meters"].asFloat());
+
+  /*
+   * The sensors get read every ws_sample_interval so the windows have
+   * something to average. The report goes out every reporting_loop_interval.
+   */
+  steady_clock::time_point next_report = steady_clock::now();
+  steady_clock::time_point next_rapid_fire = steady_clock::now();
+  steady_clock::time_point next_live = steady_clock::now();
+  steady_clock::time_point planned_wake;
 
   while (true) {
-    if (pwu_name == "" || pwu_password == "") {
+    /*
+     * A RapidFire update's latency is measured from here
+     */
+    steady_clock::time_point cycle_start = steady_clock::now();
+
+    /*
+     * How late we woke up for this cycle, unless it was the config
+     * changing that woke us
+     */
+    if (planned_wake != steady_clock::time_point()) {
+      loop_late.observe(cycle_start - planned_wake);
+    }
+
+    /*
+     * Gather up all the raw data, timing each conversion
+     */
+    steady_clock::time_point read_start = steady_clock::now();
+    auto x_sht4x_temp = sht4x.getTemperatureMeasurement();
+    sht4x_temperature_read.observe(steady_clock::now() - read_start);
+
+    read_start = steady_clock::now();
+    auto x_sht4x_humidity = sht4x.getRelativeHumidityMeasurement();
+    sht4x_humidity_read.observe(steady_clock::now() - read_start);
+
+    read_start = steady_clock::now();
+    auto x_lps22_temp = lps22.getTemperatureMeasurement();
+    lps22_temperature_read.observe(steady_clock::now() - read_start);
+
+    read_start = steady_clock::now();
+    auto x_lps22_pressure = lps22.getPressureMeasurement();
+    lps22_pressure_read.observe(steady_clock::now() - read_start);
+
+    /*
+     * Throw out spikes. A rejected reading is treated like a failed read.
+     */
+    if (x_sht4x_temp.has_value() == true) {
+      x_sht4x_temp = sht4x_temperature_filter.filter(x_sht4x_temp.value());
+    }
+    if (x_sht4x_humidity.has_value() == true) {
+      x_sht4x_humidity = sht4x_humidity_filter.filter(x_sht4x_humidity.value());
+    }
+    if (x_lps22_temp.has_value() == true) {
+      x_lps22_temp = lps22_temperature_filter.filter(x_lps22_temp.value());
+    }
+    if (x_lps22_pressure.has_value() == true) {
+      x_lps22_pressure = lps22_pressure_filter.filter(x_lps22_pressure.value());
+    }
+
+    /*
+     * Record the readings in the history and the windowed statistics
+     */
+    if (x_sht4x_temp.has_value() == true) {
+      history.append(x_sht4x_temp.value());
+      statistics.add(x_sht4x_temp.value());
+    }
+    if (x_sht4x_humidity.has_value() == true) {
+      history.append(x_sht4x_humidity.value());
+      statistics.add(x_sht4x_humidity.value());
+    }
+    if (x_lps22_pressure.has_value() == true) {
+      history.append(x_lps22_pressure.value());
+      statistics.add(x_lps22_pressure.value());
+      pressure_tendency.add(x_lps22_pressure.value());
+    }
+    statistics.expire(system_clock::now());
+    history.expire(system_clock::now() - history_retention);
+
+    /*
+     * A new sample for the derived metrics. Anything that doesn't change
+     * keeps its cached results.
+     */
+    auto x_mean_tempc = statistics.temperature().mean();
+    if (x_mean_tempc.has_value() == true) {
+      derived.setTemperature(Celsius(x_mean_tempc.value()));
+    } else {
+      derived.clearInput(qw_utilities::DERIVED_INPUT_TEMPERATURE);
+    }
+    auto x_mean_humidity = statistics.humidity().mean();
+    if (x_mean_humidity.has_value() == true) {
+      derived.setHumidity(qw_units::RelativeHumidity(x_mean_humidity.value()));
+    } else {
+      derived.clearInput(qw_utilities::DERIVED_INPUT_HUMIDITY);
+    }
+    auto x_mean_pressure = statistics.pressure().mean();
+    if (x_mean_pressure.has_value() == true) {
+      derived.setPressure(Millibar(x_mean_pressure.value()));
+    } else {
+      derived.clearInput(qw_utilities::DERIVED_INPUT_PRESSURE);
+    }
+    auto x_mean_wind_speed = statistics.windSpeed().mean();
+    if (x_mean_wind_speed.has_value() == true) {
+      derived.setWindSpeed(x_mean_wind_speed.value());
+    } else {
+      derived.clearInput(qw_utilities::DERIVED_INPUT_WIND_SPEED);
+    }
+
+    /*
+     * The forecast wants sea level pressure
+     */
+    auto x_change = pressure_tendency.change();
+    auto x_sea_level = derived.seaLevelPressure();
+    if ((x_change.has_value() == true) && (x_sea_level.has_value() == true)) {
+      zambretti.update(x_sea_level.value().value(), x_change.value());
+    }
+
+    bool report_due = (steady_clock::now() >= next_report);
+    if (report_due == true) {
       /*
-       * If there is no Weather Underground username and password
-       * then don't gather any data.
+       * If we fell behind don't try to catch up with a burst of reports
        */
-      logger.log(LOG_INFO, "Invalid Weather Underground Authentication");
-    } else {
+      next_report += rate_controller.interval();
+      if (next_report < steady_clock::now()) {
+        next_report = steady_clock::now() + rate_controller.interval();
+      }
+    }
+
+    /*
+     * The report is put into every unit anybody wants once, here, and the
+     * same sample goes to Weather Underground and every other sink
+     */
+    SharedSample sample;
+    if (report_due == true) {
+      sample = publishedSample(statistics, derived, zambretti, x_lps22_temp);
+      publisher.publish(sample);
+    }
+
+    if (report_due == true && (pwu_name == "" || pwu_password == "")) {
       /*
-       * Gather the data. 
-       * get the current time.
+       * If there is no Weather Underground username and password
+       * then don't report any data.
        */
-      auto now_time = system_clock::now();
+      logger.log(LOG_INFO, "Invalid Weather Underground Authentication");
+    } else if (report_due == true) {
+      auto now_time = sample->time_;
       logger.log(LOG_INFO, format("{:%F %T}", now_time));
 
       /*
-       * Gather up all the raw data
+       * Put the sample into the wu data, in the units Weather Underground
+       * wants, fahrenheit and inches of mercury
        */
-      auto x_sht4x_temp = sht4x.getTemperatureMeasurement();
+      wu->setVarData("action", "updateraw");
+      wu->setVarData("dateutc", now_time);
+      if (sample->temperature_.has_value() == true) {
+        wu->setVarData("tempf",
+                       Fahrenheit(sample->temperature_.value()).value());
+      }
+      if (sample->temperature2_.has_value() == true) {
+        wu->setVarData("temp2f",
+                       Fahrenheit(sample->temperature2_.value()).value());
+      }
+      if (sample->humidity_.has_value() == true) {
+        wu->setVarData("humidity", sample->humidity_.value().value());
+      }
+      if (sample->dewpoint_.has_value() == true) {
+        wu->setVarData("dewptf", Fahrenheit(sample->dewpoint_.value()).value());
+      }
+      if (sample->pressure_.has_value() == true) {
+        wu->setVarData("baromin",
+                       InchesMercury(sample->pressure_.value()).value());
+      }
+      if (sample->wind_speed_avg_.has_value() == true) {
+        wu->setVarData("windspdmph_avg2m",
+                       sample->wind_speed_avg_.value().value());
+        wu->setVarData("windspeedmph", sample->wind_speed_.value().value());
+      }
+      if (sample->wind_direction_.has_value() == true) {
+        wu->setVarData("winddir_avg2m", sample->wind_direction_.value());
+      }
+      if (sample->wind_gust_.has_value() == true) {
+        wu->setVarData("windgustmph_10m", sample->wind_gust_.value().value());
+      }
 
-      auto x_sht4x_humidity = sht4x.getRelativeHumidityMeasurement();
+      for (qw_utilities::SpikeFilter* spike_filter : spike_filters) {
+        logger.log(LOG_INFO,
+                   format("Filter {}: accepted {} rejected {} (rate {} "
+                          "hampel {}) resyncs {}",
+                          spike_filter->name(), spike_filter->acceptedCount(),
+                          spike_filter->rejectedCount(),
+                          spike_filter->rateRejectedCount(),
+                          spike_filter->hampelRejectedCount(),
+                          spike_filter->resyncCount()));
+      }
 
-      auto x_lps22_temp = lps22.getTemperatureMeasurement();
+      auto x_smoothed_temp = statistics.smoothedTemperature().value();
+      auto x_smoothed_pressure = statistics.smoothedPressure().value();
+      if ((x_smoothed_temp.has_value() == true) &&
+          (x_smoothed_pressure.has_value() == true)) {
+        logger.log(LOG_INFO, format("Smoothed: {:.2f} C {:.2f} mb",
+                                    x_smoothed_temp.value(),
+                                    x_smoothed_pressure.value()));
+      }
 
-      auto x_lps22_pressure = lps22.getPressureMeasurement();
+      for (int m = 0; m < qw_utilities::DERIVED_METRIC_MAX; m++) {
+        auto metric = static_cast<qw_utilities::DerivedMetric>(m);
+        auto x_metric = derived.value(metric);
+        if (x_metric.has_value() == true) {
+          logger.log(LOG_INFO, format("Derived {}: {:.2f}",
+                                      qw_utilities::DerivedMetrics::name(metric),
+                                      x_metric.value()));
+        }
+      }
+
+      auto x_trend = pressure_tendency.trend();
+      if ((x_change.has_value() == true) && (x_trend.has_value() == true)) {
+        logger.log(LOG_INFO,
+                   format("Pressure tendency: {:+.2f} mb/3h {}", x_change.value(),
+                          qw_utilities::pressureTrendName(x_trend.value())));
+      }
+      auto x_forecast = zambretti.forecast();
+      if (x_forecast.has_value() == true) {
+        logger.log(LOG_INFO, format("Forecast: {} (Zambretti {})",
+                                    x_forecast.value(), zambretti.number().value()));
+      }
 
       /*
-       * Put the raw data into the wu data
+       * From the history. The end of the range is a little in the future
+       * so this cycle's readings are in it.
        */
-      wu->setVarData("action", "updateraw");
-      //time_point<utc_clock> utc_time = utc_clock::now();
-      wu->setVarData("dateutc", "now");
+      auto history_to = system_clock::now() + seconds(1);
+      auto x_day_min = history.query(
+          qw_utilities::HISTORY_QUANTITY_CELSIUS,
+          qw_utilities::HISTORY_AGGREGATE_MIN, history_to - hours(24),
+          history_to);
+      auto x_day_max = history.query(
+          qw_utilities::HISTORY_QUANTITY_CELSIUS,
+          qw_utilities::HISTORY_AGGREGATE_MAX, history_to - hours(24),
+          history_to);
+      auto x_retention_max = history.query(
+          qw_utilities::HISTORY_QUANTITY_CELSIUS,
+          qw_utilities::HISTORY_AGGREGATE_MAX,
+          history_to - history_retention, history_to);
+      if ((x_day_min.has_value() == true) && (x_day_max.has_value() == true) &&
+          (x_retention_max.has_value() == true)) {
+        logger.log(
+            LOG_INFO,
+            format("History: temperature 24h min {:.1f} C max {:.1f} C, "
+                   "{} day max {:.1f} C",
+                   static_cast<double>(x_day_min.value()) /
+                       qw_units::temperature_base_conversion_factor,
+                   static_cast<double>(x_day_max.value()) /
+                       qw_units::temperature_base_conversion_factor,
+                   history_retention.count() / 24,
+                   static_cast<double>(x_retention_max.value()) /
+                       qw_units::temperature_base_conversion_factor));
+      }
+      string hourly_pressure;
+      for (const auto& x_hour_mean : history.queryBuckets(
+               qw_utilities::HISTORY_QUANTITY_MILLIBAR,
+               qw_utilities::HISTORY_AGGREGATE_MEAN,
+               history_to - hours(history_pressure_hours), history_to,
+               hours(1))) {
+        if (x_hour_mean.has_value() == true) {
+          hourly_pressure +=
+              format(" {:.1f}", static_cast<double>(x_hour_mean.value()) /
+                                    qw_units::pressure_base_conversion_factor);
+        } else {
+          hourly_pressure += " -";
+        }
+      }
+      logger.log(LOG_INFO, format("History: pressure hourly means, last {}h, "
+                                  "mb:{}",
+                                  history_pressure_hours, hourly_pressure));
+
       /*
-       * Weather Underground wants fahrenheit
+       * Into the queue with the time it was taken. It goes out from there,
+       * straight away unless there's a backlog or the last try failed.
+       * The fields don't have the ID and PASSWORD in them so they can go
+       * in the log.
        */
-      if (x_sht4x_temp.has_value()) {
-        /*
-         * The SHT4x is supposed to be more accurate so use it
-         */
-        qw_units::Fahrenheit tempf = x_sht4x_temp.value().fahrenheitValue();
-        wu->setVarData("tempf", tempf.value());
-        qw_units::Fahrenheit temp2f = x_lps22_temp.value().fahrenheitValue();
-        wu->setVarData("temp2f", temp2f.value());
+      auto x_fields = wu->reportFields();
+      if (x_fields.has_value() == true) {
+        logger.log(LOG_INFO, x_fields.value());
+        auto x_pushed = upload_queue.push(now_time, x_fields.value());
+        if (x_pushed.has_value() == false) {
+          logger.log(LOG_ERR, format("Upload queue: report not saved: {}",
+                                     strerror(x_pushed.error())));
+        }
+      }
+
+      auto x_oldest = upload_queue.oldestAge(system_clock::now());
+      logger.log(LOG_INFO,
+                 format("Upload queue: {} reports, oldest {}s, sent {} "
+                        "failed {} dropped {}",
+                        upload_queue.depth(),
+                        (x_oldest.has_value() == true)
+                            ? duration_cast<seconds>(x_oldest.value()).count()
+                            : 0,
+                        upload_queue.sentCount(), upload_queue.failedCount(),
+                        upload_queue.droppedCount()));
+
+      WuRateControlState rate_state = rate_controller.state();
+      string responses;
+      for (int c = 0; c < WU_RESPONSE_MAX; c++) {
+        responses += format(" {} {}",
+                            wuResponseClassName(static_cast<WuResponseClass>(c)),
+                            rate_state.responses_[c]);
+      }
+      logger.log(LOG_INFO,
+                 format("Rate control: interval {} (configured {}){}, last {}, "
+                        "backoffs {} suspensions {}, responses:{}",
+                        rate_state.interval_, rate_state.base_interval_,
+                        rate_state.suspended_ ? " SUSPENDED" : "",
+                        wuResponseClassName(rate_state.last_class_),
+                        rate_state.backoffs_, rate_state.suspensions_,
+                        responses));
+
+      vector<PublisherSinkStatistics> sinks = publisher.statistics();
+      for (const PublisherSinkStatistics& sink : live_publisher.statistics()) {
+        sinks.push_back(sink);
+      }
+      for (const PublisherSinkStatistics& sink : sinks) {
+        logger.log(LOG_INFO,
+                   format("Publisher {}: waiting {}, published {} skipped {} "
+                          "retries {} failed {} dropped {}, last error {}, "
+                          "latency {}",
+                          sink.name_, sink.depth_, sink.published_,
+                          sink.skipped_, sink.retries_, sink.failed_,
+                          sink.dropped_, sink.last_error_,
+                          duration_cast<milliseconds>(sink.last_latency_)));
+      }
+    }
+
+    if (report_due == true) {
+      wu->reset();
+    }
+
+    /*
+     * The live sinks get the same sample when it is a report, a new one
+     * otherwise
+     */
+    bool live_due = (live_publisher.sinkCount() > 0) &&
+                    (steady_clock::now() >= next_live);
+    if (live_due == true) {
+      next_live += milliseconds(live_interval);
+      if (next_live < steady_clock::now()) {
+        next_live = steady_clock::now() + milliseconds(live_interval);
+      }
+      if (sample == nullptr) {
+        sample = publishedSample(statistics, derived, zambretti, x_lps22_temp);
       }
+      live_publisher.publish(sample);
+    }
 
-      if (x_sht4x_humidity.has_value()) {
-        qw_units::RelativeHumidity humidity =
-          x_sht4x_humidity.value().relativeHumidityValue();
-        wu->setVarData("humidity", humidity.value());
+    /*
+     * The RapidFire update gets the readings from this cycle as they are,
+     * not the windowed averages. While the regular reports are being held
+     * back there are no RapidFire updates at all.
+     */
+    bool rapid_fire_due = (rapid_fire_interval > 0) &&
+                          (pwu_name != "") && (pwu_password != "") &&
+                          (rate_controller.suspended() == false) &&
+                          (rate_controller.backingOff() == false) &&
+                          (steady_clock::now() >= next_rapid_fire);
+    if (rapid_fire_due == true) {
+      next_rapid_fire += milliseconds(rapid_fire_interval);
+      if (next_rapid_fire < steady_clock::now()) {
+        next_rapid_fire =
+            steady_clock::now() + milliseconds(rapid_fire_interval);
+      }
+
+      if (x_sht4x_temp.has_value() == true) {
+        rapid_fire.setValue(rapid_fire_tempf,
+                            x_sht4x_temp.value().fahrenheitValue().value());
+      } else {
+        rapid_fire.clearValue(rapid_fire_tempf);
+      }
+      if (x_sht4x_humidity.has_value() == true) {
+        rapid_fire.setValue(
+            rapid_fire_humidity,
+            x_sht4x_humidity.value().relativeHumidityValue().value());
+      } else {
+        rapid_fire.clearValue(rapid_fire_humidity);
+      }
+      auto x_rapid_fire_dewptc = derived.dewPoint();
+      if (x_rapid_fire_dewptc.has_value() == true) {
+        Fahrenheit dewptf = x_rapid_fire_dewptc.value();
+        rapid_fire.setValue(rapid_fire_dewptf, dewptf.value());
+      } else {
+        rapid_fire.clearValue(rapid_fire_dewptf);
+      }
+      if (x_lps22_pressure.has_value() == true) {
+        rapid_fire.setValue(
+            rapid_fire_baromin,
+            x_lps22_pressure.value().inchesMercuryValue().value());
+      } else {
+        rapid_fire.clearValue(rapid_fire_baromin);
+      }
+      auto x_wind_speed_now = statistics.windSpeed().last();
+      if (x_wind_speed_now.has_value() == true) {
+        rapid_fire.setValue(rapid_fire_windspeedmph,
+                            static_cast<float>(x_wind_speed_now.value()));
+      } else {
+        rapid_fire.clearValue(rapid_fire_windspeedmph);
       }
 
       /*
-       * If there are valid temperature and relative humidity then add a dewpoint
+       * Busy means the last one is still going. It gets counted and this
+       * one is dropped, the next one will have newer readings anyway.
        */
-      if (x_sht4x_temp.has_value() && x_sht4x_humidity.has_value()) {
-        qw_units::Celsius tempc = x_sht4x_temp.value().celsiusValue();
-        qw_units::RelativeHumidity humidity =
-          x_sht4x_humidity.value().relativeHumidityValue();
-        Celsius dewptc = qw_utilities::dewPoint(tempc, humidity);
-        Fahrenheit dewptf = dewptc;
-        wu->setVarData("dewptf", dewptf.value());
+      auto x_rapid_fire_sent = rapid_fire.sendAsync(
+          cycle_start, [&rate_controller, &rapid_fire_upload_latency](
+                           expected<bool, int> result,
+                           const string& response,
+                           const WuUploadTiming& timing) {
+            rapid_fire_upload_latency.observe(timing.total_);
+            WuResponseClass response_class =
+                wuClassifyResponse(result, timing.http_status_, response);
+            rate_controller.record(response_class, timing.retry_after_);
+            if (response_class != WU_RESPONSE_SUCCESS) {
+              logger.log(LOG_ERR,
+                         format("RapidFire update {}, HTTP {}: {}",
+                                wuResponseClassName(response_class),
+                                timing.http_status_,
+                                (result.has_value() == true) ? response :
+                                    strerror(result.error())));
+            }
+          });
+      if ((x_rapid_fire_sent.has_value() == false) &&
+          (x_rapid_fire_sent.error() != EBUSY)) {
+        logger.log(LOG_ERR, format("RapidFire update not sent: {}",
+                                   strerror(x_rapid_fire_sent.error())));
+      }
+    }
+
+    /*
+     * How RapidFire has been keeping up goes in the log with each regular
+     * report, once every cycle would be too much
+     */
+    if ((report_due == true) && (rapid_fire_interval > 0)) {
+      WuRapidFireStatistics rapid_fire_statistics = rapid_fire.statistics();
+      logger.log(LOG_INFO,
+                 format("RapidFire every {}: sent {} failed {} late {} "
+                        "skipped {} latency last {} mean {} max {}",
+                        rapid_fire.interval(), rapid_fire_statistics.sent_,
+                        rapid_fire_statistics.failed_,
+                        rapid_fire_statistics.late_,
+                        rapid_fire_statistics.skipped_,
+                        duration_cast<milliseconds>(
+                            rapid_fire_statistics.last_),
+                        duration_cast<milliseconds>(
+                            rapid_fire_statistics.mean_),
+                        duration_cast<milliseconds>(
+                            rapid_fire_statistics.max_)));
+    }
+
+    send_queued_report();
+
+    /*
+     * The metrics for the scrapes until the next cycle
+     */
+    if (metrics_exporter.isOpen() == true) {
+      steady_clock::time_point render_start = steady_clock::now();
+      if (sample == nullptr) {
+        sample = publishedSample(statistics, derived, zambretti, x_lps22_temp);
+      }
+      metrics_writer.clear();
+      sampleMetrics(metrics_writer, *sample);
+
+      qw_devices::I2cTransferCounts sht4x_counts =
+          I2cBus::transferCounts(kSht4xI2cPrimaryAddress);
+      qw_devices::I2cTransferCounts lps22_counts =
+          I2cBus::transferCounts(kLps22hbI2cPrimaryAddress);
+      metrics_writer.family("quietwind_i2c_transfers", "counter",
+                            "I2C transfers with each device");
+      metrics_writer.sample("quietwind_i2c_transfers_total", sht4x_labels,
+                            sht4x_counts.transfers_);
+      metrics_writer.sample("quietwind_i2c_transfers_total", lps22_labels,
+                            lps22_counts.transfers_);
+      metrics_writer.family("quietwind_i2c_errors", "counter",
+                            "I2C transfers with each device that failed");
+      metrics_writer.sample("quietwind_i2c_errors_total", sht4x_labels,
+                            sht4x_counts.errors_);
+      metrics_writer.sample("quietwind_i2c_errors_total", lps22_labels,
+                            lps22_counts.errors_);
+
+      metrics_writer.family("quietwind_sensor_read_seconds", "histogram",
+                            "How long getting a reading from a sensor takes, "
+                            "conversion included");
+      metrics_writer.histogram("quietwind_sensor_read_seconds",
+                               "sensor=\"sht4x\",quantity=\"temperature\"",
+                               sht4x_temperature_read);
+      metrics_writer.histogram("quietwind_sensor_read_seconds",
+                               "sensor=\"sht4x\",quantity=\"humidity\"",
+                               sht4x_humidity_read);
+      metrics_writer.histogram("quietwind_sensor_read_seconds",
+                               "sensor=\"lps22\",quantity=\"temperature\"",
+                               lps22_temperature_read);
+      metrics_writer.histogram("quietwind_sensor_read_seconds",
+                               "sensor=\"lps22\",quantity=\"pressure\"",
+                               lps22_pressure_read);
+
+      metrics_writer.family("quietwind_spike_filter_accepted", "counter",
+                            "Readings the spike filter let through");
+      for (qw_utilities::SpikeFilter* spike_filter : spike_filters) {
+        metrics_writer.sample("quietwind_spike_filter_accepted_total",
+                              format("filter=\"{}\"", spike_filter->name()),
+                              spike_filter->acceptedCount());
+      }
+      metrics_writer.family("quietwind_spike_filter_rejected", "counter",
+                            "Readings the spike filter threw out");
+      for (qw_utilities::SpikeFilter* spike_filter : spike_filters) {
+        metrics_writer.sample("quietwind_spike_filter_rejected_total",
+                              format("filter=\"{}\"", spike_filter->name()),
+                              spike_filter->rejectedCount());
       }
 
       /*
-       * Weather Underground wants inches mercury
+       * Weather Underground. A response that wasn't a success is an
+       * upload that failed, by what went wrong.
        */
-      if (x_lps22_pressure.has_value()) {
-        qw_units::InchesMercury pressure =
-          x_lps22_pressure.value().inchesMercuryValue();
-        wu->setVarData("baromin", pressure.value());
+      metrics_writer.family("quietwind_upload_seconds", "histogram",
+                            "How long Weather Underground uploads take");
+      metrics_writer.histogram("quietwind_upload_seconds", "kind=\"report\"",
+                               report_upload_latency);
+      metrics_writer.histogram("quietwind_upload_seconds",
+                               "kind=\"rapid_fire\"",
+                               rapid_fire_upload_latency);
+      WuRateControlState metrics_rate_state = rate_controller.state();
+      metrics_writer.family("quietwind_upload_responses", "counter",
+                            "Weather Underground upload results by class");
+      for (int c = 0; c < WU_RESPONSE_MAX; c++) {
+        metrics_writer.sample(
+            "quietwind_upload_responses_total",
+            format("class=\"{}\"",
+                   wuResponseClassName(static_cast<WuResponseClass>(c))),
+            metrics_rate_state.responses_[c]);
       }
+      metrics_writer.family("quietwind_report_interval_seconds", "gauge",
+                            "The report interval the rate control is using");
+      metrics_writer.sample(
+          "quietwind_report_interval_seconds", "",
+          std::chrono::duration<double>(metrics_rate_state.interval_).count());
+      metrics_writer.family("quietwind_upload_queue_depth", "gauge",
+                            "Reports waiting to go to Weather Underground");
+      metrics_writer.sample("quietwind_upload_queue_depth", "",
+                            upload_queue.depth());
+      auto x_metrics_oldest = upload_queue.oldestAge(system_clock::now());
+      metrics_writer.family("quietwind_upload_queue_oldest_seconds", "gauge",
+                            "Age of the oldest report waiting");
+      metrics_writer.sample(
+          "quietwind_upload_queue_oldest_seconds", "",
+          (x_metrics_oldest.has_value() == true)
+              ? std::chrono::duration<double>(x_metrics_oldest.value()).count()
+              : 0.0);
+      metrics_writer.family("quietwind_upload_queue_reports", "counter",
+                            "Reports out of the upload queue by how");
+      metrics_writer.sample("quietwind_upload_queue_reports_total",
+                            "result=\"sent\"", upload_queue.sentCount());
+      metrics_writer.sample("quietwind_upload_queue_reports_total",
+                            "result=\"failed\"", upload_queue.failedCount());
+      metrics_writer.sample("quietwind_upload_queue_reports_total",
+                            "result=\"dropped\"",
+                            upload_queue.droppedCount());
 
       /*
-       * debug to check out the string
+       * Every other destination
        */
-      string http_request = wu->buildHttpRequest();
-      logger.log(LOG_INFO, http_request);
-
-      auto errval = wu->sendData();
-      if (errval.has_value() == false) {
-        logger.log(LOG_ERR, "COMM Error");
+      vector<PublisherSinkStatistics> metrics_sinks = publisher.statistics();
+      for (const PublisherSinkStatistics& sink :
+           live_publisher.statistics()) {
+        metrics_sinks.push_back(sink);
+      }
+      metrics_writer.family("quietwind_publisher_queue_depth", "gauge",
+                            "Samples waiting for each destination");
+      for (const PublisherSinkStatistics& sink : metrics_sinks) {
+        metrics_writer.sample("quietwind_publisher_queue_depth",
+                              format("sink=\"{}\"", sink.name_),
+                              sink.depth_);
+      }
+      metrics_writer.family("quietwind_publisher_samples", "counter",
+                            "Samples for each destination by what "
+                            "happened to them");
+      for (const PublisherSinkStatistics& sink : metrics_sinks) {
+        metrics_writer.sample(
+            "quietwind_publisher_samples_total",
+            format("sink=\"{}\",result=\"published\"", sink.name_),
+            sink.published_);
+        metrics_writer.sample(
+            "quietwind_publisher_samples_total",
+            format("sink=\"{}\",result=\"skipped\"", sink.name_),
+            sink.skipped_);
+        metrics_writer.sample(
+            "quietwind_publisher_samples_total",
+            format("sink=\"{}\",result=\"failed\"", sink.name_),
+            sink.failed_);
+        metrics_writer.sample(
+            "quietwind_publisher_samples_total",
+            format("sink=\"{}\",result=\"dropped\"", sink.name_),
+            sink.dropped_);
+      }
+      metrics_writer.family("quietwind_publisher_retries", "counter",
+                            "Tries for each destination that failed and "
+                            "were tried again");
+      for (const PublisherSinkStatistics& sink : metrics_sinks) {
+        metrics_writer.sample("quietwind_publisher_retries_total",
+                              format("sink=\"{}\"", sink.name_),
+                              sink.retries_);
+      }
+      metrics_writer.family("quietwind_publisher_latency_seconds", "gauge",
+                            "How long the last sample took to get to each "
+                            "destination");
+      for (const PublisherSinkStatistics& sink : metrics_sinks) {
+        metrics_writer.sample(
+            "quietwind_publisher_latency_seconds",
+            format("sink=\"{}\"", sink.name_),
+            std::chrono::duration<double>(sink.last_latency_).count());
       }
 
-      string response = wu->getHttpResponse();
+      /*
+       * The main loop itself
+       */
+      metrics_writer.family("quietwind_loop_wake_late_seconds", "histogram",
+                            "How much later than planned each sampling "
+                            "cycle started");
+      metrics_writer.histogram("quietwind_loop_wake_late_seconds", "",
+                               loop_late);
+      metrics_writer.family("quietwind_metrics_scrapes", "counter",
+                            "Scrapes of these metrics");
+      metrics_writer.sample("quietwind_metrics_scrapes_total", "",
+                            metrics_exporter.scrapes());
+      metrics_writer.family("quietwind_metrics_render_seconds", "gauge",
+                            "How long the last render of these metrics "
+                            "took");
+      metrics_writer.sample(
+          "quietwind_metrics_render_seconds", "",
+          std::chrono::duration<double>(steady_clock::now() - render_start)
+              .count());
+      metrics_writer.finish();
+      metrics_exporter.update(metrics_writer.text());
+    }
 
-      logger.log(LOG_INFO, response);
+    /*
+     * Sleep until the next sample or the next report, whichever is first.
+     * An upload that is going gets looked after while we wait, but it
+     * never holds up the next sample.
+     */
+    steady_clock::time_point wake_time =
+        min(steady_clock::now() + milliseconds(ws_sample_interval),
+            next_report);
+    if (rapid_fire_interval > 0) {
+      wake_time = min(wake_time, next_rapid_fire);
     }
+    if (live_publisher.sinkCount() > 0) {
+      wake_time = min(wake_time, next_live);
+    }
+    bool config_changed = false;
+    while ((config_changed == false) && (steady_clock::now() < wake_time)) {
+      fds.clear();
+      fds.push_back(pollfd{inotify_fd, POLLIN, 0});
+      wu_connection.addPollFds(fds);
+      rapid_fire_connection.addPollFds(fds);
 
-    wu->reset();
+      auto until_wake =
+          duration_cast<milliseconds>(wake_time - steady_clock::now());
+      int poll_timeout = max(0, static_cast<int>(until_wake.count()));
+      int upload_timeout = wu_connection.timeout();
+      if (upload_timeout >= 0) {
+        poll_timeout = min(poll_timeout, upload_timeout);
+      }
+      int rapid_fire_timeout = rapid_fire_connection.timeout();
+      if (rapid_fire_timeout >= 0) {
+        poll_timeout = min(poll_timeout, rapid_fire_timeout);
+      }
+      int queue_timeout = upload_queue.timeout(steady_clock::now());
+      if ((queue_timeout >= 0) && (wu_connection.busy() == false)) {
+        poll_timeout = min(poll_timeout, queue_timeout);
+      }
+
+      int poll_cnt = poll(fds.data(), fds.size(), poll_timeout);
+      if ((poll_cnt > 0) && ((fds[0].revents & POLLIN) != 0)) {
+        /*
+         * Read the inotify events so the fd doesn't stay readable
+         */
+        char events[sizeof(struct inotify_event) + NAME_MAX + 1];
+        read(inotify_fd, events, sizeof(events));
+        config_changed = true;
+      }
+      wu_connection.process(span<const pollfd>(fds).subspan(1));
+      rapid_fire_connection.process(span<const pollfd>(fds).subspan(1));
+      send_queued_report();
+    }
+    planned_wake =
+        (config_changed == true) ? steady_clock::time_point() : wake_time;
 
-    int poll_cnt = poll(fds, 1, reporting_loop_interval);
     /*
-     * If poll_cnt is zero it means the configuration file was
-     * not updated and we can just cycle through and gather
+     * If the config didn't change we can just cycle through and gather
      * another set of data.
      */
-    if (poll_cnt != 0 || (pwu_name == "" || pwu_password == "")) {
-      delete wu;
+    if (config_changed == true ||
+        (report_due == true && (pwu_name == "" || pwu_password == ""))) {
       /*
        * If we got here it means the configuration file was
        * changed. Or the authentication was invalid. So, we have to
@@ -397,16 +1682,42 @@ int main(int argc, char* argv[]) {
           (wu_json_config.isMember("pwu_password") == false)) {
         logger.log(LOG_INFO, "Unable to parse Weather Underground config file");
       } else {
+        delete wu;
         pwu_name = wu_json_config["pwu_name"].asString();
         pwu_password = wu_json_config["pwu_password"].asString();
-        wu = new WeatherUnderground(pwu_name, pwu_password);
+        wu = new WeatherUnderground(pwu_name, pwu_password, &wu_connection);
+      }
+      pwu_url = wu_url;
+      if (wu_json_config.isMember("wu_url") == true) {
+        pwu_url = wu_json_config["wu_url"].asString();
       }
+      pwu_rapid_fire_url = wu_rapid_fire_url;
+      if (wu_json_config.isMember("rapid_fire_url") == true) {
+        pwu_rapid_fire_url = wu_json_config["rapid_fire_url"].asString();
+      }
+      wu->setUrl(pwu_url);
       reporting_loop_interval = wu_default_report_interval;
       if (wu_json_config.isMember("report_interval") == true) {
         reporting_loop_interval = min(
-          max(wu_report_interval_min, json_config["report_interval"].asInt()),
+          max(wu_report_interval_min, wu_json_config["report_interval"].asInt()),
           wu_report_interval_max);
       }
+      rate_controller.setBaseInterval(milliseconds(reporting_loop_interval));
+      if (rate_controller.suspended() == true) {
+        logger.log(LOG_INFO, "Config changed, uploads resumed");
+        rate_controller.resume();
+      }
+      rapid_fire_interval = 0;
+      if (wu_json_config.isMember("rapid_fire_interval") == true) {
+        rapid_fire_interval = wu_json_config["rapid_fire_interval"].asInt();
+        if (rapid_fire_interval > 0) {
+          rapid_fire_interval =
+              max(wu_report_interval_min, rapid_fire_interval);
+        }
+      }
+      rapid_fire.setStation(pwu_name, pwu_password,
+                            milliseconds(rapid_fire_interval),
+                            pwu_rapid_fire_url);
     }
   }
 }
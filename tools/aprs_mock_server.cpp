@@ -0,0 +1,330 @@
+/*
+ * A stand in for an APRS-IS server, enough of one to point the station's
+ * CWOP publisher at and see what it does.
+ *
+ * It says hello the way aprsc does, takes the user line and answers it
+ * with a logresp, verified if the passcode goes with the callsign and
+ * unverified if it doesn't, which is what CWOP stations get with -1. Each
+ * line after that has to be a weather packet from the callsign that
+ * logged in, they're checked and counted.
+ *
+ * Things can be made to go wrong:
+ *   -a seconds  send a # keepalive comment this often, like a real server
+ *   -k count    hang up on a client after this many packets
+ *   -r count    hang up on the first count connections straight away
+ *   -v          print every line
+ *
+ * The counts are printed when it is stopped with ^C.
+ *
+ * Usage: aprs_mock_server [-p port] [-a seconds] [-k count] [-r count] [-v]
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::string_view;
+using std::vector;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+constexpr int default_port = 14580;
+
+struct ServerConfig {
+  int port = default_port;
+  int keepalive = 0;  // seconds
+  uint64_t hang_up_after = 0;
+  uint64_t refuse = 0;
+  bool verbose = false;
+};
+
+struct Client {
+  int fd;
+  string in;
+  string callsign;  // once logged in
+  uint64_t packets = 0;
+  steady_clock::time_point next_keepalive;
+};
+
+struct ServerCounts {
+  uint64_t connections = 0;
+  uint64_t refused = 0;
+  uint64_t logins = 0;
+  uint64_t verified = 0;
+  uint64_t packets = 0;
+  uint64_t bad_packets = 0;
+  uint64_t keepalives = 0;
+  uint64_t hang_ups = 0;
+};
+
+static volatile sig_atomic_t stop = 0;
+
+static void stopHandler(int) {
+
+  stop = 1;
+
+  return;
+}
+
+/*
+ * The APRS-IS passcode, a hash of the callsign without its SSID
+ */
+static int passcode(string_view callsign) {
+  int hash = 0x73e2;
+  string upper;
+
+  for (char c : callsign.substr(0, callsign.find('-'))) {
+    upper.push_back(static_cast<char>(toupper(c)));
+  }
+  for (size_t i = 0; i < upper.size(); i += 2) {
+    hash ^= upper[i] << 8;
+    if (i + 1 < upper.size()) {
+      hash ^= upper[i + 1];
+    }
+  }
+
+  return hash & 0x7fff;
+}
+
+static void sendLine(int fd, const string& line) {
+  string out = line + "\r\n";
+
+  /*
+   * Lines are short and the client reads them, a non blocking write that
+   * doesn't all go is somebody else's problem
+   */
+  if (write(fd, out.data(), out.size()) < 0) {
+    perror("write");
+  }
+
+  return;
+}
+
+/*
+ * "user CALL pass CODE vers NAME VERSION"
+ */
+static bool handleLogin(Client& client, const string& line,
+                        ServerCounts& counts) {
+  static const std::regex user_line(
+      "user ([A-Za-z0-9-]+) pass (-?[0-9]+)( vers .*)?");
+  std::smatch match;
+
+  if (std::regex_match(line, match, user_line) == false) {
+    sendLine(client.fd, "# logresp unknown unverified, server MOCK");
+    return false;
+  }
+  client.callsign = match[1].str();
+  bool verified = (atoi(match[2].str().c_str()) == passcode(client.callsign));
+  counts.logins++;
+  if (verified == true) {
+    counts.verified++;
+  }
+  sendLine(client.fd, "# logresp " + client.callsign +
+                          (verified ? " verified" : " unverified") +
+                          ", server MOCK");
+
+  return true;
+}
+
+/*
+ * CALL>APRS,TCPIP*:@DDHHMMzDDMM.mmN/DDDMM.mmW_ddd/sssgggtTTT[hHH][bBBBBB]...
+ */
+static bool goodPacket(const Client& client, const string& line) {
+  static const std::regex weather(
+      "([A-Za-z0-9-]+)>APRS,TCPIP\\*:@[0-9]{6}z"
+      "[0-9]{4}\\.[0-9]{2}[NS]/[0-9]{5}\\.[0-9]{2}[EW]_"
+      "([0-9]{3}|\\.\\.\\.)/([0-9]{3}|\\.\\.\\.)g([0-9]{3}|\\.\\.\\.)"
+      "t(-[0-9]{2}|[0-9]{3}|\\.\\.\\.)(h[0-9]{2})?(b[0-9]{5})?.*");
+  std::smatch match;
+
+  if (std::regex_match(line, match, weather) == false) {
+    return false;
+  }
+
+  return match[1].str() == client.callsign;
+}
+
+/*
+ * Every whole line in client.in. Returns false if the client has to go.
+ */
+static bool handleLines(Client& client, const ServerConfig& config,
+                        ServerCounts& counts) {
+  size_t end;
+
+  while ((end = client.in.find('\n')) != string::npos) {
+    string line = client.in.substr(0, end);
+    client.in.erase(0, end + 1);
+    if ((line.empty() == false) && (line.back() == '\r')) {
+      line.pop_back();
+    }
+    if (config.verbose == true) {
+      printf("%d %s\n", client.fd, line.c_str());
+    }
+
+    if (client.callsign.empty() == true) {
+      if (handleLogin(client, line, counts) == false) {
+        return false;
+      }
+      continue;
+    }
+    if (line.starts_with("#") == true) {
+      continue;
+    }
+
+    counts.packets++;
+    client.packets++;
+    if (goodPacket(client, line) == false) {
+      counts.bad_packets++;
+      printf("%d bad packet: %s\n", client.fd, line.c_str());
+    }
+    if ((config.hang_up_after > 0) &&
+        (client.packets >= config.hang_up_after)) {
+      counts.hang_ups++;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  ServerConfig config;
+
+  while ((opt = getopt(argc, argv, "p:a:k:r:v")) != -1) {
+    switch (opt) {
+      case 'p':
+        config.port = atoi(optarg);
+        break;
+      case 'a':
+        config.keepalive = atoi(optarg);
+        break;
+      case 'k':
+        config.hang_up_after = strtoull(optarg, nullptr, 10);
+        break;
+      case 'r':
+        config.refuse = strtoull(optarg, nullptr, 10);
+        break;
+      case 'v':
+        config.verbose = true;
+        break;
+      default:
+        printf("Usage: aprs_mock_server [-p port] [-a seconds] [-k count] "
+               "[-r count] [-v]\n");
+        exit(1);
+    }
+  }
+
+  int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int on = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(config.port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if ((bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+            sizeof(address)) != 0) ||
+      (listen(listen_fd, SOMAXCONN) != 0)) {
+    printf("Can't listen on port %d: %s\n", config.port, strerror(errno));
+    exit(1);
+  }
+  printf("Listening on 127.0.0.1:%d\n", config.port);
+  fflush(stdout);
+
+  /*
+   * No SA_RESTART so poll() comes back when we're stopped
+   */
+  struct sigaction action = {};
+  action.sa_handler = stopHandler;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  ServerCounts counts;
+  map<int, Client> clients;
+  vector<pollfd> fds;
+
+  while (stop == 0) {
+    auto now = steady_clock::now();
+    int timeout = -1;
+
+    fds.clear();
+    fds.push_back(pollfd{listen_fd, POLLIN, 0});
+    for (auto& [fd, client] : clients) {
+      fds.push_back(pollfd{fd, POLLIN, 0});
+      if (config.keepalive > 0) {
+        if (now >= client.next_keepalive) {
+          sendLine(fd, "# aprsc mock keepalive");
+          counts.keepalives++;
+          client.next_keepalive = now + seconds(config.keepalive);
+        }
+        int wait = static_cast<int>(
+            std::chrono::ceil<std::chrono::milliseconds>(
+                client.next_keepalive - now)
+                .count());
+        timeout = (timeout < 0) ? wait : std::min(timeout, wait);
+      }
+    }
+
+    if (poll(fds.data(), fds.size(), timeout) < 0) {
+      continue;
+    }
+
+    if ((fds[0].revents & POLLIN) != 0) {
+      int fd;
+      while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+        counts.connections++;
+        if (counts.refused < config.refuse) {
+          counts.refused++;
+          close(fd);
+          continue;
+        }
+        clients[fd] = {};
+        clients[fd].fd = fd;
+        clients[fd].next_keepalive = now + seconds(config.keepalive);
+        sendLine(fd, "# aprsc mock");
+      }
+    }
+
+    for (size_t i = 1; i < fds.size(); i++) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+      Client& client = clients[fds[i].fd];
+      char buffer[4096];
+      ssize_t n = read(client.fd, buffer, sizeof(buffer));
+      bool closed = (n <= 0);
+      if (closed == false) {
+        client.in.append(buffer, n);
+        closed = (handleLines(client, config, counts) == false);
+      }
+      if (closed == true) {
+        close(client.fd);
+        clients.erase(fds[i].fd);
+      }
+    }
+  }
+
+  printf("\nConnections: %lu, refused %lu, hung up on %lu\n",
+         counts.connections, counts.refused, counts.hang_ups);
+  printf("Logins: %lu, verified %lu\n", counts.logins, counts.verified);
+  printf("Packets: %lu, bad %lu\n", counts.packets, counts.bad_packets);
+  printf("Keepalives sent: %lu\n", counts.keepalives);
+
+  return 0;
+}
@@ -0,0 +1,231 @@
+/*
+ * Check and time the batch conversion kernels.
+ * Every possible SHT4x and LPS22 temperature count, and every 24 bit LPS22
+ * pressure count, is converted with the vector kernels and with the scalar
+ * ones and the results compared bit for bit. The base values are then
+ * converted to Fahrenheit and inHg the same way.
+ * Last the temperatures go into a TemperatureSeries and are converted from
+ * there, next to the same readings converted one TemperatureMeasurement at
+ * a time out of a vector.
+ *
+ * Usage: batch_conversion_benchmark [-r repeats]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "include/batch_conversion.h"
+
+using qw_devices::BATCH_CONVERSION_SCALAR;
+using qw_devices::BatchConversionKernel;
+using qw_devices::batchConversionKernel;
+using qw_devices::batchConversionKernelName;
+using qw_devices::setBatchConversionKernel;
+using qw_units::Celsius;
+using qw_units::TemperatureMeasurement;
+using qw_units::TemperatureSeries;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::high_resolution_clock;
+using std::chrono::nanoseconds;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+constexpr int default_repeat_count = 10;
+constexpr int32_t lps22_pressure_min = -(1 << 23);
+constexpr int32_t lps22_pressure_max = (1 << 23) - 1;
+
+/*
+ * Run the conversion with the scalar kernel and then with the vector one,
+ * print the time per value for each and compare the outputs.
+ */
+template <typename Out>
+int compare(const char* name, size_t count, int repeat_count,
+            BatchConversionKernel kernel,
+            std::function<void(Out*)> convert) {
+  vector<Out> scalar(count);
+  vector<Out> vector_result(count);
+  double per_value[2];
+
+  for (int pass = 0; pass < 2; pass++) {
+    Out* out = (pass == 0) ? scalar.data() : vector_result.data();
+    setBatchConversionKernel((pass == 0) ? BATCH_CONVERSION_SCALAR : kernel);
+
+    auto start = high_resolution_clock::now();
+    for (int r = 0; r < repeat_count; r++) {
+      convert(out);
+    }
+    auto elapsed = duration_cast<nanoseconds>(high_resolution_clock::now() -
+                                              start);
+    per_value[pass] =
+        static_cast<double>(elapsed.count()) / (count * repeat_count);
+  }
+
+  int errors = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (memcmp(&scalar[i], &vector_result[i], sizeof(Out)) != 0) {
+      if (errors < 10) {
+        printf("%s: mismatch at %zu\n", name, i);
+      }
+      errors++;
+    }
+  }
+
+  printf("%-24s %9zu values  scalar %6.2f ns  %s %6.2f ns  %s\n", name, count,
+         per_value[0], batchConversionKernelName(kernel), per_value[1],
+         (errors == 0) ? "identical" : "MISMATCH");
+
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  int repeat_count = default_repeat_count;
+
+  while ((opt = getopt(argc, argv, "r:")) != -1) {
+    switch (opt) {
+      case 'r':
+        repeat_count = atoi(optarg);
+        break;
+      default:
+        printf("Usage: batch_conversion_benchmark [-r repeats]\n");
+        exit(1);
+    }
+  }
+  if (repeat_count < 1) {
+    repeat_count = 1;
+  }
+
+  BatchConversionKernel kernel = batchConversionKernel();
+  printf("Best kernel: %s\n", batchConversionKernelName(kernel));
+
+  vector<uint16_t> sht4x_raw(1 << 16);
+  vector<int16_t> lps22_temperature_raw(1 << 16);
+  for (size_t i = 0; i < sht4x_raw.size(); i++) {
+    sht4x_raw[i] = i;
+    lps22_temperature_raw[i] = static_cast<int16_t>(i);
+  }
+
+  vector<int32_t> lps22_pressure_raw;
+  lps22_pressure_raw.reserve(1 << 24);
+  for (int32_t raw = lps22_pressure_min; raw <= lps22_pressure_max; raw++) {
+    lps22_pressure_raw.push_back(raw);
+  }
+
+  vector<int64_t> temperature_base(sht4x_raw.size());
+  vector<int64_t> pressure_base(lps22_pressure_raw.size());
+  int errors = 0;
+
+  errors += compare<int64_t>(
+      "sht4x temperature", sht4x_raw.size(), repeat_count, kernel,
+      [&](int64_t* out) {
+        qw_devices::sht4xTemperatureToBase(sht4x_raw.data(), out,
+                                           sht4x_raw.size());
+      });
+  errors += compare<int64_t>(
+      "sht4x humidity", sht4x_raw.size(), repeat_count, kernel,
+      [&](int64_t* out) {
+        qw_devices::sht4xHumidityToBase(sht4x_raw.data(), out,
+                                        sht4x_raw.size());
+      });
+  errors += compare<int64_t>(
+      "lps22 temperature", lps22_temperature_raw.size(), repeat_count, kernel,
+      [&](int64_t* out) {
+        qw_devices::lps22TemperatureToBase(lps22_temperature_raw.data(), out,
+                                           lps22_temperature_raw.size());
+      });
+  errors += compare<int64_t>(
+      "lps22 pressure", lps22_pressure_raw.size(), 1, kernel,
+      [&](int64_t* out) {
+        qw_devices::lps22PressureToBase(lps22_pressure_raw.data(), out,
+                                        lps22_pressure_raw.size());
+      });
+
+  /*
+   * Feed the base values we just made through the display conversions
+   */
+  setBatchConversionKernel(BATCH_CONVERSION_SCALAR);
+  qw_devices::sht4xTemperatureToBase(sht4x_raw.data(), temperature_base.data(),
+                                     sht4x_raw.size());
+  qw_devices::lps22PressureToBase(lps22_pressure_raw.data(),
+                                  pressure_base.data(),
+                                  lps22_pressure_raw.size());
+
+  errors += compare<float>(
+      "base to fahrenheit", temperature_base.size(), repeat_count, kernel,
+      [&](float* out) {
+        qw_devices::baseToFahrenheit(temperature_base.data(), out,
+                                     temperature_base.size());
+      });
+  errors += compare<float>(
+      "base to inHg", pressure_base.size(), 1, kernel, [&](float* out) {
+        qw_devices::baseToInchesMercury(pressure_base.data(), out,
+                                        pressure_base.size());
+      });
+
+  /*
+   * The series path against the array of measurements
+   */
+  setBatchConversionKernel(kernel);
+  time_point<system_clock> epoch = system_clock::now();
+  vector<time_point<system_clock>> times(sht4x_raw.size());
+  vector<TemperatureMeasurement> measurements;
+  for (size_t i = 0; i < times.size(); i++) {
+    times[i] = epoch + seconds(i);
+    measurements.emplace_back(Celsius::fromBase(temperature_base[i]),
+                              Celsius(0.2f), times[i]);
+  }
+
+  TemperatureSeries series;
+  series.reserve(sht4x_raw.size());
+  qw_devices::sht4xTemperatureToSeries(sht4x_raw.data(), times, series);
+  for (size_t i = 0; i < series.size(); i++) {
+    if ((series[i].time() != times[i]) ||
+        (series[i].value().baseValue() != temperature_base[i])) {
+      printf("series: mismatch at %zu\n", i);
+      errors++;
+    }
+  }
+
+  vector<float> series_fahrenheit(series.size());
+  vector<float> measurement_fahrenheit(measurements.size());
+  auto start = high_resolution_clock::now();
+  for (int r = 0; r < repeat_count; r++) {
+    qw_devices::baseToFahrenheit(series.view(), series_fahrenheit.data());
+  }
+  auto series_elapsed =
+      duration_cast<nanoseconds>(high_resolution_clock::now() - start);
+  start = high_resolution_clock::now();
+  for (int r = 0; r < repeat_count; r++) {
+    for (size_t i = 0; i < measurements.size(); i++) {
+      measurement_fahrenheit[i] = measurements[i].fahrenheitValue().value();
+    }
+  }
+  auto measurement_elapsed =
+      duration_cast<nanoseconds>(high_resolution_clock::now() - start);
+  if (memcmp(series_fahrenheit.data(), measurement_fahrenheit.data(),
+             series_fahrenheit.size() * sizeof(float)) != 0) {
+    printf("series: fahrenheit differs from the measurements\n");
+    errors++;
+  }
+  printf("%-24s %9zu values  series %6.2f ns  measurements %6.2f ns\n",
+         "series to fahrenheit", series.size(),
+         static_cast<double>(series_elapsed.count()) /
+             (series.size() * repeat_count),
+         static_cast<double>(measurement_elapsed.count()) /
+             (measurements.size() * repeat_count));
+
+  if (errors != 0) {
+    printf("%d values differ from the scalar path\n", errors);
+    exit(1);
+  }
+
+  printf("All kernels match the scalar path\n");
+
+  return 0;
+}
@@ -0,0 +1,392 @@
+/*
+ * Run the CWOP publisher against tools/aprs_mock_server and check what
+ * the server got.
+ *
+ * The server is started here, with -v so it prints every line that comes
+ * in, and its output is read back once it has been stopped. Samples are
+ * published one after another with CwopSink and then the output is
+ * checked for:
+ *   - the login line, exactly what APRS-IS expects
+ *   - every packet that was published, in order, as CwopSink::packet()
+ *     made it, and none the server calls bad
+ *   - the connection being kept open, every packet after a login comes
+ *     in on that login's connection and there are no more connections
+ *     than the server's hang ups (-k) make necessary
+ * Before any of that the packet format is checked against a couple of
+ * packets written out by hand.
+ *
+ * APRS-IS never acks anything, so a packet written just as the server
+ * hangs up is gone without the sink knowing. The packets go interval
+ * apart so the server has read each one before the next goes, and a hang
+ * up is seen by the sink before it sends again.
+ *
+ * Usage: cwop_sink_driver [-s aprs_mock_server] [-p port] [-n packets]
+ *                         [-k count] [-i interval ms]
+ */
+#include <errno.h>
+#include <fmt/format.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "include/cwop_sink.h"
+
+using qw_units::Fahrenheit;
+using std::map;
+using std::string;
+using std::string_view;
+using std::vector;
+using std::chrono::hours;
+using std::chrono::minutes;
+using std::chrono::system_clock;
+
+constexpr int default_port = 14599;
+constexpr size_t default_packet_count = 200;
+constexpr milliseconds default_interval = milliseconds(10);
+
+/*
+ * How many times a sample is tried before it counts as lost, and how
+ * long between tries
+ */
+constexpr int publish_tries = 20;
+constexpr milliseconds publish_retry_wait = milliseconds(50);
+
+constexpr char driver_callsign[] = "CW0001";
+constexpr char driver_version[] = "driver";
+
+/*
+ * The server's output, read as it comes so it never fills the pipe
+ */
+static void readOutput(int fd, string* output) {
+  char buffer[4096];
+  ssize_t n;
+
+  while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+    output->append(buffer, n);
+  }
+
+  return;
+}
+
+static pid_t startServer(const string& server, int port, const string& hang_up,
+                         int& output_fd) {
+  int pipe_fds[2];
+
+  if (pipe(pipe_fds) != 0) {
+    return -1;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    string port_arg = std::to_string(port);
+    dup2(pipe_fds[1], STDOUT_FILENO);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    if (hang_up.empty() == true) {
+      execl(server.c_str(), server.c_str(), "-p", port_arg.c_str(), "-v",
+            nullptr);
+    } else {
+      execl(server.c_str(), server.c_str(), "-p", port_arg.c_str(), "-v",
+            "-k", hang_up.c_str(), nullptr);
+    }
+    _exit(127);
+  }
+  close(pipe_fds[1]);
+  output_fd = pipe_fds[0];
+
+  return pid;
+}
+
+/*
+ * Up to and including the first line, so we know the server is there
+ */
+static string firstLine(int fd) {
+  string line;
+  char c;
+
+  while ((read(fd, &c, 1) == 1) && (c != '\n')) {
+    line.push_back(c);
+  }
+
+  return line;
+}
+
+static int comparePacket(const char* what, string_view actual,
+                         const char* expected) {
+
+  if (actual != expected) {
+    printf("Packet for %s is \"%.*s\", should be \"%s\"\n", what,
+           static_cast<int>(actual.size()), actual.data(), expected);
+    return 1;
+  }
+
+  return 0;
+}
+
+/*
+ * Packets written out by hand, so a change in the format shows up
+ */
+static int checkFormat(CwopSinkConfig config) {
+  int errors = 0;
+  CwopSink sink(config);
+  PublishedSample sample;
+
+  sample.time_ =
+      std::chrono::sys_days{std::chrono::year{2024} / 3 / 15} + hours(18) +
+      minutes(30);
+  sample.temperature_ = Fahrenheit(-4.6f);
+  sample.humidity_ = RelativeHumidity(99.7f);
+  sample.sea_level_pressure_ = Millibar(1013.24f);
+  sample.wind_direction_ = 359.6f;
+  sample.wind_speed_avg_ = MilesPerHour(4.2f);
+  sample.wind_gust_ = MilesPerHour(9.0f);
+  errors += comparePacket(
+      "cold, humid and north", sink.packet(sample),
+      "CW0001>APRS,TCPIP*:@151830z4903.50N/07201.75W_360/004g009t-05h00"
+      "b10132quietwind");
+
+  sample.temperature_ = Fahrenheit(72.5f);
+  sample.humidity_ = RelativeHumidity(45.0f);
+  sample.wind_direction_.reset();
+  sample.wind_speed_avg_.reset();
+  sample.wind_gust_.reset();
+  sample.sea_level_pressure_.reset();
+  errors += comparePacket(
+      "warm with no wind or pressure", sink.packet(sample),
+      "CW0001>APRS,TCPIP*:@151830z4903.50N/07201.75W_.../...g...t073h45"
+      "quietwind");
+
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  string server;
+  int port = default_port;
+  size_t count = default_packet_count;
+  string hang_up;
+  milliseconds interval = default_interval;
+
+  while ((opt = getopt(argc, argv, "s:p:n:k:i:")) != -1) {
+    switch (opt) {
+      case 's':
+        server = optarg;
+        break;
+      case 'p':
+        port = atoi(optarg);
+        break;
+      case 'n':
+        count = strtoull(optarg, nullptr, 10);
+        break;
+      case 'k':
+        hang_up = optarg;
+        break;
+      case 'i':
+        interval = milliseconds(atoi(optarg));
+        break;
+      default:
+        printf("Usage: cwop_sink_driver [-s aprs_mock_server] [-p port] "
+               "[-n packets] [-k count] [-i interval ms]\n");
+        exit(1);
+    }
+  }
+
+  /*
+   * Next to this program unless we're told otherwise
+   */
+  if (server.empty() == true) {
+    string self(argv[0]);
+    size_t slash = self.rfind('/');
+    server = ((slash == string::npos) ? string("./")
+                                      : self.substr(0, slash + 1)) +
+             "aprs_mock_server";
+  }
+
+  CwopSinkConfig config;
+  config.host_ = "127.0.0.1";
+  config.port_ = static_cast<uint16_t>(port);
+  config.callsign_ = driver_callsign;
+  config.passcode_ = "-1";
+  config.latitude_ = 49.0583;
+  config.longitude_ = -72.0292;
+  config.version_ = driver_version;
+  config.min_interval_ = milliseconds(0);
+  config.timeout_ = milliseconds(2000);
+  config.retry_initial_ = milliseconds(20);
+  config.retry_max_ = milliseconds(200);
+
+  int errors = checkFormat(config);
+
+  int output_fd = -1;
+  pid_t pid = startServer(server, port, hang_up, output_fd);
+  if (pid < 0) {
+    printf("Can't start %s: %s\n", server.c_str(), strerror(errno));
+    exit(1);
+  }
+  string listening = firstLine(output_fd);
+  if (listening.starts_with("Listening on") == false) {
+    printf("%s didn't start: %s\n", server.c_str(), listening.c_str());
+    waitpid(pid, nullptr, 0);
+    exit(1);
+  }
+  string output;
+  std::thread reader(readOutput, output_fd, &output);
+
+  /*
+   * Publish, keeping every packet that went
+   */
+  vector<string> sent;
+  map<int, size_t> failures;  // by errno
+  size_t lost = 0;
+  {
+    CwopSink sink(config);
+
+    for (size_t n = 0; n < count; n++) {
+      PublishedSample sample;
+      sample.time_ = system_clock::now();
+      sample.temperature_ =
+          Fahrenheit(-20.0f + static_cast<float>(n % 120) * 0.9f);
+      sample.humidity_ =
+          RelativeHumidity(static_cast<float>(n % 100) + 0.4f);
+      sample.sea_level_pressure_ =
+          Millibar(990.0f + static_cast<float>(n % 50));
+      sample.wind_direction_ = static_cast<float>((n * 7) % 360);
+      sample.wind_speed_avg_ = MilesPerHour(static_cast<float>(n % 30));
+      sample.wind_gust_ = MilesPerHour(static_cast<float>(n % 45));
+
+      bool published = false;
+      for (int tries = 0; (tries < publish_tries) && (published == false);
+           tries++) {
+        auto x_published = sink.publish(sample);
+        if (x_published.has_value() == true) {
+          published = true;
+        } else {
+          failures[x_published.error()]++;
+          std::this_thread::sleep_for(publish_retry_wait);
+        }
+      }
+      if (published == true) {
+        sent.push_back(string(sink.packet(sample)));
+      } else {
+        lost++;
+      }
+      std::this_thread::sleep_for(interval);
+    }
+  }
+
+  /*
+   * Give the server a moment to read the last of it, then stop it
+   */
+  std::this_thread::sleep_for(milliseconds(200));
+  kill(pid, SIGINT);
+  reader.join();
+  close(output_fd);
+  waitpid(pid, nullptr, 0);
+
+  /*
+   * The lines the server got are "fd line", the counts come after
+   */
+  string login_line = fmt::format("user {} pass -1 vers quietwind {}",
+                                  driver_callsign, driver_version);
+  vector<string> received;
+  size_t logins = 0;
+  size_t bad_packets = 0;
+  size_t wrong_connection = 0;
+  uint64_t connections = 0;
+  int login_fd = -1;
+  size_t at = 0;
+  while (at < output.size()) {
+    size_t end = output.find('\n', at);
+    if (end == string::npos) {
+      end = output.size();
+    }
+    string line = output.substr(at, end - at);
+    at = end + 1;
+
+    int fd = -1;
+    int used = 0;
+    if (sscanf(line.c_str(), "Connections: %lu", &connections) == 1) {
+      continue;
+    }
+    if (sscanf(line.c_str(), "%d %n", &fd, &used) != 1) {
+      continue;
+    }
+    string text = line.substr(used);
+    if (text.starts_with("bad packet") == true) {
+      bad_packets++;
+    } else if (text.starts_with("user ") == true) {
+      logins++;
+      login_fd = fd;
+      if (text != login_line) {
+        printf("Login line is \"%s\", should be \"%s\"\n", text.c_str(),
+               login_line.c_str());
+        errors++;
+      }
+    } else if (text.find(">APRS,") != string::npos) {
+      received.push_back(text);
+      if (fd != login_fd) {
+        wrong_connection++;
+      }
+    }
+  }
+
+  size_t mismatched = 0;
+  for (size_t i = 0; i < std::max(sent.size(), received.size()); i++) {
+    if ((i >= sent.size()) || (i >= received.size()) ||
+        (sent[i] != received[i])) {
+      if (mismatched < 5) {
+        printf("Packet %zu went as \"%s\" and came as \"%s\"\n", i,
+               (i < sent.size()) ? sent[i].c_str() : "",
+               (i < received.size()) ? received[i].c_str() : "");
+      }
+      mismatched++;
+    }
+  }
+
+  /*
+   * One connection for the lot, or one for every -k packets
+   */
+  uint64_t per_connection =
+      (hang_up.empty() == true) ? 0 : strtoull(hang_up.c_str(), nullptr, 10);
+  uint64_t most_connections =
+      (per_connection == 0)
+          ? 1
+          : (sent.size() + per_connection - 1) / per_connection;
+
+  printf("%zu published, %zu lost, %zu received, %zu logins, "
+         "%lu connections\n",
+         sent.size(), lost, received.size(), logins, connections);
+  for (const auto& [error, failed] : failures) {
+    printf("Failed %zu: %s\n", failed, strerror(error));
+  }
+  if (logins == 0) {
+    printf("Never logged in\n");
+    errors++;
+  }
+  if ((mismatched != 0) || (bad_packets != 0) || (lost != 0)) {
+    printf("%zu packets didn't match, %zu bad\n", mismatched, bad_packets);
+    errors++;
+  }
+  if ((wrong_connection != 0) || (connections != logins) ||
+      (connections > most_connections)) {
+    printf("The connection wasn't kept: %zu packets on another connection, "
+           "at most %lu connections should do\n",
+           wrong_connection, most_connections);
+    errors++;
+  }
+
+  printf("%d errors\n", errors);
+  if (errors != 0) {
+    exit(1);
+  }
+
+  return 0;
+}
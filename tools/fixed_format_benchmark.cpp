@@ -0,0 +1,279 @@
+/*
+ * Check and time qw_units::formatFixed().
+ * Formats a set of readings the way the WU fields and the unit formatters
+ * used to, fmt::format() with a run time format string into a new string,
+ * and with formatFixed(), from the float and from the unit base value.
+ * Every result is compared. -x also compares every float there is at the
+ * precisions the WU fields use.
+ *
+ * Usage: fixed_format_benchmark [-n values] [-x]
+ */
+#include <fmt/compile.h>
+#include <fmt/format.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "celsius.h"
+#include "fixed_format.h"
+#include "inches_mercury.h"
+#include "millibar.h"
+#include "relative_humidity.h"
+
+using qw_units::Celsius;
+using qw_units::formatFixed;
+using qw_units::InchesMercury;
+using qw_units::kFixedFormatBufferSize;
+using qw_units::Millibar;
+using qw_units::RelativeHumidity;
+using std::string;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::high_resolution_clock;
+using std::chrono::nanoseconds;
+
+constexpr size_t default_value_count = 1000000;
+
+/*
+ * Time one way of formatting all the values, keep what it made
+ */
+template <typename Format>
+double timeFormat(size_t count, vector<string>& results, Format format) {
+
+  results.clear();
+  results.reserve(count);
+
+  auto start = high_resolution_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    results.push_back(format(i));
+  }
+  auto elapsed =
+      duration_cast<nanoseconds>(high_resolution_clock::now() - start);
+
+  return static_cast<double>(elapsed.count()) / count;
+}
+
+/*
+ * Time the buffer path without building strings, so it's the formatting
+ * and nothing else. The lengths are summed so the work isn't thrown away.
+ */
+template <typename Format>
+double timeBuffer(size_t count, Format format) {
+  char buffer[kFixedFormatBufferSize];
+  size_t total = 0;
+
+  auto start = high_resolution_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    total += format(i, buffer);
+    asm volatile("" : : "r"(buffer) : "memory");
+  }
+  auto elapsed =
+      duration_cast<nanoseconds>(high_resolution_clock::now() - start);
+  if (total == 0) {
+    printf("Nothing formatted\n");
+  }
+
+  return static_cast<double>(elapsed.count()) / count;
+}
+
+int compareResults(const char* name, const vector<string>& expected,
+                   const vector<string>& actual) {
+  int errors = 0;
+
+  for (size_t i = 0; i < expected.size(); i++) {
+    if (expected[i] != actual[i]) {
+      if (errors < 5) {
+        printf("%s: \"%s\" should be \"%s\"\n", name, actual[i].c_str(),
+               expected[i].c_str());
+      }
+      errors++;
+    }
+  }
+
+  return errors;
+}
+
+/*
+ * Every float, against fmt with the format compiled in
+ */
+template <int Precision>
+int compareAllFloats() {
+  static constexpr char spec[] = {'{', ':', '.', '0' + Precision,
+                                  'f', '}', '\0'};
+  char expected[kFixedFormatBufferSize];
+  char actual[kFixedFormatBufferSize];
+  int errors = 0;
+
+  for (uint64_t bits = 0; bits < (1ull << 32); bits++) {
+    uint32_t value_bits = static_cast<uint32_t>(bits);
+    float value;
+    memcpy(&value, &value_bits, sizeof(value));
+
+    size_t expected_length =
+        fmt::format_to_n(expected, sizeof(expected), FMT_COMPILE(spec), value)
+            .size;
+    size_t actual_length = formatFixed<Precision>(actual, sizeof(actual),
+                                                  value);
+    if ((expected_length != actual_length) ||
+        (memcmp(expected, actual,
+                std::min(expected_length, sizeof(expected))) != 0)) {
+      if (errors < 5) {
+        printf("%a at .%df: \"%.*s\" should be \"%.*s\"\n", value, Precision,
+               static_cast<int>(actual_length), actual,
+               static_cast<int>(expected_length), expected);
+      }
+      errors++;
+    }
+  }
+  printf("All floats at .%df: %d differences\n", Precision, errors);
+
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  size_t count = default_value_count;
+  bool exhaustive = false;
+
+  while ((opt = getopt(argc, argv, "n:x")) != -1) {
+    switch (opt) {
+      case 'n':
+        count = strtoull(optarg, NULL, 10);
+        break;
+      case 'x':
+        exhaustive = true;
+        break;
+      default:
+        printf("Usage: fixed_format_benchmark [-n values] [-x]\n");
+        exit(1);
+    }
+  }
+
+  /*
+   * Readings like the station takes, as unit base values
+   */
+  std::mt19937_64 rng(1);
+  std::uniform_int_distribution<int64_t> temperature(-40000, 50000);
+  std::uniform_int_distribution<int64_t> humidity(0, 10000);
+  std::uniform_int_distribution<int64_t> pressure(950000, 1050000);
+  vector<Celsius> temperatures;
+  vector<RelativeHumidity> humidities;
+  vector<Millibar> pressures;
+  for (size_t i = 0; i < count; i++) {
+    temperatures.push_back(Celsius::fromBase(temperature(rng)));
+    humidities.push_back(RelativeHumidity::fromBase(humidity(rng)));
+    pressures.push_back(Millibar::fromBase(pressure(rng)));
+  }
+
+  vector<string> expected;
+  vector<string> actual;
+  int errors = 0;
+
+  printf("%-22s %12s %12s %12s %12s\n", "", "fmt runtime", "fmt compile",
+         "fixed float", "fixed base");
+
+  /*
+   * Celsius at .2f
+   */
+  double runtime = timeFormat(count, expected, [&](size_t i) {
+    return fmt::format(fmt::runtime("{0:.2f}"), temperatures[i].value());
+  });
+  double compiled = timeBuffer(count, [&](size_t i, char* buffer) {
+    return fmt::format_to_n(buffer, kFixedFormatBufferSize,
+                            FMT_COMPILE("{0:.2f}"), temperatures[i].value())
+        .size;
+  });
+  double fixed_float = timeBuffer(count, [&](size_t i, char* buffer) {
+    return formatFixed<2>(buffer, kFixedFormatBufferSize,
+                          temperatures[i].value());
+  });
+  double fixed_base = timeBuffer(count, [&](size_t i, char* buffer) {
+    return formatFixed<2>(buffer, kFixedFormatBufferSize, temperatures[i]);
+  });
+  printf("%-22s %9.1f ns %9.1f ns %9.1f ns %9.1f ns\n", "celsius .2f", runtime,
+         compiled, fixed_float, fixed_base);
+  timeFormat(count, actual, [&](size_t i) {
+    char buffer[kFixedFormatBufferSize];
+    return string(buffer, formatFixed<2>(buffer, sizeof(buffer),
+                                         temperatures[i]));
+  });
+  errors += compareResults("celsius .2f", expected, actual);
+  timeFormat(count, actual, [&](size_t i) {
+    return fmt::format("{}", temperatures[i]);
+  });
+  errors += compareResults("celsius {}", expected, actual);
+
+  /*
+   * Relative humidity at .1f
+   */
+  runtime = timeFormat(count, expected, [&](size_t i) {
+    return fmt::format(fmt::runtime("{0:.1f}"), humidities[i].value());
+  });
+  compiled = timeBuffer(count, [&](size_t i, char* buffer) {
+    return fmt::format_to_n(buffer, kFixedFormatBufferSize,
+                            FMT_COMPILE("{0:.1f}"), humidities[i].value())
+        .size;
+  });
+  fixed_float = timeBuffer(count, [&](size_t i, char* buffer) {
+    return formatFixed<1>(buffer, kFixedFormatBufferSize,
+                          humidities[i].value());
+  });
+  fixed_base = timeBuffer(count, [&](size_t i, char* buffer) {
+    return formatFixed<1>(buffer, kFixedFormatBufferSize, humidities[i]);
+  });
+  printf("%-22s %9.1f ns %9.1f ns %9.1f ns %9.1f ns\n", "humidity .1f",
+         runtime, compiled, fixed_float, fixed_base);
+  timeFormat(count, actual, [&](size_t i) {
+    char buffer[kFixedFormatBufferSize];
+    return string(buffer,
+                  formatFixed<1>(buffer, sizeof(buffer), humidities[i]));
+  });
+  errors += compareResults("humidity .1f", expected, actual);
+
+  /*
+   * Pressure as inHg at .2f, the baromin field. InchesMercury isn't the
+   * reference unit so there is only the float path.
+   */
+  runtime = timeFormat(count, expected, [&](size_t i) {
+    return fmt::format(fmt::runtime("{0:.2f}"),
+                       InchesMercury(pressures[i]).value());
+  });
+  compiled = timeBuffer(count, [&](size_t i, char* buffer) {
+    return fmt::format_to_n(buffer, kFixedFormatBufferSize,
+                            FMT_COMPILE("{0:.2f}"),
+                            InchesMercury(pressures[i]).value())
+        .size;
+  });
+  fixed_float = timeBuffer(count, [&](size_t i, char* buffer) {
+    return formatFixed<2>(buffer, kFixedFormatBufferSize,
+                          InchesMercury(pressures[i]));
+  });
+  printf("%-22s %9.1f ns %9.1f ns %9.1f ns %12s\n", "inHg .2f", runtime,
+         compiled, fixed_float, "-");
+  timeFormat(count, actual, [&](size_t i) {
+    char buffer[kFixedFormatBufferSize];
+    return string(buffer, formatFixed<2>(buffer, sizeof(buffer),
+                                         InchesMercury(pressures[i])));
+  });
+  errors += compareResults("inHg .2f", expected, actual);
+
+  if (exhaustive == true) {
+    errors += compareAllFloats<0>();
+    errors += compareAllFloats<1>();
+    errors += compareAllFloats<2>();
+  }
+
+  if (errors != 0) {
+    printf("%d values differ from fmt\n", errors);
+    exit(1);
+  }
+
+  printf("All values match fmt\n");
+
+  return 0;
+}
@@ -0,0 +1,405 @@
+/*
+ * Check the exact integer conversions of the units, fixedValue(),
+ * fromFixed() and divideRounded(), and the QuantityAccumulator.
+ *
+ * Every base value in a range is converted to each unit at a few
+ * denominators and compared with a rounding worked out a different way,
+ * from the floor of the exact quotient. The half-way cases are counted so
+ * a run shows the negative ones really were checked. Values are taken
+ * back and forth both ways where the steps allow it to be exact. The
+ * accumulator is pushed up against the limits of its int64_t sum.
+ *
+ * Usage: fixed_point_check [-r range]
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cstdint>
+#include <limits>
+
+#include "celsius.h"
+#include "fahrenheit.h"
+#include "inches_mercury.h"
+#include "kelvin.h"
+#include "millibar.h"
+#include "quantity_accumulator.h"
+#include "relative_humidity.h"
+
+using qw_units::Celsius;
+using qw_units::divideRounded;
+using qw_units::Fahrenheit;
+using qw_units::InchesMercury;
+using qw_units::Kelvin;
+using qw_units::Millibar;
+using qw_units::QuantityAccumulator;
+using qw_units::RelativeHumidity;
+
+/*
+ * 200 degrees either side of zero in millicelsius, or 200 mb in
+ * milli-millibars
+ */
+constexpr int64_t default_range = 200000;
+
+constexpr int64_t int64_max = std::numeric_limits<int64_t>::max();
+constexpr int64_t int64_min = std::numeric_limits<int64_t>::min();
+
+struct CheckCounts {
+  int errors = 0;
+  int64_t checked = 0;
+  int64_t negative_halves = 0;
+  int64_t positive_halves = 0;
+};
+
+/*
+ * numerator / denominator rounded half away from zero, from the floor and
+ * what is left over, nothing shared with divideRounded()
+ */
+static __int128 referenceRounded(__int128 numerator, __int128 denominator,
+                                 CheckCounts& counts) {
+  __int128 floor = numerator / denominator;
+  if ((numerator % denominator != 0) && (numerator < 0)) {
+    floor--;
+  }
+  __int128 fraction = numerator - (floor * denominator);
+
+  if (2 * fraction > denominator) {
+    return floor + 1;
+  }
+  if (2 * fraction == denominator) {
+    if (numerator < 0) {
+      counts.negative_halves++;
+      return floor;
+    }
+    counts.positive_halves++;
+    return floor + 1;
+  }
+
+  return floor;
+}
+
+static void divideRoundedCheck(CheckCounts& counts) {
+
+  for (int64_t denominator = 1; denominator <= 64; denominator++) {
+    for (int64_t numerator = -4096; numerator <= 4096; numerator++) {
+      int64_t expected = static_cast<int64_t>(
+          referenceRounded(numerator, denominator, counts));
+      int64_t actual = divideRounded(numerator, denominator);
+      counts.checked++;
+      if (actual != expected) {
+        if (counts.errors < 5) {
+          printf("divideRounded(%ld, %ld) is %ld, should be %ld\n", numerator,
+                 denominator, actual, expected);
+        }
+        counts.errors++;
+      }
+    }
+  }
+
+  /*
+   * Right up against the limits, where adding half the denominator first
+   * would overflow
+   */
+  const int64_t numerators[] = {int64_max,     int64_max - 1, int64_min + 1,
+                                int64_min + 2, int64_min};
+  const int64_t denominators[] = {1, 2, 3, 7, 1000, int64_max};
+  for (int64_t numerator : numerators) {
+    for (int64_t denominator : denominators) {
+      int64_t expected = static_cast<int64_t>(
+          referenceRounded(numerator, denominator, counts));
+      int64_t actual = divideRounded(numerator, denominator);
+      counts.checked++;
+      if (actual != expected) {
+        printf("divideRounded(%ld, %ld) is %ld, should be %ld\n", numerator,
+               denominator, actual, expected);
+        counts.errors++;
+      }
+    }
+  }
+
+  return;
+}
+
+/*
+ * Every base value in the range to Unit * Denominator, against the same
+ * value put over one denominator and rounded by the reference
+ */
+template <typename Unit, int64_t Denominator>
+void fixedValueCheck(const char* name, int64_t range, CheckCounts& counts) {
+  using Ratio = typename Unit::scale::ratio;
+  using Offset = typename Unit::scale::offset;
+  constexpr __int128 factor = Unit::dimension::base_conversion_factor;
+  int errors = 0;
+
+  for (int64_t base = -range; base <= range; base++) {
+    __int128 numerator = ((static_cast<__int128>(base) * Ratio::num *
+                           Offset::den) +
+                          (static_cast<__int128>(Offset::num) * factor *
+                           Ratio::den)) *
+                         Denominator;
+    int64_t expected = static_cast<int64_t>(referenceRounded(
+        numerator, factor * Ratio::den * Offset::den, counts));
+    int64_t actual = Unit::fromBase(base).template fixedValue<Denominator>();
+    counts.checked++;
+    if (actual != expected) {
+      if (errors < 5) {
+        printf("%s base %ld fixedValue<%ld> is %ld, should be %ld\n", name,
+               base, Denominator, actual, expected);
+      }
+      errors++;
+    }
+  }
+  counts.errors += errors;
+
+  return;
+}
+
+/*
+ * value * Denominator to the base and back has to come out the same when
+ * a step of 1 / Denominator is at least as big as a base step
+ */
+template <typename Unit, int64_t Denominator>
+void fixedRoundTripCheck(const char* name, int64_t range,
+                         CheckCounts& counts) {
+  int errors = 0;
+
+  for (int64_t value = -range; value <= range; value++) {
+    int64_t actual =
+        Unit::template fromFixed<Denominator>(value)
+            .template fixedValue<Denominator>();
+    counts.checked++;
+    if (actual != value) {
+      if (errors < 5) {
+        printf("%s fixed %ld / %ld round trips to %ld\n", name, value,
+               Denominator, actual);
+      }
+      errors++;
+    }
+  }
+  counts.errors += errors;
+
+  return;
+}
+
+/*
+ * And the base through value * Denominator and back, when a step of
+ * 1 / Denominator is no bigger than a base step
+ */
+template <typename Unit, int64_t Denominator>
+void baseRoundTripCheck(const char* name, int64_t range, CheckCounts& counts) {
+  int errors = 0;
+
+  for (int64_t base = -range; base <= range; base++) {
+    int64_t actual = Unit::template fromFixed<Denominator>(
+                         Unit::fromBase(base)
+                             .template fixedValue<Denominator>())
+                         .baseValue();
+    counts.checked++;
+    if (actual != base) {
+      if (errors < 5) {
+        printf("%s base %ld round trips through / %ld to %ld\n", name, base,
+               Denominator, actual);
+      }
+      errors++;
+    }
+  }
+  counts.errors += errors;
+
+  return;
+}
+
+/*
+ * Particular values, where the answer is known without working it out
+ */
+static void knownValueCheck(CheckCounts& counts) {
+  struct Known {
+    const char* what;
+    int64_t actual;
+    int64_t expected;
+  };
+  const Known known[] = {
+      {"-0.005 C in hundredths", Celsius::fromBase(-5).fixedValue<100>(), -1},
+      {"0.005 C in hundredths", Celsius::fromBase(5).fixedValue<100>(), 1},
+      {"-0.015 C in hundredths", Celsius::fromBase(-15).fixedValue<100>(), -2},
+      {"-0.5 C in degrees", Celsius::fromBase(-500).fixedValue<1>(), -1},
+      {"-0.499 C in degrees", Celsius::fromBase(-499).fixedValue<1>(), 0},
+      {"-40 C in F", Fahrenheit(Celsius::fromBase(-40000)).fixedValue<1>(),
+       -40},
+      {"-20.25 C in tenths of F",
+       Fahrenheit(Celsius::fromBase(-20250)).fixedValue<10>(), -45},
+      {"-0.005 K in hundredths", Kelvin::fromBase(-273155).fixedValue<100>(),
+       -1},
+      {"-0.5 F in millicelsius", Fahrenheit::fromFixed<10>(-5).baseValue(),
+       -18056},
+      {"1013.25 mb in inHg / 1000",
+       InchesMercury(Millibar::fromBase(1013250)).fixedValue<1000>(), 29920},
+      {"-0.005 % in tenths", RelativeHumidity::fromBase(-5).fixedValue<10>(),
+       -1},
+  };
+  for (const Known& k : known) {
+    counts.checked++;
+    if (k.actual != k.expected) {
+      printf("%s is %ld, should be %ld\n", k.what, k.actual, k.expected);
+      counts.errors++;
+    }
+  }
+
+  return;
+}
+
+static int expectError(const char* what, const expected<bool, int>& result,
+                       int error) {
+
+  if ((result.has_value() == true) || (result.error() != error)) {
+    printf("%s should have failed with %d\n", what, error);
+    return 1;
+  }
+
+  return 0;
+}
+
+static void accumulatorCheck(CheckCounts& counts) {
+  QuantityAccumulator<Millibar> accumulator;
+  int errors = 0;
+
+  errors += accumulator.mean().has_value() == true ? 1 : 0;
+  errors += expectError("remove from empty",
+                        accumulator.remove(Millibar::fromBase(1)), ENODATA);
+
+  /*
+   * A long run of ordinary readings is exact
+   */
+  constexpr int64_t readings = 1000000;
+  for (int64_t i = 0; i < readings; i++) {
+    if (accumulator.add(Millibar::fromBase(1013000 + (i % 500))).has_value() ==
+        false) {
+      printf("add of an ordinary reading failed\n");
+      errors++;
+      break;
+    }
+  }
+  int64_t expected_sum = (1013000 * readings) + ((readings / 500) * 124750);
+  if ((accumulator.sum() != expected_sum) ||
+      (accumulator.mean().value().baseValue() != 1013250)) {
+    printf("sum %ld mean %ld, should be %ld and 1013250\n", accumulator.sum(),
+           accumulator.mean().value().baseValue(), expected_sum);
+    errors++;
+  }
+
+  /*
+   * Past the top and the bottom, and the accumulator is left as it was
+   */
+  accumulator.clear();
+  accumulator.add(Millibar::fromBase(int64_max - 10));
+  errors += expectError("add past the top",
+                        accumulator.add(Millibar::fromBase(11)), EOVERFLOW);
+  errors += expectError("remove past the top",
+                        accumulator.remove(Millibar::fromBase(-11)),
+                        EOVERFLOW);
+  if ((accumulator.sum() != int64_max - 10) || (accumulator.count() != 1)) {
+    printf("overflow changed the accumulator\n");
+    errors++;
+  }
+  QuantityAccumulator<Millibar> other;
+  other.add(Millibar::fromBase(11));
+  errors += expectError("merge past the top", accumulator.add(other),
+                        EOVERFLOW);
+  accumulator.clear();
+  accumulator.add(Millibar::fromBase(int64_min + 10));
+  errors += expectError("add past the bottom",
+                        accumulator.add(Millibar::fromBase(-11)), EOVERFLOW);
+
+  /*
+   * The mean of sums right at the limits, and of negative half-way sums
+   */
+  accumulator.clear();
+  accumulator.add(Millibar::fromBase(int64_max - 1));
+  accumulator.add(Millibar::fromBase(1));
+  accumulator.add(Millibar::fromBase(0));
+  if (accumulator.mean().value().baseValue() !=
+      (int64_max / 3) + ((int64_max % 3) * 2 >= 3 ? 1 : 0)) {
+    printf("mean at the top is %ld\n", accumulator.mean().value().baseValue());
+    errors++;
+  }
+  accumulator.clear();
+  accumulator.add(Millibar::fromBase(-1));
+  accumulator.add(Millibar::fromBase(-2));
+  if (accumulator.mean().value().baseValue() != -2) {
+    printf("mean of -1 and -2 is %ld, should be -2\n",
+           accumulator.mean().value().baseValue());
+    errors++;
+  }
+  accumulator.remove(Millibar::fromBase(-2));
+  accumulator.add(Millibar::fromBase(-4));
+  accumulator.add(Millibar::fromBase(-4));
+  accumulator.add(Millibar::fromBase(-1));
+  if (accumulator.mean().value().baseValue() != -3) {
+    printf("mean of -1, -4, -4 and -1 is %ld, should be -3\n",
+           accumulator.mean().value().baseValue());
+    errors++;
+  }
+  counts.checked += readings + 11;
+  counts.errors += errors;
+
+  return;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  int64_t range = default_range;
+  CheckCounts counts;
+
+  while ((opt = getopt(argc, argv, "r:")) != -1) {
+    switch (opt) {
+      case 'r':
+        range = atoll(optarg);
+        break;
+      default:
+        printf("Usage: fixed_point_check [-r range]\n");
+        exit(1);
+    }
+  }
+  if (range <= 0) {
+    printf("The range has to be positive\n");
+    exit(1);
+  }
+
+  divideRoundedCheck(counts);
+
+  fixedValueCheck<Celsius, 1>("Celsius", range, counts);
+  fixedValueCheck<Celsius, 100>("Celsius", range, counts);
+  fixedValueCheck<Fahrenheit, 1>("Fahrenheit", range, counts);
+  fixedValueCheck<Fahrenheit, 10>("Fahrenheit", range, counts);
+  fixedValueCheck<Fahrenheit, 100>("Fahrenheit", range, counts);
+  fixedValueCheck<Kelvin, 100>("Kelvin", range, counts);
+  fixedValueCheck<Millibar, 10>("Millibar", range, counts);
+  fixedValueCheck<InchesMercury, 100>("InchesMercury", range, counts);
+  fixedValueCheck<InchesMercury, 1000>("InchesMercury", range, counts);
+  fixedValueCheck<RelativeHumidity, 10>("RelativeHumidity", range, counts);
+
+  fixedRoundTripCheck<Celsius, 100>("Celsius", range, counts);
+  fixedRoundTripCheck<Fahrenheit, 10>("Fahrenheit", range, counts);
+  fixedRoundTripCheck<Fahrenheit, 100>("Fahrenheit", range, counts);
+  fixedRoundTripCheck<Kelvin, 100>("Kelvin", range, counts);
+  fixedRoundTripCheck<Millibar, 10>("Millibar", range, counts);
+  fixedRoundTripCheck<InchesMercury, 1000>("InchesMercury", range, counts);
+  fixedRoundTripCheck<RelativeHumidity, 10>("RelativeHumidity", range,
+                                            counts);
+
+  baseRoundTripCheck<Celsius, 1000>("Celsius", range, counts);
+  baseRoundTripCheck<Fahrenheit, 1000>("Fahrenheit", range, counts);
+  baseRoundTripCheck<Kelvin, 1000>("Kelvin", range, counts);
+
+  knownValueCheck(counts);
+  accumulatorCheck(counts);
+
+  printf("%ld checked, %ld negative and %ld positive half-way cases, "
+         "%d errors\n",
+         counts.checked, counts.negative_halves, counts.positive_halves,
+         counts.errors);
+  if ((counts.errors != 0) || (counts.negative_halves == 0)) {
+    exit(1);
+  }
+
+  return 0;
+}
@@ -0,0 +1,423 @@
+/*
+ * Time the InfluxDB sink, and check it keeps out of the way of sampling.
+ *
+ * Unless it is given a URL with -u it answers the writes itself, on a
+ * thread with a socket on the loopback, the way InfluxDB does with a
+ * 204. Every write it gets is gunzipped and its lines counted, so the
+ * count at the end has to match what was published. -e makes that many
+ * percent of the writes fail with a 500, with -k they get spilled and
+ * should all turn up later.
+ *
+ * First -n samples are published as fast as they go and the points per
+ * second, the batches, the bytes before and after gzip and the
+ * allocations per point once the buffers have grown are printed.
+ *
+ * Then a stand in for the sampling loop wakes up every -s milliseconds
+ * for -d seconds and how late it wakes up is measured, first with
+ * nothing else going on, then with -r samples a second going through a
+ * Publisher to the sink.
+ *
+ * Usage: influx_sink_benchmark [-u url] [-n samples] [-b batch points]
+ *                              [-z] [-e percent] [-k spill directory]
+ *                              [-r samples per second] [-s ms] [-d seconds]
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fmt/format.h>
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "include/influx_sink.h"
+#include "include/publisher.h"
+
+using qw_units::MetersPerSecond;
+using std::string;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+
+constexpr size_t default_sample_count = 100000;
+constexpr int default_rate = 10000;        // samples a second
+constexpr int default_sample_period = 10;  // milliseconds
+constexpr int default_duration = 3;        // seconds
+
+/*
+ * Every malloc() in the process goes through here and gets counted.
+ * glibc's own malloc is still there as __libc_malloc().
+ */
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+static std::atomic<uint64_t> allocations = 0;
+
+extern "C" void* malloc(size_t size) {
+
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  return __libc_realloc(pointer, size);
+}
+
+/*
+ * The stand in for InfluxDB
+ */
+struct Responder {
+  int listen_fd = -1;
+  int port = 0;
+  int error_percent = 0;
+  std::atomic<uint64_t> writes = 0;
+  std::atomic<uint64_t> errors = 0;
+  std::atomic<uint64_t> lines = 0;
+  std::atomic<uint64_t> bad = 0;
+  std::atomic<bool> stop = false;
+};
+
+static size_t countLines(const string& body, bool gzipped) {
+
+  if (gzipped == false) {
+    return std::count(body.begin(), body.end(), '\n');
+  }
+
+  z_stream stream = {};
+  if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+    return 0;
+  }
+  char buffer[65536];
+  size_t lines = 0;
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+  stream.avail_in = body.size();
+  int result = Z_OK;
+  while (result == Z_OK) {
+    stream.next_out = reinterpret_cast<Bytef*>(buffer);
+    stream.avail_out = sizeof(buffer);
+    result = inflate(&stream, Z_NO_FLUSH);
+    lines += std::count(buffer, buffer + sizeof(buffer) - stream.avail_out,
+                        '\n');
+  }
+  inflateEnd(&stream);
+
+  return (result == Z_STREAM_END) ? lines : 0;
+}
+
+static void respond(Responder* responder) {
+  std::mt19937 random(1);
+
+  while (responder->stop == false) {
+    int fd = accept(responder->listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      continue;
+    }
+    string in;
+    char buffer[65536];
+
+    /*
+     * Requests one after the other on the same connection, headers and
+     * then Content-Length of body
+     */
+    while (true) {
+      size_t end = in.find("\r\n\r\n");
+      if (end != string::npos) {
+        string headers = in.substr(0, end);
+        size_t length = 0;
+        size_t at = headers.find("Content-Length: ");
+        if (at != string::npos) {
+          length = strtoul(headers.c_str() + at + 16, nullptr, 10);
+        }
+        if (in.size() >= end + 4 + length) {
+          string body = in.substr(end + 4, length);
+          bool gzipped =
+              headers.find("Content-Encoding: gzip") != string::npos;
+          in.erase(0, end + 4 + length);
+
+          const char* response = "HTTP/1.1 204 No Content\r\n\r\n";
+          if (static_cast<int>(random() % 100) < responder->error_percent) {
+            response =
+                "HTTP/1.1 500 Internal Server Error\r\n"
+                "Content-Length: 0\r\n\r\n";
+            responder->errors++;
+          } else {
+            size_t lines = countLines(body, gzipped);
+            if (lines == 0) {
+              responder->bad++;
+            }
+            responder->lines += lines;
+            responder->writes++;
+          }
+          write(fd, response, strlen(response));
+          continue;
+        }
+      }
+      ssize_t count = read(fd, buffer, sizeof(buffer));
+      if (count <= 0) {
+        break;
+      }
+      in.append(buffer, count);
+    }
+    close(fd);
+  }
+
+  return;
+}
+
+static PublishedSample sample(size_t n) {
+  PublishedSample sample;
+
+  /*
+   * A second apart, like they would be at 1Hz, readings that change a
+   * little every time
+   */
+  sample.time_ = system_clock::time_point(seconds(1718000000 + n));
+  sample.temperature_ = Celsius(21.5f + static_cast<float>(n % 17) * 0.13f);
+  sample.temperature2_ = Celsius(22.1f + static_cast<float>(n % 13) * 0.11f);
+  sample.humidity_ =
+      RelativeHumidity(45.0f + static_cast<float>(n % 11) * 0.7f);
+  sample.dewpoint_ = Celsius(9.2f + static_cast<float>(n % 7) * 0.2f);
+  sample.pressure_ = Millibar(1013.2f + static_cast<float>(n % 5) * 0.1f);
+  sample.sea_level_pressure_ =
+      Millibar(1016.4f + static_cast<float>(n % 5) * 0.1f);
+  sample.wind_speed_avg_ =
+      MetersPerSecond(2.1f + static_cast<float>(n % 9) * 0.3f);
+  sample.wind_direction_ = static_cast<float>(n % 360);
+  sample.wind_gust_ = MetersPerSecond(5.5f + static_cast<float>(n % 9) * 0.4f);
+
+  return sample;
+}
+
+/*
+ * How late a loop that wants to wake up every period wakes up
+ */
+static vector<microseconds> samplingJitter(milliseconds period,
+                                           seconds duration) {
+  vector<microseconds> late;
+  auto next = steady_clock::now() + period;
+  auto end = steady_clock::now() + duration;
+
+  while (next < end) {
+    std::this_thread::sleep_until(next);
+    late.push_back(duration_cast<microseconds>(steady_clock::now() - next));
+    next += period;
+  }
+  std::sort(late.begin(), late.end());
+
+  return late;
+}
+
+static void printJitter(const char* name, const vector<microseconds>& late) {
+
+  if (late.empty() == true) {
+    return;
+  }
+  printf("  %-24s p50 %6ldus  p99 %6ldus  max %6ldus\n", name,
+         late[late.size() / 2].count(), late[late.size() * 99 / 100].count(),
+         late.back().count());
+
+  return;
+}
+
+static void printStatistics(const InfluxSinkStatistics& statistics) {
+
+  printf("  points %lu, batches %lu, writes %lu, failed %lu, spilled %lu, "
+         "dropped %lu, waiting %zu\n",
+         statistics.points_, statistics.batches_, statistics.posts_,
+         statistics.failed_, statistics.spilled_, statistics.dropped_,
+         statistics.spill_depth_);
+  if (statistics.sent_bytes_ > 0) {
+    printf("  line protocol %lu bytes, sent %lu bytes, %.1f:1\n",
+           statistics.line_bytes_, statistics.sent_bytes_,
+           static_cast<double>(statistics.line_bytes_) /
+               statistics.sent_bytes_);
+  }
+
+  return;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  InfluxSinkConfig config;
+  size_t sample_count = default_sample_count;
+  int rate = default_rate;
+  int sample_period = default_sample_period;
+  int duration = default_duration;
+  Responder responder;
+
+  config.batch_points_ = 5000;
+  config.retry_initial_ = milliseconds(0);
+  while ((opt = getopt(argc, argv, "u:n:b:ze:k:r:s:d:")) != -1) {
+    switch (opt) {
+      case 'u':
+        config.url_ = optarg;
+        break;
+      case 'n':
+        sample_count = strtoul(optarg, nullptr, 10);
+        break;
+      case 'b':
+        config.batch_points_ = strtoul(optarg, nullptr, 10);
+        break;
+      case 'z':
+        config.gzip_ = false;
+        break;
+      case 'e':
+        responder.error_percent = atoi(optarg);
+        break;
+      case 'k':
+        config.spill_directory_ = optarg;
+        break;
+      case 'r':
+        rate = std::max(1, atoi(optarg));
+        break;
+      case 's':
+        sample_period = std::max(1, atoi(optarg));
+        break;
+      case 'd':
+        duration = std::max(1, atoi(optarg));
+        break;
+      default:
+        printf("Usage: influx_sink_benchmark [-u url] [-n samples] "
+               "[-b batch points] [-z] [-e percent] [-k spill directory] "
+               "[-r samples per second] [-s ms] [-d seconds]\n");
+        exit(1);
+    }
+  }
+
+  std::thread responder_thread;
+  if (config.url_.empty() == true) {
+    responder.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    socklen_t address_length = sizeof(address);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((bind(responder.listen_fd, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) != 0) ||
+        (listen(responder.listen_fd, SOMAXCONN) != 0)) {
+      printf("Can't listen: %s\n", strerror(errno));
+      exit(1);
+    }
+    getsockname(responder.listen_fd, reinterpret_cast<sockaddr*>(&address),
+                &address_length);
+    responder.port = ntohs(address.sin_port);
+    config.url_ = fmt::format(
+        "http://127.0.0.1:{}/api/v2/write?org=bench&bucket=bench",
+        responder.port);
+    responder_thread = std::thread(respond, &responder);
+  }
+  printf("Writing to %s, %zu points a batch%s\n", config.url_.c_str(),
+         config.batch_points_, config.gzip_ ? ", gzipped" : "");
+
+  /*
+   * As fast as it goes. The allocations are only counted after the
+   * first batch, by then the buffers are as big as they get.
+   */
+  {
+    InfluxSink sink(config);
+    vector<PublishedSample> samples;
+    for (size_t n = 0; n < sample_count; n++) {
+      samples.push_back(sample(n));
+    }
+    size_t warmup = std::min(sample_count, config.batch_points_ + 1);
+    for (size_t n = 0; n < warmup; n++) {
+      sink.publish(samples[n]);
+    }
+
+    auto start = steady_clock::now();
+    uint64_t start_allocations = allocations;
+    for (size_t n = warmup; n < sample_count; n++) {
+      sink.publish(samples[n]);
+    }
+    sink.flush();
+    auto elapsed = duration_cast<microseconds>(steady_clock::now() - start);
+    uint64_t used_allocations = allocations - start_allocations;
+
+    size_t timed = sample_count - warmup;
+    printf("\nThroughput:\n");
+    printf("  %zu points in %.3fs, %.0f points/s\n", timed,
+           elapsed.count() / 1e6,
+           timed / std::max(elapsed.count() / 1e6, 1e-9));
+    printf("  %.3f allocations a point, writes included\n",
+           static_cast<double>(used_allocations) / std::max<size_t>(timed, 1));
+    printStatistics(sink.statistics());
+  }
+
+  /*
+   * The sampling loop on its own, then with the publisher going flat out
+   * beside it
+   */
+  printf("\nSampling every %dms for %ds:\n", sample_period, duration);
+  printJitter("idle", samplingJitter(milliseconds(sample_period),
+                                     seconds(duration)));
+  {
+    Publisher publisher;
+    PublisherSinkConfig sink_config;
+    sink_config.queue_capacity_ = static_cast<size_t>(rate);
+    publisher.addSink(std::make_unique<InfluxSink>(config), sink_config);
+
+    std::atomic<bool> feeding = true;
+    std::thread feeder([&publisher, &feeding, rate] {
+      auto next = steady_clock::now();
+      size_t n = 0;
+      while (feeding == true) {
+        /*
+         * A thousandth of a second's worth at a time
+         */
+        for (int i = 0; i < std::max(1, rate / 1000); i++) {
+          publisher.publish(std::make_shared<PublishedSample>(sample(n++)));
+        }
+        next += milliseconds(1);
+        std::this_thread::sleep_until(next);
+      }
+    });
+    printJitter(fmt::format("{} points/s", rate).c_str(),
+                samplingJitter(milliseconds(sample_period),
+                               seconds(duration)));
+    feeding = false;
+    feeder.join();
+
+    for (const PublisherSinkStatistics& statistics : publisher.statistics()) {
+      printf("  publisher: published %lu, dropped %lu, waiting %zu\n",
+             statistics.published_, statistics.dropped_, statistics.depth_);
+    }
+  }
+
+  if (responder_thread.joinable() == true) {
+    /*
+     * Give the last writes a moment to land, then wake accept() up
+     */
+    std::this_thread::sleep_for(milliseconds(200));
+    responder.stop = true;
+    shutdown(responder.listen_fd, SHUT_RDWR);
+    close(responder.listen_fd);
+    responder_thread.join();
+    printf("\nServer: %lu writes, %lu lines, %lu errors, %lu unreadable\n",
+           responder.writes.load(), responder.lines.load(),
+           responder.errors.load(), responder.bad.load());
+  }
+
+  return 0;
+}
@@ -0,0 +1,591 @@
+/*
+ * A stand in for an MQTT broker, enough of one to point the station's
+ * MQTT publisher at and see what it does.
+ *
+ * It speaks MQTT 3.1.1. It takes CONNECT, PUBLISH at QoS 0 and 1,
+ * PINGREQ and DISCONNECT, keeps the retained messages and the persistent
+ * sessions the way a broker would and publishes a client's will if it
+ * goes away without a DISCONNECT. A SUBSCRIBE only gets the retained
+ * messages that match it, at QoS 0, nothing published after that is
+ * passed on. That is enough to check what a client left behind, and the
+ * retained messages are printed at the end as well.
+ *
+ * It counts how many PUBLISH packets come in each read, so it shows
+ * whether a client pipelines them or waits for each PUBACK before it
+ * sends the next.
+ *
+ * Things can be made to go wrong:
+ *   -a user:password  turn down a CONNECT without these
+ *   -l ms             hold every PUBACK back this long
+ *   -d percent        never ack this many publishes
+ *   -x count          hang up on a client after this many publishes
+ *   -v                print every packet
+ *
+ * The counts and the retained messages are printed when it is stopped
+ * with ^C.
+ *
+ * Usage: mqtt_mock_broker [-p port] [-a user:password] [-l ms]
+ *                         [-d percent] [-x count] [-v]
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "include/mqtt_packet.h"
+
+using std::map;
+using std::set;
+using std::string;
+using std::string_view;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+constexpr int default_port = 1883;
+
+struct BrokerConfig {
+  int port = default_port;
+  string username;
+  string password;
+  int latency = 0;  // milliseconds
+  int drop_percent = 0;
+  uint64_t hang_up_after = 0;
+  bool verbose = false;
+};
+
+struct Client {
+  int fd;
+  vector<uint8_t> in;
+  string out;
+  steady_clock::time_point due;  // out goes once it is due
+  bool connected = false;
+  bool disconnected = false;  // said goodbye, no will
+  bool close_after = false;
+  string client_id;
+  string will_topic;
+  string will_message;
+  bool will_retain = false;
+  uint64_t publishes = 0;
+};
+
+struct BrokerCounts {
+  uint64_t connections = 0;
+  uint64_t connects = 0;
+  uint64_t sessions_resumed = 0;
+  uint64_t refused = 0;
+  uint64_t publishes = 0;
+  uint64_t qos0 = 0;
+  uint64_t qos1 = 0;
+  uint64_t duplicates = 0;  // DUP set, sent again after a reconnect
+  uint64_t retained = 0;
+  uint64_t acks = 0;
+  uint64_t dropped = 0;
+  uint64_t pings = 0;
+  uint64_t subscribes = 0;
+  uint64_t disconnects = 0;
+  uint64_t wills = 0;
+  uint64_t hang_ups = 0;
+  uint64_t protocol_errors = 0;
+  map<size_t, uint64_t> batches;  // publishes in one read, how often
+};
+
+static volatile sig_atomic_t stop = 0;
+
+static void stopHandler(int) {
+
+  stop = 1;
+
+  return;
+}
+
+static string printable(string_view value) {
+  string result;
+
+  for (char c : value) {
+    result.push_back(((c >= ' ') && (c < 0x7f)) ? c : '.');
+  }
+
+  return result;
+}
+
+static bool handleConnect(Client& client, span<const uint8_t> body,
+                          const BrokerConfig& config, set<string>& sessions,
+                          BrokerCounts& counts) {
+  string_view protocol;
+  string_view client_id;
+  string_view will_topic;
+  string_view will_message;
+  string_view username;
+  string_view password;
+  size_t at = 0;
+
+  auto x_used = mqttParseString(body, protocol);
+  if ((x_used.has_value() == false) || (protocol != "MQTT") ||
+      (body.size() < x_used.value() + 4)) {
+    return false;
+  }
+  at = x_used.value();
+  uint8_t level = body[at];
+  uint8_t flags = body[at + 1];
+  int keepalive = (body[at + 2] << 8) | body[at + 3];
+  at += 4;
+
+  x_used = mqttParseString(body.subspan(at), client_id);
+  if (x_used.has_value() == false) {
+    return false;
+  }
+  at += x_used.value();
+  if ((flags & 0x04) != 0) {
+    x_used = mqttParseString(body.subspan(at), will_topic);
+    if (x_used.has_value() == false) {
+      return false;
+    }
+    at += x_used.value();
+    x_used = mqttParseString(body.subspan(at), will_message);
+    if (x_used.has_value() == false) {
+      return false;
+    }
+    at += x_used.value();
+  }
+  if ((flags & 0x80) != 0) {
+    x_used = mqttParseString(body.subspan(at), username);
+    if (x_used.has_value() == false) {
+      return false;
+    }
+    at += x_used.value();
+  }
+  if ((flags & 0x40) != 0) {
+    x_used = mqttParseString(body.subspan(at), password);
+    if (x_used.has_value() == false) {
+      return false;
+    }
+    at += x_used.value();
+  }
+
+  if (level != 4) {
+    mqttAppendConnack(client.out, false, mqtt_connack_bad_protocol);
+    client.close_after = true;
+    counts.refused++;
+    return true;
+  }
+  if ((config.username.empty() == false) &&
+      ((username != config.username) || (password != config.password))) {
+    mqttAppendConnack(client.out, false, mqtt_connack_bad_credentials);
+    client.close_after = true;
+    counts.refused++;
+    return true;
+  }
+
+  /*
+   * A clean session throws away whatever we had, otherwise it is kept
+   * for next time
+   */
+  bool session_present = false;
+  if ((flags & 0x02) != 0) {
+    sessions.erase(string(client_id));
+  } else {
+    session_present = (sessions.insert(string(client_id)).second == false);
+  }
+  if (session_present == true) {
+    counts.sessions_resumed++;
+  }
+
+  client.connected = true;
+  client.client_id = client_id;
+  client.will_topic = will_topic;
+  client.will_message = will_message;
+  client.will_retain = (flags & 0x20) != 0;
+  counts.connects++;
+  mqttAppendConnack(client.out, session_present, mqtt_connack_accepted);
+  if (config.verbose == true) {
+    printf("%d CONNECT %s%s%s keepalive %d\n", client.fd,
+           client.client_id.c_str(),
+           ((flags & 0x02) != 0) ? " clean" : "",
+           session_present ? " session present" : "", keepalive);
+  }
+
+  return true;
+}
+
+/*
+ * A topic filter, with + for any one level and # for everything from
+ * there down, the level above included
+ */
+static bool topicMatches(string_view filter, string_view topic) {
+
+  while (true) {
+    size_t filter_end = filter.find('/');
+    size_t topic_end = topic.find('/');
+    string_view filter_level = filter.substr(0, filter_end);
+
+    if (filter_level == "#") {
+      return true;
+    }
+    if ((filter_level != "+") && (filter_level != topic.substr(0, topic_end))) {
+      return false;
+    }
+    if (topic_end == string_view::npos) {
+      return (filter_end == string_view::npos) ||
+             (filter.substr(filter_end + 1) == "#");
+    }
+    if (filter_end == string_view::npos) {
+      return false;
+    }
+    filter.remove_prefix(filter_end + 1);
+    topic.remove_prefix(topic_end + 1);
+  }
+}
+
+/*
+ * The SUBACK, then every retained message any of the filters match
+ */
+static bool handleSubscribe(Client& client, MqttPacket packet,
+                            const BrokerConfig& config,
+                            const map<string, string>& retained,
+                            BrokerCounts& counts) {
+  vector<string_view> filters;
+
+  auto x_packet_id = mqttParsePacketId(packet.body_);
+  if ((packet.flags_ != 0x02) || (x_packet_id.has_value() == false)) {
+    return false;
+  }
+  size_t at = 2;
+  while (at < packet.body_.size()) {
+    string_view filter;
+    auto x_used = mqttParseString(packet.body_.subspan(at), filter);
+    if ((x_used.has_value() == false) ||
+        (at + x_used.value() >= packet.body_.size())) {
+      return false;
+    }
+    filters.push_back(filter);
+    at += x_used.value() + 1;  // and the QoS asked for
+  }
+  if (filters.empty() == true) {
+    return false;
+  }
+
+  counts.subscribes++;
+  mqttAppendSuback(client.out, x_packet_id.value(), filters.size());
+  for (const auto& [topic, payload] : retained) {
+    for (string_view filter : filters) {
+      if (topicMatches(filter, topic) == true) {
+        mqttAppendPublish(client.out, topic, payload, 0, true);
+        break;
+      }
+    }
+  }
+  if (config.verbose == true) {
+    for (string_view filter : filters) {
+      printf("%d SUBSCRIBE %.*s\n", client.fd,
+             static_cast<int>(filter.size()), filter.data());
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Take every whole packet off the front of client.in. Returns false if
+ * the client has to go.
+ */
+static bool handlePackets(Client& client, const BrokerConfig& config,
+                          set<string>& sessions,
+                          map<string, string>& retained,
+                          BrokerCounts& counts, std::mt19937& random) {
+  size_t batch = 0;
+  bool keep = true;
+
+  while (keep == true) {
+    auto x_packet = mqttParsePacket(client.in);
+    if (x_packet.has_value() == false) {
+      if (x_packet.error() != EAGAIN) {
+        counts.protocol_errors++;
+        keep = false;
+      }
+      break;
+    }
+    MqttPacket packet = x_packet.value();
+
+    if ((client.connected == false) && (packet.type_ != MQTT_CONNECT)) {
+      counts.protocol_errors++;
+      keep = false;
+    } else if (packet.type_ == MQTT_CONNECT) {
+      if ((client.connected == true) ||
+          (handleConnect(client, packet.body_, config, sessions, counts) ==
+           false)) {
+        counts.protocol_errors++;
+        keep = false;
+      }
+    } else if (packet.type_ == MQTT_PUBLISH) {
+      string_view topic;
+      auto x_used = mqttParseString(packet.body_, topic);
+      int qos = (packet.flags_ >> 1) & 0x03;
+      uint16_t packet_id = 0;
+      if ((x_used.has_value() == false) || (qos > 1)) {
+        counts.protocol_errors++;
+        keep = false;
+        break;
+      }
+      size_t at = x_used.value();
+      if (qos == 1) {
+        auto x_packet_id = mqttParsePacketId(packet.body_.subspan(at));
+        if ((x_packet_id.has_value() == false) || (x_packet_id.value() == 0)) {
+          counts.protocol_errors++;
+          keep = false;
+          break;
+        }
+        packet_id = x_packet_id.value();
+        at += 2;
+      }
+      string_view payload(
+          reinterpret_cast<const char*>(packet.body_.data()) + at,
+          packet.body_.size() - at);
+
+      counts.publishes++;
+      if ((packet.flags_ & mqtt_publish_dup) != 0) {
+        counts.duplicates++;
+      }
+      batch++;
+      client.publishes++;
+      if ((packet.flags_ & mqtt_publish_retain) != 0) {
+        counts.retained++;
+        if (payload.empty() == true) {
+          retained.erase(string(topic));
+        } else {
+          retained[string(topic)] = payload;
+        }
+      }
+      if (config.verbose == true) {
+        printf("%d PUBLISH %u qos %d%s%s %.*s %s\n", client.fd, packet_id,
+               qos,
+               ((packet.flags_ & mqtt_publish_retain) != 0) ? " retain" : "",
+               ((packet.flags_ & mqtt_publish_dup) != 0) ? " dup" : "",
+               static_cast<int>(topic.size()), topic.data(),
+               printable(payload).c_str());
+      }
+      if (qos == 0) {
+        counts.qos0++;
+      } else {
+        counts.qos1++;
+        if (static_cast<int>(random() % 100) < config.drop_percent) {
+          counts.dropped++;
+        } else {
+          mqttAppendPuback(client.out, packet_id);
+          counts.acks++;
+        }
+      }
+      if ((config.hang_up_after > 0) &&
+          (client.publishes >= config.hang_up_after)) {
+        counts.hang_ups++;
+        keep = false;
+      }
+    } else if (packet.type_ == MQTT_SUBSCRIBE) {
+      if (handleSubscribe(client, packet, config, retained, counts) ==
+          false) {
+        counts.protocol_errors++;
+        keep = false;
+      }
+    } else if (packet.type_ == MQTT_PINGREQ) {
+      counts.pings++;
+      mqttAppendPingresp(client.out);
+    } else if (packet.type_ == MQTT_DISCONNECT) {
+      counts.disconnects++;
+      client.disconnected = true;
+      keep = false;
+    } else {
+      counts.protocol_errors++;
+      keep = false;
+    }
+
+    client.in.erase(client.in.begin(), client.in.begin() + packet.size_);
+  }
+  if (batch > 0) {
+    counts.batches[batch]++;
+  }
+
+  return keep;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  BrokerConfig config;
+
+  while ((opt = getopt(argc, argv, "p:a:l:d:x:v")) != -1) {
+    switch (opt) {
+      case 'p':
+        config.port = atoi(optarg);
+        break;
+      case 'a': {
+        string_view credentials(optarg);
+        size_t colon = credentials.find(':');
+        config.username = credentials.substr(0, colon);
+        if (colon != string_view::npos) {
+          config.password = credentials.substr(colon + 1);
+        }
+        break;
+      }
+      case 'l':
+        config.latency = atoi(optarg);
+        break;
+      case 'd':
+        config.drop_percent = atoi(optarg);
+        break;
+      case 'x':
+        config.hang_up_after = strtoull(optarg, nullptr, 10);
+        break;
+      case 'v':
+        config.verbose = true;
+        break;
+      default:
+        printf("Usage: mqtt_mock_broker [-p port] [-a user:password] "
+               "[-l ms] [-d percent] [-x count] [-v]\n");
+        exit(1);
+    }
+  }
+
+  int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int on = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(config.port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if ((bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+            sizeof(address)) != 0) ||
+      (listen(listen_fd, SOMAXCONN) != 0)) {
+    printf("Can't listen on port %d: %s\n", config.port, strerror(errno));
+    exit(1);
+  }
+  printf("Listening on 127.0.0.1:%d\n", config.port);
+  fflush(stdout);
+
+  /*
+   * No SA_RESTART so poll() comes back when we're stopped
+   */
+  struct sigaction action = {};
+  action.sa_handler = stopHandler;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  std::mt19937 random(std::random_device{}());
+  BrokerCounts counts;
+  map<int, Client> clients;
+  set<string> sessions;
+  map<string, string> retained;
+  vector<pollfd> fds;
+
+  while (stop == 0) {
+    auto now = steady_clock::now();
+    int timeout = -1;
+
+    /*
+     * A client is read from while it has nothing going out, so held back
+     * acks hold back the client the way a slow broker would
+     */
+    fds.clear();
+    fds.push_back(pollfd{listen_fd, POLLIN, 0});
+    for (auto& [fd, client] : clients) {
+      if (client.out.empty() == true) {
+        fds.push_back(pollfd{fd, POLLIN, 0});
+      } else if (now >= client.due) {
+        fds.push_back(pollfd{fd, POLLOUT, 0});
+      } else {
+        int wait = static_cast<int>(
+            std::chrono::ceil<milliseconds>(client.due - now).count());
+        timeout = (timeout < 0) ? wait : std::min(timeout, wait);
+      }
+    }
+
+    if (poll(fds.data(), fds.size(), timeout) < 0) {
+      continue;
+    }
+
+    if ((fds[0].revents & POLLIN) != 0) {
+      int fd;
+      while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+        clients[fd] = {};
+        clients[fd].fd = fd;
+        counts.connections++;
+      }
+    }
+
+    for (size_t i = 1; i < fds.size(); i++) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+      Client& client = clients[fds[i].fd];
+      bool closed = false;
+
+      if (client.out.empty() == true) {
+        uint8_t buffer[4096];
+        ssize_t n = read(client.fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+          closed = true;
+        } else {
+          client.in.insert(client.in.end(), buffer, buffer + n);
+          closed = (handlePackets(client, config, sessions, retained, counts,
+                                  random) == false);
+          client.due = steady_clock::now() + milliseconds(config.latency);
+        }
+      } else {
+        ssize_t n = write(client.fd, client.out.data(), client.out.size());
+        if (n < 0) {
+          closed = true;
+        } else {
+          client.out.erase(0, n);
+          closed = (client.out.empty() == true) && client.close_after;
+        }
+      }
+
+      if (closed == true) {
+        if ((client.connected == true) && (client.disconnected == false) &&
+            (client.will_topic.empty() == false)) {
+          counts.wills++;
+          if (client.will_retain == true) {
+            retained[client.will_topic] = client.will_message;
+          }
+        }
+        close(client.fd);
+        clients.erase(fds[i].fd);
+      }
+    }
+  }
+
+  printf("\nConnections: %lu\n", counts.connections);
+  printf("CONNECTs: %lu, sessions resumed %lu, refused %lu\n", counts.connects,
+         counts.sessions_resumed, counts.refused);
+  printf("PUBLISHes: %lu, QoS 0 %lu, QoS 1 %lu, duplicates %lu, "
+         "retained %lu\n",
+         counts.publishes, counts.qos0, counts.qos1, counts.duplicates,
+         counts.retained);
+  printf("PUBACKs: %lu, dropped %lu\n", counts.acks, counts.dropped);
+  printf("PINGREQs: %lu, SUBSCRIBEs %lu\n", counts.pings, counts.subscribes);
+  printf("DISCONNECTs: %lu, wills published %lu, hung up on %lu\n",
+         counts.disconnects, counts.wills, counts.hang_ups);
+  printf("Protocol errors: %lu\n", counts.protocol_errors);
+  printf("PUBLISHes per read:\n");
+  for (const auto& [batch, count] : counts.batches) {
+    printf("  %zu: %lu\n", batch, count);
+  }
+  printf("Retained:\n");
+  for (const auto& [topic, payload] : retained) {
+    printf("  %s %s\n", topic.c_str(), printable(payload).c_str());
+  }
+
+  return 0;
+}
@@ -0,0 +1,418 @@
+/*
+ * Run the MQTT publisher against tools/mqtt_mock_broker and check what it
+ * did. Samples are published one after another with MqttSink, the way
+ * the publisher thread would, and the time each took and what went wrong
+ * are kept. A sample that fails is tried again with the next one, so
+ * with the broker hanging up (-x) or dropping acks (-d) it shows the
+ * sink connecting again and carrying on.
+ *
+ * Every publish is at QoS 1 and only comes back true once the broker has
+ * acked all of it, so the samples that went are the ones that were
+ * acked. After the last one the driver subscribes to what is retained
+ * and checks:
+ *   - the status is online
+ *   - each reading the samples had is retained with the last value that
+ *     went, at the precision the sink uses
+ *   - each of those has its Home Assistant discovery config retained,
+ *     pointing at its state topic, and readings the samples never had
+ *     don't have one
+ * Then the sink is let go and the status has to be offline.
+ *
+ * Between samples the sink gets idle() called when it asks for it, so
+ * with an interval longer than half the keepalive (-k) the broker should
+ * count PINGREQs.
+ *
+ * Usage: mqtt_sink_driver [-p port] [-n samples] [-a user:password]
+ *                         [-i interval ms] [-k keepalive seconds]
+ */
+#include <jsoncpp/json/json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fixed_format.h"
+#include "include/mqtt_packet.h"
+#include "include/mqtt_sink.h"
+#include "include/tcp_connection.h"
+
+using qw_units::MetersPerSecond;
+using std::map;
+using std::optional;
+using std::string;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+using std::chrono::system_clock;
+
+constexpr size_t default_sample_count = 1000;
+
+/*
+ * How long the retained messages get to come in after the SUBACK
+ */
+constexpr milliseconds retained_wait = milliseconds(300);
+
+/*
+ * What the sink publishes, the object id under the topic prefix, where
+ * it is in the sample and how many decimals
+ */
+struct DriverReading {
+  const char* object_id;
+  optional<float> (*value)(const PublishedSample& sample);
+  int precision;
+};
+
+static const DriverReading driver_readings[] = {
+    {"temperature", sampleValue<Celsius, &PublishedSample::temperature_>, 2},
+    {"temperature2", sampleValue<Celsius, &PublishedSample::temperature2_>,
+     2},
+    {"humidity", sampleValue<RelativeHumidity, &PublishedSample::humidity_>,
+     1},
+    {"dewpoint", sampleValue<Celsius, &PublishedSample::dewpoint_>, 2},
+    {"pressure", sampleValue<Millibar, &PublishedSample::pressure_>, 2},
+    {"sea_level_pressure",
+     sampleValue<Millibar, &PublishedSample::sea_level_pressure_>, 2},
+    {"wind_speed",
+     sampleValue<MetersPerSecond, &PublishedSample::wind_speed_avg_>, 1},
+    {"wind_direction", sampleValue<float, &PublishedSample::wind_direction_>,
+     0},
+    {"wind_gust", sampleValue<MetersPerSecond, &PublishedSample::wind_gust_>,
+     1},
+};
+
+/*
+ * Readings that change a little every time like they would. There is no
+ * second temperature or dew point, so those should never get a sensor.
+ */
+static PublishedSample makeSample(size_t n) {
+  PublishedSample sample;
+  float step = static_cast<float>(n % 17);
+
+  sample.time_ = system_clock::now();
+  sample.temperature_ = Celsius(21.5f + (step * 0.13f));
+  sample.humidity_ = RelativeHumidity(45.0f + (step * 0.7f));
+  sample.pressure_ = Millibar(985.2f + (step * 0.05f));
+  sample.sea_level_pressure_ = Millibar(1013.25f + (step * 0.05f));
+  sample.wind_speed_avg_ = MetersPerSecond(2.1f + (step * 0.3f));
+  sample.wind_direction_ = static_cast<float>((n * 7) % 360);
+  sample.wind_gust_ = MetersPerSecond(5.4f + (step * 0.3f));
+
+  return sample;
+}
+
+/*
+ * Subscribe to filters on a connection of our own and collect what comes
+ * back, which from the mock broker is only what is retained
+ */
+static expected<map<string, string>, int> retainedMessages(
+    const MqttSinkConfig& config, const vector<string>& filters) {
+  TcpConnection connection;
+  string out;
+  vector<uint8_t> in;
+  map<string, string> retained;
+  uint8_t buffer[4096];
+
+  auto x_opened = connection.open(config.host_, config.port_,
+                                  config.connect_timeout_);
+  if (x_opened.has_value() == false) {
+    return unexpected(x_opened.error());
+  }
+  MqttConnectOptions options;
+  options.client_id_ = "mqtt_sink_driver";
+  options.username_ = config.username_;
+  options.password_ = config.password_;
+  options.clean_session_ = true;
+  mqttAppendConnect(out, options);
+  uint16_t packet_id = 1;
+  for (const string& filter : filters) {
+    mqttAppendSubscribe(out, packet_id++, filter);
+  }
+  auto x_sent = connection.send(out, config.connect_timeout_);
+  if (x_sent.has_value() == false) {
+    return unexpected(x_sent.error());
+  }
+
+  size_t subacks = 0;
+  steady_clock::time_point deadline =
+      steady_clock::now() + config.connect_timeout_;
+  while (true) {
+    auto x_packet = mqttParsePacket(in);
+    if (x_packet.has_value() == true) {
+      MqttPacket packet = x_packet.value();
+      if ((packet.type_ == MQTT_CONNACK) &&
+          ((packet.body_.size() != 2) ||
+           (packet.body_[1] != mqtt_connack_accepted))) {
+        return unexpected(EACCES);
+      }
+      if (packet.type_ == MQTT_SUBACK) {
+        subacks++;
+        if (subacks == filters.size()) {
+          deadline = steady_clock::now() + retained_wait;
+        }
+      }
+      if (packet.type_ == MQTT_PUBLISH) {
+        string_view topic;
+        auto x_used = mqttParseString(packet.body_, topic);
+        if (x_used.has_value() == false) {
+          return unexpected(EPROTO);
+        }
+        retained[string(topic)] = string(
+            reinterpret_cast<const char*>(packet.body_.data()) +
+                x_used.value(),
+            packet.body_.size() - x_used.value());
+      }
+      in.erase(in.begin(), in.begin() + packet.size_);
+      continue;
+    }
+    if (x_packet.error() != EAGAIN) {
+      return unexpected(x_packet.error());
+    }
+
+    auto x_received = connection.receive(buffer, deadline);
+    if (x_received.has_value() == false) {
+      if ((x_received.error() == ETIMEDOUT) && (subacks == filters.size())) {
+        break;
+      }
+      return unexpected(x_received.error());
+    }
+    in.insert(in.end(), buffer, buffer + x_received.value());
+  }
+
+  out.clear();
+  mqttAppendDisconnect(out);
+  connection.send(out, config.connect_timeout_);
+
+  return retained;
+}
+
+/*
+ * Compare what is retained with the last sample that went. Returns the
+ * number of things wrong.
+ */
+static int checkRetained(const MqttSinkConfig& config,
+                         const map<string, string>& retained,
+                         const PublishedSample& last) {
+  char value[qw_units::kFixedFormatBufferSize];
+  int errors = 0;
+
+  auto status = retained.find(config.topic_prefix_ + "/status");
+  if ((status == retained.end()) || (status->second != "online")) {
+    printf("%s/status isn't online\n", config.topic_prefix_.c_str());
+    errors++;
+  }
+
+  for (const DriverReading& reading : driver_readings) {
+    string state_topic = config.topic_prefix_ + "/" + reading.object_id;
+    string discovery_topic = config.discovery_prefix_ + "/sensor/" +
+                             config.client_id_ + "_" + reading.object_id +
+                             "/config";
+    auto state = retained.find(state_topic);
+    auto discovery = retained.find(discovery_topic);
+    optional<float> expected_value = reading.value(last);
+
+    if (expected_value.has_value() == false) {
+      if ((state != retained.end()) || (discovery != retained.end())) {
+        printf("%s was never in a sample but was published\n",
+               reading.object_id);
+        errors++;
+      }
+      continue;
+    }
+
+    size_t length = qw_units::formatFixed(value, sizeof(value),
+                                          expected_value.value(),
+                                          reading.precision);
+    string_view formatted(value, std::min(length, sizeof(value)));
+    if (state == retained.end()) {
+      printf("%s isn't retained\n", state_topic.c_str());
+      errors++;
+    } else if (state->second != formatted) {
+      printf("%s is %s, the last sample had %.*s\n", state_topic.c_str(),
+             state->second.c_str(), static_cast<int>(formatted.size()),
+             formatted.data());
+      errors++;
+    }
+
+    Json::Value discovery_config;
+    Json::CharReaderBuilder builder;
+    string parse_errors;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    if (discovery == retained.end()) {
+      printf("%s isn't retained\n", discovery_topic.c_str());
+      errors++;
+    } else if ((reader->parse(discovery->second.data(),
+                              discovery->second.data() +
+                                  discovery->second.size(),
+                              &discovery_config, &parse_errors) == false) ||
+               (discovery_config["state_topic"].asString() != state_topic)) {
+      printf("%s doesn't point at %s: %s\n", discovery_topic.c_str(),
+             state_topic.c_str(), discovery->second.c_str());
+      errors++;
+    }
+  }
+
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  size_t count = default_sample_count;
+  milliseconds interval = milliseconds(0);
+  MqttSinkConfig config;
+
+  config.host_ = "127.0.0.1";
+  config.client_id_ = "quietwind_driver";
+  config.connect_timeout_ = milliseconds(2000);
+  config.ack_timeout_ = milliseconds(2000);
+
+  while ((opt = getopt(argc, argv, "p:n:a:i:k:")) != -1) {
+    switch (opt) {
+      case 'p':
+        config.port_ = static_cast<uint16_t>(atoi(optarg));
+        break;
+      case 'n':
+        count = strtoull(optarg, nullptr, 10);
+        break;
+      case 'a': {
+        string_view credentials(optarg);
+        size_t colon = credentials.find(':');
+        config.username_ = credentials.substr(0, colon);
+        if (colon != string_view::npos) {
+          config.password_ = credentials.substr(colon + 1);
+        }
+        break;
+      }
+      case 'i':
+        interval = milliseconds(atoi(optarg));
+        break;
+      case 'k':
+        config.keepalive_ = seconds(atoi(optarg));
+        break;
+      default:
+        printf("Usage: mqtt_sink_driver [-p port] [-n samples] "
+               "[-a user:password] [-i interval ms] "
+               "[-k keepalive seconds]\n");
+        exit(1);
+    }
+  }
+  if (count == 0) {
+    printf("There has to be at least one sample\n");
+    exit(1);
+  }
+
+  vector<string> filters = {config.topic_prefix_ + "/#",
+                            config.discovery_prefix_ + "/#"};
+  map<int, size_t> failures;  // by errno
+  vector<microseconds> latency;
+  optional<PublishedSample> last_sent;
+  size_t reconnects = 0;
+  bool failing = false;
+  int errors = 0;
+
+  {
+    MqttSink sink(config);
+
+    auto start = steady_clock::now();
+    for (size_t n = 0; n < count; n++) {
+      PublishedSample sample = makeSample(n);
+      auto publish_start = steady_clock::now();
+      auto x_published = sink.publish(sample);
+      auto took =
+          duration_cast<microseconds>(steady_clock::now() - publish_start);
+
+      if (x_published.has_value() == true) {
+        latency.push_back(took);
+        last_sent = sample;
+        if (failing == true) {
+          reconnects++;
+          failing = false;
+        }
+      } else {
+        failures[x_published.error()]++;
+        failing = true;
+      }
+
+      /*
+       * Wait for the next one the way the publisher thread does
+       */
+      steady_clock::time_point next = steady_clock::now() + interval;
+      while (steady_clock::now() < next) {
+        steady_clock::time_point idle_at = sink.idleAt();
+        if (idle_at >= next) {
+          std::this_thread::sleep_until(next);
+          break;
+        }
+        std::this_thread::sleep_until(idle_at);
+        sink.idle();
+      }
+    }
+    auto elapsed =
+        duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    printf("%zu samples, %zu acked, %.1f samples/s\n", count, latency.size(),
+           count * 1e6 / std::max<int64_t>(elapsed, 1));
+    if (latency.empty() == false) {
+      std::sort(latency.begin(), latency.end());
+      auto percentile = [&](double p) {
+        return latency[std::min(latency.size() - 1,
+                                static_cast<size_t>(p * latency.size()))]
+            .count();
+      };
+      printf("Latency us: p50 %ld p90 %ld p99 %ld max %ld\n",
+             percentile(0.5), percentile(0.9), percentile(0.99),
+             latency.back().count());
+    }
+    for (const auto& [error, failed] : failures) {
+      printf("Failed %zu: %s\n", failed, strerror(error));
+    }
+    printf("Connected again and carried on %zu times\n", reconnects);
+
+    if (last_sent.has_value() == false) {
+      printf("Nothing was acked\n");
+      exit(1);
+    }
+    if (failing == true) {
+      printf("The last sample failed, it never got going again\n");
+      errors++;
+    }
+
+    auto x_retained = retainedMessages(config, filters);
+    if (x_retained.has_value() == false) {
+      printf("Can't get what is retained: %s\n",
+             strerror(x_retained.error()));
+      exit(1);
+    }
+    errors += checkRetained(config, x_retained.value(), last_sent.value());
+  }
+
+  /*
+   * The sink is gone, it should have said so
+   */
+  auto x_retained = retainedMessages(config, filters);
+  if (x_retained.has_value() == false) {
+    printf("Can't get what is retained: %s\n", strerror(x_retained.error()));
+    exit(1);
+  }
+  auto status = x_retained.value().find(config.topic_prefix_ + "/status");
+  if ((status == x_retained.value().end()) || (status->second != "offline")) {
+    printf("%s/status isn't offline after the sink went away\n",
+           config.topic_prefix_.c_str());
+    errors++;
+  }
+
+  printf("%d errors\n", errors);
+  if (errors != 0) {
+    exit(1);
+  }
+
+  return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * Sweep the psychrometric batch kernels over the whole sensor range,
+ * -40 to 125 C by 0.01 C and 0.01 to 100 %RH by 0.01 %RH, and report the
+ * largest difference from the single value reference functions along with
+ * how long each takes per value.
+ *
+ * Usage: psychrometric_error_sweep [-s stride]
+ *   stride steps through the grid stride base units at a time (default 1)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "dewpoint.h"
+#include "psychrometrics.h"
+
+using qw_units::Celsius;
+using qw_units::RelativeHumidity;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::high_resolution_clock;
+using std::chrono::nanoseconds;
+
+constexpr int sweep_temperature_min = -4000;  // hundredths of a C
+constexpr int sweep_temperature_max = 12500;
+constexpr int sweep_humidity_min = 1;  // hundredths of a %RH
+constexpr int sweep_humidity_max = 10000;
+
+class SweepResult {
+ public:
+  SweepResult(const char* name) : name_(name) {}
+
+  void check(float value, float reference, float tempc, float rh) {
+
+    double error = fabs(static_cast<double>(value) - reference);
+    if ((error > max_error_) || (std::isnan(value) == true)) {
+      max_error_ = std::isnan(value) ? INFINITY : error;
+      max_tempc_ = tempc;
+      max_rh_ = rh;
+    }
+
+    return;
+  }
+
+  void print(double batch_ns, double reference_ns) {
+
+    printf("%-26s max error %.6f at %.2f C %.2f %%RH\n", name_, max_error_,
+           max_tempc_, max_rh_);
+    printf("%-26s batch %.2f ns/value, reference %.2f ns/value\n", "",
+           batch_ns, reference_ns);
+
+    return;
+  }
+
+ private:
+  const char* name_;
+  double max_error_ = 0;
+  float max_tempc_ = 0;
+  float max_rh_ = 0;
+};
+
+int main(int argc, char** argv) {
+  int opt;
+  int stride = 1;
+
+  while ((opt = getopt(argc, argv, "s:")) != -1) {
+    switch (opt) {
+      case 's':
+        stride = atoi(optarg);
+        break;
+      default:
+        printf("Usage: psychrometric_error_sweep [-s stride]\n");
+        exit(1);
+    }
+  }
+  if (stride < 1) {
+    stride = 1;
+  }
+
+  printf("Kernels: %s\n", qw_utilities::psychrometricKernelName());
+
+  /*
+   * One row of the grid is every humidity at one temperature
+   */
+  vector<float> rh;
+  for (int h = sweep_humidity_min; h <= sweep_humidity_max; h += stride) {
+    rh.push_back(RelativeHumidity(h / 100.0f).value());
+  }
+  size_t row = rh.size();
+  vector<float> tempc(row);
+  vector<float> es(row);
+  vector<float> dewpoint(row);
+  vector<float> heat_index(row);
+  vector<float> es_reference(row);
+  vector<float> dewpoint_reference(row);
+  vector<float> heat_index_reference(row);
+
+  SweepResult es_result("saturation vapor pressure");
+  SweepResult dewpoint_result("dew point");
+  SweepResult heat_index_result("heat index");
+  nanoseconds batch_time[3] = {};
+  nanoseconds reference_time[3] = {};
+  size_t total = 0;
+
+  for (int t = sweep_temperature_min; t <= sweep_temperature_max; t += stride) {
+    Celsius c(t / 100.0f);
+    std::fill(tempc.begin(), tempc.end(), c.value());
+
+    auto start = high_resolution_clock::now();
+    qw_utilities::saturationVaporPressureBatch(tempc.data(), es.data(), row);
+    auto middle = high_resolution_clock::now();
+    qw_utilities::dewPointBatch(tempc.data(), rh.data(), dewpoint.data(), row);
+    auto end = high_resolution_clock::now();
+    qw_utilities::heatIndexBatch(tempc.data(), rh.data(), heat_index.data(),
+                                 row);
+    auto last = high_resolution_clock::now();
+    batch_time[0] += duration_cast<nanoseconds>(middle - start);
+    batch_time[1] += duration_cast<nanoseconds>(end - middle);
+    batch_time[2] += duration_cast<nanoseconds>(last - end);
+
+    /*
+     * The reference values, timed over the whole row
+     */
+    start = high_resolution_clock::now();
+    for (size_t i = 0; i < row; i++) {
+      es_reference[i] = qw_utilities::saturationVaporPressure(c).value();
+    }
+    middle = high_resolution_clock::now();
+    for (size_t i = 0; i < row; i++) {
+      dewpoint_reference[i] =
+          qw_utilities::dewPoint(c, RelativeHumidity(rh[i])).value();
+    }
+    end = high_resolution_clock::now();
+    for (size_t i = 0; i < row; i++) {
+      heat_index_reference[i] =
+          qw_utilities::heatIndex(c, RelativeHumidity(rh[i])).value();
+    }
+    last = high_resolution_clock::now();
+    reference_time[0] += duration_cast<nanoseconds>(middle - start);
+    reference_time[1] += duration_cast<nanoseconds>(end - middle);
+    reference_time[2] += duration_cast<nanoseconds>(last - end);
+
+    for (size_t i = 0; i < row; i++) {
+      es_result.check(es[i], es_reference[i], tempc[i], rh[i]);
+      dewpoint_result.check(dewpoint[i], dewpoint_reference[i], tempc[i],
+                            rh[i]);
+      heat_index_result.check(heat_index[i], heat_index_reference[i],
+                              tempc[i], rh[i]);
+    }
+    total += row;
+  }
+
+  printf("%zu points\n", total);
+  es_result.print(static_cast<double>(batch_time[0].count()) / total,
+                  static_cast<double>(reference_time[0].count()) / total);
+  dewpoint_result.print(static_cast<double>(batch_time[1].count()) / total,
+                        static_cast<double>(reference_time[1].count()) / total);
+  heat_index_result.print(
+      static_cast<double>(batch_time[2].count()) / total,
+      static_cast<double>(reference_time[2].count()) / total);
+
+  return 0;
+}
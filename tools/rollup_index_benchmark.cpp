@@ -0,0 +1,183 @@
+/*
+ * Benchmark the history rollup index.
+ * Appends a synthetic temperature series, one sample a second, then
+ * times random range queries against it. A sample of the queries is
+ * checked against a brute force scan of the raw values. Then the older
+ * half is expired, the way the station keeps its history to a fixed
+ * length, and the queries over what's left are checked again.
+ *
+ * Usage: rollup_index_benchmark [-n samples] [-q queries]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "rollup_index.h"
+
+using qw_utilities::HISTORY_AGGREGATE_MAX;
+using qw_utilities::RollupIndex;
+using qw_utilities::RollupNode;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::high_resolution_clock;
+using std::chrono::microseconds;
+using std::chrono::nanoseconds;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+constexpr size_t default_sample_count = 100000000;
+constexpr size_t default_query_count = 1000000;
+constexpr size_t verify_query_count = 100;
+
+int main(int argc, char** argv) {
+  int opt;
+  size_t sample_count = default_sample_count;
+  size_t query_count = default_query_count;
+
+  while ((opt = getopt(argc, argv, "n:q:")) != -1) {
+    switch (opt) {
+      case 'n':
+        sample_count = strtoull(optarg, NULL, 10);
+        break;
+      case 'q':
+        query_count = strtoull(optarg, NULL, 10);
+        break;
+      default:
+        printf("Usage: rollup_index_benchmark [-n samples] [-q queries]\n");
+        exit(1);
+    }
+  }
+  if (sample_count == 0) {
+    printf("Need at least one sample\n");
+    exit(1);
+  }
+
+  RollupIndex index;
+  index.reserve(sample_count);
+  time_point<system_clock> epoch = system_clock::now();
+  std::mt19937_64 rng(1);
+  std::normal_distribution<float> noise(0, 200);
+
+  /*
+   * A daily cycle of +-8 C around 20 C plus some noise, in millicelsius
+   */
+  vector<int64_t> values;
+  values.reserve(sample_count);
+  for (size_t i = 0; i < sample_count; i++) {
+    float daily = sin((2 * M_PI * (i % 86400)) / 86400);
+    values.push_back(20000 + static_cast<int64_t>(8000 * daily + noise(rng)));
+  }
+
+  printf("Appending %zu samples\n", sample_count);
+  auto start = high_resolution_clock::now();
+  for (size_t i = 0; i < sample_count; i++) {
+    index.append(epoch + seconds(i), values[i]);
+  }
+  auto end = high_resolution_clock::now();
+  auto elapsed = duration_cast<nanoseconds>(end - start);
+  printf("Append: %ld microseconds total, %.1f ns per sample\n",
+         duration_cast<microseconds>(elapsed).count(),
+         static_cast<double>(elapsed.count()) / sample_count);
+
+  /*
+   * Random ranges anywhere in the series
+   */
+  std::uniform_int_distribution<size_t> position(0, sample_count - 1);
+  vector<std::pair<size_t, size_t>> ranges;
+  ranges.reserve(query_count);
+  for (size_t i = 0; i < query_count; i++) {
+    size_t a = position(rng);
+    size_t b = position(rng);
+    ranges.push_back({std::min(a, b), std::max(a, b) + 1});
+  }
+
+  int64_t checksum = 0;
+  start = high_resolution_clock::now();
+  for (auto [first, last] : ranges) {
+    auto x_max = index.query(epoch + seconds(first), epoch + seconds(last),
+                             HISTORY_AGGREGATE_MAX);
+    checksum += x_max.value_or(0);
+  }
+  end = high_resolution_clock::now();
+  elapsed = duration_cast<nanoseconds>(end - start);
+  printf("Query: %zu max queries, %.1f ns per query (checksum %ld)\n",
+         query_count, static_cast<double>(elapsed.count()) / query_count,
+         checksum);
+
+  /*
+   * Check some of the answers the slow way
+   */
+  int errors = 0;
+  size_t verify_count = std::min(verify_query_count, ranges.size());
+  start = high_resolution_clock::now();
+  for (size_t i = 0; i < verify_count; i++) {
+    auto [first, last] = ranges[i];
+    RollupNode expected_node;
+    for (size_t j = first; j < last; j++) {
+      expected_node.add(values[j]);
+    }
+    RollupNode node = index.rollup(first, last);
+    if ((node.min_ != expected_node.min_) ||
+        (node.max_ != expected_node.max_) ||
+        (node.sum_ != expected_node.sum_) ||
+        (node.count_ != expected_node.count_)) {
+      printf("Mismatch for range %zu..%zu\n", first, last);
+      errors++;
+    }
+  }
+  end = high_resolution_clock::now();
+  elapsed = duration_cast<nanoseconds>(end - start);
+  if (verify_count != 0) {
+    printf("Scan: %zu brute force queries, %.1f ns per query\n", verify_count,
+           static_cast<double>(elapsed.count()) / verify_count);
+  }
+
+  /*
+   * Expire the older half. The pyramid gets built again from what's
+   * left so it has to answer the same as it did before.
+   */
+  size_t half = sample_count / 2;
+  start = high_resolution_clock::now();
+  size_t expired = index.expire(epoch + seconds(half));
+  end = high_resolution_clock::now();
+  elapsed = duration_cast<nanoseconds>(end - start);
+  printf("Expire: %zu samples, %ld microseconds\n", expired,
+         duration_cast<microseconds>(elapsed).count());
+  if ((half >= qw_utilities::kRollupLeafSize) &&
+      ((expired != half) || (index.size() != sample_count - half))) {
+    printf("Expired %zu samples, %zu left, wanted %zu and %zu\n", expired,
+           index.size(), half, sample_count - half);
+    errors++;
+  }
+  for (size_t i = 0; i < verify_count; i++) {
+    auto [first, last] = ranges[i];
+    first = std::max(first, expired);
+    last = std::max(last, first + 1);
+    RollupNode expected_node;
+    for (size_t j = first; j < last; j++) {
+      expected_node.add(values[j]);
+    }
+    RollupNode node = index.rollup(first - expired, last - expired);
+    if ((node.min_ != expected_node.min_) ||
+        (node.max_ != expected_node.max_) ||
+        (node.sum_ != expected_node.sum_) ||
+        (node.count_ != expected_node.count_)) {
+      printf("Mismatch after expiring for range %zu..%zu\n", first, last);
+      errors++;
+    }
+  }
+
+  if (errors != 0) {
+    printf("%d queries did not match the brute force scan\n", errors);
+    exit(1);
+  }
+
+  printf("All checked queries match\n");
+
+  return 0;
+}
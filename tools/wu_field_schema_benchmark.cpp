@@ -0,0 +1,178 @@
+/*
+ * Check and time the weather underground field lookup.
+ * The regex list the lookup used to be is copied here, along with the way
+ * it was searched. Both are asked about every field name weather
+ * underground knows and a pile that it doesn't, the answers have to
+ * agree, and then each gets timed on the fields a report sends.
+ *
+ * Usage: wu_field_schema_benchmark [-n lookups]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "include/wu_field_schema.h"
+
+using std::map;
+using std::regex;
+using std::string;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::high_resolution_clock;
+using std::chrono::nanoseconds;
+
+constexpr size_t default_lookup_count = 100000;
+
+/*
+ * What weather_underground.cpp had
+ */
+const map<string, WuFieldProperties> wu_field_regex_list = {
+    {"^ID$", WuFieldProperties(WU_FIELD_TYPE_STRING, "{}")},
+    {"^PASSWORD$", WuFieldProperties(WU_FIELD_TYPE_STRING, "{}")},
+    {"^dateutc$", WuFieldProperties(WU_FIELD_TYPE_SYSTEM_CLOCK_TIME_POINT,
+                                    "{:%Y-%m-%d %H:%M:%S}")},
+    {"^action$", WuFieldProperties(WU_FIELD_TYPE_STRING, "{}")},
+    {"^baromin$", WuFieldProperties(WU_FIELD_TYPE_NUMBER, 2)},
+    {"^humidity$", WuFieldProperties(WU_FIELD_TYPE_NUMBER, 2)},
+    {"^temp[2-9]?f$|^temp[1-9][0-9]f$",
+     WuFieldProperties(WU_FIELD_TYPE_NUMBER, 2)},  // tempf, temp2-99f
+    {"^dewptf$", WuFieldProperties(WU_FIELD_TYPE_NUMBER, 2)},
+    {"^winddir$|^windgustdir$|^winddir_avg2m$|^windgustdir_10m$",
+     WuFieldProperties(WU_FIELD_TYPE_NUMBER, 0)},
+    {"^windspeedmph$|^windgustmph$|^windspdmph_avg2m$|^windgustmph_10m$",
+     WuFieldProperties(WU_FIELD_TYPE_NUMBER, 1)}};
+
+expected<WuFieldProperties, int> regexFieldProperties(string field) {
+
+  for (auto [rgx, properties] : wu_field_regex_list) {
+    if (std::regex_match(field, regex(rgx)) == true) {
+      return properties;
+      break;
+    }
+  }
+
+  return unexpected(EINVAL);
+}
+
+/*
+ * Every name the regex list takes, near misses of those, and some other
+ * weather underground fields this station doesn't send
+ */
+vector<string> checkNames() {
+  vector<string> names = {
+      "ID", "PASSWORD", "dateutc", "action", "baromin", "humidity", "dewptf",
+      "winddir", "windgustdir", "winddir_avg2m", "windgustdir_10m",
+      "windspeedmph", "windgustmph", "windspdmph_avg2m", "windgustmph_10m",
+      "", "id", "Password", "dateut", "dateutcc", "xaction", "baromin ",
+      "winddir_avg10m", "windgustmph_2m", "rainin", "dailyrainin",
+      "soiltempf", "indoortempf", "UV", "temp", "tempff", "temp-1f",
+      "temp1.5f", "Tempf", "tempF", "temp2", "2tempf", "temp 2f"};
+
+  for (int i = 0; i <= 120; i++) {
+    names.push_back(fmt::format("temp{}f", i));
+    names.push_back(fmt::format("temp{:02}f", i));
+  }
+
+  /*
+   * Each fixed name with one character changed
+   */
+  size_t fixed_count = 15;
+  for (size_t n = 0; n < fixed_count; n++) {
+    for (size_t i = 0; i < names[n].size(); i++) {
+      string changed = names[n];
+      changed[i] ^= 0x01;
+      names.push_back(changed);
+    }
+  }
+
+  return names;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  size_t count = default_lookup_count;
+
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    switch (opt) {
+      case 'n':
+        count = strtoull(optarg, NULL, 10);
+        break;
+      default:
+        printf("Usage: wu_field_schema_benchmark [-n lookups]\n");
+        exit(1);
+    }
+  }
+
+  int errors = 0;
+  vector<string> names = checkNames();
+  for (const string& name : names) {
+    auto x_regex = regexFieldProperties(name);
+    auto x_schema = wuFieldProperties(name);
+    if (x_regex.has_value() != x_schema.has_value()) {
+      printf("\"%s\": regex %s, schema %s\n", name.c_str(),
+             x_regex.has_value() ? "found" : "not found",
+             x_schema.has_value() ? "found" : "not found");
+      errors++;
+    } else if ((x_regex.has_value() == true) &&
+               ((x_regex.value().type_ != x_schema.value()->type_) ||
+                (x_regex.value().default_format_ !=
+                 x_schema.value()->default_format_) ||
+                (x_regex.value().precision_ != x_schema.value()->precision_))) {
+      printf("\"%s\": properties differ\n", name.c_str());
+      errors++;
+    }
+  }
+  printf("Checked %zu field names\n", names.size());
+
+  /*
+   * The fields main sends with a report, each looked up twice like
+   * setVarData() and addData() do
+   */
+  vector<string> report = {"action", "dateutc", "tempf", "temp2f",
+                           "humidity", "dewptf", "baromin",
+                           "windspdmph_avg2m", "windspeedmph",
+                           "winddir_avg2m", "windgustmph_10m", "ID",
+                           "PASSWORD"};
+  size_t found = 0;
+
+  auto start = high_resolution_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    found += regexFieldProperties(report[i % report.size()]).has_value();
+  }
+  auto regex_elapsed =
+      duration_cast<nanoseconds>(high_resolution_clock::now() - start);
+
+  start = high_resolution_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    found += wuFieldProperties(report[i % report.size()]).has_value();
+  }
+  auto schema_elapsed =
+      duration_cast<nanoseconds>(high_resolution_clock::now() - start);
+
+  if (found != (2 * count)) {
+    printf("Report fields not found\n");
+    errors++;
+  }
+
+  double regex_ns = static_cast<double>(regex_elapsed.count()) / count;
+  double schema_ns = static_cast<double>(schema_elapsed.count()) / count;
+  printf("regex list  %10.1f ns per lookup\n", regex_ns);
+  printf("schema      %10.1f ns per lookup\n", schema_ns);
+  printf("per report  %10.1f us regex, %.3f us schema\n",
+         regex_ns * 2 * report.size() / 1000,
+         schema_ns * 2 * report.size() / 1000);
+
+  if (errors != 0) {
+    printf("%d field names differ\n", errors);
+    exit(1);
+  }
+
+  printf("All field names match\n");
+
+  return 0;
+}
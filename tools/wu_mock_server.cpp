@@ -0,0 +1,518 @@
+/*
+ * A stand in for the weather underground upload server.
+ * Answers GET /weatherstation/updateweatherstation.php the way weather
+ * underground does, so the station can be pointed at it with wu_url and
+ * rapid_fire_url in the weather underground config, and the upload
+ * benchmark can run against it.
+ *
+ * Every request is checked. ID, PASSWORD, action=updateraw and dateutc
+ * have to be there, dateutc has to be now or YYYY-MM-DD HH:MM:SS, every
+ * other field has to be one weather underground knows, a number field has
+ * to be a number, realtime has to be 1 and rtfreq a number, nothing can
+ * be there twice and the escaping has to be right. A request that isn't
+ * right gets a 400 with what was wrong.
+ *
+ * Responses can be slowed down and made to fail:
+ *   -l ms       add this much latency to every response
+ *   -j ms       and up to this much more, at random
+ *   -e percent  answer this many with a 500
+ *   -t percent  answer this many with a 429, Retry-After 60
+ *   -i percent  answer this many with INVALIDPASSWORDID
+ *   -w password answer INVALIDPASSWORDID unless PASSWORD is this
+ *   -k          close the connection after every response
+ *   -v          print every request
+ *
+ * Connections are kept open like weather underground does, curl reuses
+ * them. It is plain HTTP, there is no TLS, so the URL to give the station
+ * is http://localhost:port/weatherstation/updateweatherstation.php.
+ *
+ * The counts are printed when it is stopped with ^C.
+ *
+ * Usage: wu_mock_server [-p port] [-l ms] [-j ms] [-e percent]
+ *                       [-t percent] [-i percent] [-w password] [-k] [-v]
+ */
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <expected>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "include/wu_field_schema.h"
+
+using std::map;
+using std::string;
+using std::string_view;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+constexpr int default_port = 8080;
+constexpr string_view wu_path = "/weatherstation/updateweatherstation.php";
+constexpr string_view wu_success = "success\n";
+constexpr string_view wu_invalid_password =
+    "INVALIDPASSWORDID|Password or key and/or id are incorrect\n";
+
+struct MockConfig {
+  int port = default_port;
+  int latency = 0;  // milliseconds
+  int jitter = 0;   // milliseconds
+  int error_percent = 0;
+  int throttle_percent = 0;
+  int invalid_percent = 0;
+  string password;
+  bool keep_alive = true;
+  bool verbose = false;
+};
+
+struct Client {
+  int fd;
+  string in;
+  string out;
+  size_t sent = 0;
+  bool responding = false;  // out is waiting for due or going out
+  bool close_after = false;
+  steady_clock::time_point due;
+};
+
+struct MockCounts {
+  uint64_t connections = 0;
+  uint64_t requests = 0;
+  uint64_t success = 0;
+  uint64_t invalid_password = 0;
+  uint64_t errors = 0;
+  uint64_t throttled = 0;
+  uint64_t rejected = 0;
+  map<string, uint64_t> reasons;
+};
+
+static volatile sig_atomic_t stop = 0;
+
+static void stopHandler(int) {
+
+  stop = 1;
+
+  return;
+}
+
+static int hexValue(char c) {
+
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0';
+  }
+  if ((c >= 'A') && (c <= 'F')) {
+    return c - 'A' + 10;
+  }
+  if ((c >= 'a') && (c <= 'f')) {
+    return c - 'a' + 10;
+  }
+
+  return -1;
+}
+
+/*
+ * Undo the percent encoding, + is a space in a query
+ */
+static std::expected<string, string> unescape(string_view value) {
+  string out;
+
+  for (size_t i = 0; i < value.size(); i++) {
+    if (value[i] == '+') {
+      out.push_back(' ');
+    } else if (value[i] != '%') {
+      out.push_back(value[i]);
+    } else if ((i + 2 < value.size()) && (hexValue(value[i + 1]) >= 0) &&
+               (hexValue(value[i + 2]) >= 0)) {
+      out.push_back(
+          static_cast<char>(hexValue(value[i + 1]) * 16 + hexValue(value[i + 2])));
+      i += 2;
+    } else {
+      return std::unexpected("bad escape");
+    }
+  }
+
+  return out;
+}
+
+static bool isNumber(const string& value) {
+  char* end = nullptr;
+
+  if (value.empty() == true) {
+    return false;
+  }
+  double number = strtod(value.c_str(), &end);
+
+  return (*end == '\0') && (std::isfinite(number) == true);
+}
+
+static bool isDate(const string& value) {
+  int year, month, day, hour, minute, second;
+  char end;
+
+  if (value == "now") {
+    return true;
+  }
+  if ((value.size() != 19) ||
+      (sscanf(value.c_str(), "%4d-%2d-%2d %2d:%2d:%2d%c", &year, &month, &day,
+              &hour, &minute, &second, &end) != 6)) {
+    return false;
+  }
+
+  return (month >= 1) && (month <= 12) && (day >= 1) && (day <= 31) &&
+         (hour <= 23) && (minute <= 59) && (second <= 60);
+}
+
+/*
+ * Check the query the way weather underground would want it. What comes
+ * back is the fields, or what was wrong.
+ */
+static std::expected<map<string, string>, string> checkQuery(
+    string_view query) {
+  map<string, string> fields;
+
+  while (query.empty() == false) {
+    size_t amp = query.find('&');
+    string_view pair = query.substr(0, amp);
+    query = (amp == string_view::npos) ? string_view() : query.substr(amp + 1);
+
+    /*
+     * The station starts with ?&ID=, weather underground doesn't mind
+     */
+    if (pair.empty() == true) {
+      continue;
+    }
+    size_t equals = pair.find('=');
+    if (equals == string_view::npos) {
+      return std::unexpected(fmt::format("no value for {}", pair));
+    }
+    auto x_name = unescape(pair.substr(0, equals));
+    auto x_value = unescape(pair.substr(equals + 1));
+    if ((x_name.has_value() == false) || (x_value.has_value() == false)) {
+      return std::unexpected(fmt::format("bad escape in {}", pair));
+    }
+    string name = x_name.value();
+    string value = x_value.value();
+    if (fields.contains(name) == true) {
+      return std::unexpected(fmt::format("{} twice", name));
+    }
+
+    if (name == "realtime") {
+      if (value != "1") {
+        return std::unexpected("realtime isn't 1");
+      }
+    } else if (name == "rtfreq") {
+      if (isNumber(value) == false) {
+        return std::unexpected("rtfreq isn't a number");
+      }
+    } else {
+      auto x_properties = wuFieldProperties(name);
+      if (x_properties.has_value() == false) {
+        return std::unexpected(fmt::format("unknown field {}", name));
+      }
+      switch (x_properties.value()->type_) {
+        case WU_FIELD_TYPE_NUMBER:
+          if (isNumber(value) == false) {
+            return std::unexpected(fmt::format("{} isn't a number", name));
+          }
+          break;
+        case WU_FIELD_TYPE_SYSTEM_CLOCK_TIME_POINT:
+          if (isDate(value) == false) {
+            return std::unexpected(fmt::format("{} isn't a date", name));
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    fields[name] = value;
+  }
+
+  for (const char* required : {"ID", "PASSWORD", "action", "dateutc"}) {
+    if (fields.contains(required) == false) {
+      return std::unexpected(fmt::format("no {}", required));
+    }
+  }
+  if (fields["action"] != "updateraw") {
+    return std::unexpected("action isn't updateraw");
+  }
+  if (fields.contains("rtfreq") != fields.contains("realtime")) {
+    return std::unexpected("realtime and rtfreq go together");
+  }
+
+  return fields;
+}
+
+static string httpResponse(int status, string_view reason, string_view body,
+                           bool close_after, string_view headers = "") {
+
+  return fmt::format(
+      "HTTP/1.1 {} {}\r\nContent-Type: text/plain\r\nContent-Length: {}\r\n"
+      "Connection: {}\r\n{}\r\n{}",
+      status, reason, body.size(), close_after ? "close" : "keep-alive",
+      headers, body);
+}
+
+/*
+ * Work out the answer to the request at the front of client.in, if it is
+ * all there
+ */
+static bool handleRequest(Client& client, const MockConfig& config,
+                          MockCounts& counts, std::mt19937& random) {
+
+  size_t end = client.in.find("\r\n\r\n");
+  if (end == string::npos) {
+    return false;
+  }
+  string request = client.in.substr(0, end + 4);
+  client.in.erase(0, end + 4);
+  counts.requests++;
+
+  string lower = request;
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  client.close_after = (config.keep_alive == false) ||
+                       (lower.find("\r\nconnection: close") != string::npos);
+
+  /*
+   * GET target HTTP/1.x
+   */
+  string_view line = string_view(request).substr(0, request.find("\r\n"));
+  size_t space1 = line.find(' ');
+  size_t space2 = line.rfind(' ');
+  string_view method = line.substr(0, space1);
+  string_view target = (space1 == space2)
+                           ? string_view()
+                           : line.substr(space1 + 1, space2 - space1 - 1);
+  string_view path = target.substr(0, target.find('?'));
+  string_view query = (target.find('?') == string_view::npos)
+                          ? string_view()
+                          : target.substr(target.find('?') + 1);
+
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::expected<map<string, string>, string> x_fields =
+      std::unexpected("not GET");
+  if (method != "GET") {
+    client.out = httpResponse(405, "Method Not Allowed", "GET only\n",
+                              client.close_after);
+  } else if (path != wu_path) {
+    x_fields = std::unexpected(fmt::format("no {}", path));
+    client.out = httpResponse(404, "Not Found", "Not Found\n",
+                              client.close_after);
+  } else {
+    x_fields = checkQuery(query);
+    if (x_fields.has_value() == false) {
+      client.out = httpResponse(400, "Bad Request",
+                                fmt::format("{}\n", x_fields.error()),
+                                client.close_after);
+    } else if (((config.password.empty() == false) &&
+                (x_fields.value()["PASSWORD"] != config.password)) ||
+               (percent(random) < config.invalid_percent)) {
+      counts.invalid_password++;
+      client.out = httpResponse(401, "Unauthorized", wu_invalid_password,
+                                client.close_after);
+    } else if (percent(random) < config.throttle_percent) {
+      counts.throttled++;
+      client.out = httpResponse(429, "Too Many Requests",
+                                "Too Many Requests\n", client.close_after,
+                                "Retry-After: 60\r\n");
+    } else if (percent(random) < config.error_percent) {
+      counts.errors++;
+      client.out = httpResponse(500, "Internal Server Error",
+                                "Internal Server Error\n", client.close_after);
+    } else {
+      counts.success++;
+      client.out = httpResponse(200, "OK", wu_success, client.close_after);
+    }
+  }
+  if (x_fields.has_value() == false) {
+    counts.rejected++;
+    counts.reasons[x_fields.error()]++;
+  }
+
+  if (config.verbose == true) {
+    printf("%.*s -> %.*s\n", static_cast<int>(target.size()), target.data(),
+           static_cast<int>(client.out.find("\r\n")), client.out.c_str());
+  }
+
+  int delay = config.latency;
+  if (config.jitter > 0) {
+    delay += std::uniform_int_distribution<int>(0, config.jitter)(random);
+  }
+  client.due = steady_clock::now() + milliseconds(delay);
+  client.sent = 0;
+  client.responding = true;
+
+  return true;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  MockConfig config;
+
+  while ((opt = getopt(argc, argv, "p:l:j:e:t:i:w:kv")) != -1) {
+    switch (opt) {
+      case 'p':
+        config.port = atoi(optarg);
+        break;
+      case 'l':
+        config.latency = atoi(optarg);
+        break;
+      case 'j':
+        config.jitter = atoi(optarg);
+        break;
+      case 'e':
+        config.error_percent = atoi(optarg);
+        break;
+      case 't':
+        config.throttle_percent = atoi(optarg);
+        break;
+      case 'i':
+        config.invalid_percent = atoi(optarg);
+        break;
+      case 'w':
+        config.password = optarg;
+        break;
+      case 'k':
+        config.keep_alive = false;
+        break;
+      case 'v':
+        config.verbose = true;
+        break;
+      default:
+        printf("Usage: wu_mock_server [-p port] [-l ms] [-j ms] "
+               "[-e percent] [-t percent] [-i percent] [-w password] [-k] "
+               "[-v]\n");
+        exit(1);
+    }
+  }
+
+  int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int on = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(config.port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if ((bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+            sizeof(address)) != 0) ||
+      (listen(listen_fd, SOMAXCONN) != 0)) {
+    printf("Can't listen on port %d: %s\n", config.port, strerror(errno));
+    exit(1);
+  }
+  printf("Listening on http://127.0.0.1:%d%.*s\n", config.port,
+         static_cast<int>(wu_path.size()), wu_path.data());
+  fflush(stdout);
+
+  /*
+   * No SA_RESTART so poll() comes back when we're stopped
+   */
+  struct sigaction action = {};
+  action.sa_handler = stopHandler;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  std::mt19937 random(std::random_device{}());
+  MockCounts counts;
+  map<int, Client> clients;
+  vector<pollfd> fds;
+
+  while (stop == 0) {
+    auto now = steady_clock::now();
+    int timeout = -1;
+
+    fds.clear();
+    fds.push_back(pollfd{listen_fd, POLLIN, 0});
+    for (auto& [fd, client] : clients) {
+      if (client.responding == false) {
+        fds.push_back(pollfd{fd, POLLIN, 0});
+      } else if (now >= client.due) {
+        fds.push_back(pollfd{fd, POLLOUT, 0});
+      } else {
+        int wait = static_cast<int>(
+            std::chrono::ceil<milliseconds>(client.due - now).count());
+        timeout = (timeout < 0) ? wait : std::min(timeout, wait);
+      }
+    }
+
+    if (poll(fds.data(), fds.size(), timeout) < 0) {
+      continue;
+    }
+
+    if ((fds[0].revents & POLLIN) != 0) {
+      int fd;
+      while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+        clients[fd] = {};
+        clients[fd].fd = fd;
+        counts.connections++;
+      }
+    }
+
+    for (size_t i = 1; i < fds.size(); i++) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+      Client& client = clients[fds[i].fd];
+      bool closed = false;
+
+      if (client.responding == false) {
+        char buffer[4096];
+        ssize_t n = read(client.fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+          closed = true;
+        } else {
+          client.in.append(buffer, n);
+          handleRequest(client, config, counts, random);
+        }
+      } else {
+        ssize_t n = write(client.fd, client.out.data() + client.sent,
+                          client.out.size() - client.sent);
+        if (n < 0) {
+          closed = true;
+        } else {
+          client.sent += n;
+          if (client.sent == client.out.size()) {
+            client.responding = false;
+            closed = client.close_after;
+            /*
+             * Another request could have come in behind this one
+             */
+            if (closed == false) {
+              handleRequest(client, config, counts, random);
+            }
+          }
+        }
+      }
+
+      if (closed == true) {
+        close(client.fd);
+        clients.erase(fds[i].fd);
+      }
+    }
+  }
+
+  printf("\nConnections: %lu\n", counts.connections);
+  printf("Requests: %lu\n", counts.requests);
+  printf("  success: %lu\n", counts.success);
+  printf("  INVALIDPASSWORDID: %lu\n", counts.invalid_password);
+  printf("  throttled: %lu\n", counts.throttled);
+  printf("  server errors: %lu\n", counts.errors);
+  printf("  rejected: %lu\n", counts.rejected);
+  for (const auto& [reason, count] : counts.reasons) {
+    printf("    %s: %lu\n", reason.c_str(), count);
+  }
+
+  return 0;
+}
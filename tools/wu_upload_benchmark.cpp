@@ -0,0 +1,298 @@
+/*
+ * Time uploads to weather underground, end to end.
+ * Meant to be run against tools/wu_mock_server so it doesn't need the
+ * real service or the station's password. Each upload is a report put
+ * together the way main does it and sent with
+ * WeatherUnderground::sendData(), or with -r a RapidFire update sent with
+ * WuRapidFire. The time of every upload is kept and the rate, the latency
+ * percentiles and what came back, sorted out by wuClassifyResponse(), are
+ * printed.
+ *
+ * malloc() is counted too, so allocations per upload are shown. They are
+ * split into putting the report together and sending it, which includes
+ * whatever curl allocates.
+ *
+ * Usage: wu_upload_benchmark [-u url] [-n uploads] [-i id] [-w password]
+ *                            [-r]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "include/weather_underground.h"
+#include "include/wu_rapid_fire.h"
+#include "include/wu_response.h"
+
+using std::array;
+using std::string;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+constexpr size_t default_upload_count = 1000;
+constexpr size_t warmup_count = 10;
+constexpr milliseconds rapid_fire_interval = milliseconds(2500);
+constexpr char default_url[] =
+    "http://127.0.0.1:8080/weatherstation/updateweatherstation.php";
+
+/*
+ * Every malloc() in the process goes through here and gets counted.
+ * glibc's own malloc is still there as __libc_malloc().
+ */
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+static std::atomic<uint64_t> allocations = 0;
+
+extern "C" void* malloc(size_t size) {
+
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  return __libc_realloc(pointer, size);
+}
+
+struct UploadResults {
+  vector<microseconds> latency;
+  size_t failed = 0;
+  string first_failure;
+  array<size_t, WU_RESPONSE_MAX> responses{};
+  uint64_t build_allocations = 0;
+  uint64_t send_allocations = 0;
+};
+
+/*
+ * Readings that change a little every time like they would
+ */
+static float reading(float base, size_t n) {
+
+  return base + static_cast<float>(n % 17) * 0.13f;
+}
+
+static void reportUploads(WeatherUnderground& wu, size_t count,
+                          UploadResults& results) {
+
+  for (size_t n = 0; n < count + warmup_count; n++) {
+    auto start = steady_clock::now();
+    uint64_t start_allocations = allocations;
+
+    wu.reset();
+    wu.setVarData("action", "updateraw");
+    wu.setVarData("dateutc", system_clock::now());
+    wu.setVarData("tempf", reading(71.5f, n));
+    wu.setVarData("temp2f", reading(72.1f, n));
+    wu.setVarData("humidity", reading(45.0f, n));
+    wu.setVarData("dewptf", reading(49.2f, n));
+    wu.setVarData("baromin", reading(29.92f, n));
+    wu.setVarData("windspdmph_avg2m", reading(4.2f, n));
+    wu.setVarData("windspeedmph", reading(5.1f, n));
+    wu.setVarData("winddir_avg2m", reading(180.0f, n));
+    wu.setVarData("windgustmph_10m", reading(12.3f, n));
+    uint64_t built_allocations = allocations;
+
+    wu.clearHttpResponse();
+    auto x_sent = wu.sendData();
+    uint64_t sent_allocations = allocations;
+    auto latency = duration_cast<microseconds>(steady_clock::now() - start);
+
+    /*
+     * The first few open the connection and grow the buffers
+     */
+    if (n < warmup_count) {
+      continue;
+    }
+    results.latency.push_back(latency);
+    results.build_allocations += built_allocations - start_allocations;
+    results.send_allocations += sent_allocations - built_allocations;
+    string response = wu.getHttpResponse();
+    WuResponseClass response_class = wuClassifyResponse(
+        x_sent, wu.lastUploadTiming().http_status_, response);
+    results.responses[response_class]++;
+    if (response_class != WU_RESPONSE_SUCCESS) {
+      if (results.failed == 0) {
+        results.first_failure =
+            (x_sent.has_value() == false) ? strerror(x_sent.error()) : response;
+      }
+      results.failed++;
+    }
+  }
+
+  return;
+}
+
+static void rapidFireUploads(const string& url, const string& id,
+                             const string& password, size_t count,
+                             UploadResults& results) {
+  WuConnection connection;
+  WuRapidFire rapid_fire(&connection);
+
+  rapid_fire.setStation(id, password, rapid_fire_interval, url);
+  size_t tempf = rapid_fire.addField("tempf").value();
+  size_t humidity = rapid_fire.addField("humidity").value();
+  size_t dewptf = rapid_fire.addField("dewptf").value();
+  size_t baromin = rapid_fire.addField("baromin").value();
+  size_t windspeedmph = rapid_fire.addField("windspeedmph").value();
+
+  vector<pollfd> fds;
+  for (size_t n = 0; n < count + warmup_count; n++) {
+    auto start = steady_clock::now();
+    uint64_t start_allocations = allocations;
+
+    rapid_fire.setValue(tempf, reading(71.5f, n));
+    rapid_fire.setValue(humidity, reading(45.0f, n));
+    rapid_fire.setValue(dewptf, reading(49.2f, n));
+    rapid_fire.setValue(baromin, reading(29.92f, n));
+    rapid_fire.setValue(windspeedmph, reading(5.1f, n));
+    uint64_t built_allocations = allocations;
+
+    bool done = false;
+    WuResponseClass response_class = WU_RESPONSE_COMM_ERROR;
+    string failure;
+    auto x_sent = rapid_fire.sendAsync(
+        start, [&](expected<bool, int> result, const string& response,
+                   const WuUploadTiming& timing) {
+          response_class =
+              wuClassifyResponse(result, timing.http_status_, response);
+          if (response_class != WU_RESPONSE_SUCCESS) {
+            failure = (result.has_value() == false) ? strerror(result.error())
+                                                    : response;
+          }
+          done = true;
+        });
+    while ((x_sent.has_value() == true) && (done == false)) {
+      fds.clear();
+      connection.addPollFds(fds);
+      poll(fds.data(), fds.size(), connection.timeout());
+      connection.process(fds);
+    }
+    uint64_t sent_allocations = allocations;
+    auto latency = duration_cast<microseconds>(steady_clock::now() - start);
+
+    if (n < warmup_count) {
+      continue;
+    }
+    results.latency.push_back(latency);
+    results.build_allocations += built_allocations - start_allocations;
+    results.send_allocations += sent_allocations - built_allocations;
+    results.responses[response_class]++;
+    if (response_class != WU_RESPONSE_SUCCESS) {
+      if (results.failed == 0) {
+        results.first_failure = (x_sent.has_value() == false)
+                                    ? strerror(x_sent.error())
+                                    : failure;
+      }
+      results.failed++;
+    }
+  }
+
+  return;
+}
+
+static long percentile(const vector<microseconds>& sorted, double p) {
+
+  if (sorted.empty() == true) {
+    return 0;
+  }
+
+  return sorted[std::min(sorted.size() - 1,
+                         static_cast<size_t>(p * sorted.size()))]
+      .count();
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  string url = default_url;
+  string id = "KMOCK1";
+  string password = "mock";
+  size_t count = default_upload_count;
+  bool rapid_fire = false;
+
+  while ((opt = getopt(argc, argv, "u:n:i:w:r")) != -1) {
+    switch (opt) {
+      case 'u':
+        url = optarg;
+        break;
+      case 'n':
+        count = strtoull(optarg, NULL, 10);
+        break;
+      case 'i':
+        id = optarg;
+        break;
+      case 'w':
+        password = optarg;
+        break;
+      case 'r':
+        rapid_fire = true;
+        break;
+      default:
+        printf("Usage: wu_upload_benchmark [-u url] [-n uploads] [-i id] "
+               "[-w password] [-r]\n");
+        exit(1);
+    }
+  }
+
+  UploadResults results;
+  auto start = steady_clock::now();
+  if (rapid_fire == true) {
+    rapidFireUploads(url, id, password, count, results);
+  } else {
+    WuConnection connection;
+    WeatherUnderground wu(id, password, &connection);
+    wu.setUrl(url);
+    reportUploads(wu, count, results);
+  }
+  double elapsed =
+      duration_cast<microseconds>(steady_clock::now() - start).count() / 1e6;
+
+  vector<microseconds> sorted = results.latency;
+  std::sort(sorted.begin(), sorted.end());
+  size_t uploads = std::max<size_t>(1, sorted.size());
+
+  printf("%s uploads to %s\n", rapid_fire ? "RapidFire" : "Report",
+         url.c_str());
+  printf("Uploads: %zu in %.3f s (%zu warmup), %.1f uploads/s, %zu failed\n",
+         sorted.size(), elapsed, warmup_count,
+         (count + warmup_count) / elapsed, results.failed);
+  if (results.failed > 0) {
+    printf("First failure: %s\n", results.first_failure.c_str());
+  }
+  printf("Responses:");
+  for (int c = 0; c < WU_RESPONSE_MAX; c++) {
+    printf(" %.*s %zu",
+           static_cast<int>(
+               wuResponseClassName(static_cast<WuResponseClass>(c)).size()),
+           wuResponseClassName(static_cast<WuResponseClass>(c)).data(),
+           results.responses[c]);
+  }
+  printf("\n");
+  printf("Latency us: p50 %ld p90 %ld p99 %ld max %ld\n",
+         percentile(sorted, 0.50), percentile(sorted, 0.90),
+         percentile(sorted, 0.99),
+         sorted.empty() ? 0L : static_cast<long>(sorted.back().count()));
+  printf("Allocations per upload: %.2f building, %.2f sending\n",
+         static_cast<double>(results.build_allocations) / uploads,
+         static_cast<double>(results.send_allocations) / uploads);
+
+  return results.failed == 0 ? 0 : 1;
+}